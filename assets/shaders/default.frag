@@ -1,123 +1,220 @@
-#version 450
-
-layout(binding = 1) uniform PBRMaterial {
-    vec3 albedo;
-    float metallic;
-    float roughness;
-    float ao;
-} material;
-
-layout(binding = 2) uniform LightData {
-    vec3 position;
-    vec3 color;
-} light;
-
-layout(binding = 3) uniform sampler2D texSampler;
-
-layout(location = 0) in vec3 fragPos;
-layout(location = 1) in vec3 fragNormal;
-layout(location = 2) in vec2 fragTexCoord;
-layout(location = 3) in vec3 fragTangent;
-layout(location = 4) in vec3 fragBitangent;
-layout(location = 5) in vec3 fragCameraPos;
-
-layout(location = 0) out vec4 outColor;
-
-const float PI = 3.14159265359;
-
-vec3 getNormalFromMap() {
-    return normalize(fragNormal);
-}
-
-float DistributionGGX(vec3 N, vec3 H, float roughness) {
-    float a = roughness * roughness;
-    float a2 = a * a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH * NdotH;
-    
-    float num = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-    
-    return num / denom;
-}
-
-float GeometrySchlickGGX(float NdotV, float roughness) {
-    float r = (roughness + 1.0);
-    float k = (r * r) / 8.0;
-    
-    float num = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-    
-    return num / denom;
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
-    
-    return ggx1 * ggx2;
-}
-
-vec3 fresnelSchlick(float cosTheta, vec3 F0) {
-    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}
-
-void main() {
-    vec4 textureColor = texture(texSampler, fragTexCoord);
-    
-    if (textureColor.a < 0.5) {
-        discard;
-    }
-    
-    vec3 albedo;
-    if (length(material.albedo - vec3(1.0)) < 0.1) {
-        albedo = textureColor.rgb;
-    } else {
-        albedo = material.albedo * textureColor.rgb;
-    }
-    
-    float metallic = material.metallic;
-    float roughness = material.roughness;
-    float ao = material.ao;
-    
-    vec3 N = getNormalFromMap();
-    vec3 V = normalize(fragCameraPos - fragPos);
-    
-    vec3 F0 = vec3(0.04);
-    F0 = mix(F0, albedo, metallic);
-    
-    vec3 Lo = vec3(0.0);
-    
-    vec3 L = normalize(light.position - fragPos);
-    vec3 H = normalize(V + L);
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (distance * distance);
-    vec3 radiance = light.color * attenuation;
-    
-    float NDF = DistributionGGX(N, H, roughness);
-    float G = GeometrySmith(N, V, L, roughness);
-    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
-    
-    vec3 kS = F;
-    vec3 kD = vec3(1.0) - kS;
-    kD *= 1.0 - metallic;
-    
-    vec3 numerator = NDF * G * F;
-    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
-    vec3 specular = numerator / denominator;
-    
-    float NdotL = max(dot(N, L), 0.0);
-    Lo += (kD * albedo / PI + specular) * radiance * NdotL;
-    
-    vec3 ambient = vec3(0.15) * albedo * ao;
-    vec3 color = ambient + Lo;
-    
-    color = color / (color + vec3(1.0));
-
-    color = pow(color, vec3(1.0/2.2));
-    
-    outColor = vec4(color, textureColor.a);
-}
+#version 450
+
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+
+struct MaterialRecord {
+    vec3 albedo;
+    float metallic;
+    float roughness;
+    float ao;
+    uint albedoTexture;
+};
+
+// The global tables of BindlessTable; the draw picks its entry.
+layout(std430, set = 4, binding = 0) readonly buffer MaterialBuffer {
+    MaterialRecord materials[];
+};
+
+layout(set = 4, binding = 1) uniform sampler2D textures[];
+
+layout(push_constant) uniform DrawConstants {
+    uint materialIndex;
+} draw;
+
+// The index is uniform across the draw, so no nonuniformEXT is needed.
+#define material materials[draw.materialIndex]
+#define texSampler textures[materials[draw.materialIndex].albedoTexture]
+#else
+layout(binding = 1) uniform PBRMaterial {
+    vec3 albedo;
+    float metallic;
+    float roughness;
+    float ao;
+} material;
+
+layout(binding = 3) uniform sampler2D texSampler;
+#endif
+
+layout(set = 2, binding = 0) uniform samplerCube irradianceMap;
+layout(set = 2, binding = 1) uniform samplerCube prefilteredMap;
+layout(set = 2, binding = 2) uniform sampler2D brdfLUT;
+
+struct PointLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+// Written by the CPU and binned by light_cull.comp; see LightGrid.
+layout(std430, set = 3, binding = 0) readonly buffer LightBuffer {
+    mat4 view;
+    mat4 inverseProjection;
+    uvec4 gridSize;     // clusters in x, y, z; w = light count
+    vec4 depthParams;   // near, far, slice scale, slice bias
+    vec4 tileSize;      // pixels per cluster in x, y; screen size in z, w
+    PointLight lights[];
+} lightBuffer;
+
+layout(std430, set = 3, binding = 1) readonly buffer ClusterBuffer {
+    uint clusterData[];
+};
+
+const uint MAX_LIGHTS_PER_CLUSTER = 128u;
+const uint CLUSTER_STRIDE = MAX_LIGHTS_PER_CLUSTER + 1u;
+
+layout(location = 0) in vec3 fragPos;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec2 fragTexCoord;
+layout(location = 3) in vec3 fragTangent;
+layout(location = 4) in vec3 fragBitangent;
+layout(location = 5) in vec3 fragCameraPos;
+
+layout(location = 0) out vec4 outColor;
+
+// Off when the depth pre-pass already resolved the cutout: fragments that
+// would be discarded fail the eEqual depth test instead.
+layout(constant_id = 0) const bool ALPHA_TEST = true;
+
+const float PI = 3.14159265359;
+
+vec3 getNormalFromMap() {
+    return normalize(fragNormal);
+}
+
+float DistributionGGX(vec3 N, vec3 H, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+    
+    float num = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+    
+    return num / denom;
+}
+
+float GeometrySchlickGGX(float NdotV, float roughness) {
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+    
+    float num = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+    
+    return num / denom;
+}
+
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+    
+    return ggx1 * ggx2;
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0) {
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+// Cluster of this fragment, with the same slicing as light_cull.comp.
+uint clusterIndex() {
+    uvec3 grid = lightBuffer.gridSize.xyz;
+    float viewDepth = -(lightBuffer.view * vec4(fragPos, 1.0)).z;
+    float slice = log(max(viewDepth, lightBuffer.depthParams.x)) * lightBuffer.depthParams.z - lightBuffer.depthParams.w;
+    uint z = min(uint(max(slice, 0.0)), grid.z - 1u);
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / lightBuffer.tileSize.xy), grid.xy - 1u);
+    return tile.x + grid.x * (tile.y + grid.y * z);
+}
+
+vec3 pointLighting(PointLight light, vec3 N, vec3 V, vec3 albedo, vec3 F0, float metallic, float roughness) {
+    vec3 L = normalize(light.position - fragPos);
+    vec3 H = normalize(V + L);
+    float distance = length(light.position - fragPos);
+    // Inverse square, windowed to reach zero at the radius the light was binned with.
+    float falloff = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+    float attenuation = falloff * falloff / max(distance * distance, 0.0001);
+    vec3 radiance = light.color * light.intensity * attenuation;
+    
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+    
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+    
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+    
+    float NdotL = max(dot(N, L), 0.0);
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+// Split-sum image based lighting: irradiance for diffuse, the prefiltered
+// environment at the roughness mip plus the BRDF LUT for specular.
+vec3 ambientLighting(vec3 N, vec3 V, vec3 albedo, vec3 F0, float metallic, float roughness) {
+    float NdotV = max(dot(N, V), 0.0);
+    vec3 F = fresnelSchlickRoughness(NdotV, F0, roughness);
+
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    vec3 diffuse = texture(irradianceMap, N).rgb * albedo;
+
+    vec3 R = reflect(-V, N);
+    float maxLod = float(textureQueryLevels(prefilteredMap) - 1);
+    vec3 prefiltered = textureLod(prefilteredMap, R, roughness * maxLod).rgb;
+    vec2 brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
+    vec3 specular = prefiltered * (F * brdf.x + brdf.y);
+
+    return kD * diffuse + specular;
+}
+
+void main() {
+    vec4 textureColor = texture(texSampler, fragTexCoord);
+    
+    if (ALPHA_TEST && textureColor.a < 0.5) {
+        discard;
+    }
+    
+    vec3 albedo;
+    if (length(material.albedo - vec3(1.0)) < 0.1) {
+        albedo = textureColor.rgb;
+    } else {
+        albedo = material.albedo * textureColor.rgb;
+    }
+    
+    float metallic = material.metallic;
+    float roughness = material.roughness;
+    float ao = material.ao;
+    
+    vec3 N = getNormalFromMap();
+    vec3 V = normalize(fragCameraPos - fragPos);
+    
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+    
+    vec3 Lo = vec3(0.0);
+    
+    uint base = clusterIndex() * CLUSTER_STRIDE;
+    uint lightCount = clusterData[base];
+    for (uint i = 0u; i < lightCount; i++) {
+        PointLight light = lightBuffer.lights[clusterData[base + 1u + i]];
+        Lo += pointLighting(light, N, V, albedo, F0, metallic, roughness);
+    }
+    
+    vec3 ambient = ambientLighting(N, V, albedo, F0, metallic, roughness) * ao;
+    vec3 color = ambient + Lo;
+    
+    color = color / (color + vec3(1.0));
+
+    color = pow(color, vec3(1.0/2.2));
+    
+    outColor = vec4(color, textureColor.a);
+}
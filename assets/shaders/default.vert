@@ -1,35 +1,72 @@
-#version 450
-
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-    mat4 normalMatrix;
-    vec3 cameraPos;
-} ubo;
-
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inTangent;
-
-layout(location = 0) out vec3 fragPos;
-layout(location = 1) out vec3 fragNormal;
-layout(location = 2) out vec2 fragTexCoord;
-layout(location = 3) out vec3 fragTangent;
-layout(location = 4) out vec3 fragBitangent;
-layout(location = 5) out vec3 fragCameraPos;
-
-void main() {
-    vec4 worldPos = ubo.model * vec4(inPosition, 1.0);
-    fragPos = worldPos.xyz;
-    
-    fragNormal = normalize((ubo.normalMatrix * vec4(inNormal, 0.0)).xyz);
-    fragTangent = normalize((ubo.normalMatrix * vec4(inTangent, 0.0)).xyz);
-    fragBitangent = normalize(cross(fragNormal, fragTangent));
-    
-    fragTexCoord = vec2(inTexCoord.x, 1.0 - inTexCoord.y);
-    fragCameraPos = ubo.cameraPos;
-    
-    gl_Position = ubo.proj * ubo.view * worldPos;
-}
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    vec3 cameraPos;
+} ubo;
+
+struct ObjectData {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 boundingSphere;
+    uvec4 drawInfo;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// Objects that survived culling, written by scene_cull.comp.
+layout(std430, set = 1, binding = 1) readonly buffer VisibleBuffer {
+    uint visibleObjects[];
+};
+
+// Decodes PackedVertex: positions arrive as unorm within the mesh bounds (the
+// bounds transform is folded into the model matrix) with the bitangent sign in
+// w, normal and tangent octahedral in xy.
+layout(constant_id = 0) const bool PACKED_VERTEX = false;
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inTangent;
+
+layout(location = 0) out vec3 fragPos;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec2 fragTexCoord;
+layout(location = 3) out vec3 fragTangent;
+layout(location = 4) out vec3 fragBitangent;
+layout(location = 5) out vec3 fragCameraPos;
+
+// The depth pre-pass and the main pass must produce bit-identical depth for
+// the eEqual test.
+invariant gl_Position;
+
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (direction.z < 0.0) {
+        direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(direction);
+}
+
+void main() {
+    ObjectData object = objectBuffer.objects[visibleObjects[gl_InstanceIndex]];
+
+    vec3 normal = PACKED_VERTEX ? decodeOctahedral(inNormal.xy) : inNormal;
+    vec3 tangent = PACKED_VERTEX ? decodeOctahedral(inTangent.xy) : inTangent;
+    float bitangentSign = PACKED_VERTEX && inPosition.w < 0.5 ? -1.0 : 1.0;
+
+    vec4 worldPos = object.model * vec4(inPosition.xyz, 1.0);
+    fragPos = worldPos.xyz;
+    
+    fragNormal = normalize((object.normalMatrix * vec4(normal, 0.0)).xyz);
+    fragTangent = normalize((object.normalMatrix * vec4(tangent, 0.0)).xyz);
+    fragBitangent = normalize(cross(fragNormal, fragTangent)) * bitangentSign;
+    
+    fragTexCoord = vec2(inTexCoord.x, 1.0 - inTexCoord.y);
+    fragCameraPos = ubo.cameraPos;
+    
+    gl_Position = ubo.proj * ubo.view * worldPos;
+}
@@ -0,0 +1,39 @@
+#version 450
+
+// Depth pre-pass for alpha-tested geometry: only the cutout, no shading.
+// Opaque geometry takes a pipeline without a fragment stage.
+
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Mirrors default.frag; only the texture index is read here.
+struct MaterialRecord {
+    vec3 albedo;
+    float metallic;
+    float roughness;
+    float ao;
+    uint albedoTexture;
+};
+
+layout(std430, set = 4, binding = 0) readonly buffer MaterialBuffer {
+    MaterialRecord materials[];
+};
+
+layout(set = 4, binding = 1) uniform sampler2D textures[];
+
+layout(push_constant) uniform DrawConstants {
+    uint materialIndex;
+} draw;
+
+#define texSampler textures[materials[draw.materialIndex].albedoTexture]
+#else
+layout(binding = 3) uniform sampler2D texSampler;
+#endif
+
+layout(location = 2) in vec2 fragTexCoord;
+
+void main() {
+    if (texture(texSampler, fragTexCoord).a < 0.5) {
+        discard;
+    }
+}
@@ -0,0 +1,129 @@
+#include "model_loader.h"
+#include "legacy_obj_loader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Usage: ObjLoaderBenchmark [model.obj] [iterations]
+// Without a model path a grid of 2 * 1500 * 1500 triangles is generated.
+
+namespace {
+
+bool writeGridOBJ(const std::string& filename, int resolution) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::vector<char> buffer(1 << 20);
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+    char line[128];
+    for (int y = 0; y <= resolution; y++) {
+        for (int x = 0; x <= resolution; x++) {
+            float u = static_cast<float>(x) / resolution;
+            float v = static_cast<float>(y) / resolution;
+            int n = std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0 1 0\n",
+                u * 10.0f - 5.0f, 0.25f * (u * u - v), v * 10.0f - 5.0f, u, v);
+            file.write(line, n);
+        }
+    }
+
+    int row = resolution + 1;
+    for (int y = 0; y < resolution; y++) {
+        for (int x = 0; x < resolution; x++) {
+            int a = y * row + x + 1;
+            int b = a + 1;
+            int c = a + row + 1;
+            int d = a + row;
+            int n = std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                a, a, a, d, d, d, c, c, c, b, b, b);
+            file.write(line, n);
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+template <typename Loader>
+double measure(const char* name, Loader loader, const std::string& filename, int iterations,
+    std::vector<Vertex>& result, size_t& index_count) {
+    std::vector<double> timings;
+
+    for (int i = 0; i < iterations; i++) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        auto start = std::chrono::steady_clock::now();
+        if (!loader(filename, vertices, indices)) {
+            std::cerr << name << ": failed to load " << filename << std::endl;
+            return -1.0;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        timings.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        result = std::move(vertices);
+        index_count = indices.size();
+    }
+
+    std::sort(timings.begin(), timings.end());
+    std::printf("%-8s min %9.1f ms  median %9.1f ms  (%zu vertices, %zu triangles)\n",
+        name, timings.front(), timings[timings.size() / 2], result.size(), index_count / 3);
+    return timings.front();
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (!Logger::getInstance().init("ObjLoaderBenchmark", "logs/ObjLoaderBenchmark.log", LogLevel::WARN)) {
+        std::cerr << "Failed to initialize logger" << std::endl;
+        return -1;
+    }
+
+    std::string filename = argc > 1 ? argv[1] : "benchmark_grid.obj";
+    int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+
+    if (argc <= 1) {
+        std::printf("Generating %s...\n", filename.c_str());
+        if (!writeGridOBJ(filename, 1500)) {
+            std::cerr << "Failed to write " << filename << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<Vertex> legacy_vertices, vertices;
+    size_t legacy_indices = 0, indices = 0;
+
+    double legacy_ms = measure("legacy", LegacyObjLoader::loadOBJ, filename, iterations, legacy_vertices, legacy_indices);
+    // Without a job system the chunks and post-processing ranges get a thread each.
+    auto chunked_loader = [](const std::string& path, std::vector<Vertex>& result, std::vector<uint32_t>& result_indices) {
+        return ModelLoader::loadOBJ(path, result, result_indices);
+    };
+    double chunked_ms = measure("chunked", chunked_loader, filename, iterations, vertices, indices);
+
+    if (legacy_ms < 0.0 || chunked_ms < 0.0) {
+        return -1;
+    }
+
+    if (legacy_vertices.size() != vertices.size() || legacy_indices != indices) {
+        std::printf("warning: loaders disagree on vertex/index counts\n");
+    }
+    else {
+        // Both number vertices in order of first use, so they compare one to one.
+        float position_error = 0.0f, tangent_error = 0.0f;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            position_error = std::max(position_error, glm::length(vertices[i].position - legacy_vertices[i].position));
+            tangent_error = std::max(tangent_error, glm::length(vertices[i].tangent - legacy_vertices[i].tangent));
+        }
+        std::printf("max deviation  position %g  tangent %g\n", position_error, tangent_error);
+    }
+
+    std::printf("speedup  %.2fx\n", legacy_ms / chunked_ms);
+
+    Logger::getInstance().shutdown();
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "vulkan_renderer.h"
+#include "camera_path.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Usage: RenderBenchmark [--model model.obj] [--texture albedo.png] [--camera-path path.txt]
+//                        [--frames 1000] [--warmup 100] [--size 1280x720] [--headless]
+//                        [--output benchmark_results.json] [--no-vulkan13]
+// Without a camera path the camera orbits the origin once over the measured
+// frames. Path time advances by a fixed step per frame, never by wall-clock
+// time, so every run renders the same sequence of views. Vsync is off; the
+// results are written as JSON to the output file and to stdout.
+
+namespace {
+
+struct Options {
+    std::string model = MODEL_DIR "Chair/Chair.obj";
+    std::string texture = MODEL_DIR "Chair/Texture/Chair/Chair_Base_color.png";
+    std::string camera_path;
+    std::string output = "benchmark_results.json";
+    uint32_t frames = 1000;
+    uint32_t warmup = 100;
+    int width = 1280;
+    int height = 720;
+    bool headless = false;
+    bool vulkan13_path = true;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (argument == "--headless") {
+            options.headless = true;
+        }
+        else if (argument == "--no-vulkan13") {
+            options.vulkan13_path = false;
+        }
+        else if (argument == "--model" && has_value) {
+            options.model = argv[++i];
+        }
+        else if (argument == "--texture" && has_value) {
+            options.texture = argv[++i];
+        }
+        else if (argument == "--camera-path" && has_value) {
+            options.camera_path = argv[++i];
+        }
+        else if (argument == "--output" && has_value) {
+            options.output = argv[++i];
+        }
+        else if (argument == "--frames" && has_value) {
+            options.frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (argument == "--warmup" && has_value) {
+            options.warmup = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (argument == "--size" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0) {
+                std::cerr << "Invalid size: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Unknown or incomplete option: " << argument << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Percentiles {
+    size_t samples = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Nearest-rank percentiles.
+Percentiles computePercentiles(std::vector<double> values) {
+    Percentiles result;
+    if (values.empty()) return result;
+
+    std::sort(values.begin(), values.end());
+    auto rank = [&values](double percentile) {
+        size_t index = static_cast<size_t>(std::ceil(percentile / 100.0 * values.size()));
+        return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+    };
+
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+
+    result.samples = values.size();
+    result.mean = sum / values.size();
+    result.p50 = rank(50.0);
+    result.p95 = rank(95.0);
+    result.p99 = rank(99.0);
+    result.max = values.back();
+    return result;
+}
+
+uint64_t getPeakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+}
+
+std::string escapeJson(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+void writePercentiles(std::ostream& out, const char* name, const Percentiles& values, bool available) {
+    out << "  \"" << name << "\": ";
+    if (!available || values.samples == 0) {
+        out << "null,\n";
+        return;
+    }
+    out << "{ \"samples\": " << values.samples << ", \"mean\": " << values.mean << ", \"p50\": " << values.p50 <<
+        ", \"p95\": " << values.p95 << ", \"p99\": " << values.p99 << ", \"max\": " << values.max << " },\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return -1;
+    }
+
+    if (!Logger::getInstance().init("RenderBenchmark", "logs/RenderBenchmark.log", LogLevel::WARN)) {
+        std::cerr << "Failed to initialize logger" << std::endl;
+        return -1;
+    }
+
+    std::vector<double> cpu_frame_ms;
+    std::vector<double> gpu_frame_ms;
+    double load_ms = 0.0;
+    bool gpu_available = false;
+    bool dynamic_rendering = false;
+    bool push_descriptors = false;
+    uint64_t peak_device_local = 0;
+    uint64_t peak_host_visible = 0;
+    LoadTimings load_timings;
+
+    try {
+        VulkanRenderer renderer;
+        renderer.setVsyncEnabled(false);
+        renderer.setVulkan13PathEnabled(options.vulkan13_path);
+
+        auto load_start = std::chrono::steady_clock::now();
+        bool initialized = options.headless ? renderer.initializeHeadless(options.width, options.height) :
+            renderer.initialize(options.width, options.height, "Render Benchmark");
+        if (!initialized) {
+            std::cerr << "Failed to initialize renderer" << std::endl;
+            return -1;
+        }
+
+        auto model = renderer.requestModel(options.model);
+        auto texture = renderer.requestTexture(options.texture);
+        auto skybox = renderer.requestDefaultSkyBox();
+        renderer.finishPendingLoads();
+        if (!model.get() || !texture.get() || !skybox.get()) {
+            std::cerr << "Failed to load the benchmark scene" << std::endl;
+            return -1;
+        }
+        load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+        load_timings = renderer.getLoadTimings();
+
+        CameraPath path;
+        if (options.camera_path.empty()) {
+            path = CameraPath::orbit(glm::vec3(0.0f, 0.5f, 0.0f), 4.0f, 1.5f, 1.0f);
+        }
+        else if (!path.load(options.camera_path)) {
+            std::cerr << "Failed to load camera path " << options.camera_path << std::endl;
+            return -1;
+        }
+
+        // Each callback closes the previous frame: its CPU time is the time
+        // between callbacks, so the last measured frame has no CPU sample.
+        // GPU results lag by the frames in flight and are only sampled when
+        // the profiler has published a frame not seen yet.
+        uint32_t total_frames = options.warmup + options.frames;
+        auto previous_time = std::chrono::steady_clock::now();
+        uint64_t last_gpu_frame_id = 0;
+        auto before_frame = [&](uint32_t frame, Camera& camera) {
+            auto now = std::chrono::steady_clock::now();
+            if (frame > options.warmup) {
+                cpu_frame_ms.push_back(std::chrono::duration<double, std::milli>(now - previous_time).count());
+
+                const GpuProfiler& gpu_profiler = renderer.getGpuProfiler();
+                const auto& scopes = gpu_profiler.getScopes();
+                if (gpu_profiler.getResultFrameId() > last_gpu_frame_id && !scopes.empty() &&
+                    scopes.front().depth == 0) {
+                    gpu_frame_ms.push_back(scopes.front().milliseconds);
+                }
+            }
+            last_gpu_frame_id = renderer.getGpuProfiler().getResultFrameId();
+            previous_time = now;
+
+            uint32_t measured = frame < options.warmup ? 0 : frame - options.warmup;
+            path.apply(path.getDuration() * measured / options.frames, camera);
+        };
+
+        bool completed = options.headless ?
+            renderer.renderOffscreen(total_frames, "", FrameReadback::OutputFormat::Raw, before_frame) >= 0.0 :
+            renderer.renderFrames(total_frames, before_frame);
+
+        if (!completed) {
+            std::cerr << "Benchmark interrupted" << std::endl;
+            return -1;
+        }
+
+        gpu_available = renderer.getGpuProfiler().isAvailable();
+        dynamic_rendering = renderer.getContext().supportsDynamicRendering();
+        push_descriptors = renderer.getContext().supportsPushDescriptors();
+        for (const auto& heap : renderer.getContext().getAllocator().getHeapStatistics()) {
+            (heap.device_local ? peak_device_local : peak_host_visible) += heap.peak_used_bytes;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        Logger::getInstance().shutdown();
+        return -1;
+    }
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"frames\": " << options.frames << ",\n";
+    json << "  \"warmup_frames\": " << options.warmup << ",\n";
+    json << "  \"width\": " << options.width << ",\n";
+    json << "  \"height\": " << options.height << ",\n";
+    json << "  \"headless\": " << (options.headless ? "true" : "false") << ",\n";
+    json << "  \"dynamic_rendering\": " << (dynamic_rendering ? "true" : "false") << ",\n";
+    json << "  \"push_descriptors\": " << (push_descriptors ? "true" : "false") << ",\n";
+    json << "  \"model\": \"" << escapeJson(options.model) << "\",\n";
+    json << "  \"camera_path\": \"" << escapeJson(options.camera_path.empty() ? "orbit" : options.camera_path) << "\",\n";
+    writePercentiles(json, "cpu_frame_ms", computePercentiles(cpu_frame_ms), true);
+    writePercentiles(json, "gpu_frame_ms", computePercentiles(gpu_frame_ms), gpu_available);
+    json << "  \"load_ms\": { \"total\": " << load_ms << ", \"parse\": " << load_timings.parse_ms <<
+        ", \"decode\": " << load_timings.decode_ms << ", \"upload\": " << load_timings.upload_ms <<
+        ", \"pipeline_build\": " << load_timings.pipeline_ms << " },\n";
+    json << "  \"memory\": { \"peak_resident_bytes\": " << getPeakResidentBytes() <<
+        ", \"peak_device_local_bytes\": " << peak_device_local <<
+        ", \"peak_host_visible_bytes\": " << peak_host_visible << " }\n";
+    json << "}\n";
+
+    std::cout << json.str();
+
+    std::ofstream file(options.output, std::ios::trunc);
+    if (!file.is_open() || !(file << json.str())) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        Logger::getInstance().shutdown();
+        return -1;
+    }
+
+    Logger::getInstance().shutdown();
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "bindless_table.h"
+#include "utils/logger.h"
+#include <array>
+#include <cstring>
+
+BindlessTable::BindlessTable(vk::Device device, GpuAllocator& allocator)
+    : device_(device), allocator_(allocator), max_textures_(0), max_materials_(0),
+    texture_count_(0), material_count_(0) {
+}
+
+BindlessTable::~BindlessTable() {
+    cleanup();
+}
+
+bool BindlessTable::initialize(uint32_t max_textures, uint32_t max_materials) {
+    max_textures_ = max_textures;
+    max_materials_ = max_materials;
+
+    if (!allocator_.createBuffer(sizeof(BindlessMaterial) * max_materials_, vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        material_buffer_, material_buffer_allocation_)) {
+        LOGE("Failed to create bindless material buffer");
+        return false;
+    }
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorCount = 1;
+    bindings[0].descriptorType = vk::DescriptorType::eStorageBuffer;
+    bindings[0].stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorCount = max_textures_;
+    bindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+    std::array<vk::DescriptorBindingFlagsEXT, 2> binding_flags = {
+        vk::DescriptorBindingFlagsEXT{},
+        vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind | vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending |
+            vk::DescriptorBindingFlagBitsEXT::ePartiallyBound
+    };
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info{};
+    binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+    binding_flags_info.pBindingFlags = binding_flags.data();
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = vk::DescriptorType::eStorageBuffer;
+    pool_sizes[0].descriptorCount = 1;
+    pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
+    pool_sizes[1].descriptorCount = max_textures_;
+
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = 1;
+
+    try {
+        descriptor_set_layout_ = device_.createDescriptorSetLayout(layout_info);
+        descriptor_pool_ = device_.createDescriptorPool(pool_info);
+
+        vk::DescriptorSetAllocateInfo alloc_info{};
+        alloc_info.descriptorPool = descriptor_pool_;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &descriptor_set_layout_;
+        descriptor_set_ = device_.allocateDescriptorSets(alloc_info)[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create bindless descriptor set: {}", e.what());
+        return false;
+    }
+
+    vk::DescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = material_buffer_;
+    buffer_info.offset = 0;
+    buffer_info.range = VK_WHOLE_SIZE;
+
+    vk::WriteDescriptorSet material_write{};
+    material_write.dstSet = descriptor_set_;
+    material_write.dstBinding = 0;
+    material_write.dstArrayElement = 0;
+    material_write.descriptorType = vk::DescriptorType::eStorageBuffer;
+    material_write.descriptorCount = 1;
+    material_write.pBufferInfo = &buffer_info;
+    device_.updateDescriptorSets(1, &material_write, 0, nullptr);
+
+    LOGI("Bindless table created: {} textures, {} materials", max_textures_, max_materials_);
+    return true;
+}
+
+void BindlessTable::cleanup() {
+    if (descriptor_pool_) {
+        device_.destroyDescriptorPool(descriptor_pool_);
+        descriptor_pool_ = nullptr;
+        descriptor_set_ = nullptr;
+    }
+
+    if (descriptor_set_layout_) {
+        device_.destroyDescriptorSetLayout(descriptor_set_layout_);
+        descriptor_set_layout_ = nullptr;
+    }
+
+    if (material_buffer_) {
+        allocator_.destroyBuffer(material_buffer_, material_buffer_allocation_);
+        material_buffer_ = nullptr;
+    }
+}
+
+uint32_t BindlessTable::allocateSlot(std::vector<uint32_t>& free_slots, uint32_t& slot_count, uint32_t max_slots) {
+    if (!free_slots.empty()) {
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
+    }
+
+    if (slot_count >= max_slots) {
+        return INVALID_INDEX;
+    }
+    return slot_count++;
+}
+
+uint32_t BindlessTable::addTexture(vk::ImageView view, vk::Sampler sampler) {
+    uint32_t index = allocateSlot(free_textures_, texture_count_, max_textures_);
+    if (index == INVALID_INDEX) {
+        LOGE("Bindless texture table full ({} textures)", max_textures_);
+        return INVALID_INDEX;
+    }
+
+    vk::DescriptorImageInfo image_info{};
+    image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    image_info.imageView = view;
+    image_info.sampler = sampler;
+
+    vk::WriteDescriptorSet texture_write{};
+    texture_write.dstSet = descriptor_set_;
+    texture_write.dstBinding = 1;
+    texture_write.dstArrayElement = index;
+    texture_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    texture_write.descriptorCount = 1;
+    texture_write.pImageInfo = &image_info;
+    device_.updateDescriptorSets(1, &texture_write, 0, nullptr);
+
+    return index;
+}
+
+void BindlessTable::releaseTexture(uint32_t index) {
+    // The descriptor stays as it is; partially bound slots need not be valid.
+    if (index < texture_count_) {
+        free_textures_.push_back(index);
+    }
+}
+
+uint32_t BindlessTable::addMaterial(const BindlessMaterial& material) {
+    uint32_t index = allocateSlot(free_materials_, material_count_, max_materials_);
+    if (index == INVALID_INDEX) {
+        LOGE("Bindless material table full ({} materials)", max_materials_);
+        return INVALID_INDEX;
+    }
+
+    updateMaterial(index, material);
+    return index;
+}
+
+void BindlessTable::updateMaterial(uint32_t index, const BindlessMaterial& material) {
+    if (index >= material_count_) return;
+
+    auto* records = static_cast<BindlessMaterial*>(material_buffer_allocation_.mapped);
+    memcpy(&records[index], &material, sizeof(BindlessMaterial));
+}
+
+void BindlessTable::releaseMaterial(uint32_t index) {
+    if (index < material_count_) {
+        free_materials_.push_back(index);
+    }
+}
+
+void BindlessTable::bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t set) const {
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, set, 1, &descriptor_set_, 0, nullptr);
+}
+
+vk::PushConstantRange BindlessTable::getPushConstantRange() const {
+    vk::PushConstantRange range{};
+    range.stageFlags = vk::ShaderStageFlagBits::eFragment;
+    range.offset = 0;
+    range.size = sizeof(DrawPushConstants);
+    return range;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include "uniform_buffer.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+// Push constant of draws on the bindless path: which material record to use.
+struct DrawPushConstants {
+    uint32_t material_index;
+};
+
+// One global descriptor set for VK_EXT_descriptor_indexing devices: an array of
+// every sampled texture and a storage buffer of every material record. It is
+// bound once per pass and draws pick their material through a push constant,
+// so switching materials costs no descriptor binds. The texture array is
+// update-after-bind and partially bound: slots can be filled while command
+// buffers using the set are recording or pending, as long as those do not
+// read them.
+class BindlessTable {
+public:
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+    // Set index the shaders declare the table at, after the per-pass sets.
+    static constexpr uint32_t DESCRIPTOR_SET = 4;
+
+    BindlessTable(vk::Device device, GpuAllocator& allocator);
+    ~BindlessTable();
+
+    bool initialize(uint32_t max_textures, uint32_t max_materials);
+    void cleanup();
+
+    // Returns INVALID_INDEX when the table is full. Released slots are reused,
+    // so the caller must make sure no frame in flight still reads them.
+    uint32_t addTexture(vk::ImageView view, vk::Sampler sampler);
+    void releaseTexture(uint32_t index);
+
+    uint32_t addMaterial(const BindlessMaterial& material);
+    void updateMaterial(uint32_t index, const BindlessMaterial& material);
+    void releaseMaterial(uint32_t index);
+
+    void bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t set) const;
+
+    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
+    vk::PushConstantRange getPushConstantRange() const;
+
+private:
+    static uint32_t allocateSlot(std::vector<uint32_t>& free_slots, uint32_t& slot_count, uint32_t max_slots);
+
+    vk::Device device_;
+    GpuAllocator& allocator_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    vk::DescriptorSet descriptor_set_;
+
+    vk::Buffer material_buffer_;
+    GpuAllocation material_buffer_allocation_;
+
+    uint32_t max_textures_;
+    uint32_t max_materials_;
+    uint32_t texture_count_;  // high-water marks, below them slots come from the free lists
+    uint32_t material_count_;
+    std::vector<uint32_t> free_textures_;
+    std::vector<uint32_t> free_materials_;
+};
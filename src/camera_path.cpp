@@ -0,0 +1,111 @@
+#include "camera_path.h"
+#include "utils/logger.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool CameraPath::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        LOGE("Failed to open camera path: {}", filename);
+        return false;
+    }
+
+    keyframes_.clear();
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream stream(line);
+        Keyframe keyframe{};
+        if (!(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >>
+            keyframe.yaw >> keyframe.pitch)) {
+            LOGE("Malformed camera path keyframe at {}:{}", filename, line_number);
+            return false;
+        }
+
+        if (!keyframes_.empty() && keyframe.time < keyframes_.back().time) {
+            LOGE("Camera path keyframes out of order at {}:{}", filename, line_number);
+            return false;
+        }
+        keyframes_.push_back(keyframe);
+    }
+
+    LOGI("Camera path loaded: {} ({} keyframes, {:.2f} s)", filename, keyframes_.size(), getDuration());
+    return !keyframes_.empty();
+}
+
+bool CameraPath::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        LOGE("Failed to write camera path: {}", filename);
+        return false;
+    }
+
+    file << "# time x y z yaw pitch\n";
+    for (const Keyframe& keyframe : keyframes_) {
+        file << keyframe.time << ' ' << keyframe.position.x << ' ' << keyframe.position.y << ' ' <<
+            keyframe.position.z << ' ' << keyframe.yaw << ' ' << keyframe.pitch << '\n';
+    }
+
+    LOGI("Camera path saved: {} ({} keyframes)", filename, keyframes_.size());
+    return static_cast<bool>(file);
+}
+
+void CameraPath::addKeyframe(const Keyframe& keyframe) {
+    keyframes_.push_back(keyframe);
+}
+
+void CameraPath::record(float time, const Camera& camera) {
+    addKeyframe({ time, camera.getPosition(), camera.getYaw(), camera.getPitch() });
+}
+
+void CameraPath::apply(float time, Camera& camera) const {
+    if (keyframes_.empty()) return;
+
+    auto next = std::upper_bound(keyframes_.begin(), keyframes_.end(), time,
+        [](float value, const Keyframe& keyframe) { return value < keyframe.time; });
+
+    if (next == keyframes_.begin()) {
+        camera.setPose(next->position, next->yaw, next->pitch);
+        return;
+    }
+    if (next == keyframes_.end()) {
+        const Keyframe& last = keyframes_.back();
+        camera.setPose(last.position, last.yaw, last.pitch);
+        return;
+    }
+
+    const Keyframe& a = *(next - 1);
+    const Keyframe& b = *next;
+    float span = b.time - a.time;
+    float t = span > 0.0f ? (time - a.time) / span : 1.0f;
+
+    // Recorded yaw is unwrapped, so a plain lerp turns the short way.
+    camera.setPose(glm::mix(a.position, b.position, t), a.yaw + (b.yaw - a.yaw) * t, a.pitch + (b.pitch - a.pitch) * t);
+}
+
+CameraPath CameraPath::orbit(const glm::vec3& center, float radius, float height, float duration) {
+    CameraPath path;
+    float pitch = -glm::degrees(std::atan2(height, radius));
+
+    for (int i = 0; i <= ORBIT_SEGMENTS; i++) {
+        float fraction = static_cast<float>(i) / ORBIT_SEGMENTS;
+        float angle = glm::two_pi<float>() * fraction;
+
+        Keyframe keyframe{};
+        keyframe.time = duration * fraction;
+        keyframe.position = center + glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+        // Facing back at the center: the camera's front is (cos yaw, sin yaw) in xz.
+        keyframe.yaw = glm::degrees(angle) + 180.0f;
+        keyframe.pitch = pitch;
+        path.addKeyframe(keyframe);
+    }
+
+    return path;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "camera.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Timed camera poses, recorded from an interactive session or generated, and
+// replayed by benchmarks so that every run renders the same views. Stored as
+// text, one "time x y z yaw pitch" line per keyframe.
+class CameraPath {
+public:
+    struct Keyframe {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    bool load(const std::string& filename);
+    bool save(const std::string& filename) const;
+
+    // Keyframes must be added in time order.
+    void addKeyframe(const Keyframe& keyframe);
+    void record(float time, const Camera& camera);
+    void clear() { keyframes_.clear(); }
+
+    // Interpolates linearly between keyframes and holds the ends.
+    void apply(float time, Camera& camera) const;
+
+    // One turn around center, looking at it, sampled every few degrees.
+    static CameraPath orbit(const glm::vec3& center, float radius, float height, float duration);
+
+    bool empty() const { return keyframes_.empty(); }
+    size_t getKeyframeCount() const { return keyframes_.size(); }
+    float getDuration() const { return keyframes_.empty() ? 0.0f : keyframes_.back().time; }
+
+private:
+    std::vector<Keyframe> keyframes_;
+
+    static constexpr int ORBIT_SEGMENTS = 72;
+};
@@ -0,0 +1,382 @@
+#include "depth_pyramid.h"
+#include "vulkan_context.h"
+#include "shader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+constexpr uint32_t BUILD_GROUP_SIZE = 8;
+
+struct PyramidBuildPushConstants {
+    int32_t source_size[2];
+    int32_t destination_size[2];
+};
+
+}
+
+DepthPyramid::DepthPyramid(std::shared_ptr<VulkanContext> context)
+    : context_(context), mip_levels_(0) {
+}
+
+DepthPyramid::~DepthPyramid() {
+    cleanup();
+}
+
+bool DepthPyramid::initialize() {
+    if (!createDescriptorSetLayout() || !createSampler()) {
+        LOGE("Failed to create depth pyramid descriptors");
+        return false;
+    }
+
+    if (!createPipeline()) {
+        LOGE("Failed to create depth pyramid pipeline");
+        return false;
+    }
+
+    return true;
+}
+
+void DepthPyramid::cleanup() {
+    if (!context_) return;
+    auto device = context_->getDevice();
+
+    destroyImage();
+
+    if (pipeline_) device.destroyPipeline(pipeline_);
+    if (pipeline_layout_) device.destroyPipelineLayout(pipeline_layout_);
+    if (descriptor_set_layout_) device.destroyDescriptorSetLayout(descriptor_set_layout_);
+    if (sampler_) device.destroySampler(sampler_);
+    pipeline_ = nullptr;
+    pipeline_layout_ = nullptr;
+    descriptor_set_layout_ = nullptr;
+    sampler_ = nullptr;
+}
+
+bool DepthPyramid::create(vk::ImageView depth_view, vk::Extent2D depth_extent) {
+    destroyImage();
+
+    depth_extent_ = depth_extent;
+    extent_ = vk::Extent2D{ std::max(depth_extent.width / 2, 1u), std::max(depth_extent.height / 2, 1u) };
+
+    mip_levels_ = 1;
+    while ((std::max(extent_.width, extent_.height) >> mip_levels_) > 0) {
+        mip_levels_++;
+    }
+
+    if (!createImage() || !createDescriptorSets(depth_view) || !clearImage()) {
+        LOGE("Failed to create depth pyramid");
+        return false;
+    }
+
+    LOGI("Depth pyramid created: {}x{}, {} mip levels", extent_.width, extent_.height, mip_levels_);
+    return true;
+}
+
+void DepthPyramid::recordBuild(vk::CommandBuffer command_buffer) {
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eGeneral;
+    barrier.newLayout = vk::ImageLayout::eGeneral;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image_;
+    barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_);
+
+    vk::Extent2D source_extent = depth_extent_;
+    for (uint32_t level = 0; level < mip_levels_; level++) {
+        vk::Extent2D level_extent{ std::max(extent_.width >> level, 1u), std::max(extent_.height >> level, 1u) };
+
+        PyramidBuildPushConstants push_constants{};
+        push_constants.source_size[0] = static_cast<int32_t>(source_extent.width);
+        push_constants.source_size[1] = static_cast<int32_t>(source_extent.height);
+        push_constants.destination_size[0] = static_cast<int32_t>(level_extent.width);
+        push_constants.destination_size[1] = static_cast<int32_t>(level_extent.height);
+
+        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_,
+            0, 1, &descriptor_sets_[level], 0, nullptr);
+        command_buffer.pushConstants(pipeline_layout_, vk::ShaderStageFlagBits::eCompute,
+            0, sizeof(push_constants), &push_constants);
+        command_buffer.dispatch((level_extent.width + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE,
+            (level_extent.height + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE, 1);
+
+        // The next level reads this one; the caller covers the last level.
+        if (level + 1 < mip_levels_) {
+            barrier.subresourceRange.baseMipLevel = level;
+            command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+
+        source_extent = level_extent;
+    }
+}
+
+bool DepthPyramid::createDescriptorSetLayout() {
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorCount = 1;
+    bindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    bindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorCount = 1;
+    bindings[1].descriptorType = vk::DescriptorType::eStorageImage;
+    bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    try {
+        descriptor_set_layout_ = context_->getDevice().createDescriptorSetLayout(layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create depth pyramid descriptor set layout: {}", e.what());
+        return false;
+    }
+}
+
+bool DepthPyramid::createSampler() {
+    // Texels are fetched individually; filtering would mix depths and break
+    // the conservative farthest-depth reduction.
+    vk::SamplerCreateInfo sampler_info{};
+    sampler_info.magFilter = vk::Filter::eNearest;
+    sampler_info.minFilter = vk::Filter::eNearest;
+    sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.anisotropyEnable = VK_FALSE;
+    sampler_info.borderColor = vk::BorderColor::eFloatOpaqueWhite;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.compareOp = vk::CompareOp::eAlways;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+    try {
+        sampler_ = context_->getDevice().createSampler(sampler_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create depth pyramid sampler: {}", e.what());
+        return false;
+    }
+}
+
+bool DepthPyramid::createPipeline() {
+    auto device = context_->getDevice();
+
+    Shader shader(context_);
+    if (!shader.loadComputeFromFile(SHADER_DIR "depth_pyramid.comp")) {
+        LOGE("Failed to load depth pyramid shader");
+        return false;
+    }
+
+    vk::PushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PyramidBuildPushConstants);
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &descriptor_set_layout_;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    try {
+        pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create depth pyramid pipeline layout: {}", e.what());
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipeline_info.stage.module = shader.getComputeShader();
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = pipeline_layout_;
+
+    try {
+        pipeline_ = device.createComputePipeline(context_->getPipelineCache(), pipeline_info).value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create depth pyramid pipeline: {}", e.what());
+        return false;
+    }
+}
+
+bool DepthPyramid::createImage() {
+    auto device = context_->getDevice();
+
+    vk::ImageCreateInfo image_info{};
+    image_info.imageType = vk::ImageType::e2D;
+    image_info.extent = vk::Extent3D{ extent_.width, extent_.height, 1 };
+    image_info.mipLevels = mip_levels_;
+    image_info.arrayLayers = 1;
+    image_info.format = PYRAMID_FORMAT;
+    image_info.tiling = vk::ImageTiling::eOptimal;
+    image_info.initialLayout = vk::ImageLayout::eUndefined;
+    image_info.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled |
+        vk::ImageUsageFlagBits::eTransferDst;
+    image_info.samples = vk::SampleCountFlagBits::e1;
+    image_info.sharingMode = vk::SharingMode::eExclusive;
+
+    if (!context_->getAllocator().createImage(image_info, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        image_, image_allocation_)) {
+        LOGE("Failed to create depth pyramid image");
+        return false;
+    }
+
+    vk::ImageViewCreateInfo view_info{};
+    view_info.image = image_;
+    view_info.viewType = vk::ImageViewType::e2D;
+    view_info.format = PYRAMID_FORMAT;
+    view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, mip_levels_, 0, 1 };
+
+    try {
+        view_ = device.createImageView(view_info);
+
+        view_info.subresourceRange.levelCount = 1;
+        for (uint32_t level = 0; level < mip_levels_; level++) {
+            view_info.subresourceRange.baseMipLevel = level;
+            mip_views_.push_back(device.createImageView(view_info));
+        }
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create depth pyramid image view: {}", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool DepthPyramid::createDescriptorSets(vk::ImageView depth_view) {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = vk::DescriptorType::eCombinedImageSampler;
+    pool_sizes[0].descriptorCount = mip_levels_;
+    pool_sizes[1].type = vk::DescriptorType::eStorageImage;
+    pool_sizes[1].descriptorCount = mip_levels_;
+
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = mip_levels_;
+
+    std::vector<vk::DescriptorSetLayout> layouts(mip_levels_, descriptor_set_layout_);
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorSetCount = mip_levels_;
+    alloc_info.pSetLayouts = layouts.data();
+
+    try {
+        descriptor_pool_ = device.createDescriptorPool(pool_info);
+        alloc_info.descriptorPool = descriptor_pool_;
+        descriptor_sets_ = device.allocateDescriptorSets(alloc_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate depth pyramid descriptor sets: {}", e.what());
+        return false;
+    }
+
+    std::vector<vk::DescriptorImageInfo> source_infos(mip_levels_);
+    std::vector<vk::DescriptorImageInfo> destination_infos(mip_levels_);
+    std::vector<vk::WriteDescriptorSet> descriptor_writes;
+    descriptor_writes.reserve(mip_levels_ * 2);
+
+    for (uint32_t level = 0; level < mip_levels_; level++) {
+        source_infos[level].sampler = sampler_;
+        source_infos[level].imageView = level == 0 ? depth_view : mip_views_[level - 1];
+        source_infos[level].imageLayout = level == 0
+            ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eGeneral;
+
+        destination_infos[level].imageView = mip_views_[level];
+        destination_infos[level].imageLayout = vk::ImageLayout::eGeneral;
+
+        descriptor_writes.emplace_back();
+        auto& source_write = descriptor_writes.back();
+        source_write.dstSet = descriptor_sets_[level];
+        source_write.dstBinding = 0;
+        source_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        source_write.descriptorCount = 1;
+        source_write.pImageInfo = &source_infos[level];
+
+        descriptor_writes.emplace_back();
+        auto& destination_write = descriptor_writes.back();
+        destination_write.dstSet = descriptor_sets_[level];
+        destination_write.dstBinding = 1;
+        destination_write.descriptorType = vk::DescriptorType::eStorageImage;
+        destination_write.descriptorCount = 1;
+        destination_write.pImageInfo = &destination_infos[level];
+    }
+
+    device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+    return true;
+}
+
+bool DepthPyramid::clearImage() {
+    try {
+        vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
+
+        vk::ImageMemoryBarrier barrier{};
+        barrier.oldLayout = vk::ImageLayout::eUndefined;
+        barrier.newLayout = vk::ImageLayout::eGeneral;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image_;
+        barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, mip_levels_, 0, 1 };
+        barrier.srcAccessMask = vk::AccessFlags{};
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+            vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vk::ClearColorValue far_depth{ std::array<float, 4>{ 1.0f, 1.0f, 1.0f, 1.0f } };
+        command_buffer.clearColorImage(image_, vk::ImageLayout::eGeneral, &far_depth, 1, &barrier.subresourceRange);
+
+        barrier.oldLayout = vk::ImageLayout::eGeneral;
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        context_->endSingleTimeCommands(command_buffer);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to clear depth pyramid: {}", e.what());
+        return false;
+    }
+}
+
+// Recreation on resize does not wait for the frames still sampling the old
+// pyramid; its objects are retired instead.
+void DepthPyramid::destroyImage() {
+    vk::Device device = context_->getDevice();
+    GpuAllocator* allocator = &context_->getAllocator();
+    context_->retire([device, allocator, pool = descriptor_pool_, mip_views = std::move(mip_views_), view = view_,
+        image = image_, allocation = image_allocation_]() mutable {
+        if (pool) device.destroyDescriptorPool(pool);
+        for (auto mip_view : mip_views) {
+            device.destroyImageView(mip_view);
+        }
+        if (view) device.destroyImageView(view);
+        if (image) allocator->destroyImage(image, allocation);
+    });
+
+    descriptor_pool_ = nullptr;
+    descriptor_sets_.clear();
+    mip_views_.clear();
+    view_ = nullptr;
+    image_ = nullptr;
+    image_allocation_ = {};
+}
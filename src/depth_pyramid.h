@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+class VulkanContext;
+
+// Hierarchical-Z pyramid of the depth buffer for occlusion culling. Mip 0 is
+// half the depth resolution and every texel holds the farthest depth of the
+// texels it covers, so a single fetch at the mip matching an object's screen
+// footprint gives a conservative occluder depth.
+//
+// The pyramid stays in the General layout: it is written as a storage image
+// while building and sampled both by the next mip and by the culling pass.
+class DepthPyramid {
+public:
+    static constexpr vk::Format PYRAMID_FORMAT = vk::Format::eR32Sfloat;
+
+    DepthPyramid(std::shared_ptr<VulkanContext> context);
+    ~DepthPyramid();
+
+    bool initialize();
+    void cleanup();
+
+    // (Re)creates the pyramid for a depth image; call again whenever the depth
+    // image is recreated. The pyramid starts cleared to the far plane, so
+    // nothing is occluded until the first build.
+    bool create(vk::ImageView depth_view, vk::Extent2D depth_extent);
+
+    // Must be recorded outside a render pass, with the depth image in the
+    // DepthStencilReadOnlyOptimal layout and its writes made visible to compute.
+    // The caller orders the build against earlier reads of the pyramid and
+    // makes the finished pyramid visible to later ones; only the dependencies
+    // between mip levels are recorded here.
+    void recordBuild(vk::CommandBuffer command_buffer);
+
+    vk::Image getImage() const { return image_; }
+    vk::ImageView getView() const { return view_; }
+    vk::Sampler getSampler() const { return sampler_; }
+    vk::Extent2D getExtent() const { return extent_; }
+    uint32_t getMipLevels() const { return mip_levels_; }
+
+private:
+    bool createDescriptorSetLayout();
+    bool createSampler();
+    bool createPipeline();
+    bool createImage();
+    bool createDescriptorSets(vk::ImageView depth_view);
+    bool clearImage();
+    void destroyImage();
+
+    std::shared_ptr<VulkanContext> context_;
+
+    vk::Image image_;
+    GpuAllocation image_allocation_;
+    vk::ImageView view_;
+    std::vector<vk::ImageView> mip_views_;
+    vk::Extent2D extent_;
+    vk::Extent2D depth_extent_;
+    uint32_t mip_levels_;
+
+    vk::Sampler sampler_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    std::vector<vk::DescriptorSet> descriptor_sets_; // one per mip level
+
+    vk::PipelineLayout pipeline_layout_;
+    vk::Pipeline pipeline_;
+};
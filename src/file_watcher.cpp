@@ -0,0 +1,39 @@
+#include "file_watcher.h"
+#include <algorithm>
+
+void FileWatcher::watch(const std::string& path) {
+    auto it = std::find_if(files_.begin(), files_.end(),
+        [&path](const WatchedFile& file) { return file.path == path; });
+    if (it != files_.end()) return;
+
+    std::error_code error;
+    WatchedFile file{ path, std::filesystem::last_write_time(path, error) };
+    if (error) {
+        file.write_time = std::filesystem::file_time_type::min();
+    }
+    files_.push_back(file);
+}
+
+void FileWatcher::unwatch(const std::string& path) {
+    files_.erase(std::remove_if(files_.begin(), files_.end(),
+        [&path](const WatchedFile& file) { return file.path == path; }), files_.end());
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_check_) return changed;
+    next_check_ = now + interval_;
+
+    for (WatchedFile& file : files_) {
+        std::error_code error;
+        auto write_time = std::filesystem::last_write_time(file.path, error);
+        if (error || write_time == file.write_time) continue;
+
+        file.write_time = write_time;
+        changed.push_back(file.path);
+    }
+
+    return changed;
+}
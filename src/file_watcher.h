@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Reports files whose modification time changed. poll() is cheap enough to
+// call every frame: the files are only stat'ed once per interval, and a
+// handful of stats cost microseconds. A file that is briefly missing, as
+// while an editor replaces it, keeps its old time and is reported once it
+// reappears with a new one.
+class FileWatcher {
+public:
+    explicit FileWatcher(std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+        : interval_(interval) {}
+
+    void watch(const std::string& path);
+    void unwatch(const std::string& path);
+
+    // Paths modified since the previous check.
+    std::vector<std::string> poll();
+
+private:
+    struct WatchedFile {
+        std::string path;
+        std::filesystem::file_time_type write_time;
+    };
+
+    std::vector<WatchedFile> files_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point next_check_;
+};
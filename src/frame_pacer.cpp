@@ -0,0 +1,116 @@
+#include "frame_pacer.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+#include <GLFW/glfw3.h>
+#include <thread>
+
+FramePacer::FramePacer(std::shared_ptr<VulkanContext> context)
+    : context_(context), wait_for_present_(nullptr), current_(0), next_present_id_(0), last_present_id_(0),
+    refresh_interval_(0), latency_(0.0f) {
+}
+
+bool FramePacer::initialize() {
+    frames_.resize(VulkanContext::MAX_FRAMES_IN_FLIGHT);
+
+    if (context_->supportsPresentWait()) {
+        wait_for_present_ = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            context_->getDevice().getProcAddr("vkWaitForPresentKHR"));
+    }
+
+    int refresh_rate = 60;
+    const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (video_mode && video_mode->refreshRate > 0) {
+        refresh_rate = video_mode->refreshRate;
+    }
+    refresh_interval_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / refresh_rate));
+    next_frame_time_ = Clock::now();
+
+    LOGI("Frame pacer initialized ({}, {} Hz display)",
+        wait_for_present_ ? "present wait" : "frame limiter", refresh_rate);
+    return true;
+}
+
+void FramePacer::waitForDisplay() {
+    if (wait_for_present_) {
+        if (last_present_id_ == 0) return;
+
+        for (PendingFrame& frame : frames_) {
+            if (frame.pending && frame.present_id == last_present_id_) {
+                pollPresent(frame, PRESENT_TIMEOUT_NS);
+                return;
+            }
+        }
+
+        // The frame was already retired; still wait for its present.
+        wait_for_present_(context_->getDevice(), context_->getSwapChain(), last_present_id_, PRESENT_TIMEOUT_NS);
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (next_frame_time_ > now) {
+        std::this_thread::sleep_until(next_frame_time_);
+        now = next_frame_time_;
+    }
+    next_frame_time_ = now + refresh_interval_;
+}
+
+void FramePacer::beginFrame(uint32_t frame_index, Clock::time_point input_time) {
+    current_ = frame_index % frames_.size();
+
+    PendingFrame& frame = frames_[current_];
+    frame.input_time = input_time;
+    frame.present_id = 0;
+    frame.pending = true;
+}
+
+void FramePacer::attachPresentId(vk::PresentInfoKHR& present_info) {
+    if (!wait_for_present_) return;
+
+    PendingFrame& frame = frames_[current_];
+    frame.present_id = ++next_present_id_;
+    last_present_id_ = frame.present_id;
+
+    present_id_info_.swapchainCount = 1;
+    present_id_info_.pPresentIds = &frame.present_id;
+    present_info.pNext = &present_id_info_;
+}
+
+void FramePacer::retireFrame(uint32_t frame_index) {
+    PendingFrame& frame = frames_[frame_index % frames_.size()];
+    if (!frame.pending) return;
+
+    if (!wait_for_present_) {
+        recordLatency(frame);
+        frame.pending = false;
+        return;
+    }
+
+    // The slot is about to be reused; a present still on its way is not
+    // waited for, so this frame gives no sample.
+    if (!pollPresent(frame, 0)) {
+        frame.pending = false;
+    }
+}
+
+void FramePacer::resetSwapChain() {
+    for (PendingFrame& frame : frames_) {
+        frame.pending = false;
+    }
+    last_present_id_ = 0;
+}
+
+bool FramePacer::pollPresent(PendingFrame& frame, uint64_t timeout) {
+    if (frame.present_id == 0) return false;
+
+    VkResult result = wait_for_present_(context_->getDevice(), context_->getSwapChain(), frame.present_id, timeout);
+    if (result != VK_SUCCESS) return false;
+
+    recordLatency(frame);
+    frame.pending = false;
+    return true;
+}
+
+void FramePacer::recordLatency(const PendingFrame& frame) {
+    float milliseconds = std::chrono::duration<float, std::milli>(Clock::now() - frame.input_time).count();
+    latency_ = latency_ == 0.0f ? milliseconds : latency_ + (milliseconds - latency_) * LATENCY_SMOOTHING;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+class VulkanContext;
+
+// Display pacing and input-to-present latency. With VK_KHR_present_wait every
+// present carries an id, and waitForDisplay() blocks until the previous frame
+// is on screen; without it a limiter holds the monitor's refresh rate.
+//
+// Latency runs from the input sample of a frame to the moment its present was
+// observed complete, or, without present wait, to the moment its fence was
+// seen signaled. Both are observed from the CPU, so they are upper bounds.
+class FramePacer {
+public:
+    FramePacer(std::shared_ptr<VulkanContext> context);
+
+    bool initialize();
+
+    // Blocks until the last presented frame is on screen, or until a refresh
+    // interval has passed since the previous call.
+    void waitForDisplay();
+
+    // Called once the frame's input is sampled and before it is presented,
+    // with the present info of that frame; chains the present id if any.
+    void beginFrame(uint32_t frame_index, std::chrono::steady_clock::time_point input_time);
+    void attachPresentId(vk::PresentInfoKHR& present_info);
+
+    // Called right after the fence wait of a frame slot.
+    void retireFrame(uint32_t frame_index);
+
+    // Present ids are per swap chain; ids of the one being replaced never complete.
+    void resetSwapChain();
+
+    bool isPresentTimed() const { return wait_for_present_ != nullptr; }
+    float getLatency() const { return latency_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingFrame {
+        Clock::time_point input_time;
+        uint64_t present_id = 0;
+        bool pending = false;
+    };
+
+    bool pollPresent(PendingFrame& frame, uint64_t timeout);
+    void recordLatency(const PendingFrame& frame);
+
+    std::shared_ptr<VulkanContext> context_;
+    PFN_vkWaitForPresentKHR wait_for_present_;
+
+    std::vector<PendingFrame> frames_;
+    uint32_t current_;
+    uint64_t next_present_id_;
+    uint64_t last_present_id_;
+    vk::PresentIdKHR present_id_info_;
+
+    Clock::duration refresh_interval_;
+    Clock::time_point next_frame_time_;
+    float latency_;
+
+    static constexpr uint64_t PRESENT_TIMEOUT_NS = 100000000; // never stall longer than 100 ms
+    static constexpr float LATENCY_SMOOTHING = 0.1f;
+};
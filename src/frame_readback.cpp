@@ -0,0 +1,177 @@
+#include "frame_readback.h"
+#include "vulkan_context.h"
+#include "job_system.h"
+#include "texture.h"
+#include "utils/logger.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+FrameReadback::FrameReadback(std::shared_ptr<VulkanContext> context, JobSystem& job_system)
+    : context_(context), job_system_(job_system), frame_size_(0), output_format_(OutputFormat::Png),
+    frames_written_(0) {
+}
+
+FrameReadback::~FrameReadback() {
+    cleanup();
+}
+
+bool FrameReadback::initialize(vk::Extent2D extent, vk::Format format) {
+    // Written files are RGBA8, which is what the offscreen targets use.
+    if (format != vk::Format::eR8G8B8A8Srgb && format != vk::Format::eR8G8B8A8Unorm) {
+        LOGE("Frame readback needs an RGBA8 target, got {}", vk::to_string(format));
+        return false;
+    }
+
+    extent_ = extent;
+    frame_size_ = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+    slots_.resize(VulkanContext::MAX_FRAMES_IN_FLIGHT);
+
+    // The host reads every byte back, which is slow from write-combined
+    // memory, so cached memory is preferred where the device has it.
+    GpuAllocator& allocator = context_->getAllocator();
+    vk::MemoryPropertyFlags cached = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached;
+    vk::MemoryPropertyFlags coherent = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+    bool prefer_cached = allocator.hasMemoryType(cached);
+
+    for (Slot& slot : slots_) {
+        bool created = prefer_cached && allocator.createBuffer(frame_size_, vk::BufferUsageFlagBits::eTransferDst,
+            cached, slot.buffer, slot.allocation);
+        if (!created && !allocator.createBuffer(frame_size_, vk::BufferUsageFlagBits::eTransferDst,
+            coherent, slot.buffer, slot.allocation)) {
+            LOGE("Failed to create frame readback buffer");
+            return false;
+        }
+    }
+
+    bool is_cached = static_cast<bool>(allocator.getMemoryProperties(slots_.front().allocation) &
+        vk::MemoryPropertyFlagBits::eHostCached);
+    LOGI("Frame readback created: {} slots of {}x{} in {} memory", slots_.size(), extent.width, extent.height,
+        is_cached ? "cached" : "uncached");
+    return true;
+}
+
+void FrameReadback::cleanup() {
+    flush();
+
+    for (Slot& slot : slots_) {
+        if (slot.buffer) {
+            context_->getAllocator().destroyBuffer(slot.buffer, slot.allocation);
+            slot.buffer = nullptr;
+        }
+    }
+    slots_.clear();
+}
+
+void FrameReadback::setOutput(const std::string& directory, OutputFormat format) {
+    directory_ = directory;
+    output_format_ = format;
+
+    if (!directory_.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        if (error) {
+            LOGW("Failed to create output directory {}: {}", directory_, error.message());
+        }
+    }
+}
+
+void FrameReadback::record(vk::CommandBuffer command_buffer, uint32_t slot, vk::Image image, uint64_t frame_number) {
+    Slot& target = slots_[slot];
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    barrier.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+        vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+
+    vk::BufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+    region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+    region.imageExtent = vk::Extent3D{ extent_.width, extent_.height, 1 };
+
+    command_buffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, target.buffer, region);
+
+    // Makes the copy visible to the host read after the fence wait.
+    vk::BufferMemoryBarrier host_barrier{};
+    host_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    host_barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.buffer = target.buffer;
+    host_barrier.offset = 0;
+    host_barrier.size = VK_WHOLE_SIZE;
+
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+        {}, nullptr, host_barrier, nullptr);
+
+    target.frame_number = frame_number;
+    target.pending = true;
+}
+
+void FrameReadback::collect(uint32_t slot) {
+    Slot& source = slots_[slot];
+    if (!source.pending) return;
+    source.pending = false;
+
+    if (directory_.empty()) return;
+
+    // The buffer is recorded into again right after this, so its contents are
+    // copied out here and only the encode runs on a worker.
+    if (!context_->getAllocator().invalidate(source.allocation)) {
+        LOGW("Skipping readback of frame {}", source.frame_number);
+        return;
+    }
+
+    auto pixels = std::make_shared<std::vector<unsigned char>>(static_cast<size_t>(frame_size_));
+    memcpy(pixels->data(), source.allocation.mapped, static_cast<size_t>(frame_size_));
+
+    while (writes_.size() >= MAX_QUEUED_WRITES) {
+        frames_written_ += writes_.front().get() ? 1 : 0;
+        writes_.pop_front();
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06llu", static_cast<unsigned long long>(source.frame_number));
+    std::string path = (std::filesystem::path(directory_) / name).string();
+
+    int width = static_cast<int>(extent_.width);
+    int height = static_cast<int>(extent_.height);
+    OutputFormat format = output_format_;
+
+    writes_.push_back(job_system_.submit([pixels, path, width, height, format]() {
+        if (format == OutputFormat::Png) {
+            return Texture::saveImageData(path + ".png", *pixels, width, height, 4);
+        }
+
+        std::ofstream file(path + ".rgba", std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(pixels->data()), static_cast<std::streamsize>(pixels->size()));
+        if (!file) {
+            LOGE("Failed to write frame {}.rgba", path);
+            return false;
+        }
+        return true;
+    }));
+}
+
+bool FrameReadback::flush() {
+    bool success = true;
+    while (!writes_.empty()) {
+        bool written = writes_.front().get();
+        frames_written_ += written ? 1 : 0;
+        success = success && written;
+        writes_.pop_front();
+    }
+    return success;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <future>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VulkanContext;
+class JobSystem;
+
+// Copies rendered frames back to the host for headless runs. Every frame slot
+// owns a readback buffer, so the copy of frame N is in flight while frame N+1
+// renders; a slot is collected after its fence wait, right before it is
+// recorded again. Encoding and file writes run on the job system.
+class FrameReadback {
+public:
+    enum class OutputFormat {
+        Png,
+        Raw  // tightly packed RGBA8 rows, no header
+    };
+
+    FrameReadback(std::shared_ptr<VulkanContext> context, JobSystem& job_system);
+    ~FrameReadback();
+
+    bool initialize(vk::Extent2D extent, vk::Format format);
+    void cleanup();
+
+    // Without a directory the copies still happen but nothing is written,
+    // which measures the readback cost alone.
+    void setOutput(const std::string& directory, OutputFormat format);
+
+    // Expects the image in eColorAttachmentOptimal after its last write of the
+    // frame and leaves it in eTransferSrcOptimal.
+    void record(vk::CommandBuffer command_buffer, uint32_t slot, vk::Image image, uint64_t frame_number);
+
+    // The slot's fence must have signaled.
+    void collect(uint32_t slot);
+
+    // Waits for every queued write.
+    bool flush();
+
+    uint64_t getFramesWritten() const { return frames_written_; }
+
+private:
+    struct Slot {
+        vk::Buffer buffer;
+        GpuAllocation allocation;
+        uint64_t frame_number = 0;
+        bool pending = false;
+    };
+
+    std::shared_ptr<VulkanContext> context_;
+    JobSystem& job_system_;
+
+    std::vector<Slot> slots_;
+    vk::Extent2D extent_;
+    vk::DeviceSize frame_size_;
+
+    std::string directory_;
+    OutputFormat output_format_;
+    std::deque<std::future<bool>> writes_;
+    uint64_t frames_written_;
+
+    // Bounds host memory when encoding is slower than rendering.
+    static constexpr size_t MAX_QUEUED_WRITES = 8;
+};
@@ -0,0 +1,260 @@
+#include "geometry_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+// MSVC never defines __SSE2__, but SSE2 is the x64 baseline; AVX needs /arch:AVX.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GEOMETRY_KERNELS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GEOMETRY_KERNELS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GEOMETRY_KERNELS_NEON
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = GeometryKernels::BLOCK_SIZE;
+
+// Thin wrappers so the kernels below are written once for every instruction set.
+#if defined(GEOMETRY_KERNELS_AVX)
+constexpr size_t WIDTH = 8;
+struct Lanes { __m256 v; };
+inline Lanes load(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline void store(float* p, Lanes a) { _mm256_storeu_ps(p, a.v); }
+inline Lanes splat(float f) { return { _mm256_set1_ps(f) }; }
+inline Lanes operator+(Lanes a, Lanes b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Lanes operator-(Lanes a, Lanes b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Lanes operator*(Lanes a, Lanes b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Lanes operator/(Lanes a, Lanes b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Lanes minimum(Lanes a, Lanes b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Lanes maximum(Lanes a, Lanes b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Lanes squareRoot(Lanes a) { return { _mm256_sqrt_ps(a.v) }; }
+// a > b ? x : y per lane, false for NaN.
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) {
+    return { _mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)) };
+}
+#elif defined(GEOMETRY_KERNELS_SSE2)
+constexpr size_t WIDTH = 4;
+struct Lanes { __m128 v; };
+inline Lanes load(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void store(float* p, Lanes a) { _mm_storeu_ps(p, a.v); }
+inline Lanes splat(float f) { return { _mm_set1_ps(f) }; }
+inline Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Lanes operator/(Lanes a, Lanes b) { return { _mm_div_ps(a.v, b.v) }; }
+inline Lanes minimum(Lanes a, Lanes b) { return { _mm_min_ps(a.v, b.v) }; }
+inline Lanes maximum(Lanes a, Lanes b) { return { _mm_max_ps(a.v, b.v) }; }
+inline Lanes squareRoot(Lanes a) { return { _mm_sqrt_ps(a.v) }; }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) {
+    __m128 mask = _mm_cmpgt_ps(a.v, b.v);
+    return { _mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v)) };
+}
+#elif defined(GEOMETRY_KERNELS_NEON)
+constexpr size_t WIDTH = 4;
+struct Lanes { float32x4_t v; };
+inline Lanes load(const float* p) { return { vld1q_f32(p) }; }
+inline void store(float* p, Lanes a) { vst1q_f32(p, a.v); }
+inline Lanes splat(float f) { return { vdupq_n_f32(f) }; }
+inline Lanes operator+(Lanes a, Lanes b) { return { vaddq_f32(a.v, b.v) }; }
+inline Lanes operator-(Lanes a, Lanes b) { return { vsubq_f32(a.v, b.v) }; }
+inline Lanes operator*(Lanes a, Lanes b) { return { vmulq_f32(a.v, b.v) }; }
+inline Lanes operator/(Lanes a, Lanes b) { return { vdivq_f32(a.v, b.v) }; }
+inline Lanes minimum(Lanes a, Lanes b) { return { vminq_f32(a.v, b.v) }; }
+inline Lanes maximum(Lanes a, Lanes b) { return { vmaxq_f32(a.v, b.v) }; }
+inline Lanes squareRoot(Lanes a) { return { vsqrtq_f32(a.v) }; }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) {
+    return { vbslq_f32(vcgtq_f32(a.v, b.v), x.v, y.v) };
+}
+#else
+constexpr size_t WIDTH = 1;
+struct Lanes { float v; };
+inline Lanes load(const float* p) { return { *p }; }
+inline void store(float* p, Lanes a) { *p = a.v; }
+inline Lanes splat(float f) { return { f }; }
+inline Lanes operator+(Lanes a, Lanes b) { return { a.v + b.v }; }
+inline Lanes operator-(Lanes a, Lanes b) { return { a.v - b.v }; }
+inline Lanes operator*(Lanes a, Lanes b) { return { a.v * b.v }; }
+inline Lanes operator/(Lanes a, Lanes b) { return { a.v / b.v }; }
+inline Lanes minimum(Lanes a, Lanes b) { return { std::min(a.v, b.v) }; }
+inline Lanes maximum(Lanes a, Lanes b) { return { std::max(a.v, b.v) }; }
+inline Lanes squareRoot(Lanes a) { return { std::sqrt(a.v) }; }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) { return a.v > b.v ? x : y; }
+#endif
+
+static_assert(BLOCK_SIZE % WIDTH == 0, "blocks must hold whole vectors");
+
+size_t roundUpToWidth(size_t count) {
+    return (count + WIDTH - 1) / WIDTH * WIDTH;
+}
+
+// One block of vec3s split into component arrays.
+struct Block3 {
+    alignas(32) float x[BLOCK_SIZE];
+    alignas(32) float y[BLOCK_SIZE];
+    alignas(32) float z[BLOCK_SIZE];
+
+    // Lanes past count up to the vector width repeat `padding`.
+    void stage(const Vertex* vertices, glm::vec3 Vertex::* member, size_t count, const glm::vec3& padding) {
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec3& value = vertices[i].*member;
+            x[i] = value.x;
+            y[i] = value.y;
+            z[i] = value.z;
+        }
+        for (size_t i = count; i < roundUpToWidth(count); i++) {
+            x[i] = padding.x;
+            y[i] = padding.y;
+            z[i] = padding.z;
+        }
+    }
+
+    void unstage(Vertex* vertices, glm::vec3 Vertex::* member, size_t count) const {
+        for (size_t i = 0; i < count; i++) {
+            vertices[i].*member = glm::vec3(x[i], y[i], z[i]);
+        }
+    }
+};
+
+template <typename Op>
+float reduce(Lanes lanes, Op op) {
+    alignas(32) float values[WIDTH];
+    store(values, lanes);
+    float result = values[0];
+    for (size_t i = 1; i < WIDTH; i++) {
+        result = op(result, values[i]);
+    }
+    return result;
+}
+
+}
+
+void GeometryKernels::accumulateBounds(const Vertex* vertices, size_t count, glm::vec3& min_pos, glm::vec3& max_pos) {
+    if (count == 0) return;
+
+    Lanes min_x = splat(min_pos.x), min_y = splat(min_pos.y), min_z = splat(min_pos.z);
+    Lanes max_x = splat(max_pos.x), max_y = splat(max_pos.y), max_z = splat(max_pos.z);
+
+    Block3 block;
+    for (size_t base = 0; base < count; base += BLOCK_SIZE) {
+        size_t block_count = std::min(BLOCK_SIZE, count - base);
+        // Padding with a real position leaves the bounds unchanged.
+        block.stage(vertices + base, &Vertex::position, block_count, vertices[base].position);
+
+        for (size_t i = 0; i < block_count; i += WIDTH) {
+            Lanes x = load(block.x + i), y = load(block.y + i), z = load(block.z + i);
+            min_x = minimum(min_x, x);
+            min_y = minimum(min_y, y);
+            min_z = minimum(min_z, z);
+            max_x = maximum(max_x, x);
+            max_y = maximum(max_y, y);
+            max_z = maximum(max_z, z);
+        }
+    }
+
+    auto lower = [](float a, float b) { return std::min(a, b); };
+    auto upper = [](float a, float b) { return std::max(a, b); };
+    min_pos = glm::vec3(reduce(min_x, lower), reduce(min_y, lower), reduce(min_z, lower));
+    max_pos = glm::vec3(reduce(max_x, upper), reduce(max_y, upper), reduce(max_z, upper));
+}
+
+void GeometryKernels::rescalePositions(Vertex* vertices, size_t count, const glm::vec3& center, float scale) {
+    Lanes center_x = splat(center.x), center_y = splat(center.y), center_z = splat(center.z);
+    Lanes factor = splat(scale);
+
+    Block3 block;
+    for (size_t base = 0; base < count; base += BLOCK_SIZE) {
+        size_t block_count = std::min(BLOCK_SIZE, count - base);
+        block.stage(vertices + base, &Vertex::position, block_count, glm::vec3(0.0f));
+
+        for (size_t i = 0; i < block_count; i += WIDTH) {
+            store(block.x + i, (load(block.x + i) - center_x) * factor);
+            store(block.y + i, (load(block.y + i) - center_y) * factor);
+            store(block.z + i, (load(block.z + i) - center_z) * factor);
+        }
+
+        block.unstage(vertices + base, &Vertex::position, block_count);
+    }
+}
+
+void GeometryKernels::computeFaceTangents(const Vertex* vertices, size_t vertex_count, const uint32_t* indices,
+    size_t triangle_count, float* tangent_x, float* tangent_y, float* tangent_z) {
+    // The three corners of every triangle in the block, position and UV.
+    alignas(32) float px[3][BLOCK_SIZE], py[3][BLOCK_SIZE], pz[3][BLOCK_SIZE];
+    alignas(32) float u[3][BLOCK_SIZE], v[3][BLOCK_SIZE];
+    Block3 result;
+
+    for (size_t base = 0; base < triangle_count; base += BLOCK_SIZE) {
+        size_t block_count = std::min(BLOCK_SIZE, triangle_count - base);
+        size_t padded_count = roundUpToWidth(block_count);
+
+        for (size_t t = 0; t < padded_count; t++) {
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t index = t < block_count ? indices[(base + t) * 3 + corner] : 0;
+                const Vertex& vertex = vertices[index < vertex_count ? index : 0];
+                px[corner][t] = vertex.position.x;
+                py[corner][t] = vertex.position.y;
+                pz[corner][t] = vertex.position.z;
+                u[corner][t] = vertex.tex_coord.x;
+                v[corner][t] = vertex.tex_coord.y;
+            }
+        }
+
+        for (size_t i = 0; i < block_count; i += WIDTH) {
+            Lanes x0 = load(px[0] + i), y0 = load(py[0] + i), z0 = load(pz[0] + i);
+            Lanes edge1_x = load(px[1] + i) - x0, edge1_y = load(py[1] + i) - y0, edge1_z = load(pz[1] + i) - z0;
+            Lanes edge2_x = load(px[2] + i) - x0, edge2_y = load(py[2] + i) - y0, edge2_z = load(pz[2] + i) - z0;
+
+            Lanes u0 = load(u[0] + i), v0 = load(v[0] + i);
+            Lanes delta_u1 = load(u[1] + i) - u0, delta_v1 = load(v[1] + i) - v0;
+            Lanes delta_u2 = load(u[2] + i) - u0, delta_v2 = load(v[2] + i) - v0;
+
+            Lanes f = splat(1.0f) / (delta_u1 * delta_v2 - delta_u2 * delta_v1);
+
+            store(result.x + i, f * (delta_v2 * edge1_x - delta_v1 * edge2_x));
+            store(result.y + i, f * (delta_v2 * edge1_y - delta_v1 * edge2_y));
+            store(result.z + i, f * (delta_v2 * edge1_z - delta_v1 * edge2_z));
+        }
+
+        std::copy(result.x, result.x + block_count, tangent_x + base);
+        std::copy(result.y, result.y + block_count, tangent_y + base);
+        std::copy(result.z, result.z + block_count, tangent_z + base);
+    }
+}
+
+void GeometryKernels::normalizeTangents(Vertex* vertices, size_t count) {
+    Lanes zero = splat(0.0f), one = splat(1.0f);
+
+    Block3 block;
+    for (size_t base = 0; base < count; base += BLOCK_SIZE) {
+        size_t block_count = std::min(BLOCK_SIZE, count - base);
+        block.stage(vertices + base, &Vertex::tangent, block_count, glm::vec3(0.0f));
+
+        for (size_t i = 0; i < block_count; i += WIDTH) {
+            Lanes x = load(block.x + i), y = load(block.y + i), z = load(block.z + i);
+            Lanes length_squared = x * x + y * y + z * z;
+            Lanes inverse_length = one / squareRoot(length_squared);
+
+            store(block.x + i, selectGreater(length_squared, zero, x * inverse_length, one));
+            store(block.y + i, selectGreater(length_squared, zero, y * inverse_length, zero));
+            store(block.z + i, selectGreater(length_squared, zero, z * inverse_length, zero));
+        }
+
+        block.unstage(vertices + base, &Vertex::tangent, block_count);
+    }
+}
+
+const char* GeometryKernels::getInstructionSet() {
+#if defined(GEOMETRY_KERNELS_AVX)
+    return "AVX";
+#elif defined(GEOMETRY_KERNELS_SSE2)
+    return "SSE2";
+#elif defined(GEOMETRY_KERNELS_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
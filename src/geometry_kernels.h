@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vertex.h"
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized kernels for post-load vertex processing. Each kernel stages up to
+// BLOCK_SIZE vertices or triangles into structure-of-arrays blocks, so every
+// SIMD lane holds the same component of a different element, and stores the
+// results back into the interleaved vertices. AVX, SSE2 or NEON is chosen at
+// compile time, with a scalar fallback; all of them do the arithmetic of the
+// scalar glm code in the same order. The kernels are single-threaded and only
+// touch the elements they are given, so callers can run disjoint ranges in
+// parallel.
+class GeometryKernels {
+public:
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    // Merges the component-wise bounds of the positions into min_pos/max_pos.
+    static void accumulateBounds(const Vertex* vertices, size_t count, glm::vec3& min_pos, glm::vec3& max_pos);
+
+    // position = (position - center) * scale.
+    static void rescalePositions(Vertex* vertices, size_t count, const glm::vec3& center, float scale);
+
+    // Unnormalized UV-aligned tangent of each triangle, as separate x/y/z
+    // arrays of triangle_count entries. Corners indexing past vertex_count
+    // read vertex 0; callers are expected to skip such triangles.
+    static void computeFaceTangents(const Vertex* vertices, size_t vertex_count, const uint32_t* indices,
+        size_t triangle_count, float* tangent_x, float* tangent_y, float* tangent_z);
+
+    // Normalizes the accumulated tangents; zero-length ones become +X.
+    static void normalizeTangents(Vertex* vertices, size_t count);
+
+    // Instruction set the kernels were compiled for, for logging.
+    static const char* getInstructionSet();
+};
@@ -0,0 +1,469 @@
+#include "gpu_allocator.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+struct GpuMemoryBlock {
+    vk::DeviceMemory memory;
+    vk::DeviceSize size = 0;
+    void* mapped = nullptr;
+    uint32_t memory_type = 0;
+    bool linear = false;
+    uint32_t allocation_count = 0;
+    std::map<vk::DeviceSize, vk::DeviceSize> free_ranges; // offset -> size
+};
+
+namespace {
+
+constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool carveRange(GpuMemoryBlock& block, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& out_offset) {
+    for (auto it = block.free_ranges.begin(); it != block.free_ranges.end(); ++it) {
+        vk::DeviceSize range_offset = it->first;
+        vk::DeviceSize range_size = it->second;
+        vk::DeviceSize aligned_offset = alignUp(range_offset, alignment);
+        vk::DeviceSize padding = aligned_offset - range_offset;
+
+        if (padding + size > range_size) {
+            continue;
+        }
+
+        block.free_ranges.erase(it);
+
+        if (padding > 0) {
+            block.free_ranges.emplace(range_offset, padding);
+        }
+
+        vk::DeviceSize remaining = range_size - padding - size;
+        if (remaining > 0) {
+            block.free_ranges.emplace(aligned_offset + size, remaining);
+        }
+
+        out_offset = aligned_offset;
+        return true;
+    }
+
+    return false;
+}
+
+void releaseRange(GpuMemoryBlock& block, vk::DeviceSize offset, vk::DeviceSize size) {
+    auto it = block.free_ranges.emplace(offset, size).first;
+
+    if (it != block.free_ranges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            block.free_ranges.erase(it);
+            it = prev;
+        }
+    }
+
+    auto next = std::next(it);
+    if (next != block.free_ranges.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        block.free_ranges.erase(next);
+    }
+}
+
+}
+
+GpuAllocator::GpuAllocator(vk::PhysicalDevice physical_device, vk::Device device)
+    : physical_device_(physical_device), device_(device), device_allocation_count_(0) {
+    memory_properties_ = physical_device_.getMemoryProperties();
+    vk::PhysicalDeviceLimits limits = physical_device_.getProperties().limits;
+    max_allocation_count_ = limits.maxMemoryAllocationCount;
+    non_coherent_atom_size_ = std::max<vk::DeviceSize>(limits.nonCoherentAtomSize, 1);
+
+    pools_.resize(memory_properties_.memoryTypeCount * 2);
+    heap_usage_.resize(memory_properties_.memoryHeapCount);
+}
+
+GpuAllocator::~GpuAllocator() {
+    cleanup();
+}
+
+bool GpuAllocator::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties,
+    bool linear, GpuAllocation& allocation) {
+    uint32_t memory_type;
+    try {
+        memory_type = findMemoryType(requirements.memoryTypeBits, properties);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate GPU memory: {}", e.what());
+        return false;
+    }
+
+    // Non-coherent allocations are padded to whole atoms, so invalidating one
+    // never touches the cache lines of its neighbours.
+    vk::MemoryRequirements padded = requirements;
+    vk::MemoryPropertyFlags type_properties = memory_properties_.memoryTypes[memory_type].propertyFlags;
+    if ((type_properties & vk::MemoryPropertyFlagBits::eHostVisible) &&
+        !(type_properties & vk::MemoryPropertyFlagBits::eHostCoherent)) {
+        padded.alignment = std::max(padded.alignment, non_coherent_atom_size_);
+        padded.size = alignUp(padded.size, non_coherent_atom_size_);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (padded.size > getBlockSize(memory_type) / 2) {
+        return allocateDedicated(memory_type, padded, allocation);
+    }
+
+    return allocateFromPool(getPool(memory_type, linear), memory_type, linear, padded, allocation);
+}
+
+void GpuAllocator::free(GpuAllocation& allocation) {
+    if (!allocation.isValid()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    trackUsage(allocation.memory_type, allocation.size, false);
+
+    GpuMemoryBlock* block = allocation.block;
+    if (!block) {
+        freeDeviceMemory(allocation.memory_type, allocation.size, allocation.memory, allocation.mapped != nullptr);
+        allocation = GpuAllocation{};
+        return;
+    }
+
+    releaseRange(*block, allocation.offset, allocation.size);
+    block->allocation_count--;
+
+    // Keep one empty block per pool around so a load/unload cycle does not
+    // bounce memory back and forth with the driver.
+    if (block->allocation_count == 0) {
+        auto& blocks = getPool(block->memory_type, block->linear).blocks;
+        if (blocks.size() > 1) {
+            auto it = std::find_if(blocks.begin(), blocks.end(),
+                [block](const std::unique_ptr<GpuMemoryBlock>& b) { return b.get() == block; });
+
+            freeDeviceMemory(block->memory_type, block->size, block->memory, block->mapped != nullptr);
+            blocks.erase(it);
+        }
+    }
+
+    allocation = GpuAllocation{};
+}
+
+bool GpuAllocator::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+    vk::MemoryPropertyFlags properties,
+    vk::Buffer& buffer, GpuAllocation& allocation) {
+    vk::BufferCreateInfo buffer_info{};
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = vk::SharingMode::eExclusive;
+
+    try {
+        buffer = device_.createBuffer(buffer_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create buffer: {}", e.what());
+        return false;
+    }
+
+    vk::MemoryRequirements mem_requirements = device_.getBufferMemoryRequirements(buffer);
+
+    if (!allocate(mem_requirements, properties, true, allocation)) {
+        LOGE("Failed to allocate buffer memory");
+        device_.destroyBuffer(buffer);
+        buffer = nullptr;
+        return false;
+    }
+
+    try {
+        device_.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to bind buffer memory: {}", e.what());
+        destroyBuffer(buffer, allocation);
+        return false;
+    }
+
+    return true;
+}
+
+void GpuAllocator::destroyBuffer(vk::Buffer& buffer, GpuAllocation& allocation) {
+    if (buffer) {
+        device_.destroyBuffer(buffer);
+        buffer = nullptr;
+    }
+    free(allocation);
+}
+
+bool GpuAllocator::createImage(const vk::ImageCreateInfo& image_info, vk::MemoryPropertyFlags properties,
+    vk::Image& image, GpuAllocation& allocation) {
+    try {
+        image = device_.createImage(image_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image: {}", e.what());
+        return false;
+    }
+
+    vk::MemoryRequirements mem_requirements = device_.getImageMemoryRequirements(image);
+    bool linear = image_info.tiling == vk::ImageTiling::eLinear;
+
+    if (!allocate(mem_requirements, properties, linear, allocation)) {
+        LOGE("Failed to allocate image memory");
+        device_.destroyImage(image);
+        image = nullptr;
+        return false;
+    }
+
+    try {
+        device_.bindImageMemory(image, allocation.memory, allocation.offset);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to bind image memory: {}", e.what());
+        destroyImage(image, allocation);
+        return false;
+    }
+
+    return true;
+}
+
+void GpuAllocator::destroyImage(vk::Image& image, GpuAllocation& allocation) {
+    if (image) {
+        device_.destroyImage(image);
+        image = nullptr;
+    }
+    free(allocation);
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; i++) {
+        if ((type_filter & (1 << i)) &&
+            (memory_properties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+bool GpuAllocator::hasMemoryType(vk::MemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; i++) {
+        if ((memory_properties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            return true;
+        }
+    }
+    return false;
+}
+
+vk::MemoryPropertyFlags GpuAllocator::getMemoryProperties(const GpuAllocation& allocation) const {
+    return memory_properties_.memoryTypes[allocation.memory_type].propertyFlags;
+}
+
+bool GpuAllocator::invalidate(const GpuAllocation& allocation) {
+    if (!allocation.isValid() || (getMemoryProperties(allocation) & vk::MemoryPropertyFlagBits::eHostCoherent)) {
+        return true;
+    }
+
+    // allocate() keeps non-coherent ranges atom aligned.
+    vk::MappedMemoryRange range{};
+    range.memory = allocation.memory;
+    range.offset = allocation.offset;
+    range.size = allocation.size;
+
+    try {
+        device_.invalidateMappedMemoryRanges(range);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to invalidate mapped memory: {}", e.what());
+        return false;
+    }
+    return true;
+}
+
+std::vector<HeapStatistics> GpuAllocator::getHeapStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<HeapStatistics> statistics(memory_properties_.memoryHeapCount);
+    for (uint32_t i = 0; i < memory_properties_.memoryHeapCount; i++) {
+        const auto& heap = memory_properties_.memoryHeaps[i];
+        const auto& usage = heap_usage_[i];
+
+        statistics[i].heap_index = i;
+        statistics[i].device_local = static_cast<bool>(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+        statistics[i].heap_size = heap.size;
+        statistics[i].reserved_bytes = usage.reserved_bytes;
+        statistics[i].used_bytes = usage.used_bytes;
+        statistics[i].peak_used_bytes = usage.peak_used_bytes;
+        statistics[i].block_count = usage.block_count;
+        statistics[i].allocation_count = usage.allocation_count;
+    }
+
+    return statistics;
+}
+
+void GpuAllocator::logStatistics() const {
+    for (const auto& heap : getHeapStatistics()) {
+        LOGI("GPU heap {} ({}): {:.1f} MB used, {:.1f} MB reserved, {:.1f} MB peak, {} blocks, {} allocations",
+            heap.heap_index, heap.device_local ? "device local" : "host",
+            heap.used_bytes / BYTES_PER_MB, heap.reserved_bytes / BYTES_PER_MB,
+            heap.peak_used_bytes / BYTES_PER_MB, heap.block_count, heap.allocation_count);
+    }
+}
+
+void GpuAllocator::cleanup() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (uint32_t i = 0; i < pools_.size(); i++) {
+        for (auto& block : pools_[i].blocks) {
+            if (block->allocation_count > 0) {
+                LOGW("GPU memory block of type {} destroyed with {} live allocations",
+                    block->memory_type, block->allocation_count);
+            }
+            freeDeviceMemory(block->memory_type, block->size, block->memory, block->mapped != nullptr);
+        }
+        pools_[i].blocks.clear();
+    }
+}
+
+bool GpuAllocator::allocateFromPool(MemoryPool& pool, uint32_t memory_type, bool linear,
+    const vk::MemoryRequirements& requirements, GpuAllocation& allocation) {
+    vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+
+    GpuMemoryBlock* target = nullptr;
+    vk::DeviceSize offset = 0;
+
+    for (auto& block : pool.blocks) {
+        if (carveRange(*block, requirements.size, alignment, offset)) {
+            target = block.get();
+            break;
+        }
+    }
+
+    if (!target) {
+        auto block = std::make_unique<GpuMemoryBlock>();
+        block->size = getBlockSize(memory_type);
+        block->memory_type = memory_type;
+        block->linear = linear;
+
+        if (!allocateDeviceMemory(memory_type, block->size, block->memory, block->mapped)) {
+            return false;
+        }
+
+        block->free_ranges.emplace(0, block->size);
+        carveRange(*block, requirements.size, alignment, offset);
+
+        target = block.get();
+        pool.blocks.push_back(std::move(block));
+    }
+
+    target->allocation_count++;
+
+    allocation.memory = target->memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = target->mapped ? static_cast<char*>(target->mapped) + offset : nullptr;
+    allocation.memory_type = memory_type;
+    allocation.block = target;
+
+    trackUsage(memory_type, requirements.size, true);
+    return true;
+}
+
+bool GpuAllocator::allocateDedicated(uint32_t memory_type, const vk::MemoryRequirements& requirements,
+    GpuAllocation& allocation) {
+    vk::DeviceMemory memory;
+    void* mapped = nullptr;
+
+    if (!allocateDeviceMemory(memory_type, requirements.size, memory, mapped)) {
+        return false;
+    }
+
+    allocation.memory = memory;
+    allocation.offset = 0;
+    allocation.size = requirements.size;
+    allocation.mapped = mapped;
+    allocation.memory_type = memory_type;
+    allocation.block = nullptr;
+
+    trackUsage(memory_type, requirements.size, true);
+    return true;
+}
+
+bool GpuAllocator::allocateDeviceMemory(uint32_t memory_type, vk::DeviceSize size,
+    vk::DeviceMemory& memory, void*& mapped) {
+    if (device_allocation_count_ >= max_allocation_count_) {
+        LOGE("Reached maxMemoryAllocationCount ({})", max_allocation_count_);
+        return false;
+    }
+
+    vk::MemoryAllocateInfo alloc_info{};
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    try {
+        memory = device_.allocateMemory(alloc_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate device memory ({:.1f} MB): {}", size / BYTES_PER_MB, e.what());
+        return false;
+    }
+
+    // Host visible memory is mapped once for its whole lifetime; sub-allocations
+    // hand out pointers into this mapping instead of calling mapMemory again.
+    mapped = nullptr;
+    if (memory_properties_.memoryTypes[memory_type].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        try {
+            mapped = device_.mapMemory(memory, 0, size);
+        }
+        catch (const std::exception& e) {
+            LOGE("Failed to map device memory: {}", e.what());
+            device_.freeMemory(memory);
+            return false;
+        }
+    }
+
+    device_allocation_count_++;
+
+    auto& usage = heap_usage_[memory_properties_.memoryTypes[memory_type].heapIndex];
+    usage.reserved_bytes += size;
+    usage.block_count++;
+    return true;
+}
+
+void GpuAllocator::freeDeviceMemory(uint32_t memory_type, vk::DeviceSize size, vk::DeviceMemory memory, bool mapped) {
+    if (mapped) {
+        device_.unmapMemory(memory);
+    }
+    device_.freeMemory(memory);
+    device_allocation_count_--;
+
+    auto& usage = heap_usage_[memory_properties_.memoryTypes[memory_type].heapIndex];
+    usage.reserved_bytes -= size;
+    usage.block_count--;
+}
+
+vk::DeviceSize GpuAllocator::getBlockSize(uint32_t memory_type) const {
+    vk::DeviceSize heap_size = memory_properties_.memoryHeaps[memory_properties_.memoryTypes[memory_type].heapIndex].size;
+
+    if (heap_size <= 1024ull * 1024 * 1024) {
+        return std::max(heap_size / 8, std::min(MIN_BLOCK_SIZE, heap_size));
+    }
+
+    return DEFAULT_BLOCK_SIZE;
+}
+
+GpuAllocator::MemoryPool& GpuAllocator::getPool(uint32_t memory_type, bool linear) {
+    return pools_[memory_type * 2 + (linear ? 1 : 0)];
+}
+
+void GpuAllocator::trackUsage(uint32_t memory_type, vk::DeviceSize size, bool allocated) {
+    auto& usage = heap_usage_[memory_properties_.memoryTypes[memory_type].heapIndex];
+
+    if (allocated) {
+        usage.used_bytes += size;
+        usage.allocation_count++;
+        usage.peak_used_bytes = std::max(usage.peak_used_bytes, usage.used_bytes);
+    }
+    else {
+        usage.used_bytes -= size;
+        usage.allocation_count--;
+    }
+}
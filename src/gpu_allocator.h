@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+struct GpuMemoryBlock;
+
+struct GpuAllocation {
+    vk::DeviceMemory memory;
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+    void* mapped = nullptr;
+    uint32_t memory_type = 0;
+    GpuMemoryBlock* block = nullptr; // nullptr for dedicated allocations
+
+    bool isValid() const { return static_cast<bool>(memory); }
+};
+
+struct HeapStatistics {
+    uint32_t heap_index = 0;
+    bool device_local = false;
+    vk::DeviceSize heap_size = 0;
+    vk::DeviceSize reserved_bytes = 0;  // memory obtained from the driver
+    vk::DeviceSize used_bytes = 0;      // memory handed out to resources
+    vk::DeviceSize peak_used_bytes = 0;
+    uint32_t block_count = 0;
+    uint32_t allocation_count = 0;
+};
+
+// Sub-allocates buffers and images out of large vk::DeviceMemory blocks so the
+// number of driver allocations stays far below maxMemoryAllocationCount.
+// Linear (buffer) and optimal (image) resources live in separate blocks, which
+// keeps bufferImageGranularity out of the offset math.
+class GpuAllocator {
+public:
+    GpuAllocator(vk::PhysicalDevice physical_device, vk::Device device);
+    ~GpuAllocator();
+
+    bool allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties,
+        bool linear, GpuAllocation& allocation);
+    void free(GpuAllocation& allocation);
+
+    bool createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+        vk::MemoryPropertyFlags properties,
+        vk::Buffer& buffer, GpuAllocation& allocation);
+    void destroyBuffer(vk::Buffer& buffer, GpuAllocation& allocation);
+
+    bool createImage(const vk::ImageCreateInfo& image_info, vk::MemoryPropertyFlags properties,
+        vk::Image& image, GpuAllocation& allocation);
+    void destroyImage(vk::Image& image, GpuAllocation& allocation);
+
+    uint32_t findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) const;
+    bool hasMemoryType(vk::MemoryPropertyFlags properties) const;
+    vk::MemoryPropertyFlags getMemoryProperties(const GpuAllocation& allocation) const;
+
+    // Makes device writes to a mapped allocation visible to the host. Only
+    // non-coherent memory needs it; for coherent memory it does nothing.
+    bool invalidate(const GpuAllocation& allocation);
+
+    std::vector<HeapStatistics> getHeapStatistics() const;
+    void logStatistics() const;
+
+    void cleanup();
+
+private:
+    struct MemoryPool {
+        std::vector<std::unique_ptr<GpuMemoryBlock>> blocks;
+    };
+
+    bool allocateFromPool(MemoryPool& pool, uint32_t memory_type, bool linear,
+        const vk::MemoryRequirements& requirements, GpuAllocation& allocation);
+    bool allocateDedicated(uint32_t memory_type, const vk::MemoryRequirements& requirements,
+        GpuAllocation& allocation);
+    bool allocateDeviceMemory(uint32_t memory_type, vk::DeviceSize size,
+        vk::DeviceMemory& memory, void*& mapped);
+    void freeDeviceMemory(uint32_t memory_type, vk::DeviceSize size, vk::DeviceMemory memory, bool mapped);
+    vk::DeviceSize getBlockSize(uint32_t memory_type) const;
+    MemoryPool& getPool(uint32_t memory_type, bool linear);
+    void trackUsage(uint32_t memory_type, vk::DeviceSize size, bool allocated);
+
+    vk::PhysicalDevice physical_device_;
+    vk::Device device_;
+    vk::PhysicalDeviceMemoryProperties memory_properties_;
+    uint32_t max_allocation_count_;
+    vk::DeviceSize non_coherent_atom_size_;
+    uint32_t device_allocation_count_;
+
+    std::vector<MemoryPool> pools_; // indexed by memory_type * 2 + linear
+
+    struct HeapUsage {
+        vk::DeviceSize reserved_bytes = 0;
+        vk::DeviceSize used_bytes = 0;
+        vk::DeviceSize peak_used_bytes = 0;
+        uint32_t block_count = 0;
+        uint32_t allocation_count = 0;
+    };
+    std::vector<HeapUsage> heap_usage_;
+
+    mutable std::mutex mutex_;
+
+    static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+    static constexpr vk::DeviceSize MIN_BLOCK_SIZE = 4ull * 1024 * 1024;
+};
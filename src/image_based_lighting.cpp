@@ -0,0 +1,756 @@
+#include "image_based_lighting.h"
+#include "vulkan_context.h"
+#include "shader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// Matches the push constant block of the shaders under assets/shaders/ibl.
+struct BakeParams {
+    uint32_t face_size;
+    float roughness;
+};
+
+constexpr uint32_t BAKE_GROUP_SIZE = 8;
+
+}
+
+ImageBasedLighting::ImageBasedLighting(std::shared_ptr<VulkanContext> context)
+    : context_(context), data_size_(0), environment_key_(0),
+    bake_pending_(false), persist_bake_(false), brdf_lut_valid_(false),
+    readback_pending_(false), readback_frame_(0) {
+}
+
+ImageBasedLighting::~ImageBasedLighting() {
+    cleanup();
+}
+
+bool ImageBasedLighting::initialize() {
+    if (!createMap(irradiance_map_, IRRADIANCE_SIZE, 1, 6) ||
+        !createMap(prefiltered_map_, PREFILTERED_SIZE, PREFILTERED_MIP_LEVELS, 6) ||
+        !createMap(brdf_lut_, BRDF_LUT_SIZE, 1, 1)) {
+        LOGE("Failed to create image based lighting maps");
+        return false;
+    }
+
+    if (!clearMaps()) {
+        LOGE("Failed to clear image based lighting maps");
+        return false;
+    }
+
+    if (!createSamplers() || !createDescriptorSetLayouts() || !createDescriptorPool() ||
+        !createDescriptorSets()) {
+        LOGE("Failed to create image based lighting descriptors");
+        return false;
+    }
+
+    if (!createBakePipelines()) {
+        LOGE("Failed to create image based lighting bake pipelines");
+        return false;
+    }
+
+    LOGI("Image based lighting initialized ({} bytes per bake)", data_size_);
+    return true;
+}
+
+void ImageBasedLighting::cleanup() {
+    if (!context_) return;
+    auto device = context_->getDevice();
+
+    // Only reached once the device is idle, so an in-flight readback is done.
+    if (readback_pending_) {
+        writeCache();
+        readback_pending_ = false;
+    }
+    if (readback_buffer_) {
+        context_->getAllocator().destroyBuffer(readback_buffer_, readback_allocation_);
+    }
+
+    if (irradiance_pipeline_) device.destroyPipeline(irradiance_pipeline_);
+    if (prefilter_pipeline_) device.destroyPipeline(prefilter_pipeline_);
+    if (brdf_pipeline_) device.destroyPipeline(brdf_pipeline_);
+    if (bake_pipeline_layout_) device.destroyPipelineLayout(bake_pipeline_layout_);
+    irradiance_pipeline_ = nullptr;
+    prefilter_pipeline_ = nullptr;
+    brdf_pipeline_ = nullptr;
+    bake_pipeline_layout_ = nullptr;
+
+    if (descriptor_pool_) device.destroyDescriptorPool(descriptor_pool_);
+    if (descriptor_set_layout_) device.destroyDescriptorSetLayout(descriptor_set_layout_);
+    if (bake_descriptor_set_layout_) device.destroyDescriptorSetLayout(bake_descriptor_set_layout_);
+    descriptor_pool_ = nullptr;
+    descriptor_set_layout_ = nullptr;
+    bake_descriptor_set_layout_ = nullptr;
+
+    if (map_sampler_) device.destroySampler(map_sampler_);
+    if (lut_sampler_) device.destroySampler(lut_sampler_);
+    map_sampler_ = nullptr;
+    lut_sampler_ = nullptr;
+
+    destroyMap(irradiance_map_);
+    destroyMap(prefiltered_map_);
+    destroyMap(brdf_lut_);
+}
+
+bool ImageBasedLighting::setEnvironment(vk::ImageView environment_view, vk::Sampler environment_sampler,
+    uint64_t environment_key) {
+    if (!environment_view || !environment_sampler) {
+        LOGE("Invalid environment map for image based lighting");
+        return false;
+    }
+
+    // The caller guarantees no frame is in flight, so a pending readback is complete.
+    if (readback_pending_) {
+        writeCache();
+        readback_pending_ = false;
+        context_->getAllocator().destroyBuffer(readback_buffer_, readback_allocation_);
+    }
+
+    environment_view_ = environment_view;
+    environment_sampler_ = environment_sampler;
+    environment_key_ = environment_key;
+    updateBakeDescriptorSets();
+
+    if (loadFromCache(environment_key)) {
+        LOGI("Image based lighting loaded from cache: {}", getCachePath(environment_key));
+        brdf_lut_valid_ = true;
+        bake_pending_ = false;
+        return true;
+    }
+
+    if (!irradiance_pipeline_) {
+        LOGW("No compute support on the graphics queue, image based lighting stays black");
+        return false;
+    }
+
+    bake_pending_ = true;
+    persist_bake_ = true;
+    return true;
+}
+
+void ImageBasedLighting::invalidate() {
+    if (!environment_view_ || !irradiance_pipeline_) return;
+
+    bake_pending_ = true;
+    persist_bake_ = false;
+}
+
+void ImageBasedLighting::beginFrame(uint32_t frame_index) {
+    if (!readback_pending_ || frame_index != readback_frame_) return;
+
+    // The fence of the frame that recorded the readback has just been waited on.
+    if (!writeCache()) {
+        LOGW("Image based lighting cache not written");
+    }
+
+    context_->getAllocator().destroyBuffer(readback_buffer_, readback_allocation_);
+    readback_pending_ = false;
+}
+
+void ImageBasedLighting::recordBake(vk::CommandBuffer command_buffer, uint32_t frame_index) {
+    if (!bake_pending_ || !irradiance_pipeline_) return;
+
+    // Earlier frames may still be sampling the maps.
+    recordTransition(command_buffer, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+        vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader);
+
+    recordDispatch(command_buffer, irradiance_pipeline_, irradiance_bake_set_, IRRADIANCE_SIZE, 6, 0.0f);
+
+    for (uint32_t level = 0; level < PREFILTERED_MIP_LEVELS; level++) {
+        float roughness = static_cast<float>(level) / static_cast<float>(PREFILTERED_MIP_LEVELS - 1);
+        recordDispatch(command_buffer, prefilter_pipeline_, prefilter_bake_sets_[level],
+            std::max(PREFILTERED_SIZE >> level, 1u), 6, roughness);
+    }
+
+    // The LUT does not depend on the environment.
+    if (!brdf_lut_valid_) {
+        recordDispatch(command_buffer, brdf_pipeline_, brdf_bake_set_, BRDF_LUT_SIZE, 1, 0.0f);
+    }
+
+    bool persist = persist_bake_;
+    if (persist && !context_->getAllocator().createBuffer(data_size_, vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        readback_buffer_, readback_allocation_)) {
+        LOGW("Failed to create image based lighting readback buffer, bake will not be cached");
+        persist = false;
+    }
+
+    if (persist) {
+        recordTransition(command_buffer, vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal,
+            vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead,
+            vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer);
+
+        recordReadback(command_buffer);
+
+        recordTransition(command_buffer, vk::ImageLayout::eTransferSrcOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::AccessFlags{}, vk::AccessFlagBits::eShaderRead,
+            vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+
+        readback_pending_ = true;
+        readback_frame_ = frame_index;
+    }
+    else {
+        recordTransition(command_buffer, vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
+            vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader);
+    }
+
+    brdf_lut_valid_ = true;
+    bake_pending_ = false;
+    persist_bake_ = false;
+}
+
+void ImageBasedLighting::bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout,
+    uint32_t set) const {
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+        pipeline_layout, set, 1, &descriptor_set_, 0, nullptr);
+}
+
+bool ImageBasedLighting::createMap(LightingMap& map, uint32_t size, uint32_t mip_levels, uint32_t layers) {
+    auto device = context_->getDevice();
+
+    map.size = size;
+    map.mip_levels = mip_levels;
+    map.layers = layers;
+    map.data_offset = data_size_;
+    map.data_size = 0;
+    for (uint32_t level = 0; level < mip_levels; level++) {
+        vk::DeviceSize level_size = std::max(size >> level, 1u);
+        map.data_size += level_size * level_size * layers * TEXEL_SIZE;
+    }
+    data_size_ += map.data_size;
+
+    vk::ImageCreateInfo image_info{};
+    image_info.imageType = vk::ImageType::e2D;
+    image_info.extent = vk::Extent3D{ size, size, 1 };
+    image_info.mipLevels = mip_levels;
+    image_info.arrayLayers = layers;
+    image_info.format = MAP_FORMAT;
+    image_info.tiling = vk::ImageTiling::eOptimal;
+    image_info.initialLayout = vk::ImageLayout::eUndefined;
+    image_info.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled |
+        vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+    image_info.samples = vk::SampleCountFlagBits::e1;
+    image_info.sharingMode = vk::SharingMode::eExclusive;
+    if (layers == 6) {
+        image_info.flags = vk::ImageCreateFlagBits::eCubeCompatible;
+    }
+
+    if (!context_->getAllocator().createImage(image_info, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        map.image, map.allocation)) {
+        LOGE("Failed to create image based lighting image");
+        return false;
+    }
+
+    vk::ImageViewCreateInfo view_info{};
+    view_info.image = map.image;
+    view_info.viewType = layers == 6 ? vk::ImageViewType::eCube : vk::ImageViewType::e2D;
+    view_info.format = MAP_FORMAT;
+    view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, mip_levels, 0, layers };
+
+    try {
+        map.view = device.createImageView(view_info);
+
+        // Compute writes one mip level at a time, cube faces as array layers.
+        view_info.viewType = layers == 6 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
+        view_info.subresourceRange.levelCount = 1;
+        for (uint32_t level = 0; level < mip_levels; level++) {
+            view_info.subresourceRange.baseMipLevel = level;
+            map.storage_views.push_back(device.createImageView(view_info));
+        }
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image based lighting image view: {}", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+void ImageBasedLighting::destroyMap(LightingMap& map) {
+    auto device = context_->getDevice();
+
+    for (auto view : map.storage_views) {
+        device.destroyImageView(view);
+    }
+    map.storage_views.clear();
+
+    if (map.view) {
+        device.destroyImageView(map.view);
+        map.view = nullptr;
+    }
+    if (map.image) {
+        context_->getAllocator().destroyImage(map.image, map.allocation);
+        map.image = nullptr;
+    }
+}
+
+bool ImageBasedLighting::clearMaps() {
+    try {
+        vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
+
+        recordTransition(command_buffer, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+            vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+            vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer);
+
+        vk::ClearColorValue black{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
+        for (const LightingMap* map : { &irradiance_map_, &prefiltered_map_, &brdf_lut_ }) {
+            vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, map->mip_levels, 0, map->layers };
+            command_buffer.clearColorImage(map->image, vk::ImageLayout::eTransferDstOptimal, &black, 1, &range);
+        }
+
+        recordTransition(command_buffer, vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+            vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+
+        context_->endSingleTimeCommands(command_buffer);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to clear image based lighting maps: {}", e.what());
+        return false;
+    }
+}
+
+bool ImageBasedLighting::createSamplers() {
+    auto device = context_->getDevice();
+
+    vk::SamplerCreateInfo sampler_info{};
+    sampler_info.magFilter = vk::Filter::eLinear;
+    sampler_info.minFilter = vk::Filter::eLinear;
+    sampler_info.mipmapMode = vk::SamplerMipmapMode::eLinear;
+    sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.anisotropyEnable = VK_FALSE;
+    sampler_info.borderColor = vk::BorderColor::eIntOpaqueBlack;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.compareOp = vk::CompareOp::eAlways;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = static_cast<float>(PREFILTERED_MIP_LEVELS);
+
+    try {
+        map_sampler_ = device.createSampler(sampler_info);
+
+        sampler_info.maxLod = 0.0f;
+        lut_sampler_ = device.createSampler(sampler_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image based lighting sampler: {}", e.what());
+        return false;
+    }
+}
+
+bool ImageBasedLighting::createDescriptorSetLayouts() {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorCount = 1;
+        bindings[i].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        bindings[i].pImmutableSamplers = nullptr;
+        bindings[i].stageFlags = vk::ShaderStageFlagBits::eFragment;
+    }
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bake_bindings{};
+    bake_bindings[0].binding = 0;
+    bake_bindings[0].descriptorCount = 1;
+    bake_bindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    bake_bindings[0].pImmutableSamplers = nullptr;
+    bake_bindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    bake_bindings[1].binding = 1;
+    bake_bindings[1].descriptorCount = 1;
+    bake_bindings[1].descriptorType = vk::DescriptorType::eStorageImage;
+    bake_bindings[1].pImmutableSamplers = nullptr;
+    bake_bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    vk::DescriptorSetLayoutCreateInfo bake_layout_info{};
+    bake_layout_info.bindingCount = static_cast<uint32_t>(bake_bindings.size());
+    bake_layout_info.pBindings = bake_bindings.data();
+
+    try {
+        descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
+        bake_descriptor_set_layout_ = device.createDescriptorSetLayout(bake_layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image based lighting descriptor set layout: {}", e.what());
+        return false;
+    }
+}
+
+bool ImageBasedLighting::createDescriptorPool() {
+    auto device = context_->getDevice();
+
+    // The shading set plus one bake set per written mip level.
+    uint32_t bake_set_count = irradiance_map_.mip_levels + prefiltered_map_.mip_levels + brdf_lut_.mip_levels;
+
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = vk::DescriptorType::eCombinedImageSampler;
+    pool_sizes[0].descriptorCount = 3 + bake_set_count;
+    pool_sizes[1].type = vk::DescriptorType::eStorageImage;
+    pool_sizes[1].descriptorCount = bake_set_count;
+
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = 1 + bake_set_count;
+
+    try {
+        descriptor_pool_ = device.createDescriptorPool(pool_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image based lighting descriptor pool: {}", e.what());
+        return false;
+    }
+}
+
+bool ImageBasedLighting::createDescriptorSets() {
+    auto device = context_->getDevice();
+
+    std::vector<vk::DescriptorSetLayout> layouts(2 + PREFILTERED_MIP_LEVELS + 1, bake_descriptor_set_layout_);
+    layouts[0] = descriptor_set_layout_;
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    alloc_info.pSetLayouts = layouts.data();
+
+    std::vector<vk::DescriptorSet> sets;
+    try {
+        sets = device.allocateDescriptorSets(alloc_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate image based lighting descriptor sets: {}", e.what());
+        return false;
+    }
+
+    descriptor_set_ = sets[0];
+    irradiance_bake_set_ = sets[1];
+    prefilter_bake_sets_.assign(sets.begin() + 2, sets.begin() + 2 + PREFILTERED_MIP_LEVELS);
+    brdf_bake_set_ = sets.back();
+
+    std::array<vk::DescriptorImageInfo, 3> map_infos{};
+    map_infos[0] = vk::DescriptorImageInfo{ map_sampler_, irradiance_map_.view, vk::ImageLayout::eShaderReadOnlyOptimal };
+    map_infos[1] = vk::DescriptorImageInfo{ map_sampler_, prefiltered_map_.view, vk::ImageLayout::eShaderReadOnlyOptimal };
+    map_infos[2] = vk::DescriptorImageInfo{ lut_sampler_, brdf_lut_.view, vk::ImageLayout::eShaderReadOnlyOptimal };
+
+    // Storage targets; the environment binding is written by setEnvironment().
+    std::vector<vk::DescriptorImageInfo> storage_infos;
+    std::vector<vk::DescriptorSet> storage_sets;
+    storage_infos.push_back({ nullptr, irradiance_map_.storage_views[0], vk::ImageLayout::eGeneral });
+    storage_sets.push_back(irradiance_bake_set_);
+    for (uint32_t level = 0; level < PREFILTERED_MIP_LEVELS; level++) {
+        storage_infos.push_back({ nullptr, prefiltered_map_.storage_views[level], vk::ImageLayout::eGeneral });
+        storage_sets.push_back(prefilter_bake_sets_[level]);
+    }
+    storage_infos.push_back({ nullptr, brdf_lut_.storage_views[0], vk::ImageLayout::eGeneral });
+    storage_sets.push_back(brdf_bake_set_);
+
+    std::vector<vk::WriteDescriptorSet> descriptor_writes;
+    for (uint32_t i = 0; i < map_infos.size(); i++) {
+        vk::WriteDescriptorSet write{};
+        write.dstSet = descriptor_set_;
+        write.dstBinding = i;
+        write.dstArrayElement = 0;
+        write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        write.descriptorCount = 1;
+        write.pImageInfo = &map_infos[i];
+        descriptor_writes.push_back(write);
+    }
+    for (size_t i = 0; i < storage_infos.size(); i++) {
+        vk::WriteDescriptorSet write{};
+        write.dstSet = storage_sets[i];
+        write.dstBinding = 1;
+        write.dstArrayElement = 0;
+        write.descriptorType = vk::DescriptorType::eStorageImage;
+        write.descriptorCount = 1;
+        write.pImageInfo = &storage_infos[i];
+        descriptor_writes.push_back(write);
+    }
+
+    device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+    return true;
+}
+
+bool ImageBasedLighting::createBakePipelines() {
+    auto device = context_->getDevice();
+
+    // The bake is recorded into the frame's graphics command buffer.
+    uint32_t graphics_family = context_->getQueueFamilyIndices().graphics_family.value();
+    auto queue_families = context_->getPhysicalDevice().getQueueFamilyProperties();
+    if (!(queue_families[graphics_family].queueFlags & vk::QueueFlagBits::eCompute)) {
+        LOGW("Graphics queue has no compute support, image based lighting can only come from the cache");
+        return true;
+    }
+
+    vk::PushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(BakeParams);
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &bake_descriptor_set_layout_;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    try {
+        bake_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create image based lighting pipeline layout: {}", e.what());
+        return false;
+    }
+
+    return createBakePipeline(SHADER_DIR "ibl/irradiance.comp", irradiance_pipeline_) &&
+        createBakePipeline(SHADER_DIR "ibl/prefilter.comp", prefilter_pipeline_) &&
+        createBakePipeline(SHADER_DIR "ibl/brdf_lut.comp", brdf_pipeline_);
+}
+
+bool ImageBasedLighting::createBakePipeline(const std::string& shader_path, vk::Pipeline& pipeline) {
+    // The module is only needed while the pipeline is created.
+    Shader shader(context_);
+    if (!shader.loadComputeFromFile(shader_path)) {
+        LOGE("Failed to load image based lighting shader: {}", shader_path);
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipeline_info.stage.module = shader.getComputeShader();
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = bake_pipeline_layout_;
+
+    try {
+        auto result = context_->getDevice().createComputePipeline(context_->getPipelineCache(), pipeline_info);
+        pipeline = result.value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create compute pipeline for {}: {}", shader_path, e.what());
+        return false;
+    }
+}
+
+void ImageBasedLighting::updateBakeDescriptorSets() {
+    vk::DescriptorImageInfo environment_info{ environment_sampler_, environment_view_,
+        vk::ImageLayout::eShaderReadOnlyOptimal };
+
+    std::vector<vk::WriteDescriptorSet> descriptor_writes;
+    std::vector<vk::DescriptorSet> sets = prefilter_bake_sets_;
+    sets.push_back(irradiance_bake_set_);
+
+    for (auto set : sets) {
+        vk::WriteDescriptorSet write{};
+        write.dstSet = set;
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        write.descriptorCount = 1;
+        write.pImageInfo = &environment_info;
+        descriptor_writes.push_back(write);
+    }
+
+    context_->getDevice().updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+}
+
+std::vector<vk::BufferImageCopy> ImageBasedLighting::getCopyRegions(const LightingMap& map,
+    vk::DeviceSize base_offset) const {
+    std::vector<vk::BufferImageCopy> regions(map.mip_levels);
+    vk::DeviceSize offset = base_offset;
+
+    // Mip levels back to back, each holding all layers tightly packed.
+    for (uint32_t level = 0; level < map.mip_levels; level++) {
+        uint32_t level_size = std::max(map.size >> level, 1u);
+
+        regions[level].bufferOffset = offset;
+        regions[level].bufferRowLength = 0;
+        regions[level].bufferImageHeight = 0;
+        regions[level].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        regions[level].imageSubresource.mipLevel = level;
+        regions[level].imageSubresource.baseArrayLayer = 0;
+        regions[level].imageSubresource.layerCount = map.layers;
+        regions[level].imageOffset = vk::Offset3D{ 0, 0, 0 };
+        regions[level].imageExtent = vk::Extent3D{ level_size, level_size, 1 };
+
+        offset += static_cast<vk::DeviceSize>(level_size) * level_size * map.layers * TEXEL_SIZE;
+    }
+
+    return regions;
+}
+
+void ImageBasedLighting::recordTransition(vk::CommandBuffer command_buffer, vk::ImageLayout old_layout,
+    vk::ImageLayout new_layout, vk::AccessFlags src_access, vk::AccessFlags dst_access,
+    vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage) {
+    std::array<vk::ImageMemoryBarrier, 3> barriers{};
+    std::array<const LightingMap*, 3> maps = { &irradiance_map_, &prefiltered_map_, &brdf_lut_ };
+
+    for (size_t i = 0; i < barriers.size(); i++) {
+        barriers[i].oldLayout = old_layout;
+        barriers[i].newLayout = new_layout;
+        barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].srcAccessMask = src_access;
+        barriers[i].dstAccessMask = dst_access;
+        barriers[i].image = maps[i]->image;
+        barriers[i].subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor,
+            0, maps[i]->mip_levels, 0, maps[i]->layers };
+    }
+
+    command_buffer.pipelineBarrier(src_stage, dst_stage, vk::DependencyFlags{},
+        0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void ImageBasedLighting::recordDispatch(vk::CommandBuffer command_buffer, vk::Pipeline pipeline,
+    vk::DescriptorSet set, uint32_t size, uint32_t layers, float roughness) {
+    BakeParams params{};
+    params.face_size = size;
+    params.roughness = roughness;
+
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+        bake_pipeline_layout_, 0, 1, &set, 0, nullptr);
+    command_buffer.pushConstants(bake_pipeline_layout_, vk::ShaderStageFlagBits::eCompute,
+        0, sizeof(BakeParams), &params);
+
+    uint32_t group_count = (size + BAKE_GROUP_SIZE - 1) / BAKE_GROUP_SIZE;
+    command_buffer.dispatch(group_count, group_count, layers);
+}
+
+void ImageBasedLighting::recordReadback(vk::CommandBuffer command_buffer) {
+    for (const LightingMap* map : { &irradiance_map_, &prefiltered_map_, &brdf_lut_ }) {
+        auto regions = getCopyRegions(*map, map->data_offset);
+        command_buffer.copyImageToBuffer(map->image, vk::ImageLayout::eTransferSrcOptimal, readback_buffer_,
+            static_cast<uint32_t>(regions.size()), regions.data());
+    }
+
+    vk::BufferMemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback_buffer_;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+        vk::DependencyFlags{}, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+bool ImageBasedLighting::loadFromCache(uint64_t environment_key) {
+    std::string path = getCachePath(environment_key);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto file_size = static_cast<size_t>(file.tellg());
+    if (file_size != sizeof(IBLCacheFileHeader) + data_size_) {
+        LOGW("Image based lighting cache has the wrong size, ignoring: {}", path);
+        return false;
+    }
+
+    IBLCacheFileHeader header{};
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (header.magic != MAGIC || header.version != VERSION ||
+        header.irradiance_size != IRRADIANCE_SIZE || header.prefiltered_size != PREFILTERED_SIZE ||
+        header.prefiltered_mip_levels != PREFILTERED_MIP_LEVELS || header.brdf_lut_size != BRDF_LUT_SIZE ||
+        header.environment_key != environment_key || header.data_size != data_size_) {
+        LOGW("Image based lighting cache is stale, ignoring: {}", path);
+        return false;
+    }
+
+    std::vector<unsigned char> data(static_cast<size_t>(data_size_));
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (!file) {
+        LOGW("Failed to read image based lighting cache: {}", path);
+        return false;
+    }
+
+    for (const LightingMap* map : { &irradiance_map_, &prefiltered_map_, &brdf_lut_ }) {
+        vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, map->mip_levels, 0, map->layers };
+        if (!context_->getUploadService().uploadImage(map->image, data.data() + map->data_offset,
+            map->data_size, getCopyRegions(*map, 0), range)) {
+            LOGE("Failed to upload image based lighting cache: {}", path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ImageBasedLighting::writeCache() {
+    std::error_code error;
+    std::filesystem::create_directories(CACHE_DIR, error);
+    if (error) {
+        LOGW("Failed to create image based lighting cache directory: {}", error.message());
+        return false;
+    }
+
+    IBLCacheFileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.irradiance_size = IRRADIANCE_SIZE;
+    header.prefiltered_size = PREFILTERED_SIZE;
+    header.prefiltered_mip_levels = PREFILTERED_MIP_LEVELS;
+    header.brdf_lut_size = BRDF_LUT_SIZE;
+    header.environment_key = environment_key_;
+    header.data_size = data_size_;
+
+    std::string cache_path = getCachePath(environment_key_);
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOGW("Failed to create image based lighting cache file: {}", temp_path);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(readback_allocation_.mapped), static_cast<std::streamsize>(data_size_));
+
+        if (!file) {
+            LOGW("Failed to write image based lighting cache file: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error) {
+        LOGW("Failed to move image based lighting cache into place: {}", error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    LOGI("Image based lighting baked and cached: {}", cache_path);
+    return true;
+}
+
+std::string ImageBasedLighting::getCachePath(uint64_t environment_key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ibl", static_cast<unsigned long long>(environment_key));
+    return (std::filesystem::path(CACHE_DIR) / name).string();
+}
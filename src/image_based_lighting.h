@@ -0,0 +1,143 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class VulkanContext;
+
+struct IBLCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t irradiance_size;
+    uint32_t prefiltered_size;
+    uint32_t prefiltered_mip_levels;
+    uint32_t brdf_lut_size;
+    uint64_t environment_key;
+    uint64_t data_size;
+};
+
+// Split-sum image based lighting derived from the skybox cubemap: a diffuse
+// irradiance cube, a specular cube prefiltered per roughness mip level and the
+// BRDF integration LUT. The three are bound as one descriptor set, so shading
+// costs three fetches per pixel.
+//
+// The maps are baked by compute dispatches recorded into a frame's command
+// buffer (recordBake()). A bake of a new environment is read back and written
+// to CACHE_DIR, keyed on the environment, so later runs just upload the file.
+class ImageBasedLighting {
+public:
+    ImageBasedLighting(std::shared_ptr<VulkanContext> context);
+    ~ImageBasedLighting();
+
+    // Creates the maps cleared to black, so the descriptor set is valid before
+    // the first bake.
+    bool initialize();
+    void cleanup();
+
+    // Points the bake at a new environment cubemap. A cached bake for
+    // `environment_key` is uploaded right away, otherwise the next recordBake()
+    // bakes and persists it. Frames sampling the old maps must have finished.
+    bool setEnvironment(vk::ImageView environment_view, vk::Sampler environment_sampler,
+        uint64_t environment_key);
+    // Re-bakes the current environment in place, e.g. after its contents changed
+    // on the GPU; such bakes are not written to disk.
+    void invalidate();
+
+    // Graphics side, called once per frame by the renderer: beginFrame() after
+    // the frame's fence wait, recordBake() outside a render pass, after the
+    // environment cubemap has been written for this frame.
+    void beginFrame(uint32_t frame_index);
+    void recordBake(vk::CommandBuffer command_buffer, uint32_t frame_index);
+
+    void bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t set) const;
+
+    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
+    vk::DescriptorSet getDescriptorSet() const { return descriptor_set_; }
+
+private:
+    struct LightingMap {
+        vk::Image image;
+        GpuAllocation allocation;
+        vk::ImageView view;
+        std::vector<vk::ImageView> storage_views; // one per mip level
+        uint32_t size = 0;
+        uint32_t mip_levels = 1;
+        uint32_t layers = 1;
+        vk::DeviceSize data_offset = 0; // position in the cache file payload
+        vk::DeviceSize data_size = 0;
+    };
+
+    bool createMap(LightingMap& map, uint32_t size, uint32_t mip_levels, uint32_t layers);
+    void destroyMap(LightingMap& map);
+    bool clearMaps();
+    bool createSamplers();
+    bool createDescriptorSetLayouts();
+    bool createDescriptorPool();
+    bool createDescriptorSets();
+    bool createBakePipelines();
+    bool createBakePipeline(const std::string& shader_path, vk::Pipeline& pipeline);
+    void updateBakeDescriptorSets();
+
+    std::vector<vk::BufferImageCopy> getCopyRegions(const LightingMap& map, vk::DeviceSize base_offset) const;
+    void recordTransition(vk::CommandBuffer command_buffer, vk::ImageLayout old_layout,
+        vk::ImageLayout new_layout, vk::AccessFlags src_access, vk::AccessFlags dst_access,
+        vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage);
+    void recordDispatch(vk::CommandBuffer command_buffer, vk::Pipeline pipeline, vk::DescriptorSet set,
+        uint32_t size, uint32_t layers, float roughness);
+    void recordReadback(vk::CommandBuffer command_buffer);
+
+    bool loadFromCache(uint64_t environment_key);
+    bool writeCache();
+    std::string getCachePath(uint64_t environment_key) const;
+
+    std::shared_ptr<VulkanContext> context_;
+
+    LightingMap irradiance_map_;
+    LightingMap prefiltered_map_;
+    LightingMap brdf_lut_;
+    vk::DeviceSize data_size_;
+
+    vk::Sampler map_sampler_;
+    vk::Sampler lut_sampler_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorSetLayout bake_descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    vk::DescriptorSet descriptor_set_;
+    vk::DescriptorSet irradiance_bake_set_;
+    std::vector<vk::DescriptorSet> prefilter_bake_sets_;
+    vk::DescriptorSet brdf_bake_set_;
+
+    vk::PipelineLayout bake_pipeline_layout_;
+    vk::Pipeline irradiance_pipeline_;
+    vk::Pipeline prefilter_pipeline_;
+    vk::Pipeline brdf_pipeline_;
+
+    vk::ImageView environment_view_;
+    vk::Sampler environment_sampler_;
+    uint64_t environment_key_;
+
+    bool bake_pending_;
+    bool persist_bake_;
+    bool brdf_lut_valid_;
+
+    vk::Buffer readback_buffer_;
+    GpuAllocation readback_allocation_;
+    bool readback_pending_;
+    uint32_t readback_frame_;
+
+    static constexpr uint32_t IRRADIANCE_SIZE = 32;
+    static constexpr uint32_t PREFILTERED_SIZE = 128;
+    static constexpr uint32_t PREFILTERED_MIP_LEVELS = 5;
+    static constexpr uint32_t BRDF_LUT_SIZE = 256;
+    static constexpr vk::Format MAP_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+    static constexpr vk::DeviceSize TEXEL_SIZE = 8;
+
+    static constexpr uint32_t MAGIC = 0x4C424949; // "IIBL"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* CACHE_DIR = "ibl_cache";
+};
@@ -0,0 +1,179 @@
+#include "job_system.h"
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+// Identifies the pool and deque a worker thread belongs to, so submissions
+// from inside a job land on the submitting worker's own deque.
+thread_local const JobSystem* t_owner = nullptr;
+thread_local size_t t_worker_index = 0;
+
+// Shared by one parallelFor call and the helper jobs it queues. Indices are
+// claimed from `next`; a helper that starts after all of them are taken
+// returns without touching func, so only the state outlives the call.
+struct ParallelForState {
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> remaining{ 0 };
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+void runIndices(ParallelForState& state, size_t count, const std::function<void(size_t)>& func) {
+    for (size_t i = state.next.fetch_add(1, std::memory_order_relaxed); i < count;
+        i = state.next.fetch_add(1, std::memory_order_relaxed)) {
+        try {
+            func(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.error) state.error = std::current_exception();
+        }
+
+        if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.done.notify_all();
+        }
+    }
+}
+
+}
+
+JobSystem::JobSystem(uint32_t worker_count)
+    : pending_jobs_(0), next_queue_(0), stopping_(false) {
+    if (worker_count == 0) {
+        // hardware_concurrency() may report 0 when it cannot tell.
+        unsigned hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    queues_.reserve(worker_count);
+    for (uint32_t i = 0; i < worker_count; i++) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers_.reserve(worker_count);
+    for (uint32_t i = 0; i < worker_count; i++) {
+        workers_.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_condition_.notify_all();
+
+    // Workers drain every queued job before they exit.
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t)>& func) {
+    if (count == 0) return;
+
+    auto state = std::make_shared<ParallelForState>();
+    state->remaining.store(count, std::memory_order_relaxed);
+
+    size_t helper_count = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helper_count; i++) {
+        push([state, count, &func]() { runIndices(*state, count, func); });
+    }
+
+    // The caller only ever runs indices of this call: unrelated jobs, such as
+    // a pipeline build or a PNG encode, would stall it for their whole length.
+    runIndices(*state, count, func);
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state]() { return state->remaining.load(std::memory_order_acquire) == 0; });
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+bool JobSystem::runPendingJob() {
+    Job job;
+    bool found = t_owner == this
+        ? popLocal(t_worker_index, job) || steal(t_worker_index, job)
+        : steal(queues_.size(), job);
+
+    if (!found) return false;
+
+    job();
+    return true;
+}
+
+void JobSystem::push(Job job) {
+    size_t index = t_owner == this
+        ? t_worker_index
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    // Count the job before it becomes visible so a thief can never take it
+    // while the counter still reads zero.
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        pending_jobs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->jobs.push_back(std::move(job));
+    }
+    wake_condition_.notify_one();
+}
+
+bool JobSystem::popLocal(size_t index, Job& job) {
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    pending_jobs_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::steal(size_t thief, Job& job) {
+    size_t count = queues_.size();
+    for (size_t offset = 1; offset <= count; offset++) {
+        size_t index = (thief + offset) % count;
+        if (index == thief) continue;
+
+        auto& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        pending_jobs_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_owner = this;
+    t_worker_index = index;
+
+    while (true) {
+        Job job;
+        if (popLocal(index, job) || steal(index, job)) {
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_condition_.wait(lock, [this]() {
+            return stopping_ || pending_jobs_.load(std::memory_order_relaxed) > 0;
+        });
+        if (stopping_ && pending_jobs_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing thread pool for CPU-side asset work (decode, parse, generate).
+//
+// Every worker owns a deque: jobs submitted from a worker go to the back of its
+// own deque and are popped LIFO, jobs submitted from other threads are spread
+// round-robin. An idle worker steals from the front of the other deques.
+// Threads that wait on work they spawned (parallelFor) run queued jobs instead
+// of blocking, so nested parallelism never starves the pool.
+class JobSystem {
+public:
+    // worker_count 0 uses one worker per hardware thread, minus the caller's.
+    explicit JobSystem(uint32_t worker_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    template <typename Func>
+    auto submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>> {
+        using Result = std::invoke_result_t<std::decay_t<Func>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> future = task->get_future();
+        push([task]() { (*task)(); });
+        return future;
+    }
+
+    // Runs func(0) .. func(count - 1) across the pool and returns once all have
+    // finished. The calling thread claims indices alongside the workers but
+    // never runs other jobs, so this is safe inside a job and cannot stall a
+    // frame behind unrelated work. The first exception thrown by func is
+    // rethrown here once every index has finished.
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    // Runs one queued job on the calling thread; false if none was available.
+    bool runPendingJob();
+
+    uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+    using Job = std::function<void()>;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void push(Job job);
+    bool popLocal(size_t index, Job& job);
+    bool steal(size_t thief, Job& job);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_condition_;
+    std::atomic<size_t> pending_jobs_;
+    std::atomic<size_t> next_queue_;
+    bool stopping_;
+};
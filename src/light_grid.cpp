@@ -0,0 +1,379 @@
+#include "light_grid.h"
+#include "vulkan_context.h"
+#include "shader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t CULLING_GROUP_SIZE = 64;
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+LightGrid::LightGrid(std::shared_ptr<VulkanContext> context)
+    : context_(context), frame_count_(0), light_capacity_(0),
+    light_region_size_(0), cluster_region_size_(0), revision_(1) {
+}
+
+LightGrid::~LightGrid() {
+    cleanup();
+}
+
+bool LightGrid::initialize(uint32_t light_capacity) {
+    frame_count_ = VulkanContext::MAX_FRAMES_IN_FLIGHT;
+    region_revisions_.assign(frame_count_, 0);
+
+    if (!createDescriptorSetLayout()) {
+        LOGE("Failed to create light grid descriptor set layout");
+        return false;
+    }
+
+    if (!createDescriptorPool()) {
+        LOGE("Failed to create light grid descriptor pool");
+        return false;
+    }
+
+    if (!createLightBuffer(std::max(light_capacity, 1u)) || !createClusterBuffer()) {
+        LOGE("Failed to create light grid buffers");
+        return false;
+    }
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+    try {
+        descriptor_set_ = context_->getDevice().allocateDescriptorSets(alloc_info)[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate light grid descriptor set: {}", e.what());
+        return false;
+    }
+
+    updateDescriptorSet();
+
+    if (!createCullingPipeline()) {
+        LOGE("Failed to create light culling pipeline");
+        return false;
+    }
+
+    LOGI("Light grid initialized: {}x{}x{} clusters, capacity for {} lights",
+        GRID_X, GRID_Y, GRID_Z, light_capacity_);
+    return true;
+}
+
+void LightGrid::cleanup() {
+    if (!context_) return;
+
+    auto device = context_->getDevice();
+    auto& allocator = context_->getAllocator();
+
+    lights_.clear();
+
+    if (culling_pipeline_) {
+        device.destroyPipeline(culling_pipeline_);
+        culling_pipeline_ = nullptr;
+    }
+
+    if (culling_pipeline_layout_) {
+        device.destroyPipelineLayout(culling_pipeline_layout_);
+        culling_pipeline_layout_ = nullptr;
+    }
+
+    if (light_buffer_) {
+        allocator.destroyBuffer(light_buffer_, light_buffer_allocation_);
+    }
+
+    if (cluster_buffer_) {
+        allocator.destroyBuffer(cluster_buffer_, cluster_buffer_allocation_);
+    }
+
+    if (descriptor_pool_) {
+        device.destroyDescriptorPool(descriptor_pool_);
+        descriptor_pool_ = nullptr;
+    }
+
+    if (descriptor_set_layout_) {
+        device.destroyDescriptorSetLayout(descriptor_set_layout_);
+        descriptor_set_layout_ = nullptr;
+    }
+}
+
+uint32_t LightGrid::addLight(const PointLight& light) {
+    lights_.push_back(light);
+    revision_++;
+    return static_cast<uint32_t>(lights_.size() - 1);
+}
+
+void LightGrid::setLight(uint32_t light_id, const PointLight& light) {
+    lights_[light_id] = light;
+    revision_++;
+}
+
+void LightGrid::clearLights() {
+    lights_.clear();
+    revision_++;
+}
+
+bool LightGrid::update(uint32_t frame_index, const glm::mat4& view, const glm::mat4& projection,
+    vk::Extent2D extent, float near_plane, float far_plane) {
+    if (lights_.size() > light_capacity_) {
+        uint32_t light_capacity = light_capacity_;
+        while (light_capacity < lights_.size()) {
+            light_capacity *= 2;
+        }
+
+        if (!growLightBuffer(light_capacity)) {
+            LOGE("Failed to grow light buffer to {} lights", light_capacity);
+            return false;
+        }
+
+        std::fill(region_revisions_.begin(), region_revisions_.end(), 0);
+        LOGI("Light buffer grown to {} lights", light_capacity_);
+    }
+
+    uint32_t region = frame_index % frame_count_;
+    char* region_data = static_cast<char*>(light_buffer_allocation_.mapped) + light_region_size_ * region;
+
+    float log_depth_range = std::log(far_plane / near_plane);
+
+    LightGridHeader header{};
+    header.view = view;
+    header.inverse_projection = glm::inverse(projection);
+    header.grid_size = glm::uvec4(GRID_X, GRID_Y, GRID_Z, static_cast<uint32_t>(lights_.size()));
+    header.depth_params = glm::vec4(near_plane, far_plane,
+        GRID_Z / log_depth_range, GRID_Z * std::log(near_plane) / log_depth_range);
+    header.tile_size = glm::vec4(
+        std::ceil(static_cast<float>(extent.width) / GRID_X),
+        std::ceil(static_cast<float>(extent.height) / GRID_Y),
+        static_cast<float>(extent.width), static_cast<float>(extent.height));
+    memcpy(region_data, &header, sizeof(header));
+
+    if (region_revisions_[region] != revision_) {
+        memcpy(region_data + sizeof(LightGridHeader), lights_.data(), lights_.size() * sizeof(PointLight));
+        region_revisions_[region] = revision_;
+    }
+
+    return true;
+}
+
+void LightGrid::recordCulling(vk::CommandBuffer command_buffer, uint32_t frame_index) {
+    uint32_t region = frame_index % frame_count_;
+    std::array<uint32_t, 2> dynamic_offsets = {
+        static_cast<uint32_t>(light_region_size_ * region),
+        static_cast<uint32_t>(cluster_region_size_ * region)
+    };
+
+    // The region was last read by the frame that previously used this slot,
+    // which its fence wait has already retired.
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, culling_pipeline_);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, culling_pipeline_layout_,
+        0, 1, &descriptor_set_, static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+    command_buffer.dispatch((CLUSTER_COUNT + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+}
+
+void LightGrid::bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t set,
+    uint32_t frame_index) const {
+    uint32_t region = frame_index % frame_count_;
+    std::array<uint32_t, 2> dynamic_offsets = {
+        static_cast<uint32_t>(light_region_size_ * region),
+        static_cast<uint32_t>(cluster_region_size_ * region)
+    };
+
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout,
+        set, 1, &descriptor_set_, static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+}
+
+bool LightGrid::createDescriptorSetLayout() {
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorCount = 1;
+        bindings[i].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+        bindings[i].pImmutableSamplers = nullptr;
+        bindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eFragment;
+    }
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    try {
+        descriptor_set_layout_ = context_->getDevice().createDescriptorSetLayout(layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create light grid descriptor set layout: {}", e.what());
+        return false;
+    }
+}
+
+bool LightGrid::createDescriptorPool() {
+    // Room for the sets retired by at most one growth per frame in flight.
+    const uint32_t set_count = 1 + VulkanContext::MAX_FRAMES_IN_FLIGHT;
+
+    vk::DescriptorPoolSize pool_size{};
+    pool_size.type = vk::DescriptorType::eStorageBufferDynamic;
+    pool_size.descriptorCount = 2 * set_count;
+
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = set_count;
+
+    try {
+        descriptor_pool_ = context_->getDevice().createDescriptorPool(pool_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create light grid descriptor pool: {}", e.what());
+        return false;
+    }
+}
+
+bool LightGrid::createCullingPipeline() {
+    auto device = context_->getDevice();
+
+    Shader shader(context_);
+    if (!shader.loadComputeFromFile(SHADER_DIR "light_cull.comp")) {
+        LOGE("Failed to load light culling shader");
+        return false;
+    }
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &descriptor_set_layout_;
+
+    try {
+        culling_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create light culling pipeline layout: {}", e.what());
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipeline_info.stage.module = shader.getComputeShader();
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = culling_pipeline_layout_;
+
+    try {
+        auto result = device.createComputePipeline(context_->getPipelineCache(), pipeline_info);
+        culling_pipeline_ = result.value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create light culling pipeline: {}", e.what());
+        return false;
+    }
+}
+
+bool LightGrid::createLightBuffer(uint32_t light_capacity) {
+    auto limits = context_->getPhysicalDevice().getProperties().limits;
+
+    light_region_size_ = alignUp(sizeof(LightGridHeader) + sizeof(PointLight) * light_capacity,
+        std::max<vk::DeviceSize>(limits.minStorageBufferOffsetAlignment, 16));
+
+    if (!context_->getAllocator().createBuffer(light_region_size_ * frame_count_,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        light_buffer_, light_buffer_allocation_)) {
+        return false;
+    }
+
+    light_capacity_ = light_capacity;
+    return true;
+}
+
+bool LightGrid::growLightBuffer(uint32_t light_capacity) {
+    auto device = context_->getDevice();
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+    vk::DescriptorSet descriptor_set;
+    try {
+        descriptor_set = device.allocateDescriptorSets(alloc_info)[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate light grid descriptor set: {}", e.what());
+        return false;
+    }
+
+    // The current buffer stays in use if the larger one cannot be created.
+    vk::Buffer old_buffer = light_buffer_;
+    GpuAllocation old_allocation = light_buffer_allocation_;
+    vk::DeviceSize old_region_size = light_region_size_;
+    light_buffer_ = nullptr;
+    light_buffer_allocation_ = {};
+
+    if (!createLightBuffer(light_capacity)) {
+        light_buffer_ = old_buffer;
+        light_buffer_allocation_ = old_allocation;
+        light_region_size_ = old_region_size;
+        device.freeDescriptorSets(descriptor_pool_, 1, &descriptor_set);
+        return false;
+    }
+
+    // Frames in flight still read the old buffer through the old set; both
+    // are destroyed once those frames complete.
+    GpuAllocator* allocator = &context_->getAllocator();
+    vk::DescriptorPool pool = descriptor_pool_;
+    vk::DescriptorSet old_set = descriptor_set_;
+    context_->retire([allocator, device, pool, old_set, old_buffer, old_allocation]() mutable {
+        allocator->destroyBuffer(old_buffer, old_allocation);
+        device.freeDescriptorSets(pool, 1, &old_set);
+    });
+
+    descriptor_set_ = descriptor_set;
+    updateDescriptorSet();
+    return true;
+}
+
+bool LightGrid::createClusterBuffer() {
+    auto limits = context_->getPhysicalDevice().getProperties().limits;
+
+    vk::DeviceSize cluster_size = sizeof(uint32_t) * (MAX_LIGHTS_PER_CLUSTER + 1);
+    cluster_region_size_ = alignUp(cluster_size * CLUSTER_COUNT,
+        std::max<vk::DeviceSize>(limits.minStorageBufferOffsetAlignment, 16));
+
+    return context_->getAllocator().createBuffer(cluster_region_size_ * frame_count_,
+        vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        cluster_buffer_, cluster_buffer_allocation_);
+}
+
+void LightGrid::updateDescriptorSet() {
+    std::array<vk::DescriptorBufferInfo, 2> buffer_infos{};
+    buffer_infos[0].buffer = light_buffer_;
+    buffer_infos[0].offset = 0;
+    buffer_infos[0].range = light_region_size_;
+    buffer_infos[1].buffer = cluster_buffer_;
+    buffer_infos[1].offset = 0;
+    buffer_infos[1].range = cluster_region_size_;
+
+    std::array<vk::WriteDescriptorSet, 2> descriptor_writes{};
+    for (uint32_t i = 0; i < descriptor_writes.size(); i++) {
+        descriptor_writes[i].dstSet = descriptor_set_;
+        descriptor_writes[i].dstBinding = i;
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pBufferInfo = &buffer_infos[i];
+    }
+
+    context_->getDevice().updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "uniform_buffer.h"
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+class VulkanContext;
+
+// Header of each light list region, followed by the PointLight array.
+// Mirrors LightBuffer in light_cull.comp and default.frag.
+struct LightGridHeader {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 inverse_projection;
+    alignas(16) glm::uvec4 grid_size;   // clusters in x, y, z; w = light count
+    alignas(16) glm::vec4 depth_params; // near, far, slice scale, slice bias
+    alignas(16) glm::vec4 tile_size;    // pixels per cluster in x, y; screen size in z, w
+};
+
+// Clustered forward lighting. The light list lives in a host-visible storage
+// buffer with one region per frame in flight, like Scene's objects; a compute
+// pass bins it into GRID_X * GRID_Y * GRID_Z view-space clusters (screen tiles
+// times exponential depth slices) and the fragment shader only walks the list
+// of its own cluster. Both buffers are bound as one set with dynamic offsets.
+class LightGrid {
+public:
+    LightGrid(std::shared_ptr<VulkanContext> context);
+    ~LightGrid();
+
+    bool initialize(uint32_t light_capacity = 256);
+    void cleanup();
+
+    uint32_t addLight(const PointLight& light);
+    void setLight(uint32_t light_id, const PointLight& light);
+    void clearLights();
+    size_t getLightCount() const { return lights_.size(); }
+    // Recreated when the light capacity grows.
+    vk::Buffer getClusterBuffer() const { return cluster_buffer_; }
+
+    // Writes this frame's region; `projection` is the one used for rendering.
+    bool update(uint32_t frame_index, const glm::mat4& view, const glm::mat4& projection,
+        vk::Extent2D extent, float near_plane, float far_plane);
+    // Must be recorded outside a render pass, before the lit draws. The caller
+    // orders the compute writes to the cluster buffer before fragment reads.
+    void recordCulling(vk::CommandBuffer command_buffer, uint32_t frame_index);
+    void bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t set,
+        uint32_t frame_index) const;
+
+    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
+
+    static constexpr uint32_t GRID_X = 16;
+    static constexpr uint32_t GRID_Y = 9;
+    static constexpr uint32_t GRID_Z = 24;
+    static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+    // Must match light_cull.comp and default.frag.
+    static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+private:
+    bool createDescriptorSetLayout();
+    bool createDescriptorPool();
+    bool createCullingPipeline();
+    bool createLightBuffer(uint32_t light_capacity);
+    bool growLightBuffer(uint32_t light_capacity);
+    bool createClusterBuffer();
+    void updateDescriptorSet();
+
+    std::shared_ptr<VulkanContext> context_;
+
+    std::vector<PointLight> lights_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    vk::DescriptorSet descriptor_set_;
+
+    vk::PipelineLayout culling_pipeline_layout_;
+    vk::Pipeline culling_pipeline_;
+
+    vk::Buffer light_buffer_;
+    GpuAllocation light_buffer_allocation_;
+    vk::Buffer cluster_buffer_;
+    GpuAllocation cluster_buffer_allocation_;
+
+    uint32_t frame_count_;
+    uint32_t light_capacity_;
+    vk::DeviceSize light_region_size_;
+    vk::DeviceSize cluster_region_size_;
+
+    uint64_t revision_;
+    std::vector<uint64_t> region_revisions_; // light list revision last written to each region
+};
@@ -1,50 +1,99 @@
-#include "vulkan_renderer.h"
-#include "utils/logger.h"
-#include <iostream>
-#include <stdexcept>
-
-int main() {
-
-	if (!Logger::getInstance().init("VulkanRenderer", "logs/Renderer.log", LogLevel::INFO)) {
-		std::cerr << "Failed to initialize logger" << std::endl;
-		return -1;
-	}
-
-	LOGI("Starting Vulkan Renderer");
-
-	try {
-		VulkanRenderer renderer;
-
-		if (!renderer.initialize(1280, 720, "Vulkan PBR Renderer")) {
-			LOGE("Failed to initialize Renderer");
-			return -1;
-		}
-		
-		if (!renderer.loadModel(MODEL_DIR "Chair/Chair.obj")) {
-			LOGE("Failed to load model");
-			return -1;
-		}
-		
-		if (!renderer.loadTexture(MODEL_DIR "Chair/Texture/Chair/Chair_Base_color.png")) {
-			LOGW("Failed to load custom texture");
-		}
-		
-		if (!renderer.createDefaultSkyBox()) {
-			LOGE("Failed to create default skybox");
-			return -1;
-		}
-
-		LOGI("Renderer initialized successfully, starting main loop");
-		renderer.run();
-
-	}
-	catch (const std::exception& e) {
-		LOGE("Renderer error: {}", e.what());
-		Logger::getInstance().shutdown();
-		return -1;
-	}
-
-	LOGI("Renderer shutting down");
-	Logger::getInstance().shutdown();
-	return 0;
-}
+#include "vulkan_renderer.h"
+#include "utils/logger.h"
+#include <iostream>
+#include <stdexcept>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv) {
+
+	// --headless [frames] renders offscreen into output/ instead of opening a window.
+	// --record-camera <file> saves the camera path of the session for RenderBenchmark.
+	// --hot-reload rebuilds shaders and reloads the texture when their files change.
+	// --no-vulkan13 keeps 1.3 devices on the render pass and descriptor set path.
+	bool headless = false;
+	bool hot_reload = false;
+	bool vulkan13_path = true;
+	uint32_t headless_frames = 300;
+	std::string camera_path_file;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			headless = true;
+			if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+				headless_frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+		}
+		else if (strcmp(argv[i], "--hot-reload") == 0) {
+			hot_reload = true;
+		}
+		else if (strcmp(argv[i], "--no-vulkan13") == 0) {
+			vulkan13_path = false;
+		}
+		else if (strcmp(argv[i], "--record-camera") == 0 && i + 1 < argc) {
+			camera_path_file = argv[++i];
+		}
+	}
+
+	if (!Logger::getInstance().init("VulkanRenderer", "logs/Renderer.log", LogLevel::INFO)) {
+		std::cerr << "Failed to initialize logger" << std::endl;
+		return -1;
+	}
+
+	LOGI("Starting Vulkan Renderer");
+
+	try {
+		VulkanRenderer renderer;
+		renderer.setCameraPathRecording(camera_path_file);
+		renderer.setHotReloadEnabled(hot_reload);
+		renderer.setVulkan13PathEnabled(vulkan13_path);
+
+		bool initialized = headless ? renderer.initializeHeadless(1280, 720) :
+			renderer.initialize(1280, 720, "Vulkan PBR Renderer");
+		if (!initialized) {
+			LOGE("Failed to initialize Renderer");
+			return -1;
+		}
+		
+		// Decode and parse all assets concurrently, then finish them on this thread.
+		auto model = renderer.requestModel(MODEL_DIR "Chair/Chair.obj");
+		auto texture = renderer.requestTexture(MODEL_DIR "Chair/Texture/Chair/Chair_Base_color.png");
+		auto skybox = renderer.requestDefaultSkyBox();
+		renderer.finishPendingLoads();
+		
+		if (!model.get()) {
+			LOGE("Failed to load model");
+			return -1;
+		}
+		
+		if (!texture.get()) {
+			LOGW("Failed to load custom texture");
+		}
+		
+		if (!skybox.get()) {
+			LOGE("Failed to create default skybox");
+			return -1;
+		}
+
+		if (headless) {
+			if (renderer.renderOffscreen(headless_frames, "output") < 0.0) {
+				LOGE("Failed to render offscreen");
+				return -1;
+			}
+		}
+		else {
+			LOGI("Renderer initialized successfully, starting main loop");
+			renderer.run();
+		}
+
+	}
+	catch (const std::exception& e) {
+		LOGE("Renderer error: {}", e.what());
+		Logger::getInstance().shutdown();
+		return -1;
+	}
+
+	LOGI("Renderer shutting down");
+	Logger::getInstance().shutdown();
+	return 0;
+}
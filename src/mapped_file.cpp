@@ -0,0 +1,165 @@
+#include "mapped_file.h"
+#include "utils/logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : data_(nullptr), size_(0), file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(nullptr) {
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_),
+    file_handle_(other.file_handle_), mapping_handle_(other.mapping_handle_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.file_handle_ = INVALID_HANDLE_VALUE;
+    other.mapping_handle_ = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        file_handle_ = other.file_handle_;
+        mapping_handle_ = other.mapping_handle_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.file_handle_ = INVALID_HANDLE_VALUE;
+        other.mapping_handle_ = nullptr;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    file_handle_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle_, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle_) {
+        LOGE("Failed to create file mapping: {}", filename);
+        close();
+        return false;
+    }
+
+    data_ = MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+    if (!data_) {
+        LOGE("Failed to map view of file: {}", filename);
+        close();
+        return false;
+    }
+
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+
+    if (mapping_handle_) {
+        CloseHandle(mapping_handle_);
+        mapping_handle_ = nullptr;
+    }
+
+    if (file_handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle_);
+        file_handle_ = INVALID_HANDLE_VALUE;
+    }
+
+    size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : data_(nullptr), size_(0), file_descriptor_(-1) {
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), file_descriptor_(other.file_descriptor_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.file_descriptor_ = -1;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        file_descriptor_ = other.file_descriptor_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.file_descriptor_ = -1;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    file_descriptor_ = ::open(filename.c_str(), O_RDONLY);
+    if (file_descriptor_ < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file_descriptor_, &file_stat) != 0 || file_stat.st_size == 0) {
+        close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor_, 0);
+    if (data == MAP_FAILED) {
+        LOGE("Failed to map file: {}", filename);
+        close();
+        return false;
+    }
+
+    data_ = data;
+    size_ = static_cast<size_t>(file_stat.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<void*>(data_), size_);
+        data_ = nullptr;
+    }
+
+    if (file_descriptor_ >= 0) {
+        ::close(file_descriptor_);
+        file_descriptor_ = -1;
+    }
+
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
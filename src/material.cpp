@@ -1,342 +1,375 @@
-#include "material.h"
-#include "vulkan_context.h"
-#include "utils/logger.h"
-
-Material::Material(std::shared_ptr<VulkanContext> context) : context_(context) {
-}
-
-Material::~Material() {
-	cleanup();
-}
-
-bool Material::initialize() {
-	if (!createDescriptorSetLayout()) {
-		LOGE("Failed to create descriptor set layout");
-		return false;
-	}
-
-	if (!createUniformBuffers()) {
-		LOGE("Failed to create uniform buffers");
-		return false;
-	}
-
-	if (!createDescriptorPool()) {
-		LOGE("Failed to create descriptor pool");
-		return false;
-	}
-	
-	LOGI("Material initialized successfully");
-	return true;
-}
-
-void Material::cleanup() {
-	auto device = context_->getDevice();
-
-	if (uniform_buffer_) {
-		device.destroyBuffer(uniform_buffer_);
-		device.freeMemory(uniform_buffer_memory_);
-	}
-
-	if (material_buffer_) {
-		device.destroyBuffer(material_buffer_);
-		device.freeMemory(material_buffer_memory_);
-	}
-
-	if (light_buffer_) {
-		device.destroyBuffer(light_buffer_);
-		device.freeMemory(light_buffer_memory_);
-	}
-
-	if (descriptor_pool_) {
-		device.destroyDescriptorPool(descriptor_pool_);
-	}
-
-	if (descriptor_set_layout_) {
-		device.destroyDescriptorSetLayout(descriptor_set_layout_);
-	}
-}
-
-void Material::setPBRProperties(const glm::vec3& albedo, float metallic, float roughness, float ao) {
-	pbr_material_.albedo = albedo;
-	pbr_material_.metallic = metallic;
-	pbr_material_.roughness = roughness;
-	pbr_material_.ao = ao;
-	
-	auto device = context_->getDevice();
-	void* data = device.mapMemory(material_buffer_memory_, 0, sizeof(PBRMaterial));
-	memcpy(data, &pbr_material_, sizeof(PBRMaterial));
-	device.unmapMemory(material_buffer_memory_);
-}
-
-void Material::setLightProperties(const glm::vec3& position, const glm::vec3& color) {
-	light_data_.position = position;
-	light_data_.color = color;
-	
-	auto device = context_->getDevice();
-	void* data = device.mapMemory(light_buffer_memory_, 0, sizeof(LightData));
-	memcpy(data, &light_data_, sizeof(LightData));
-	device.unmapMemory(light_buffer_memory_);
-}
-
-bool Material::setTexture(std::shared_ptr<Texture> texture) {
-	if (!texture) {
-		LOGE("Cannot set null texture");
-		return false;
-	}
-	
-	texture_ = texture;
-	
-	if (!descriptor_pool_) {
-		LOGE("Cannot create descriptor sets: descriptor pool is null");
-		return false;
-	}
-
-	if (!descriptor_set_layout_) {
-		LOGE("Cannot create descriptor sets: descriptor set layout is null");
-		return false;
-	}
-	
-	return createDescriptorSets();
-}
-
-void Material::updateUniforms(const UniformBufferObject& ubo) {
-	auto device = context_->getDevice();
-	void* data = device.mapMemory(uniform_buffer_memory_, 0, sizeof(UniformBufferObject));
-	memcpy(data, &ubo, sizeof(UniformBufferObject));
-	device.unmapMemory(uniform_buffer_memory_);
-}
-
-void Material::bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout) {
-	command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-		pipeline_layout, 0, 1, &descriptor_set_, 0, nullptr);
-}
-
-bool Material::createDescriptorSetLayout() {
-	auto device = context_->getDevice();
-
-	std::array<vk::DescriptorSetLayoutBinding, 4> bindings{};
-	
-	bindings[0].binding = 0;
-	bindings[0].descriptorCount = 1;
-	bindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-	bindings[0].pImmutableSamplers = nullptr;
-	bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-	
-	bindings[1].binding = 1;
-	bindings[1].descriptorCount = 1;
-	bindings[1].descriptorType = vk::DescriptorType::eUniformBuffer;
-	bindings[1].pImmutableSamplers = nullptr;
-	bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
-	
-	bindings[2].binding = 2;
-	bindings[2].descriptorCount = 1;
-	bindings[2].descriptorType = vk::DescriptorType::eUniformBuffer;
-	bindings[2].pImmutableSamplers = nullptr;
-	bindings[2].stageFlags = vk::ShaderStageFlagBits::eFragment;
-
-	bindings[3].binding = 3;
-	bindings[3].descriptorCount = 1;
-	bindings[3].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-	bindings[3].pImmutableSamplers = nullptr;
-	bindings[3].stageFlags = vk::ShaderStageFlagBits::eFragment;
-
-	vk::DescriptorSetLayoutCreateInfo layout_info{};
-	layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
-	layout_info.pBindings = bindings.data();
-
-	try {
-		descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
-		return true;
-	}
-	catch (const std::exception& e) {
-		LOGE("Failed to create descriptor set layout: {}", e.what());
-		return false;
-	}
-}
-
-bool Material::createDescriptorPool() {
-	auto device = context_->getDevice();
-
-	std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
-	pool_sizes[0].type = vk::DescriptorType::eUniformBuffer;
-	pool_sizes[0].descriptorCount = 10;
-	pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-	pool_sizes[1].descriptorCount = 10;
-
-	vk::DescriptorPoolCreateInfo pool_info{};
-	pool_info.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
-	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
-	pool_info.pPoolSizes = pool_sizes.data();
-	pool_info.maxSets = 5;
-
-	try {
-		descriptor_pool_ = device.createDescriptorPool(pool_info);
-		return true;
-	}
-	catch (const std::exception& e) {
-		LOGE("Failed to create descriptor pool: {}", e.what());
-		return false;
-	}
-}
-
-bool Material::createDescriptorSets() {
-	auto device = context_->getDevice();
-
-	vk::DescriptorSetAllocateInfo alloc_info{};
-	alloc_info.descriptorPool = descriptor_pool_;
-	alloc_info.descriptorSetCount = 1;
-	alloc_info.pSetLayouts = &descriptor_set_layout_;
-
-	try {
-		auto descriptor_sets = device.allocateDescriptorSets(alloc_info);
-		descriptor_set_ = descriptor_sets[0];
-	}
-	catch (const std::exception& e) {
-		LOGE("Failed to allocate descriptor sets: {}", e.what());
-		return false;
-	}
-
-	std::vector<vk::WriteDescriptorSet> descriptor_writes;
-
-	vk::DescriptorBufferInfo buffer_info{};
-	buffer_info.buffer = uniform_buffer_;
-	buffer_info.offset = 0;
-	buffer_info.range = sizeof(UniformBufferObject);
-
-	descriptor_writes.emplace_back();
-	auto& ubo_write = descriptor_writes.back();
-	ubo_write.dstSet = descriptor_set_;
-	ubo_write.dstBinding = 0;
-	ubo_write.dstArrayElement = 0;
-	ubo_write.descriptorType = vk::DescriptorType::eUniformBuffer;
-	ubo_write.descriptorCount = 1;
-	ubo_write.pBufferInfo = &buffer_info;
-
-	vk::DescriptorBufferInfo material_buffer_info{};
-	material_buffer_info.buffer = material_buffer_;
-	material_buffer_info.offset = 0;
-	material_buffer_info.range = sizeof(PBRMaterial);
-
-	descriptor_writes.emplace_back();
-	auto& material_write = descriptor_writes.back();
-	material_write.dstSet = descriptor_set_;
-	material_write.dstBinding = 1;
-	material_write.dstArrayElement = 0;
-	material_write.descriptorType = vk::DescriptorType::eUniformBuffer;
-	material_write.descriptorCount = 1;
-	material_write.pBufferInfo = &material_buffer_info;
-
-	vk::DescriptorBufferInfo light_buffer_info{};
-	light_buffer_info.buffer = light_buffer_;
-	light_buffer_info.offset = 0;
-	light_buffer_info.range = sizeof(LightData);
-
-	descriptor_writes.emplace_back();
-	auto& light_write = descriptor_writes.back();
-	light_write.dstSet = descriptor_set_;
-	light_write.dstBinding = 2;
-	light_write.dstArrayElement = 0;
-	light_write.descriptorType = vk::DescriptorType::eUniformBuffer;
-	light_write.descriptorCount = 1;
-	light_write.pBufferInfo = &light_buffer_info;
-
-	vk::DescriptorImageInfo image_info{};
-	if (texture_) {
-		image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-		image_info.imageView = texture_->getImageView();
-		image_info.sampler = texture_->getSampler();
-	}
-
-	descriptor_writes.emplace_back();
-	auto& texture_write = descriptor_writes.back();
-	texture_write.dstSet = descriptor_set_;
-	texture_write.dstBinding = 3;
-	texture_write.dstArrayElement = 0;
-	texture_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
-	texture_write.descriptorCount = 1;
-	texture_write.pImageInfo = &image_info;
-
-	device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
-		descriptor_writes.data(), 0, nullptr);
-	return true;
-}
-
-bool Material::createUniformBuffers() {
-	auto device = context_->getDevice();
-	
-	vk::DeviceSize buffer_size = sizeof(UniformBufferObject);
-	if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eUniformBuffer,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-		uniform_buffer_, uniform_buffer_memory_)) {
-		return false;
-	}
-	
-	buffer_size = sizeof(PBRMaterial);
-	if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eUniformBuffer,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-		material_buffer_, material_buffer_memory_)) {
-		return false;
-	}
-	
-	buffer_size = sizeof(LightData);
-	if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eUniformBuffer,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-		light_buffer_, light_buffer_memory_)) {
-		return false;
-	}
-	
-	setPBRProperties(glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, 0.5f, 1.0f);
-	setLightProperties(glm::vec3(10.0f, 10.0f, 10.0f), glm::vec3(300.0f));
-
-	return true;
-}
-
-bool Material::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-	vk::MemoryPropertyFlags properties,
-	vk::Buffer& buffer, vk::DeviceMemory& buffer_memory) {
-	auto device = context_->getDevice();
-
-	vk::BufferCreateInfo buffer_info{};
-	buffer_info.size = size;
-	buffer_info.usage = usage;
-	buffer_info.sharingMode = vk::SharingMode::eExclusive;
-
-	try {
-		buffer = device.createBuffer(buffer_info);
-	}
-	catch (const std::exception& e) {
-		LOGE("Failed to create buffer: {}", e.what());
-		return false;
-	}
-
-	vk::MemoryRequirements mem_requirements = device.getBufferMemoryRequirements(buffer);
-
-	vk::MemoryAllocateInfo alloc_info{};
-	alloc_info.allocationSize = mem_requirements.size;
-	alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, properties);
-
-	try {
-		buffer_memory = device.allocateMemory(alloc_info);
-		device.bindBufferMemory(buffer, buffer_memory, 0);
-	}
-	catch (const std::exception& e) {
-		LOGE("Failed to allocate buffer memory: {}", e.what());
-		device.destroyBuffer(buffer);
-		return false;
-	}
-
-	return true;
-}
-
-uint32_t Material::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) {
-	vk::PhysicalDeviceMemoryProperties mem_properties = context_->getPhysicalDevice().getMemoryProperties();
-
-	for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-		if ((type_filter & (1 << i)) &&
-			(mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-			return i;
-		}
-	}
-
-	throw std::runtime_error("Failed to find suitable memory type!");
-}
+#include "material.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+
+Material::Material(std::shared_ptr<VulkanContext> context)
+	: context_(context), ubo_offset_(0), bindless_table_(context->getBindlessTable()),
+	push_descriptors_(context->supportsPushDescriptors()), bindless_material_(BindlessTable::INVALID_INDEX),
+	bindless_texture_(BindlessTable::INVALID_INDEX) {
+}
+
+Material::~Material() {
+	cleanup();
+}
+
+bool Material::initialize() {
+	if (bindless_table_) {
+		bindless_material_ = bindless_table_->addMaterial(BindlessMaterial{});
+		if (bindless_material_ == BindlessTable::INVALID_INDEX) {
+			return false;
+		}
+	}
+
+	if (!createDescriptorSetLayout()) {
+		LOGE("Failed to create descriptor set layout");
+		return false;
+	}
+
+	if (!createUniformBuffers()) {
+		LOGE("Failed to create uniform buffers");
+		return false;
+	}
+
+	// Pushed descriptors need no sets to allocate.
+	if (!push_descriptors_ && !createDescriptorPool()) {
+		LOGE("Failed to create descriptor pool");
+		return false;
+	}
+	
+	LOGI("Material initialized successfully");
+	return true;
+}
+
+void Material::cleanup() {
+	// Everything, including the bindless slots, is released once the frames
+	// that may still read the material complete.
+	vk::Device device = context_->getDevice();
+	GpuAllocator* allocator = &context_->getAllocator();
+	context_->retire([device, allocator, bindless_table = bindless_table_, buffer = material_buffer_,
+		allocation = material_buffer_allocation_, bindless_texture = bindless_texture_,
+		bindless_material = bindless_material_, pool = descriptor_pool_, layout = descriptor_set_layout_]() mutable {
+		if (buffer) allocator->destroyBuffer(buffer, allocation);
+
+		if (bindless_table) {
+			if (bindless_texture != BindlessTable::INVALID_INDEX) bindless_table->releaseTexture(bindless_texture);
+			if (bindless_material != BindlessTable::INVALID_INDEX) bindless_table->releaseMaterial(bindless_material);
+		}
+
+		if (pool) device.destroyDescriptorPool(pool);
+		if (layout) device.destroyDescriptorSetLayout(layout);
+	});
+
+	material_buffer_ = nullptr;
+	material_buffer_allocation_ = {};
+	bindless_texture_ = BindlessTable::INVALID_INDEX;
+	bindless_material_ = BindlessTable::INVALID_INDEX;
+	descriptor_pool_ = nullptr;
+	descriptor_set_ = nullptr;
+	descriptor_set_layout_ = nullptr;
+}
+
+void Material::setPBRProperties(const glm::vec3& albedo, float metallic, float roughness, float ao) {
+	pbr_material_.albedo = albedo;
+	pbr_material_.metallic = metallic;
+	pbr_material_.roughness = roughness;
+	pbr_material_.ao = ao;
+	
+	memcpy(material_buffer_allocation_.mapped, &pbr_material_, sizeof(PBRMaterial));
+	updateBindlessRecord();
+}
+
+bool Material::setTexture(std::shared_ptr<Texture> texture) {
+	if (!texture) {
+		LOGE("Cannot set null texture");
+		return false;
+	}
+	
+	// Frames in flight may still sample the old texture, through its bindless
+	// slot or the old descriptor set; all of them are retired.
+	std::shared_ptr<Texture> old_texture = std::move(texture_);
+	texture_ = texture;
+	if (old_texture) {
+		context_->retire([old_texture]() {});
+	}
+
+	if (bindless_table_) {
+		uint32_t old_index = bindless_texture_;
+		bindless_texture_ = bindless_table_->addTexture(texture_->getImageView(), texture_->getSampler());
+		if (old_index != BindlessTable::INVALID_INDEX) {
+			BindlessTable* table = bindless_table_;
+			context_->retire([table, old_index]() { table->releaseTexture(old_index); });
+		}
+		if (bindless_texture_ == BindlessTable::INVALID_INDEX) {
+			return false;
+		}
+		updateBindlessRecord();
+
+		// Set 0 then only holds the camera uniforms, which never change.
+		if (descriptor_set_) {
+			return true;
+		}
+	}
+
+	// The texture is pushed with the next bind.
+	if (push_descriptors_) {
+		return true;
+	}
+	
+	if (!descriptor_pool_) {
+		LOGE("Cannot create descriptor sets: descriptor pool is null");
+		return false;
+	}
+
+	if (!descriptor_set_layout_) {
+		LOGE("Cannot create descriptor sets: descriptor set layout is null");
+		return false;
+	}
+
+	if (descriptor_set_) {
+		vk::Device device = context_->getDevice();
+		vk::DescriptorPool pool = descriptor_pool_;
+		vk::DescriptorSet old_set = descriptor_set_;
+		context_->retire([device, pool, old_set]() { device.freeDescriptorSets(pool, 1, &old_set); });
+	}
+	
+	return createDescriptorSets();
+}
+
+void Material::updateUniforms(const UniformBufferObject& ubo) {
+	ubo_offset_ = context_->getUniformRing().push(ubo);
+}
+
+void Material::bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout) {
+	if (push_descriptors_) {
+		pushDescriptors(command_buffer, pipeline_layout);
+	}
+	else {
+		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+			pipeline_layout, 0, 1, &descriptor_set_, 1, &ubo_offset_);
+	}
+
+	if (bindless_table_) {
+		bindless_table_->bind(command_buffer, pipeline_layout, BindlessTable::DESCRIPTOR_SET);
+
+		DrawPushConstants push_constants{};
+		push_constants.material_index = bindless_material_;
+		command_buffer.pushConstants(pipeline_layout, vk::ShaderStageFlagBits::eFragment,
+			0, sizeof(DrawPushConstants), &push_constants);
+	}
+}
+
+// Same bindings as createDescriptorSets(), with the camera uniforms at their
+// ring offset directly: pushed descriptors cannot be dynamic.
+void Material::pushDescriptors(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout) const {
+	vk::DescriptorBufferInfo buffer_info{};
+	buffer_info.buffer = context_->getUniformRing().getBuffer();
+	buffer_info.offset = ubo_offset_;
+	buffer_info.range = sizeof(UniformBufferObject);
+
+	vk::DescriptorBufferInfo material_buffer_info{};
+	material_buffer_info.buffer = material_buffer_;
+	material_buffer_info.offset = 0;
+	material_buffer_info.range = sizeof(PBRMaterial);
+
+	vk::DescriptorImageInfo image_info{};
+	if (texture_) {
+		image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		image_info.imageView = texture_->getImageView();
+		image_info.sampler = texture_->getSampler();
+	}
+
+	std::array<vk::WriteDescriptorSet, 3> descriptor_writes{};
+	descriptor_writes[0].dstBinding = 0;
+	descriptor_writes[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+	descriptor_writes[0].descriptorCount = 1;
+	descriptor_writes[0].pBufferInfo = &buffer_info;
+
+	descriptor_writes[1].dstBinding = 1;
+	descriptor_writes[1].descriptorType = vk::DescriptorType::eUniformBuffer;
+	descriptor_writes[1].descriptorCount = 1;
+	descriptor_writes[1].pBufferInfo = &material_buffer_info;
+
+	descriptor_writes[2].dstBinding = 3;
+	descriptor_writes[2].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	descriptor_writes[2].descriptorCount = 1;
+	descriptor_writes[2].pImageInfo = &image_info;
+
+	uint32_t write_count = bindless_table_ ? 1 : texture_ ? 3 : 2;
+	context_->cmdPushDescriptorSet(command_buffer, vk::PipelineBindPoint::eGraphics, pipeline_layout, 0,
+		write_count, descriptor_writes.data());
+}
+
+void Material::updateBindlessRecord() {
+	if (!bindless_table_ || bindless_material_ == BindlessTable::INVALID_INDEX) return;
+
+	BindlessMaterial record{};
+	record.albedo = pbr_material_.albedo;
+	record.metallic = pbr_material_.metallic;
+	record.roughness = pbr_material_.roughness;
+	record.ao = pbr_material_.ao;
+	record.albedo_texture = bindless_texture_ != BindlessTable::INVALID_INDEX ? bindless_texture_ : 0;
+	bindless_table_->updateMaterial(bindless_material_, record);
+}
+
+bool Material::createDescriptorSetLayout() {
+	auto device = context_->getDevice();
+
+	std::vector<vk::DescriptorSetLayoutBinding> bindings(3);
+	
+	bindings[0].binding = 0;
+	bindings[0].descriptorCount = 1;
+	bindings[0].descriptorType = push_descriptors_ ?
+		vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eUniformBufferDynamic;
+	bindings[0].pImmutableSamplers = nullptr;
+	bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+	
+	bindings[1].binding = 1;
+	bindings[1].descriptorCount = 1;
+	bindings[1].descriptorType = vk::DescriptorType::eUniformBuffer;
+	bindings[1].pImmutableSamplers = nullptr;
+	bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
+	
+	// Binding 2 held the single light; lights now come from the LightGrid set.
+	bindings[2].binding = 3;
+	bindings[2].descriptorCount = 1;
+	bindings[2].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	bindings[2].pImmutableSamplers = nullptr;
+	bindings[2].stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+	// The bindless table holds the material record and the texture instead.
+	if (bindless_table_) {
+		bindings.resize(1);
+	}
+
+	vk::DescriptorSetLayoutCreateInfo layout_info{};
+	if (push_descriptors_) {
+		layout_info.flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR;
+	}
+	layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+	layout_info.pBindings = bindings.data();
+
+	try {
+		descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
+		return true;
+	}
+	catch (const std::exception& e) {
+		LOGE("Failed to create descriptor set layout: {}", e.what());
+		return false;
+	}
+}
+
+bool Material::createDescriptorPool() {
+	auto device = context_->getDevice();
+
+	std::array<vk::DescriptorPoolSize, 3> pool_sizes{};
+	pool_sizes[0].type = vk::DescriptorType::eUniformBuffer;
+	pool_sizes[0].descriptorCount = 10;
+	pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
+	pool_sizes[1].descriptorCount = 10;
+	pool_sizes[2].type = vk::DescriptorType::eUniformBufferDynamic;
+	pool_sizes[2].descriptorCount = 5;
+
+	vk::DescriptorPoolCreateInfo pool_info{};
+	pool_info.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+	pool_info.pPoolSizes = pool_sizes.data();
+	pool_info.maxSets = 5;
+
+	try {
+		descriptor_pool_ = device.createDescriptorPool(pool_info);
+		return true;
+	}
+	catch (const std::exception& e) {
+		LOGE("Failed to create descriptor pool: {}", e.what());
+		return false;
+	}
+}
+
+bool Material::createDescriptorSets() {
+	auto device = context_->getDevice();
+
+	vk::DescriptorSetAllocateInfo alloc_info{};
+	alloc_info.descriptorPool = descriptor_pool_;
+	alloc_info.descriptorSetCount = 1;
+	alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+	try {
+		auto descriptor_sets = device.allocateDescriptorSets(alloc_info);
+		descriptor_set_ = descriptor_sets[0];
+	}
+	catch (const std::exception& e) {
+		LOGE("Failed to allocate descriptor sets: {}", e.what());
+		return false;
+	}
+
+	std::vector<vk::WriteDescriptorSet> descriptor_writes;
+
+	vk::DescriptorBufferInfo buffer_info{};
+	buffer_info.buffer = context_->getUniformRing().getBuffer();
+	buffer_info.offset = 0;
+	buffer_info.range = sizeof(UniformBufferObject);
+
+	descriptor_writes.emplace_back();
+	auto& ubo_write = descriptor_writes.back();
+	ubo_write.dstSet = descriptor_set_;
+	ubo_write.dstBinding = 0;
+	ubo_write.dstArrayElement = 0;
+	ubo_write.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+	ubo_write.descriptorCount = 1;
+	ubo_write.pBufferInfo = &buffer_info;
+
+	vk::DescriptorBufferInfo material_buffer_info{};
+	material_buffer_info.buffer = material_buffer_;
+	material_buffer_info.offset = 0;
+	material_buffer_info.range = sizeof(PBRMaterial);
+
+	if (bindless_table_) {
+		device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+			descriptor_writes.data(), 0, nullptr);
+		return true;
+	}
+
+	descriptor_writes.emplace_back();
+	auto& material_write = descriptor_writes.back();
+	material_write.dstSet = descriptor_set_;
+	material_write.dstBinding = 1;
+	material_write.dstArrayElement = 0;
+	material_write.descriptorType = vk::DescriptorType::eUniformBuffer;
+	material_write.descriptorCount = 1;
+	material_write.pBufferInfo = &material_buffer_info;
+
+	vk::DescriptorImageInfo image_info{};
+	if (texture_) {
+		image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		image_info.imageView = texture_->getImageView();
+		image_info.sampler = texture_->getSampler();
+	}
+
+	descriptor_writes.emplace_back();
+	auto& texture_write = descriptor_writes.back();
+	texture_write.dstSet = descriptor_set_;
+	texture_write.dstBinding = 3;
+	texture_write.dstArrayElement = 0;
+	texture_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	texture_write.descriptorCount = 1;
+	texture_write.pImageInfo = &image_info;
+
+	device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+		descriptor_writes.data(), 0, nullptr);
+	return true;
+}
+
+bool Material::createUniformBuffers() {
+	auto& allocator = context_->getAllocator();
+	
+	vk::DeviceSize buffer_size = sizeof(PBRMaterial);
+	if (!allocator.createBuffer(buffer_size, vk::BufferUsageFlagBits::eUniformBuffer,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		material_buffer_, material_buffer_allocation_)) {
+		return false;
+	}
+	
+	setPBRProperties(glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, 0.5f, 1.0f);
+
+	return true;
+}
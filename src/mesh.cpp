@@ -1,180 +1,192 @@
-#include "mesh.h"
-#include "vulkan_context.h"
-#include "utils/logger.h"
-
-Mesh::Mesh(std::shared_ptr<VulkanContext> context)
-    : context_(context), vertex_count_(0), index_count_(0) {
-}
-
-Mesh::~Mesh() {
-    cleanup();
-}
-
-bool Mesh::create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-    vertex_count_ = vertices.size();
-    index_count_ = indices.size();
-
-    if (!createVertexBuffer(vertices)) {
-        LOGE("Failed to create vertex buffer");
-        return false;
-    }
-
-    if (!createIndexBuffer(indices)) {
-        LOGE("Failed to create index buffer");
-        return false;
-    }
-
-    LOGI("Mesh created with {} vertices and {} indices", vertex_count_, index_count_);
-    return true;
-}
-
-void Mesh::cleanup() {
-    auto device = context_->getDevice();
-    
-    if (vertex_buffer_) {
-        device.destroyBuffer(vertex_buffer_);
-        device.freeMemory(vertex_buffer_memory_);
-        vertex_buffer_ = nullptr;
-    }
-    
-    if (index_buffer_) {
-        device.destroyBuffer(index_buffer_);
-        device.freeMemory(index_buffer_memory_);
-        index_buffer_ = nullptr;
-    }
-}
-
-void Mesh::draw(vk::CommandBuffer command_buffer) const {
-    vk::Buffer vertex_buffers[] = { vertex_buffer_ };
-    vk::DeviceSize offsets[] = { 0 };
-    
-    command_buffer.bindVertexBuffers(0, 1, vertex_buffers, offsets);
-    command_buffer.bindIndexBuffer(index_buffer_, 0, vk::IndexType::eUint32);
-    command_buffer.drawIndexed(static_cast<uint32_t>(index_count_), 1, 0, 0, 0);
-}
-
-bool Mesh::createVertexBuffer(const std::vector<Vertex>& vertices) {
-    vk::DeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
-    
-    vk::Buffer staging_buffer;
-    vk::DeviceMemory staging_buffer_memory;
-    
-    if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc,
-                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                     staging_buffer, staging_buffer_memory)) {
-        return false;
-    }
-    
-    auto device = context_->getDevice();
-    void* data = device.mapMemory(staging_buffer_memory, 0, buffer_size);
-    memcpy(data, vertices.data(), static_cast<size_t>(buffer_size));
-    device.unmapMemory(staging_buffer_memory);
-    
-    if (!createBuffer(buffer_size, 
-                     vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     vertex_buffer_, vertex_buffer_memory_)) {
-        device.destroyBuffer(staging_buffer);
-        device.freeMemory(staging_buffer_memory);
-        return false;
-    }
-    
-    copyBuffer(staging_buffer, vertex_buffer_, buffer_size);
-    
-    device.destroyBuffer(staging_buffer);
-    device.freeMemory(staging_buffer_memory);
-    
-    return true;
-}
-
-bool Mesh::createIndexBuffer(const std::vector<uint32_t>& indices) {
-    vk::DeviceSize buffer_size = sizeof(indices[0]) * indices.size();
-    
-    vk::Buffer staging_buffer;
-    vk::DeviceMemory staging_buffer_memory;
-    
-    if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc,
-                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                     staging_buffer, staging_buffer_memory)) {
-        return false;
-    }
-    
-    auto device = context_->getDevice();
-    void* data = device.mapMemory(staging_buffer_memory, 0, buffer_size);
-    memcpy(data, indices.data(), static_cast<size_t>(buffer_size));
-    device.unmapMemory(staging_buffer_memory);
-    
-    if (!createBuffer(buffer_size,
-                     vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     index_buffer_, index_buffer_memory_)) {
-        device.destroyBuffer(staging_buffer);
-        device.freeMemory(staging_buffer_memory);
-        return false;
-    }
-    
-    copyBuffer(staging_buffer, index_buffer_, buffer_size);
-    
-    device.destroyBuffer(staging_buffer);
-    device.freeMemory(staging_buffer_memory);
-    
-    return true;
-}
-
-bool Mesh::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-                       vk::MemoryPropertyFlags properties,
-                       vk::Buffer& buffer, vk::DeviceMemory& buffer_memory) {
-    auto device = context_->getDevice();
-    
-    vk::BufferCreateInfo buffer_info{};
-    buffer_info.size = size;
-    buffer_info.usage = usage;
-    buffer_info.sharingMode = vk::SharingMode::eExclusive;
-    
-    try {
-        buffer = device.createBuffer(buffer_info);
-    } catch (const std::exception& e) {
-        LOGE("Failed to create buffer: {}", e.what());
-        return false;
-    }
-    
-    vk::MemoryRequirements mem_requirements = device.getBufferMemoryRequirements(buffer);
-    
-    vk::MemoryAllocateInfo alloc_info{};
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, properties);
-    
-    try {
-        buffer_memory = device.allocateMemory(alloc_info);
-        device.bindBufferMemory(buffer, buffer_memory, 0);
-    } catch (const std::exception& e) {
-        LOGE("Failed to allocate buffer memory: {}", e.what());
-        device.destroyBuffer(buffer);
-        return false;
-    }
-    
-    return true;
-}
-
-void Mesh::copyBuffer(vk::Buffer src_buffer, vk::Buffer dst_buffer, vk::DeviceSize size) {
-    vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
-    
-    vk::BufferCopy copy_region{};
-    copy_region.size = size;
-    command_buffer.copyBuffer(src_buffer, dst_buffer, 1, &copy_region);
-    
-    context_->endSingleTimeCommands(command_buffer);
-}
-
-uint32_t Mesh::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties mem_properties = context_->getPhysicalDevice().getMemoryProperties();
-    
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((type_filter & (1 << i)) && 
-            (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-    
-    throw std::runtime_error("Failed to find suitable memory type!");
-}
+#include "mesh.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// Octahedral encoding of a unit vector: project onto the octahedron, fold the
+// lower half over the upper one. Decoded in default.vert.
+glm::vec2 encodeOctahedral(const glm::vec3& direction) {
+    float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (sum <= 0.0f) return glm::vec2(0.0f);
+
+    glm::vec2 encoded = glm::vec2(direction.x, direction.y) / sum;
+    if (direction.z < 0.0f) {
+        encoded = glm::vec2((1.0f - std::abs(encoded.y)) * signNotZero(encoded.x),
+            (1.0f - std::abs(encoded.x)) * signNotZero(encoded.y));
+    }
+    return encoded;
+}
+
+uint16_t quantizeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Quantizes against the vertices' bounding box and returns the box transform
+// that maps the unorm positions back to object space.
+glm::mat4 packVertices(const Vertex* vertices, size_t vertex_count, std::vector<PackedVertex>& packed) {
+    glm::vec3 minimum(FLT_MAX);
+    glm::vec3 maximum(-FLT_MAX);
+    for (size_t i = 0; i < vertex_count; i++) {
+        minimum = glm::min(minimum, vertices[i].position);
+        maximum = glm::max(maximum, vertices[i].position);
+    }
+    if (vertex_count == 0) {
+        minimum = maximum = glm::vec3(0.0f);
+    }
+
+    glm::vec3 extent = maximum - minimum;
+    glm::vec3 inverse_extent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+        extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+    packed.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count; i++) {
+        const Vertex& vertex = vertices[i];
+        PackedVertex& out = packed[i];
+
+        glm::vec3 position = (vertex.position - minimum) * inverse_extent;
+        out.position[0] = quantizeUnorm16(position.x);
+        out.position[1] = quantizeUnorm16(position.y);
+        out.position[2] = quantizeUnorm16(position.z);
+        // Vertex carries no handedness; the bitangent is cross(normal, tangent).
+        out.position[3] = quantizeUnorm16(1.0f);
+
+        out.normal = glm::packSnorm2x16(encodeOctahedral(vertex.normal));
+        out.tangent = glm::packSnorm2x16(encodeOctahedral(vertex.tangent));
+        out.tex_coord = glm::packHalf2x16(vertex.tex_coord);
+    }
+
+    return glm::scale(glm::translate(glm::mat4(1.0f), minimum), extent);
+}
+
+}
+
+Mesh::Mesh(std::shared_ptr<VulkanContext> context, VertexFormat format)
+    : context_(context), format_(format), position_transform_(1.0f), index_type_(vk::IndexType::eUint32),
+    vertex_count_(0), index_count_(0) {
+}
+
+Mesh::~Mesh() {
+    cleanup();
+}
+
+bool Mesh::create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    return create(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+bool Mesh::create(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count) {
+    vertex_count_ = vertex_count;
+    index_count_ = index_count;
+    lods_.assign(1, MeshLod{ 0, static_cast<uint32_t>(index_count), 0.0f });
+
+    bool vertices_created;
+    if (format_ == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed;
+        position_transform_ = packVertices(vertices, vertex_count, packed);
+        vertices_created = createDeviceBuffer(packed.data(), sizeof(PackedVertex) * vertex_count,
+            vk::BufferUsageFlagBits::eVertexBuffer, vertex_buffer_, vertex_buffer_allocation_);
+    }
+    else {
+        position_transform_ = glm::mat4(1.0f);
+        vertices_created = createDeviceBuffer(vertices, sizeof(Vertex) * vertex_count,
+            vk::BufferUsageFlagBits::eVertexBuffer, vertex_buffer_, vertex_buffer_allocation_);
+    }
+
+    if (!vertices_created) {
+        LOGE("Failed to create vertex buffer");
+        return false;
+    }
+
+    // Indices narrow to 16 bits whenever every vertex is addressable, which
+    // halves index memory and fetch bandwidth. Primitive restart is never
+    // enabled, so 0xFFFF is an ordinary index.
+    bool indices_created;
+    if (vertex_count <= MAX_UINT16_VERTEX_COUNT) {
+        index_type_ = vk::IndexType::eUint16;
+        std::vector<uint16_t> narrow(index_count);
+        for (size_t i = 0; i < index_count; i++) {
+            narrow[i] = static_cast<uint16_t>(indices[i]);
+        }
+        indices_created = createDeviceBuffer(narrow.data(), sizeof(uint16_t) * index_count,
+            vk::BufferUsageFlagBits::eIndexBuffer, index_buffer_, index_buffer_allocation_);
+    }
+    else {
+        index_type_ = vk::IndexType::eUint32;
+        indices_created = createDeviceBuffer(indices, sizeof(uint32_t) * index_count,
+            vk::BufferUsageFlagBits::eIndexBuffer, index_buffer_, index_buffer_allocation_);
+    }
+
+    if (!indices_created) {
+        LOGE("Failed to create index buffer");
+        return false;
+    }
+
+    LOGI("Mesh created with {} vertices and {} {}-bit indices", vertex_count_, index_count_,
+        index_type_ == vk::IndexType::eUint16 ? 16 : 32);
+    return true;
+}
+
+void Mesh::cleanup() {
+    if (!vertex_buffer_ && !index_buffer_) return;
+
+    // Frames in flight may still draw from the buffers; re-creating a mesh
+    // (streaming, LOD rebuilds) does not wait for them.
+    GpuAllocator* allocator = &context_->getAllocator();
+    context_->retire([allocator, vertex_buffer = vertex_buffer_, vertex_allocation = vertex_buffer_allocation_,
+        index_buffer = index_buffer_, index_allocation = index_buffer_allocation_]() mutable {
+        allocator->destroyBuffer(vertex_buffer, vertex_allocation);
+        allocator->destroyBuffer(index_buffer, index_allocation);
+    });
+
+    vertex_buffer_ = nullptr;
+    vertex_buffer_allocation_ = {};
+    index_buffer_ = nullptr;
+    index_buffer_allocation_ = {};
+}
+
+void Mesh::bind(vk::CommandBuffer command_buffer) const {
+    vk::Buffer vertex_buffers[] = { vertex_buffer_ };
+    vk::DeviceSize offsets[] = { 0 };
+    
+    command_buffer.bindVertexBuffers(0, 1, vertex_buffers, offsets);
+    command_buffer.bindIndexBuffer(index_buffer_, 0, index_type_);
+}
+
+void Mesh::draw(vk::CommandBuffer command_buffer, uint32_t lod) const {
+    const MeshLod& level = lods_[std::min(lod, getLodCount() - 1)];
+    bind(command_buffer);
+    command_buffer.drawIndexed(level.index_count, 1, level.first_index, 0, 0);
+}
+
+void Mesh::setLods(const MeshLod* lods, size_t lod_count) {
+    if (lod_count == 0) return;
+    lods_.assign(lods, lods + std::min<size_t>(lod_count, MAX_LODS));
+}
+
+uint32_t Mesh::selectLod(float projected_radius, float error_threshold) const {
+    uint32_t lod = 0;
+    while (lod + 1 < getLodCount() && lods_[lod + 1].error * projected_radius <= error_threshold) {
+        lod++;
+    }
+    return lod;
+}
+
+bool Mesh::createDeviceBuffer(const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage,
+    vk::Buffer& buffer, GpuAllocation& allocation) {
+    if (!context_->getAllocator().createBuffer(size,
+                     vk::BufferUsageFlagBits::eTransferDst | usage,
+                     vk::MemoryPropertyFlagBits::eDeviceLocal,
+                     buffer, allocation)) {
+        return false;
+    }
+    
+    return context_->getUploadService().uploadBuffer(buffer, data, size);
+}
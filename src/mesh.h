@@ -1,41 +1,71 @@
-#pragma once
-
-#include "vertex.h"
-#include <vulkan/vulkan.hpp>
-#include <vector>
-#include <memory>
-
-class VulkanContext;
-
-class Mesh {
-public:
-    Mesh(std::shared_ptr<VulkanContext> context);
-    ~Mesh();
-
-    bool create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-    void cleanup();
-    
-    void draw(vk::CommandBuffer command_buffer) const;
-    
-    size_t getVertexCount() const { return vertex_count_; }
-    size_t getIndexCount() const { return index_count_; }
-
-private:
-    bool createVertexBuffer(const std::vector<Vertex>& vertices);
-    bool createIndexBuffer(const std::vector<uint32_t>& indices);
-    bool createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-                     vk::MemoryPropertyFlags properties,
-                     vk::Buffer& buffer, vk::DeviceMemory& buffer_memory);
-    void copyBuffer(vk::Buffer src_buffer, vk::Buffer dst_buffer, vk::DeviceSize size);
-    uint32_t findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties);
-
-    std::shared_ptr<VulkanContext> context_;
-    
-    vk::Buffer vertex_buffer_;
-    vk::DeviceMemory vertex_buffer_memory_;
-    vk::Buffer index_buffer_;
-    vk::DeviceMemory index_buffer_memory_;
-    
-    size_t vertex_count_;
-    size_t index_count_;
-};
+#pragma once
+
+#include "vertex.h"
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <memory>
+
+class VulkanContext;
+
+// Vertex and index buffer of one model. The index buffer may hold several
+// levels of detail back to back, all indexing the same vertices; a mesh
+// created without LODs has a single level covering every index. Indices are
+// uploaded as 16-bit whenever the vertex count allows.
+//
+// With VertexFormat::Packed the vertices are quantized to PackedVertex on
+// upload; getPositionTransform() then maps the stored unorm positions back to
+// object space and must be applied before the model matrix.
+class Mesh {
+public:
+    Mesh(std::shared_ptr<VulkanContext> context, VertexFormat format = VertexFormat::Full);
+    ~Mesh();
+
+    bool create(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    bool create(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count);
+    void cleanup();
+    
+    void bind(vk::CommandBuffer command_buffer) const;
+    void draw(vk::CommandBuffer command_buffer, uint32_t lod = 0) const;
+    
+    size_t getVertexCount() const { return vertex_count_; }
+    size_t getIndexCount() const { return index_count_; }
+    VertexFormat getVertexFormat() const { return format_; }
+    // eUint16 whenever the vertex count allows, eUint32 otherwise.
+    vk::IndexType getIndexType() const { return index_type_; }
+    const glm::mat4& getPositionTransform() const { return position_transform_; }
+
+    // Replaces the single default level; ranges must lie within the index buffer.
+    void setLods(const MeshLod* lods, size_t lod_count);
+    const std::vector<MeshLod>& getLods() const { return lods_; }
+    uint32_t getLodCount() const { return static_cast<uint32_t>(lods_.size()); }
+
+    // Coarsest level whose error stays within `error_threshold` pixels for a
+    // mesh whose bounding sphere projects to `projected_radius` pixels.
+    uint32_t selectLod(float projected_radius, float error_threshold = 1.0f) const;
+
+    void setBounds(const BoundingSphere& bounds) { bounds_ = bounds; }
+    const BoundingSphere& getBounds() const { return bounds_; }
+
+    static constexpr uint32_t MAX_LODS = 6;
+    static constexpr size_t MAX_UINT16_VERTEX_COUNT = 1 << 16;
+
+private:
+    bool createDeviceBuffer(const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage,
+        vk::Buffer& buffer, GpuAllocation& allocation);
+
+    std::shared_ptr<VulkanContext> context_;
+    VertexFormat format_;
+    glm::mat4 position_transform_;
+    
+    vk::Buffer vertex_buffer_;
+    GpuAllocation vertex_buffer_allocation_;
+    vk::Buffer index_buffer_;
+    GpuAllocation index_buffer_allocation_;
+    vk::IndexType index_type_;
+    
+    size_t vertex_count_;
+    size_t index_count_;
+    BoundingSphere bounds_;
+    std::vector<MeshLod> lods_;
+};
@@ -0,0 +1,145 @@
+#include "mesh_cache.h"
+#include "utils/logger.h"
+#include <filesystem>
+#include <fstream>
+
+std::string MeshCache::getCachePath(const std::string& source_path) {
+    return source_path + ".meshcache";
+}
+
+bool MeshCache::getSourceStamp(const std::string& source_path, uint64_t& size, int64_t& timestamp) {
+    std::error_code error;
+    auto file_size = std::filesystem::file_size(source_path, error);
+    if (error) return false;
+
+    auto write_time = std::filesystem::last_write_time(source_path, error);
+    if (error) return false;
+
+    size = static_cast<uint64_t>(file_size);
+    timestamp = static_cast<int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+bool MeshCache::write(const std::string& cache_path, const std::string& source_path,
+    const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    const std::vector<MeshLod>& lods) {
+    MeshCacheHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertex_stride = sizeof(Vertex);
+    header.index_size = sizeof(uint32_t);
+    header.vertex_count = vertices.size();
+    header.index_count = indices.size();
+    header.lod_count = lods.size();
+
+    if (!getSourceStamp(source_path, header.source_size, header.source_timestamp)) {
+        LOGW("Cannot stat mesh source file: {}", source_path);
+        return false;
+    }
+
+    // Write to a temporary file first so an interrupted write never leaves a
+    // truncated cache that passes the header check.
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOGW("Failed to create mesh cache: {}", temp_path);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertices.data()), sizeof(Vertex) * vertices.size());
+        file.write(reinterpret_cast<const char*>(indices.data()), sizeof(uint32_t) * indices.size());
+        file.write(reinterpret_cast<const char*>(lods.data()), sizeof(MeshLod) * lods.size());
+
+        if (!file) {
+            LOGW("Failed to write mesh cache: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error) {
+        LOGW("Failed to move mesh cache into place: {}", error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    LOGI("Mesh cache written: {}", cache_path);
+    return true;
+}
+
+bool MeshCache::open(const std::string& cache_path, const std::string& source_path,
+    MappedFile& file, MeshCacheView& view) {
+    if (!file.open(cache_path)) {
+        return false;
+    }
+
+    if (file.getSize() < sizeof(MeshCacheHeader)) {
+        LOGW("Mesh cache too small, ignoring: {}", cache_path);
+        file.close();
+        return false;
+    }
+
+    const auto* header = static_cast<const MeshCacheHeader*>(file.getData());
+    if (header->magic != MAGIC || header->version != VERSION ||
+        header->vertex_stride != sizeof(Vertex) || header->index_size != sizeof(uint32_t)) {
+        LOGI("Mesh cache format mismatch, rebuilding: {}", cache_path);
+        file.close();
+        return false;
+    }
+
+    uint64_t source_size = 0;
+    int64_t source_timestamp = 0;
+    // A source that cannot be stat'ed cannot be proven unchanged.
+    if (!getSourceStamp(source_path, source_size, source_timestamp) ||
+        source_size != header->source_size || source_timestamp != header->source_timestamp) {
+        LOGI("Mesh cache out of date, rebuilding: {}", cache_path);
+        file.close();
+        return false;
+    }
+
+    // Each count is bounded by the file size before the products are summed,
+    // so a corrupt header cannot overflow its way past the size check.
+    uint64_t payload_size = file.getSize() - sizeof(MeshCacheHeader);
+    bool counts_fit = header->vertex_count <= payload_size / sizeof(Vertex) &&
+        header->index_count <= payload_size / sizeof(uint32_t) &&
+        header->lod_count <= payload_size / sizeof(MeshLod);
+    if (header->vertex_count == 0 || !counts_fit ||
+        payload_size < header->vertex_count * sizeof(Vertex) + header->index_count * sizeof(uint32_t) +
+        header->lod_count * sizeof(MeshLod)) {
+        LOGW("Mesh cache truncated, ignoring: {}", cache_path);
+        file.close();
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(file.getData()) + sizeof(MeshCacheHeader);
+    view.vertices = reinterpret_cast<const Vertex*>(data);
+    view.vertex_count = static_cast<size_t>(header->vertex_count);
+    view.indices = reinterpret_cast<const uint32_t*>(data + sizeof(Vertex) * view.vertex_count);
+    view.index_count = static_cast<size_t>(header->index_count);
+    view.lods = reinterpret_cast<const MeshLod*>(data + sizeof(Vertex) * view.vertex_count +
+        sizeof(uint32_t) * view.index_count);
+    view.lod_count = static_cast<size_t>(header->lod_count);
+
+    // The optimizer and the GPU index the vertices with these unchecked.
+    for (size_t i = 0; i < view.index_count; i++) {
+        if (view.indices[i] >= view.vertex_count) {
+            LOGW("Mesh cache index out of range, ignoring: {}", cache_path);
+            file.close();
+            view = MeshCacheView{};
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < view.lod_count; i++) {
+        if (static_cast<uint64_t>(view.lods[i].first_index) + view.lods[i].index_count > view.index_count) {
+            LOGW("Mesh cache LOD table corrupt, ignoring: {}", cache_path);
+            file.close();
+            view = MeshCacheView{};
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vertex.h"
+#include "mapped_file.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_stride;
+    uint32_t index_size;
+    uint64_t source_size;
+    int64_t source_timestamp;
+    uint64_t vertex_count;
+    uint64_t index_count;
+    uint64_t lod_count;
+};
+
+// Points into a mapped cache file; valid as long as the MappedFile is open.
+struct MeshCacheView {
+    const Vertex* vertices = nullptr;
+    size_t vertex_count = 0;
+    const uint32_t* indices = nullptr;
+    size_t index_count = 0;
+    const MeshLod* lods = nullptr;
+    size_t lod_count = 0;
+};
+
+// Binary cache of a processed model: header, raw Vertex array, uint32 index
+// array, MeshLod table. Vertices are stored already normalized, with tangents
+// and optimized, so a cached load is a single mapping with no parsing. A cache is rejected when its format
+// version or stride differs, when the source file's size or timestamp changed
+// or cannot be read, or when its counts or indices do not fit the file.
+class MeshCache {
+public:
+    static std::string getCachePath(const std::string& source_path);
+
+    static bool write(const std::string& cache_path, const std::string& source_path,
+        const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+        const std::vector<MeshLod>& lods);
+
+    static bool open(const std::string& cache_path, const std::string& source_path,
+        MappedFile& file, MeshCacheView& view);
+
+private:
+    static bool getSourceStamp(const std::string& source_path, uint64_t& size, int64_t& timestamp);
+
+    static constexpr uint32_t MAGIC = 0x4843534D; // "MSCH"
+    static constexpr uint32_t VERSION = 2;
+};
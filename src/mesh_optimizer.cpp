@@ -0,0 +1,614 @@
+#include "mesh_optimizer.h"
+#include "model_loader.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+// Forsyth's scoring constants, as published.
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+constexpr uint32_t MAX_VALENCE_SCORE = 32;
+
+// FIFO cache simulated by the overdraw pass to find cluster boundaries.
+constexpr uint32_t OVERDRAW_CACHE_SIZE = 16;
+
+constexpr size_t MIN_LOD_TRIANGLES = 64;
+constexpr float MAX_LOD_ERROR = 0.05f;
+
+// Triangles using each vertex, in compressed sparse row form. `counts` starts
+// as the valence and may be lowered as triangles are retired from the lists.
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> triangles;
+};
+
+void buildAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t index_count, size_t vertex_count) {
+    adjacency.counts.assign(vertex_count, 0);
+    for (size_t i = 0; i < index_count; i++) {
+        adjacency.counts[indices[i]]++;
+    }
+
+    adjacency.offsets.resize(vertex_count + 1);
+    adjacency.offsets[0] = 0;
+    for (size_t v = 0; v < vertex_count; v++) {
+        adjacency.offsets[v + 1] = adjacency.offsets[v] + adjacency.counts[v];
+    }
+
+    adjacency.triangles.resize(index_count);
+    std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < index_count; i++) {
+        adjacency.triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+// Symmetric plane quadric: sum of (n.p + d)^2 over the accumulated planes.
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+
+    void addPlane(const glm::vec3& n, float d) {
+        a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z;
+        a11 += n.y * n.y; a12 += n.y * n.z; a22 += n.z * n.z;
+        b0 += n.x * d; b1 += n.y * d; b2 += n.z * d;
+        c += static_cast<double>(d) * d;
+    }
+
+    void add(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double value = a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(value, 0.0);
+    }
+};
+
+struct PositionKey {
+    uint32_t bits[3];
+
+    bool operator==(const PositionKey& other) const {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        uint64_t hash = key.bits[0];
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.bits[1];
+        hash = hash * 0x9E3779B97F4A7C15ull ^ key.bits[2];
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+PositionKey makePositionKey(const glm::vec3& position) {
+    PositionKey key;
+    memcpy(key.bits, &position, sizeof(key.bits));
+    return key;
+}
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+// Quadric edge collapse whose state survives between calls, so a chain of
+// levels is simplified progressively: each call continues from the previous
+// result and the reported error covers every collapse made so far.
+class EdgeCollapser {
+public:
+    EdgeCollapser(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count);
+
+    void collapse(size_t target_index_count, float target_error);
+
+    const std::vector<uint32_t>& getIndices() const { return indices_; }
+    float getError() const { return error_; }
+
+private:
+    bool flips(uint32_t from, uint32_t to) const;
+
+    const Vertex* vertices_;
+    size_t vertex_count_;
+    std::vector<uint32_t> indices_;
+    float error_;
+
+    std::vector<uint32_t> position_ids_;
+    std::vector<bool> movable_;
+    std::vector<Quadric> quadrics_; // per position id
+
+    TriangleAdjacency adjacency_;
+    std::vector<Collapse> collapses_;
+    std::vector<uint32_t> remap_;
+    std::vector<bool> pass_locked_;
+};
+
+EdgeCollapser::EdgeCollapser(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count)
+    : vertices_(vertices), vertex_count_(vertex_count), indices_(indices, indices + index_count / 3 * 3), error_(0.0f) {
+    // Vertices sharing a position are one point of the surface: quadrics and
+    // topology are tracked per position, collapses per vertex.
+    position_ids_.resize(vertex_count);
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> position_map;
+    position_map.reserve(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        position_ids_[v] = position_map.emplace(makePositionKey(vertices[v].position),
+            static_cast<uint32_t>(v)).first->second;
+    }
+
+    std::vector<bool> referenced(vertex_count, false);
+    std::vector<uint32_t> wedge_counts(vertex_count, 0);
+    for (uint32_t index : indices_) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            wedge_counts[position_ids_[index]]++;
+        }
+    }
+
+    // A half-edge without its twin lies on an open border, one with several
+    // twins on a non-manifold edge; the ends of either never move.
+    std::vector<uint32_t> position_indices(indices_.size());
+    for (size_t i = 0; i < indices_.size(); i++) {
+        position_indices[i] = position_ids_[indices_[i]];
+    }
+    TriangleAdjacency position_adjacency;
+    buildAdjacency(position_adjacency, position_indices.data(), position_indices.size(), vertex_count);
+
+    std::vector<bool> locked_positions(vertex_count, false);
+    for (size_t i = 0; i < position_indices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = position_indices[i + k];
+            uint32_t b = position_indices[i + (k + 1) % 3];
+            if (a == b) continue;
+
+            uint32_t twins = 0;
+            for (uint32_t j = 0; j < position_adjacency.counts[b]; j++) {
+                const uint32_t* triangle = position_indices.data() +
+                    position_adjacency.triangles[position_adjacency.offsets[b] + j] * 3;
+                for (int m = 0; m < 3; m++) {
+                    if (triangle[m] == b && triangle[(m + 1) % 3] == a) twins++;
+                }
+            }
+
+            if (twins != 1) {
+                locked_positions[a] = true;
+                locked_positions[b] = true;
+            }
+        }
+    }
+
+    // Seam vertices (several vertices at one position) stay in place too, but
+    // may still receive collapses.
+    movable_.assign(vertex_count, false);
+    for (size_t v = 0; v < vertex_count; v++) {
+        uint32_t position = position_ids_[v];
+        movable_[v] = referenced[v] && wedge_counts[position] == 1 && !locked_positions[position];
+    }
+
+    quadrics_.resize(vertex_count);
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        const glm::vec3& p0 = vertices[indices_[i]].position;
+        const glm::vec3& p1 = vertices[indices_[i + 1]].position;
+        const glm::vec3& p2 = vertices[indices_[i + 2]].position;
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length <= 0.0f) continue;
+
+        normal = normal * (1.0f / length);
+        float distance = -glm::dot(normal, p0);
+        for (int k = 0; k < 3; k++) {
+            quadrics_[position_ids_[indices_[i + k]]].addPlane(normal, distance);
+        }
+    }
+
+    remap_.resize(vertex_count);
+    pass_locked_.resize(vertex_count);
+}
+
+void EdgeCollapser::collapse(size_t target_index_count, float target_error) {
+    double max_cost = static_cast<double>(target_error) * target_error;
+
+    // Each pass collapses the cheapest edges whose neighborhoods do not
+    // overlap, then compacts the index list.
+    while (indices_.size() > target_index_count) {
+        buildAdjacency(adjacency_, indices_.data(), indices_.size(), vertex_count_);
+
+        // Interior edges show up once per adjacent triangle; the half-edge
+        // with the lower first index stands for the edge, and only its
+        // cheaper direction is a candidate.
+        collapses_.clear();
+        for (size_t i = 0; i < indices_.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = indices_[i + k];
+                uint32_t b = indices_[i + (k + 1) % 3];
+                if (a > b || !(movable_[a] || movable_[b])) continue;
+
+                float cost_ab = movable_[a] ?
+                    static_cast<float>(quadrics_[position_ids_[a]].evaluate(vertices_[b].position)) : FLT_MAX;
+                float cost_ba = movable_[b] ?
+                    static_cast<float>(quadrics_[position_ids_[b]].evaluate(vertices_[a].position)) : FLT_MAX;
+                collapses_.push_back(cost_ab <= cost_ba ? Collapse{ a, b, cost_ab } : Collapse{ b, a, cost_ba });
+            }
+        }
+        std::sort(collapses_.begin(), collapses_.end(),
+            [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::iota(remap_.begin(), remap_.end(), 0u);
+        std::fill(pass_locked_.begin(), pass_locked_.end(), false);
+
+        size_t triangles_to_remove = (indices_.size() - target_index_count + 2) / 3;
+        size_t removed = 0;
+        bool collapsed = false;
+        for (const Collapse& collapse : collapses_) {
+            if (collapse.cost > max_cost || removed >= triangles_to_remove) break;
+            if (pass_locked_[collapse.from] || pass_locked_[collapse.to]) continue;
+            if (flips(collapse.from, collapse.to)) continue;
+
+            remap_[collapse.from] = collapse.to;
+            quadrics_[position_ids_[collapse.to]].add(quadrics_[position_ids_[collapse.from]]);
+            error_ = std::max(error_, std::sqrt(collapse.cost));
+            collapsed = true;
+
+            for (uint32_t i = 0; i < adjacency_.counts[collapse.from]; i++) {
+                const uint32_t* triangle = indices_.data() +
+                    adjacency_.triangles[adjacency_.offsets[collapse.from] + i] * 3;
+                for (int k = 0; k < 3; k++) {
+                    pass_locked_[triangle[k]] = true;
+                    if (triangle[k] == collapse.to) removed++;
+                }
+            }
+        }
+
+        if (!collapsed) break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < indices_.size(); i += 3) {
+            uint32_t a = remap_[indices_[i]];
+            uint32_t b = remap_[indices_[i + 1]];
+            uint32_t c = remap_[indices_[i + 2]];
+            uint32_t pa = position_ids_[a];
+            uint32_t pb = position_ids_[b];
+            uint32_t pc = position_ids_[c];
+            if (pa == pb || pb == pc || pa == pc) continue;
+
+            indices_[write++] = a;
+            indices_[write++] = b;
+            indices_[write++] = c;
+        }
+        indices_.resize(write);
+    }
+}
+
+// True when moving `from` onto `to` would turn one of the surviving triangles
+// around `from` over, or squash it close to a line.
+bool EdgeCollapser::flips(uint32_t from, uint32_t to) const {
+    const glm::vec3& p0 = vertices_[from].position;
+    const glm::vec3& p1 = vertices_[to].position;
+
+    for (uint32_t i = 0; i < adjacency_.counts[from]; i++) {
+        const uint32_t* triangle = indices_.data() + adjacency_.triangles[adjacency_.offsets[from] + i] * 3;
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+        int corner = triangle[0] == from ? 0 : triangle[1] == from ? 1 : 2;
+        const glm::vec3& a = vertices_[triangle[(corner + 1) % 3]].position;
+        const glm::vec3& b = vertices_[triangle[(corner + 2) % 3]].position;
+
+        glm::vec3 before = glm::cross(a - p0, b - p0);
+        glm::vec3 after = glm::cross(a - p1, b - p1);
+        if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+void MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+    std::vector<MeshLod>& lods, uint32_t max_lods) {
+    lods.clear();
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+    if (vertices.empty() || indices.empty()) return;
+
+    optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+    optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+
+    // Levels are cut from one progressive simplification, each continuing
+    // from the previous so the work is not repeated.
+    float radius = ModelLoader::computeBoundingSphere(vertices.data(), vertices.size()).radius;
+    EdgeCollapser collapser(vertices.data(), vertices.size(), indices.data(), indices.size());
+    while (radius > 0.0f && lods.size() < max_lods) {
+        MeshLod previous = lods.back();
+        size_t target_index_count = previous.index_count / 6 * 3;
+        if (target_index_count < MIN_LOD_TRIANGLES * 3) break;
+
+        collapser.collapse(target_index_count, MAX_LOD_ERROR * radius);
+        std::vector<uint32_t> lod = collapser.getIndices();
+
+        // Held back by the error bound or by locked vertices: further levels
+        // would barely differ from this one.
+        if (lod.empty() || lod.size() * 4 > static_cast<size_t>(previous.index_count) * 3) break;
+
+        optimizeVertexCache(lod.data(), lod.size(), vertices.size());
+
+        MeshLod level;
+        level.first_index = static_cast<uint32_t>(indices.size());
+        level.index_count = static_cast<uint32_t>(lod.size());
+        level.error = collapser.getError() / radius;
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        lods.push_back(level);
+    }
+
+    optimizeVertexFetch(vertices, indices);
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count) {
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return;
+
+    float cache_scores[CACHE_SIZE];
+    for (size_t i = 0; i < CACHE_SIZE; i++) {
+        cache_scores[i] = i < 3 ? LAST_TRIANGLE_SCORE :
+            std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+
+    float valence_scores[MAX_VALENCE_SCORE + 1];
+    valence_scores[0] = 0.0f;
+    for (uint32_t i = 1; i <= MAX_VALENCE_SCORE; i++) {
+        valence_scores[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+    }
+
+    // Triangles are retired from the lists as they are emitted, so counts are
+    // the number of triangles each vertex still has to go.
+    TriangleAdjacency adjacency;
+    buildAdjacency(adjacency, indices, triangle_count * 3, vertex_count);
+    std::vector<uint32_t>& live_counts = adjacency.counts;
+
+    auto vertexScore = [&](int32_t cache_position, uint32_t live_count) {
+        if (live_count == 0) return 0.0f;
+        float score = cache_position >= 0 ? cache_scores[cache_position] : 0.0f;
+        return score + valence_scores[std::min(live_count, MAX_VALENCE_SCORE)];
+    };
+
+    std::vector<int32_t> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        vertex_scores[v] = vertexScore(-1, live_counts[v]);
+    }
+
+    std::vector<float> triangle_scores(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++) {
+        triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] +
+            vertex_scores[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triangle_count * 3);
+    std::vector<bool> emitted(triangle_count, false);
+
+    uint32_t cache[CACHE_SIZE + 3];
+    uint32_t new_cache[CACHE_SIZE + 3];
+    size_t cache_count = 0;
+    size_t input_cursor = 0;
+
+    int64_t best_triangle = std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin();
+
+    while (output.size() < triangle_count * 3) {
+        if (best_triangle < 0) {
+            // No cached vertex has triangles left: restart from input order.
+            while (emitted[input_cursor]) input_cursor++;
+            best_triangle = static_cast<int64_t>(input_cursor);
+        }
+
+        const uint32_t* triangle = indices + best_triangle * 3;
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best_triangle] = true;
+
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = triangle[k];
+            uint32_t* list = adjacency.triangles.data() + adjacency.offsets[v];
+            uint32_t* last = list + live_counts[v] - 1;
+            *std::find(list, last + 1, static_cast<uint32_t>(best_triangle)) = *last;
+            live_counts[v]--;
+        }
+
+        // The emitted triangle's vertices move to the front; whatever is
+        // pushed past CACHE_SIZE falls out.
+        size_t new_count = 0;
+        for (int k = 0; k < 3; k++) {
+            if (std::find(new_cache, new_cache + new_count, triangle[k]) == new_cache + new_count) {
+                new_cache[new_count++] = triangle[k];
+            }
+        }
+        for (size_t i = 0; i < cache_count; i++) {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                new_cache[new_count++] = v;
+            }
+        }
+
+        for (size_t i = 0; i < new_count; i++) {
+            uint32_t v = new_cache[i];
+            int32_t position = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            cache_positions[v] = position;
+
+            float score = vertexScore(position, live_counts[v]);
+            float delta = score - vertex_scores[v];
+            vertex_scores[v] = score;
+
+            for (uint32_t j = 0; j < live_counts[v]; j++) {
+                triangle_scores[adjacency.triangles[adjacency.offsets[v] + j]] += delta;
+            }
+        }
+
+        // Only triangles touching the cache changed score, so the next one
+        // is searched among them alone.
+        best_triangle = -1;
+        float best_score = 0.0f;
+        cache_count = std::min(new_count, CACHE_SIZE);
+        for (size_t i = 0; i < cache_count; i++) {
+            uint32_t v = new_cache[i];
+            cache[i] = v;
+            for (uint32_t j = 0; j < live_counts[v]; j++) {
+                uint32_t t = adjacency.triangles[adjacency.offsets[v] + j];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t index_count,
+    const Vertex* vertices, size_t vertex_count, float threshold) {
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return;
+
+    // FIFO cache by timestamps: a vertex is cached while fewer than
+    // OVERDRAW_CACHE_SIZE vertices were inserted after it.
+    std::vector<uint32_t> timestamps(vertex_count, 0);
+    uint32_t time = OVERDRAW_CACHE_SIZE + 1;
+    auto countMisses = [&](size_t t) {
+        uint32_t misses = 0;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            if (time - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+    auto flushCache = [&]() { time += OVERDRAW_CACHE_SIZE + 1; };
+
+    // Hard boundaries: the cache optimizer restarted, all three vertices miss.
+    std::vector<size_t> hard_clusters;
+    for (size_t t = 0; t < triangle_count; t++) {
+        if (countMisses(t) == 3) {
+            hard_clusters.push_back(t);
+        }
+    }
+    hard_clusters.push_back(triangle_count);
+
+    // Soft boundaries split a hard cluster wherever the misses so far, from a
+    // cold cache, are already within `threshold` of the whole cluster's rate.
+    std::vector<size_t> clusters;
+    for (size_t c = 0; c + 1 < hard_clusters.size(); c++) {
+        size_t begin = hard_clusters[c];
+        size_t end = hard_clusters[c + 1];
+
+        flushCache();
+        uint32_t cluster_misses = 0;
+        for (size_t t = begin; t < end; t++) {
+            cluster_misses += countMisses(t);
+        }
+        float cluster_rate = static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+        flushCache();
+        clusters.push_back(begin);
+        size_t start = begin;
+        uint32_t misses = 0;
+        for (size_t t = begin; t + 1 < end; t++) {
+            misses += countMisses(t);
+            if (static_cast<float>(misses) <= threshold * cluster_rate * static_cast<float>(t + 1 - start)) {
+                start = t + 1;
+                misses = 0;
+                clusters.push_back(start);
+                flushCache();
+            }
+        }
+    }
+    clusters.push_back(triangle_count);
+
+    // Clusters facing away from the mesh center are likely in front of the
+    // rest and are drawn first.
+    size_t cluster_count = clusters.size() - 1;
+    std::vector<glm::vec3> centroids(cluster_count, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(cluster_count, glm::vec3(0.0f));
+    std::vector<float> areas(cluster_count, 0.0f);
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+
+    for (size_t c = 0; c < cluster_count; c++) {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const glm::vec3& p0 = vertices[indices[t * 3]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        mesh_centroid += centroids[c];
+        mesh_area += areas[c];
+    }
+    if (mesh_area > 0.0f) {
+        mesh_centroid = mesh_centroid * (1.0f / mesh_area);
+    }
+
+    std::vector<float> sort_keys(cluster_count, 0.0f);
+    for (size_t c = 0; c < cluster_count; c++) {
+        float normal_length = glm::length(normals[c]);
+        if (areas[c] <= 0.0f || normal_length <= 0.0f) continue;
+        glm::vec3 centroid = centroids[c] * (1.0f / areas[c]);
+        sort_keys[c] = glm::dot(centroid - mesh_centroid, normals[c]) / normal_length;
+    }
+
+    std::vector<uint32_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+        [&](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangle_count * 3);
+    for (uint32_t c : order) {
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    constexpr uint32_t UNUSED = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+std::vector<uint32_t> MeshOptimizer::simplify(const Vertex* vertices, size_t vertex_count,
+    const uint32_t* indices, size_t index_count, size_t target_index_count,
+    float target_error, float* result_error) {
+    EdgeCollapser collapser(vertices, vertex_count, indices, index_count);
+    collapser.collapse(target_index_count, target_error);
+
+    if (result_error) *result_error = collapser.getError();
+    return collapser.getIndices();
+}
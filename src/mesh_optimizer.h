@@ -0,0 +1,43 @@
+#pragma once
+
+#include "vertex.h"
+#include <vector>
+#include <cstdint>
+
+// Post-load optimization of indexed triangle meshes, in the spirit of
+// meshoptimizer: triangle order for the post-transform vertex cache and for
+// overdraw, vertex order for fetch locality, and quadric edge-collapse
+// simplification for levels of detail.
+class MeshOptimizer {
+public:
+    // Runs the full pipeline in place. LOD 0 is the cache- and overdraw-ordered
+    // source mesh; up to `max_lods - 1` simplified levels, each about half the
+    // triangles of the previous one, are appended to `indices`. All levels share
+    // `vertices`, which are reordered last so every level fetches them in
+    // roughly ascending order. An empty mesh gets a single empty level.
+    static void optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+        std::vector<MeshLod>& lods, uint32_t max_lods);
+
+    // Forsyth's linear-speed ordering for a post-transform cache of CACHE_SIZE.
+    static void optimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+    // Reorders clusters of a cache-optimized triangle list so outward facing
+    // clusters come first. A cluster ends wherever the vertex cache restarts
+    // anyway, or where its miss rate drops to `threshold` times the rate of the
+    // whole run, so `threshold` trades cache efficiency for finer sorting.
+    static void optimizeOverdraw(uint32_t* indices, size_t index_count,
+        const Vertex* vertices, size_t vertex_count, float threshold = 1.05f);
+
+    // Renumbers vertices in order of first use and drops unreferenced ones.
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Collapses edges until at most `target_index_count` indices remain or the
+    // next collapse would move the surface further than `target_error` (object
+    // space). Vertices on open borders and attribute seams never move, so UVs
+    // and normals stay intact. `result_error` receives the largest error made.
+    static std::vector<uint32_t> simplify(const Vertex* vertices, size_t vertex_count,
+        const uint32_t* indices, size_t index_count, size_t target_index_count,
+        float target_error, float* result_error = nullptr);
+
+    static constexpr size_t CACHE_SIZE = 32;
+};
@@ -1,179 +1,456 @@
-#include "model_loader.h"
-#include "utils/logger.h"
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
-
-bool ModelLoader::loadOBJ(const std::string& filename, 
-                         std::vector<Vertex>& vertices, 
-                         std::vector<uint32_t>& indices) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        LOGE("Failed to open file: {}", filename);
-        return false;
-    }
-
-    std::vector<glm::vec3> temp_positions;
-    std::vector<glm::vec3> temp_normals;
-    std::vector<glm::vec2> temp_tex_coords;
-    std::unordered_map<std::string, uint32_t> vertex_map;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
-
-        if (prefix == "v") {
-            glm::vec3 position;
-            iss >> position.x >> position.y >> position.z;
-            temp_positions.push_back(position);
-        }
-        else if (prefix == "vn") {
-            glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            temp_normals.push_back(normal);
-        }
-        else if (prefix == "vt") {
-            glm::vec2 tex_coord;
-            iss >> tex_coord.x >> tex_coord.y;
-            temp_tex_coords.push_back(tex_coord);
-        }
-        else if (prefix == "f") {
-            std::string vertex_str;
-            std::vector<uint32_t> face_indices;
-
-            while (iss >> vertex_str) {
-                if (vertex_map.find(vertex_str) != vertex_map.end()) {
-                    face_indices.push_back(vertex_map[vertex_str]);
-                } else {
-                    Vertex vertex{};
-                    std::istringstream vertex_stream(vertex_str);
-                    std::string index_str;
-                    
-                    if (std::getline(vertex_stream, index_str, '/') && !index_str.empty()) {
-                        int pos_index = std::stoi(index_str) - 1;
-                        if (pos_index >= 0 && pos_index < temp_positions.size()) {
-                            vertex.position = temp_positions[pos_index];
-                        }
-                    }
-                    
-                    if (std::getline(vertex_stream, index_str, '/') && !index_str.empty()) {
-                        int tex_index = std::stoi(index_str) - 1;
-                        if (tex_index >= 0 && tex_index < temp_tex_coords.size()) {
-                            vertex.tex_coord = temp_tex_coords[tex_index];
-                        }
-                    }
-                    
-                    if (std::getline(vertex_stream, index_str) && !index_str.empty()) {
-                        int norm_index = std::stoi(index_str) - 1;
-                        if (norm_index >= 0 && norm_index < temp_normals.size()) {
-                            vertex.normal = temp_normals[norm_index];
-                        }
-                    }
-
-                    vertex_map[vertex_str] = static_cast<uint32_t>(vertices.size());
-                    face_indices.push_back(static_cast<uint32_t>(vertices.size()));
-                    vertices.push_back(vertex);
-                }
-            }
-            
-            if (face_indices.size() >= 3) {
-                indices.push_back(face_indices[0]);
-                indices.push_back(face_indices[1]);
-                indices.push_back(face_indices[2]);
-
-                if (face_indices.size() == 4) {
-                    indices.push_back(face_indices[0]);
-                    indices.push_back(face_indices[2]);
-                    indices.push_back(face_indices[3]);
-                }
-            }
-        }
-    }
-
-    file.close();
-
-    if (vertices.empty()) {
-        LOGE("No vertices loaded from file: {}", filename);
-        return false;
-    }
-
-    normalizeModel(vertices, 2.0f);
-    
-    calculateTangents(vertices, indices);
-
-    LOGI("Loaded model: {} vertices, {} indices", vertices.size(), indices.size());
-    return true;
-}
-
-void ModelLoader::calculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-    for (auto& vertex : vertices) {
-        vertex.tangent = glm::vec3(0.0f);
-    }
-    
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        if (i + 2 < indices.size()) {
-            uint32_t i0 = indices[i];
-            uint32_t i1 = indices[i + 1];
-            uint32_t i2 = indices[i + 2];
-
-            if (i0 < vertices.size() && i1 < vertices.size() && i2 < vertices.size()) {
-                glm::vec3 tangent = calculateTangent(vertices[i0], vertices[i1], vertices[i2]);
-                
-                vertices[i0].tangent += tangent;
-                vertices[i1].tangent += tangent;
-                vertices[i2].tangent += tangent;
-            }
-        }
-    }
-    
-    for (auto& vertex : vertices) {
-        if (glm::length(vertex.tangent) > 0.0f) {
-            vertex.tangent = glm::normalize(vertex.tangent);
-        } else {
-            vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
-        }
-    }
-}
-
-glm::vec3 ModelLoader::calculateTangent(const Vertex& v1, const Vertex& v2, const Vertex& v3) {
-    glm::vec3 edge1 = v2.position - v1.position;
-    glm::vec3 edge2 = v3.position - v1.position;
-    
-    glm::vec2 delta_uv1 = v2.tex_coord - v1.tex_coord;
-    glm::vec2 delta_uv2 = v3.tex_coord - v1.tex_coord;
-    
-    float f = 1.0f / (delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y);
-    
-    glm::vec3 tangent;
-    tangent.x = f * (delta_uv2.y * edge1.x - delta_uv1.y * edge2.x);
-    tangent.y = f * (delta_uv2.y * edge1.y - delta_uv1.y * edge2.y);
-    tangent.z = f * (delta_uv2.y * edge1.z - delta_uv1.y * edge2.z);
-    
-    return tangent;
-}
-
-void ModelLoader::normalizeModel(std::vector<Vertex>& vertices, float target_size) {
-    if (vertices.empty()) return;
-    
-    glm::vec3 min_pos(FLT_MAX);
-    glm::vec3 max_pos(-FLT_MAX);
-
-    for (const auto& vertex : vertices) {
-        min_pos = glm::min(min_pos, vertex.position);
-        max_pos = glm::max(max_pos, vertex.position);
-    }
-    
-    glm::vec3 center = (min_pos + max_pos) * 0.5f;
-    glm::vec3 size = max_pos - min_pos;
-    float max_extent = std::max({ size.x, size.y, size.z });
-
-    if (max_extent == 0.0f) return;
-    
-    float scale = target_size / max_extent;
-    
-    for (auto& vertex : vertices) {
-        vertex.position = (vertex.position - center) * scale;
-    }
-}
+#include "model_loader.h"
+#include "geometry_kernels.h"
+#include "mapped_file.h"
+#include "job_system.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+constexpr size_t MIN_RANGE_SIZE = 1 << 16;
+
+// Triangulated face corner with resolved 0-based attribute indices, -1 when absent.
+struct FaceCorner {
+    int32_t position;
+    int32_t tex_coord;
+    int32_t normal;
+
+    bool operator==(const FaceCorner& other) const {
+        return position == other.position && tex_coord == other.tex_coord && normal == other.normal;
+    }
+};
+
+struct FaceCornerHash {
+    size_t operator()(const FaceCorner& corner) const {
+        uint64_t key = static_cast<uint32_t>(corner.position);
+        key = key * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.tex_coord);
+        key = key * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.normal);
+        return static_cast<size_t>(key ^ (key >> 32));
+    }
+};
+
+struct ChunkCounts {
+    size_t positions = 0;
+    size_t normals = 0;
+    size_t tex_coords = 0;
+    size_t corners = 0;
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    ChunkCounts counts;
+    ChunkCounts bases;
+};
+
+enum class LineType { Position, Normal, TexCoord, Face, Other };
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+const char* skipToken(const char* p, const char* end) {
+    while (p < end && !isSpace(*p) && *p != '\n') p++;
+    return p;
+}
+
+const char* findLineEnd(const char* p, const char* end) {
+    const void* newline = memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+LineType classifyLine(const char*& p, const char* line_end) {
+    p = skipSpaces(p, line_end);
+    size_t length = static_cast<size_t>(line_end - p);
+
+    if (length >= 2 && isSpace(p[1])) {
+        if (p[0] == 'v') { p += 2; return LineType::Position; }
+        if (p[0] == 'f') { p += 2; return LineType::Face; }
+    }
+    else if (length >= 3 && p[0] == 'v' && isSpace(p[2])) {
+        if (p[1] == 'n') { p += 3; return LineType::Normal; }
+        if (p[1] == 't') { p += 3; return LineType::TexCoord; }
+    }
+    return LineType::Other;
+}
+
+size_t countFaceCorners(const char* p, const char* line_end) {
+    size_t tokens = 0;
+    while ((p = skipSpaces(p, line_end)) < line_end) {
+        p = skipToken(p, line_end);
+        tokens++;
+    }
+    return tokens >= 3 ? (tokens - 2) * 3 : 0;
+}
+
+const char* parseFloats(const char* p, const char* line_end, float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        p = skipSpaces(p, line_end);
+        auto result = std::from_chars(p, line_end, values[i]);
+        if (result.ec != std::errc()) {
+            values[i] = 0.0f;
+            p = skipToken(p, line_end);
+        }
+        else {
+            p = result.ptr;
+        }
+    }
+    return p;
+}
+
+// OBJ indices are 1-based, or negative relative to the elements declared so far.
+int32_t resolveIndex(int32_t index, size_t declared) {
+    int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(declared) + index;
+    return index != 0 && resolved >= 0 && resolved < static_cast<int64_t>(declared)
+        ? static_cast<int32_t>(resolved) : -1;
+}
+
+const char* parseCorner(const char* p, const char* token_end, const ChunkCounts& declared, FaceCorner& corner) {
+    int32_t value = 0;
+    corner = { -1, -1, -1 };
+
+    auto result = std::from_chars(p, token_end, value);
+    if (result.ec == std::errc()) corner.position = resolveIndex(value, declared.positions);
+    p = result.ptr;
+
+    if (p < token_end && *p == '/') {
+        p++;
+        result = std::from_chars(p, token_end, value);
+        if (result.ec == std::errc()) {
+            corner.tex_coord = resolveIndex(value, declared.tex_coords);
+            p = result.ptr;
+        }
+
+        if (p < token_end && *p == '/') {
+            p++;
+            result = std::from_chars(p, token_end, value);
+            if (result.ec == std::errc()) corner.normal = resolveIndex(value, declared.normals);
+        }
+    }
+
+    return token_end;
+}
+
+void countChunk(Chunk& chunk) {
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* line_end = findLineEnd(p, chunk.end);
+        switch (classifyLine(p, line_end)) {
+        case LineType::Position: chunk.counts.positions++; break;
+        case LineType::Normal: chunk.counts.normals++; break;
+        case LineType::TexCoord: chunk.counts.tex_coords++; break;
+        case LineType::Face: chunk.counts.corners += countFaceCorners(p, line_end); break;
+        default: break;
+        }
+        p = line_end + 1;
+    }
+}
+
+void parseChunk(const Chunk& chunk, glm::vec3* positions, glm::vec3* normals, glm::vec2* tex_coords,
+    FaceCorner* corners) {
+    // Running totals include everything declared by earlier chunks, which is
+    // what relative (negative) indices are resolved against.
+    ChunkCounts declared = chunk.bases;
+    FaceCorner face[3];
+
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* line_end = findLineEnd(p, chunk.end);
+        switch (classifyLine(p, line_end)) {
+        case LineType::Position:
+            parseFloats(p, line_end, &positions[declared.positions++].x, 3);
+            break;
+        case LineType::Normal:
+            parseFloats(p, line_end, &normals[declared.normals++].x, 3);
+            break;
+        case LineType::TexCoord:
+            parseFloats(p, line_end, &tex_coords[declared.tex_coords++].x, 2);
+            break;
+        case LineType::Face: {
+            // Fan triangulation: (0, i - 1, i) for every corner after the second.
+            size_t vertex = 0;
+            while ((p = skipSpaces(p, line_end)) < line_end) {
+                const char* token_end = skipToken(p, line_end);
+                FaceCorner corner;
+                p = parseCorner(p, token_end, declared, corner);
+
+                if (vertex < 2) {
+                    face[vertex] = corner;
+                }
+                else {
+                    face[2] = corner;
+                    corners[declared.corners++] = face[0];
+                    corners[declared.corners++] = face[1];
+                    corners[declared.corners++] = face[2];
+                    face[1] = face[2];
+                }
+                vertex++;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        p = line_end + 1;
+    }
+}
+
+template <typename Func>
+void parallelFor(JobSystem* job_system, size_t count, Func&& func) {
+    if (job_system) {
+        job_system->parallelFor(count, func);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(count > 0 ? count - 1 : 0);
+    for (size_t i = 1; i < count; i++) {
+        threads.emplace_back([&func, i]() { func(i); });
+    }
+    if (count > 0) func(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Post-processing runs on ranges of at least MIN_RANGE_SIZE vertices or
+// triangles, at most one per thread that will run them.
+size_t getRangeCount(size_t count, JobSystem* job_system) {
+    size_t thread_count = job_system ? job_system->getWorkerCount() + 1 :
+        std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(thread_count, count / MIN_RANGE_SIZE));
+}
+
+// [begin, end) of the range-th of range_count near-equal slices of count elements.
+std::pair<size_t, size_t> getRange(size_t count, size_t range, size_t range_count) {
+    return { count * range / range_count, count * (range + 1) / range_count };
+}
+
+// Tangent of a triangle corner whose vertex another range owns.
+struct TangentSpill {
+    uint32_t vertex;
+    glm::vec3 tangent;
+};
+
+std::vector<Chunk> splitChunks(const char* data, size_t size) {
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunk_size = std::max(MIN_CHUNK_SIZE, size / thread_count + 1);
+
+    std::vector<Chunk> chunks;
+    const char* end = data + size;
+    const char* p = data;
+    while (p < end) {
+        const char* chunk_end = end;
+        if (static_cast<size_t>(end - p) > chunk_size) {
+            chunk_end = findLineEnd(p + chunk_size, end);
+            chunk_end = chunk_end < end ? chunk_end + 1 : end;
+        }
+        chunks.push_back({ p, chunk_end, {}, {} });
+        p = chunk_end;
+    }
+    return chunks;
+}
+
+}
+
+bool ModelLoader::loadOBJ(const std::string& filename, 
+                         std::vector<Vertex>& vertices, 
+                         std::vector<uint32_t>& indices,
+                         JobSystem* job_system) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        LOGE("Failed to open file: {}", filename);
+        return false;
+    }
+
+    // Pass 1: count elements per chunk so every chunk knows where its output
+    // lands in the shared arrays and how many elements precede it.
+    auto chunks = splitChunks(static_cast<const char*>(file.getData()), file.getSize());
+    parallelFor(job_system, chunks.size(), [&](size_t i) { countChunk(chunks[i]); });
+
+    ChunkCounts totals;
+    for (auto& chunk : chunks) {
+        chunk.bases = totals;
+        totals.positions += chunk.counts.positions;
+        totals.normals += chunk.counts.normals;
+        totals.tex_coords += chunk.counts.tex_coords;
+        totals.corners += chunk.counts.corners;
+    }
+
+    // Pass 2: parse attributes and triangulated face corners in place.
+    std::vector<glm::vec3> temp_positions(totals.positions);
+    std::vector<glm::vec3> temp_normals(totals.normals);
+    std::vector<glm::vec2> temp_tex_coords(totals.tex_coords);
+    std::vector<FaceCorner> corners(totals.corners);
+
+    parallelFor(job_system, chunks.size(), [&](size_t i) {
+        parseChunk(chunks[i], temp_positions.data(), temp_normals.data(), temp_tex_coords.data(), corners.data());
+    });
+
+    file.close();
+
+    // Pass 3: dedup corners into the vertex/index buffers, in file order.
+    std::unordered_map<FaceCorner, uint32_t, FaceCornerHash> vertex_map;
+    vertex_map.reserve(totals.positions + totals.positions / 2);
+    vertices.reserve(vertices.size() + totals.positions);
+    indices.reserve(indices.size() + corners.size());
+
+    for (const FaceCorner& corner : corners) {
+        auto [it, inserted] = vertex_map.try_emplace(corner, static_cast<uint32_t>(vertices.size()));
+        if (inserted) {
+            Vertex vertex{};
+            if (corner.position >= 0) vertex.position = temp_positions[corner.position];
+            if (corner.tex_coord >= 0) vertex.tex_coord = temp_tex_coords[corner.tex_coord];
+            if (corner.normal >= 0) vertex.normal = temp_normals[corner.normal];
+            vertices.push_back(vertex);
+        }
+        indices.push_back(it->second);
+    }
+
+    if (vertices.empty()) {
+        LOGE("No vertices loaded from file: {}", filename);
+        return false;
+    }
+
+    normalizeModel(vertices, 2.0f, job_system);
+    
+    calculateTangents(vertices, indices, job_system);
+
+    LOGI("Loaded model: {} vertices, {} indices ({} chunks, {} kernels)", vertices.size(), indices.size(),
+        chunks.size(), GeometryKernels::getInstructionSet());
+    return true;
+}
+
+void ModelLoader::calculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                    JobSystem* job_system) {
+    size_t vertex_count = vertices.size();
+    size_t triangle_count = indices.size() / 3;
+
+    // Triangle range r owns the r-th slice of the vertices: it is the only one
+    // that writes their tangents, and corners outside its slice are deferred
+    // to its spill list. Vertices are numbered in order of first use, so for
+    // meshes in file order nearly every corner lands in the range's own slice.
+    size_t range_count = getRangeCount(triangle_count, job_system);
+    std::vector<std::vector<TangentSpill>> spills(range_count);
+
+    parallelFor(job_system, range_count, [&](size_t range) {
+        auto [vertex_begin, vertex_end] = getRange(vertex_count, range, range_count);
+        for (size_t i = vertex_begin; i < vertex_end; i++) {
+            vertices[i].tangent = glm::vec3(0.0f);
+        }
+
+        float tangent_x[GeometryKernels::BLOCK_SIZE];
+        float tangent_y[GeometryKernels::BLOCK_SIZE];
+        float tangent_z[GeometryKernels::BLOCK_SIZE];
+
+        auto [triangle_begin, triangle_end] = getRange(triangle_count, range, range_count);
+        for (size_t base = triangle_begin; base < triangle_end; base += GeometryKernels::BLOCK_SIZE) {
+            size_t block_count = std::min(GeometryKernels::BLOCK_SIZE, triangle_end - base);
+            GeometryKernels::computeFaceTangents(vertices.data(), vertex_count, indices.data() + base * 3,
+                block_count, tangent_x, tangent_y, tangent_z);
+
+            for (size_t t = 0; t < block_count; t++) {
+                const uint32_t* corners = indices.data() + (base + t) * 3;
+                if (corners[0] >= vertex_count || corners[1] >= vertex_count || corners[2] >= vertex_count) {
+                    continue;
+                }
+
+                glm::vec3 tangent(tangent_x[t], tangent_y[t], tangent_z[t]);
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t vertex = corners[corner];
+                    if (vertex >= vertex_begin && vertex < vertex_end) {
+                        vertices[vertex].tangent += tangent;
+                    }
+                    else {
+                        spills[range].push_back({ vertex, tangent });
+                    }
+                }
+            }
+        }
+    });
+
+    // Applied in range order, so the sums do not depend on scheduling; they
+    // differ from a single triangle-order pass only in rounding.
+    for (const auto& range_spills : spills) {
+        for (const TangentSpill& spill : range_spills) {
+            vertices[spill.vertex].tangent += spill.tangent;
+        }
+    }
+
+    size_t normalize_count = getRangeCount(vertex_count, job_system);
+    parallelFor(job_system, normalize_count, [&](size_t range) {
+        auto [begin, end] = getRange(vertex_count, range, normalize_count);
+        GeometryKernels::normalizeTangents(vertices.data() + begin, end - begin);
+    });
+}
+
+void ModelLoader::normalizeModel(std::vector<Vertex>& vertices, float target_size, JobSystem* job_system) {
+    if (vertices.empty()) return;
+
+    size_t vertex_count = vertices.size();
+    size_t range_count = getRangeCount(vertex_count, job_system);
+    std::vector<glm::vec3> range_min(range_count, glm::vec3(FLT_MAX));
+    std::vector<glm::vec3> range_max(range_count, glm::vec3(-FLT_MAX));
+
+    parallelFor(job_system, range_count, [&](size_t range) {
+        auto [begin, end] = getRange(vertex_count, range, range_count);
+        GeometryKernels::accumulateBounds(vertices.data() + begin, end - begin, range_min[range], range_max[range]);
+    });
+
+    glm::vec3 min_pos(FLT_MAX);
+    glm::vec3 max_pos(-FLT_MAX);
+
+    for (size_t range = 0; range < range_count; range++) {
+        min_pos = glm::min(min_pos, range_min[range]);
+        max_pos = glm::max(max_pos, range_max[range]);
+    }
+    
+    glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    glm::vec3 size = max_pos - min_pos;
+    float max_extent = std::max({ size.x, size.y, size.z });
+
+    if (max_extent == 0.0f) return;
+    
+    float scale = target_size / max_extent;
+    
+    parallelFor(job_system, range_count, [&](size_t range) {
+        auto [begin, end] = getRange(vertex_count, range, range_count);
+        GeometryKernels::rescalePositions(vertices.data() + begin, end - begin, center, scale);
+    });
+}
+
+BoundingSphere ModelLoader::computeBoundingSphere(const Vertex* vertices, size_t vertex_count) {
+    BoundingSphere bounds{};
+    if (vertex_count == 0) return bounds;
+
+    glm::vec3 min_pos(FLT_MAX);
+    glm::vec3 max_pos(-FLT_MAX);
+
+    for (size_t i = 0; i < vertex_count; i++) {
+        min_pos = glm::min(min_pos, vertices[i].position);
+        max_pos = glm::max(max_pos, vertices[i].position);
+    }
+
+    bounds.center = (min_pos + max_pos) * 0.5f;
+
+    float radius_squared = 0.0f;
+    for (size_t i = 0; i < vertex_count; i++) {
+        glm::vec3 offset = vertices[i].position - bounds.center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+    bounds.radius = std::sqrt(radius_squared);
+
+    return bounds;
+}
@@ -1,17 +1,29 @@
-#pragma once
-
-#include "vertex.h"
-#include <vector>
-#include <string>
-
-class ModelLoader {
-public:
-    static bool loadOBJ(const std::string& filename, 
-                       std::vector<Vertex>& vertices, 
-                       std::vector<uint32_t>& indices);
-
-private:
-    static void calculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-    static glm::vec3 calculateTangent(const Vertex& v1, const Vertex& v2, const Vertex& v3);
-    static void normalizeModel(std::vector<Vertex>& vertices, float target_size = 2.0f);
-};
+#pragma once
+
+#include "vertex.h"
+#include <vector>
+#include <string>
+
+class JobSystem;
+
+class ModelLoader {
+public:
+    // Maps the file and parses it in line-aligned chunks on all cores; corners
+    // are deduplicated on their (position, uv, normal) index triple. Chunks run
+    // on `job_system` when given, otherwise on one thread each.
+    static bool loadOBJ(const std::string& filename, 
+                       std::vector<Vertex>& vertices, 
+                       std::vector<uint32_t>& indices,
+                       JobSystem* job_system = nullptr);
+
+    // Sphere around the vertices' bounding box; also used for cached models,
+    // whose vertices are stored already normalized.
+    static BoundingSphere computeBoundingSphere(const Vertex* vertices, size_t vertex_count);
+
+private:
+    // Both split the work into ranges run like the parse chunks, each range
+    // processed by the SIMD kernels in geometry_kernels.h.
+    static void calculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                  JobSystem* job_system);
+    static void normalizeModel(std::vector<Vertex>& vertices, float target_size, JobSystem* job_system);
+};
@@ -0,0 +1,168 @@
+#include "pipeline_cache.h"
+#include "utils/logger.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+PipelineCache::PipelineCache(vk::Device device, vk::PhysicalDevice physical_device)
+    : device_(device), properties_(physical_device.getProperties()) {
+}
+
+PipelineCache::~PipelineCache() {
+    cleanup();
+}
+
+bool PipelineCache::initialize(const std::string& path) {
+    path_ = path;
+
+    std::vector<char> initial_data;
+    if (loadCacheData(initial_data)) {
+        vk::PipelineCacheCreateInfo cache_info{};
+        cache_info.initialDataSize = initial_data.size();
+        cache_info.pInitialData = initial_data.data();
+
+        try {
+            pipeline_cache_ = device_.createPipelineCache(cache_info);
+            LOGI("Pipeline cache loaded: {} ({} bytes)", path_, initial_data.size());
+            return true;
+        }
+        catch (const std::exception& e) {
+            LOGW("Pipeline cache rejected by driver, starting empty: {}", e.what());
+        }
+    }
+
+    try {
+        pipeline_cache_ = device_.createPipelineCache(vk::PipelineCacheCreateInfo{});
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create pipeline cache: {}", e.what());
+        return false;
+    }
+}
+
+bool PipelineCache::save() {
+    if (!pipeline_cache_ || path_.empty()) return false;
+
+    std::vector<uint8_t> data;
+    try {
+        data = device_.getPipelineCacheData(pipeline_cache_);
+    }
+    catch (const std::exception& e) {
+        LOGW("Failed to read pipeline cache data: {}", e.what());
+        return false;
+    }
+
+    PipelineCacheFileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vendor_id = properties_.vendorID;
+    header.device_id = properties_.deviceID;
+    header.driver_version = properties_.driverVersion;
+    memcpy(header.pipeline_cache_uuid, properties_.pipelineCacheUUID.data(), VK_UUID_SIZE);
+    header.data_size = data.size();
+
+    // Same temp-and-rename as the mesh cache: a crash mid-write must not leave
+    // a truncated file that passes the size check.
+    std::string temp_path = path_ + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOGW("Failed to create pipeline cache file: {}", temp_path);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        if (!file) {
+            LOGW("Failed to write pipeline cache file: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path_, error);
+    if (error) {
+        LOGW("Failed to move pipeline cache into place: {}", error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    LOGI("Pipeline cache saved: {} ({} bytes)", path_, data.size());
+    return true;
+}
+
+void PipelineCache::cleanup() {
+    if (pipeline_cache_) {
+        device_.destroyPipelineCache(pipeline_cache_);
+        pipeline_cache_ = nullptr;
+    }
+}
+
+bool PipelineCache::loadCacheData(std::vector<char>& data) {
+    std::ifstream file(path_, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto file_size = static_cast<size_t>(file.tellg());
+    if (file_size < sizeof(PipelineCacheFileHeader)) {
+        LOGW("Pipeline cache file too small, ignoring: {}", path_);
+        return false;
+    }
+
+    PipelineCacheFileHeader header{};
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (header.data_size != file_size - sizeof(header)) {
+        LOGW("Pipeline cache file truncated, ignoring: {}", path_);
+        return false;
+    }
+
+    data.resize(static_cast<size_t>(header.data_size));
+    file.read(data.data(), data.size());
+    if (!file) {
+        LOGW("Failed to read pipeline cache file: {}", path_);
+        return false;
+    }
+
+    if (!isCompatible(header, data)) {
+        LOGI("Pipeline cache built for another device or driver, discarding: {}", path_);
+        return false;
+    }
+
+    return true;
+}
+
+bool PipelineCache::isCompatible(const PipelineCacheFileHeader& header, const std::vector<char>& data) const {
+    if (header.magic != MAGIC || header.version != VERSION ||
+        header.vendor_id != properties_.vendorID || header.device_id != properties_.deviceID ||
+        header.driver_version != properties_.driverVersion ||
+        memcmp(header.pipeline_cache_uuid, properties_.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0) {
+        return false;
+    }
+
+    // The driver's own header (VkPipelineCacheHeaderVersionOne) must agree too.
+    struct DriverCacheHeader {
+        uint32_t header_size;
+        uint32_t header_version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    };
+
+    if (data.size() < sizeof(DriverCacheHeader)) {
+        return false;
+    }
+
+    DriverCacheHeader driver_header{};
+    memcpy(&driver_header, data.data(), sizeof(driver_header));
+
+    return driver_header.header_size >= sizeof(DriverCacheHeader) &&
+        driver_header.header_version == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne) &&
+        driver_header.vendor_id == properties_.vendorID &&
+        driver_header.device_id == properties_.deviceID &&
+        memcmp(driver_header.pipeline_cache_uuid, properties_.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// File prefix in front of the driver's cache blob. The blob also carries a
+// VkPipelineCacheHeaderVersionOne, but that header has no driver version, so
+// the device identity is recorded here as well.
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+};
+
+// Disk-backed vk::PipelineCache shared by every pipeline the application
+// builds. A cache file written by another GPU, driver or build of the driver
+// cache format is discarded and the cache starts empty.
+class PipelineCache {
+public:
+    PipelineCache(vk::Device device, vk::PhysicalDevice physical_device);
+    ~PipelineCache();
+
+    bool initialize(const std::string& path);
+    bool save();
+    void cleanup();
+
+    vk::PipelineCache getHandle() const { return pipeline_cache_; }
+
+private:
+    bool loadCacheData(std::vector<char>& data);
+    bool isCompatible(const PipelineCacheFileHeader& header, const std::vector<char>& data) const;
+
+    vk::Device device_;
+    vk::PhysicalDeviceProperties properties_;
+    std::string path_;
+
+    vk::PipelineCache pipeline_cache_;
+
+    static constexpr uint32_t MAGIC = 0x43505356; // "VSPC"
+    static constexpr uint32_t VERSION = 1;
+};
@@ -0,0 +1,222 @@
+#include "profiler.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr uint32_t UNTRACKED_SCOPE = ~0u;
+
+// Result order follows the bit order of the flags.
+constexpr vk::QueryPipelineStatisticFlags STATISTIC_FLAGS =
+    vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+    vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+    vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+constexpr uint32_t STATISTIC_COUNT = 5;
+
+}
+
+GpuProfiler::GpuProfiler(std::shared_ptr<VulkanContext> context)
+    : context_(context), current_(nullptr), max_scopes_(0), timestamp_period_(0.0f), timestamp_mask_(0),
+    available_(false), statistics_available_(false), frames_begun_(0), result_frame_id_(0) {
+}
+
+GpuProfiler::~GpuProfiler() {
+    cleanup();
+}
+
+bool GpuProfiler::initialize(uint32_t max_scopes) {
+    auto physical_device = context_->getPhysicalDevice();
+    vk::PhysicalDeviceProperties properties = physical_device.getProperties();
+    auto queue_families = physical_device.getQueueFamilyProperties();
+    uint32_t valid_bits = queue_families[context_->getQueueFamilyIndices().graphics_family.value()].timestampValidBits;
+
+    // Profiling is optional: without timestamps the profiler records nothing.
+    if (valid_bits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+        LOGW("Graphics queue has no timestamp support, GPU profiling disabled");
+        return true;
+    }
+
+    max_scopes_ = max_scopes;
+    timestamp_period_ = properties.limits.timestampPeriod;
+    timestamp_mask_ = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+    // The statistics query spans the frame, so secondary command buffers have
+    // to inherit it.
+    vk::PhysicalDeviceFeatures features = physical_device.getFeatures();
+    statistics_available_ = features.pipelineStatisticsQuery == VK_TRUE && features.inheritedQueries == VK_TRUE;
+
+    vk::QueryPoolCreateInfo timestamp_info{};
+    timestamp_info.queryType = vk::QueryType::eTimestamp;
+    timestamp_info.queryCount = max_scopes_ * 2;
+
+    vk::QueryPoolCreateInfo statistics_info{};
+    statistics_info.queryType = vk::QueryType::ePipelineStatistics;
+    statistics_info.queryCount = 1;
+    statistics_info.pipelineStatistics = STATISTIC_FLAGS;
+
+    frames_.resize(VulkanContext::MAX_FRAMES_IN_FLIGHT);
+    try {
+        for (FrameQueries& frame : frames_) {
+            frame.timestamps = context_->getDevice().createQueryPool(timestamp_info);
+            if (statistics_available_) {
+                frame.statistics = context_->getDevice().createQueryPool(statistics_info);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create profiler query pools: {}", e.what());
+        return false;
+    }
+
+    available_ = true;
+    LOGI("GPU profiler initialized ({} scopes per frame, pipeline statistics {})",
+        max_scopes_, statistics_available_ ? "on" : "off");
+    return true;
+}
+
+void GpuProfiler::cleanup() {
+    if (!context_) return;
+
+    auto device = context_->getDevice();
+    for (FrameQueries& frame : frames_) {
+        if (frame.timestamps) device.destroyQueryPool(frame.timestamps);
+        if (frame.statistics) device.destroyQueryPool(frame.statistics);
+    }
+    frames_.clear();
+    current_ = nullptr;
+    available_ = false;
+}
+
+vk::QueryPipelineStatisticFlags GpuProfiler::getStatisticFlags() const {
+    return statistics_available_ ? STATISTIC_FLAGS : vk::QueryPipelineStatisticFlags{};
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer command_buffer, uint32_t frame_index) {
+    if (!available_) return;
+
+    // The slot's fence has been waited on, so its queries are complete.
+    FrameQueries& frame = frames_[frame_index % frames_.size()];
+    if (frame.recorded) {
+        collect(frame);
+    }
+
+    frame.names.clear();
+    frame.depths.clear();
+    frame.frame_id = ++frames_begun_;
+    frame.recorded = true;
+
+    command_buffer.resetQueryPool(frame.timestamps, 0, max_scopes_ * 2);
+    if (statistics_available_) {
+        command_buffer.resetQueryPool(frame.statistics, 0, 1);
+        command_buffer.beginQuery(frame.statistics, 0, vk::QueryControlFlags{});
+    }
+
+    current_ = &frame;
+    open_scopes_.clear();
+    beginScope(command_buffer, "Frame");
+}
+
+void GpuProfiler::endFrame(vk::CommandBuffer command_buffer) {
+    if (!current_) return;
+
+    while (!open_scopes_.empty()) {
+        endScope(command_buffer);
+    }
+
+    if (statistics_available_) {
+        command_buffer.endQuery(current_->statistics, 0);
+    }
+    current_ = nullptr;
+}
+
+void GpuProfiler::beginScope(vk::CommandBuffer command_buffer, const char* name) {
+    if (!current_) return;
+
+    // Past the pool size scopes still nest correctly, they are just not timed.
+    uint32_t scope = static_cast<uint32_t>(current_->names.size());
+    if (scope >= max_scopes_) {
+        open_scopes_.push_back(UNTRACKED_SCOPE);
+        return;
+    }
+
+    current_->names.push_back(name);
+    current_->depths.push_back(static_cast<uint32_t>(open_scopes_.size()));
+    open_scopes_.push_back(scope);
+
+    // Bottom of pipe: the scope starts once the work recorded before it is done.
+    command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, current_->timestamps, scope * 2);
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer command_buffer) {
+    if (!current_ || open_scopes_.empty()) return;
+
+    uint32_t scope = open_scopes_.back();
+    open_scopes_.pop_back();
+    if (scope == UNTRACKED_SCOPE) return;
+
+    command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, current_->timestamps, scope * 2 + 1);
+}
+
+void GpuProfiler::collect(FrameQueries& frame) {
+    auto device = context_->getDevice();
+    uint32_t query_count = static_cast<uint32_t>(frame.names.size()) * 2;
+
+    if (query_count > 0) {
+        auto timestamps = device.getQueryPoolResults<uint64_t>(frame.timestamps, 0, query_count,
+            sizeof(uint64_t) * query_count, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+        if (timestamps.result == vk::Result::eSuccess) {
+            results_.clear();
+            for (size_t i = 0; i < frame.names.size(); i++) {
+                uint64_t begin = timestamps.value[i * 2] & timestamp_mask_;
+                uint64_t end = timestamps.value[i * 2 + 1] & timestamp_mask_;
+                uint64_t ticks = end >= begin ? end - begin : 0;
+                results_.push_back({ frame.names[i], frame.depths[i],
+                    static_cast<float>(static_cast<double>(ticks) * timestamp_period_ * 1e-6) });
+            }
+            result_frame_id_ = frame.frame_id;
+        }
+    }
+
+    if (statistics_available_) {
+        auto statistics = device.getQueryPoolResults<uint64_t>(frame.statistics, 0, 1,
+            sizeof(uint64_t) * STATISTIC_COUNT, sizeof(uint64_t) * STATISTIC_COUNT, vk::QueryResultFlagBits::e64);
+
+        if (statistics.result == vk::Result::eSuccess) {
+            statistics_.input_primitives = statistics.value[0];
+            statistics_.vertex_invocations = statistics.value[1];
+            statistics_.clipping_primitives = statistics.value[2];
+            statistics_.fragment_invocations = statistics.value[3];
+            statistics_.compute_invocations = statistics.value[4];
+        }
+    }
+}
+
+void CpuProfiler::beginFrame() {
+    while (!open_scopes_.empty()) {
+        endScope();
+    }
+
+    if (!current_.empty()) {
+        results_.swap(current_);
+    }
+    current_.clear();
+    starts_.clear();
+
+    beginScope("Frame");
+}
+
+void CpuProfiler::beginScope(const char* name) {
+    open_scopes_.push_back(static_cast<uint32_t>(current_.size()));
+    current_.push_back({ name, static_cast<uint32_t>(open_scopes_.size() - 1), 0.0f });
+    starts_.push_back(Clock::now());
+}
+
+void CpuProfiler::endScope() {
+    if (open_scopes_.empty()) return;
+
+    uint32_t scope = open_scopes_.back();
+    open_scopes_.pop_back();
+    current_[scope].milliseconds = std::chrono::duration<float, std::milli>(Clock::now() - starts_[scope]).count();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VulkanContext;
+
+// One timed scope of a finished frame, in the order the scopes were opened.
+// Depth 0 is the whole frame, nested scopes count up from there.
+struct ProfileScope {
+    std::string name;
+    uint32_t depth;
+    float milliseconds;
+};
+
+struct PipelineStatistics {
+    uint64_t input_primitives = 0;
+    uint64_t vertex_invocations = 0;
+    uint64_t clipping_primitives = 0;
+    uint64_t fragment_invocations = 0;
+    uint64_t compute_invocations = 0;
+};
+
+// GPU pass timings from timestamp queries, plus pipeline statistics over the
+// whole frame when the device supports them. Every frame in flight owns its
+// query pools; beginFrame() collects that slot's results right after its
+// fence was waited on, so reading never stalls and results lag by the
+// number of frames in flight.
+class GpuProfiler {
+public:
+    GpuProfiler(std::shared_ptr<VulkanContext> context);
+    ~GpuProfiler();
+
+    bool initialize(uint32_t max_scopes = 32);
+    void cleanup();
+
+    // Both must be recorded outside a render pass, first and last in the
+    // frame's command buffer. Scopes may be opened in between, also inside
+    // render passes, as long as they nest.
+    void beginFrame(vk::CommandBuffer command_buffer, uint32_t frame_index);
+    void endFrame(vk::CommandBuffer command_buffer);
+
+    void beginScope(vk::CommandBuffer command_buffer, const char* name);
+    void endScope(vk::CommandBuffer command_buffer);
+
+    class Scope {
+    public:
+        Scope(GpuProfiler& profiler, vk::CommandBuffer command_buffer, const char* name)
+            : profiler_(profiler), command_buffer_(command_buffer) {
+            profiler_.beginScope(command_buffer_, name);
+        }
+        ~Scope() { profiler_.endScope(command_buffer_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuProfiler& profiler_;
+        vk::CommandBuffer command_buffer_;
+    };
+
+    bool isAvailable() const { return available_; }
+    bool hasPipelineStatistics() const { return statistics_available_; }
+
+    // Secondary command buffers executed within the frame must inherit these.
+    vk::QueryPipelineStatisticFlags getStatisticFlags() const;
+
+    const std::vector<ProfileScope>& getScopes() const { return results_; }
+    const PipelineStatistics& getPipelineStatistics() const { return statistics_; }
+    // Counts up from 1 with every profiled frame; identifies the frame the
+    // scopes were collected from, 0 until results are first published.
+    uint64_t getResultFrameId() const { return result_frame_id_; }
+
+private:
+    struct FrameQueries {
+        vk::QueryPool timestamps;
+        vk::QueryPool statistics;
+        std::vector<std::string> names;
+        std::vector<uint32_t> depths;
+        uint64_t frame_id = 0;
+        bool recorded = false;
+    };
+
+    void collect(FrameQueries& frame);
+
+    std::shared_ptr<VulkanContext> context_;
+    std::vector<FrameQueries> frames_;
+    FrameQueries* current_;
+    std::vector<uint32_t> open_scopes_;
+
+    uint32_t max_scopes_;
+    float timestamp_period_; // nanoseconds per tick
+    uint64_t timestamp_mask_;
+    bool available_;
+    bool statistics_available_;
+
+    std::vector<ProfileScope> results_;
+    PipelineStatistics statistics_;
+    uint64_t frames_begun_;
+    uint64_t result_frame_id_;
+};
+
+// CPU counterpart of GpuProfiler: nested wall-clock scopes, published as a
+// tree once the next frame begins.
+class CpuProfiler {
+public:
+    // Closes the previous frame, publishes its scopes and opens the root scope
+    // of the new one.
+    void beginFrame();
+
+    void beginScope(const char* name);
+    void endScope();
+
+    class Scope {
+    public:
+        Scope(CpuProfiler& profiler, const char* name) : profiler_(profiler) { profiler_.beginScope(name); }
+        ~Scope() { profiler_.endScope(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CpuProfiler& profiler_;
+    };
+
+    const std::vector<ProfileScope>& getScopes() const { return results_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<ProfileScope> current_;
+    std::vector<Clock::time_point> starts_;
+    std::vector<uint32_t> open_scopes_;
+    std::vector<ProfileScope> results_;
+};
@@ -0,0 +1,875 @@
+#include "render_graph.h"
+#include "vulkan_context.h"
+#include "profiler.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+RenderGraph::RenderGraph(std::shared_ptr<VulkanContext> context)
+    : context_(context), profiler_(nullptr), extent_{ 0, 0 }, dynamic_rendering_(false), compiled_(false) {
+}
+
+RenderGraph::~RenderGraph() {
+    cleanup();
+}
+
+RenderGraph::Resource RenderGraph::importImage(const std::string& name, const ImageImport& import) {
+    ResourceInfo resource{};
+    resource.name = name;
+    resource.is_image = true;
+    resource.import = import;
+    resource.reset_each_frame = import.reset_each_frame;
+    resource.state.layout = import.fixed_layout;
+    resources_.push_back(resource);
+    return static_cast<Resource>(resources_.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createImage(const std::string& name, vk::Format format) {
+    ResourceInfo resource{};
+    resource.name = name;
+    resource.is_image = true;
+    resource.transient = true;
+    resource.import.format = format;
+    resources_.push_back(resource);
+    return static_cast<Resource>(resources_.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::importBuffer(const std::string& name, bool reset_each_frame) {
+    ResourceInfo resource{};
+    resource.name = name;
+    resource.reset_each_frame = reset_each_frame;
+    resources_.push_back(resource);
+    return static_cast<Resource>(resources_.size() - 1);
+}
+
+RenderGraph::Pass RenderGraph::addPass(const std::string& name, PassType type, RecordFunction record) {
+    PassInfo pass{};
+    pass.name = name;
+    pass.type = type;
+    pass.record = std::move(record);
+    passes_.push_back(std::move(pass));
+    return static_cast<Pass>(passes_.size() - 1);
+}
+
+void RenderGraph::addColorAttachment(Pass pass, Resource image, const vk::ClearColorValue* clear) {
+    Usage usage{};
+    usage.resource = image;
+    usage.type = UsageType::ColorAttachment;
+    usage.stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    usage.access = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+    usage.layout = vk::ImageLayout::eColorAttachmentOptimal;
+    usage.write = true;
+    usage.clear = clear != nullptr;
+    if (clear) usage.clear_value.color = *clear;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addDepthAttachment(Pass pass, Resource image, bool write, const vk::ClearDepthStencilValue* clear) {
+    // Clearing is a write, so a cleared attachment is never read-only.
+    write = write || clear != nullptr;
+
+    Usage usage{};
+    usage.resource = image;
+    usage.type = UsageType::DepthAttachment;
+    usage.stages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    usage.access = write ?
+        vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite :
+        vk::AccessFlagBits::eDepthStencilAttachmentRead;
+    usage.layout = write ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+    usage.write = write;
+    usage.clear = clear != nullptr;
+    if (clear) usage.clear_value.depthStencil = *clear;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addImageRead(Pass pass, Resource image, vk::PipelineStageFlags stages) {
+    const ResourceInfo& resource = resources_[image];
+
+    Usage usage{};
+    usage.resource = image;
+    usage.type = UsageType::Sampled;
+    usage.stages = stages;
+    usage.access = vk::AccessFlagBits::eShaderRead;
+    if (resource.import.fixed_layout != vk::ImageLayout::eUndefined) {
+        usage.layout = resource.import.fixed_layout;
+    }
+    else {
+        usage.layout = isDepthFormat(resource.import.format) ?
+            vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+    }
+    usage.write = false;
+    usage.clear = false;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addImageWrite(Pass pass, Resource image, vk::PipelineStageFlags stages) {
+    Usage usage{};
+    usage.resource = image;
+    usage.type = UsageType::Storage;
+    usage.stages = stages;
+    usage.access = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+    usage.layout = vk::ImageLayout::eGeneral;
+    usage.write = true;
+    usage.clear = false;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addBufferRead(Pass pass, Resource buffer, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+    Usage usage{};
+    usage.resource = buffer;
+    usage.type = UsageType::Buffer;
+    usage.stages = stages;
+    usage.access = access;
+    usage.layout = vk::ImageLayout::eUndefined;
+    usage.write = false;
+    usage.clear = false;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addBufferWrite(Pass pass, Resource buffer, vk::PipelineStageFlags stages, vk::AccessFlags access) {
+    Usage usage{};
+    usage.resource = buffer;
+    usage.type = UsageType::Buffer;
+    usage.stages = stages;
+    usage.access = access;
+    usage.layout = vk::ImageLayout::eUndefined;
+    usage.write = true;
+    usage.clear = false;
+    addUsage(pass, usage);
+}
+
+void RenderGraph::addUsage(Pass pass, const Usage& usage) {
+    ResourceInfo& resource = resources_[usage.resource];
+    resource.first_pass = std::min(resource.first_pass, pass);
+    resource.last_pass = std::max(resource.last_pass, pass);
+
+    switch (usage.type) {
+    case UsageType::ColorAttachment: resource.usage |= vk::ImageUsageFlagBits::eColorAttachment; break;
+    case UsageType::DepthAttachment: resource.usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment; break;
+    case UsageType::Sampled: resource.usage |= vk::ImageUsageFlagBits::eSampled; break;
+    case UsageType::Storage: resource.usage |= vk::ImageUsageFlagBits::eStorage; break;
+    case UsageType::Buffer: break;
+    }
+
+    passes_[pass].usages.push_back(usage);
+}
+
+bool RenderGraph::compile() {
+    groups_.clear();
+    dynamic_rendering_ = context_->supportsDynamicRendering();
+
+    for (Pass index = 0; index < passes_.size(); index++) {
+        PassInfo& pass = passes_[index];
+
+        // Rendering scopes have no subpasses to merge into.
+        bool merge = !dynamic_rendering_ && pass.type == PassType::Graphics && !groups_.empty() &&
+            passes_[groups_.back().passes[0]].type == PassType::Graphics && canMerge(groups_.back(), pass);
+        if (!merge) {
+            groups_.emplace_back();
+        }
+
+        Group& group = groups_.back();
+        pass.group = static_cast<uint32_t>(groups_.size() - 1);
+        pass.subpass = static_cast<uint32_t>(group.passes.size());
+        group.passes.push_back(index);
+        group.name += group.name.empty() ? pass.name : " + " + pass.name;
+    }
+
+    // With dynamic rendering this stops at the attachment operations.
+    for (Group& group : groups_) {
+        if (passes_[group.passes[0]].type == PassType::Graphics && !createRenderPass(group)) {
+            return false;
+        }
+    }
+
+    compiled_ = true;
+    LOGI("Render graph compiled: {} passes in {} groups{}", passes_.size(), groups_.size(),
+        dynamic_rendering_ ? ", dynamic rendering" : "");
+    return true;
+}
+
+bool RenderGraph::canMerge(const Group& group, const PassInfo& pass) const {
+    // Subpasses can only order attachment use; anything else that needs a
+    // barrier has to go between render passes.
+    for (const Usage& usage : pass.usages) {
+        for (Pass other_index : group.passes) {
+            for (const Usage& other : passes_[other_index].usages) {
+                if (other.resource != usage.resource) continue;
+
+                if (isAttachment(usage.type) && isAttachment(other.type)) continue;
+
+                if (usage.write || other.write || usage.layout != other.layout) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool RenderGraph::createRenderPass(Group& group) {
+    std::vector<vk::AttachmentDescription> descriptions;
+    std::vector<Usage> last_usages;
+    std::vector<uint32_t> last_subpasses;
+
+    std::vector<std::vector<vk::AttachmentReference>> color_references(group.passes.size());
+    std::vector<vk::AttachmentReference> depth_references(group.passes.size());
+    std::vector<bool> has_depth(group.passes.size(), false);
+    std::map<std::pair<uint32_t, uint32_t>, vk::SubpassDependency> dependencies;
+
+    Pass first_pass = group.passes.front();
+    Pass last_pass = group.passes.back();
+
+    for (uint32_t subpass = 0; subpass < group.passes.size(); subpass++) {
+        for (const Usage& usage : passes_[group.passes[subpass]].usages) {
+            if (!isAttachment(usage.type)) continue;
+
+            const ResourceInfo& resource = resources_[usage.resource];
+            auto found = std::find(group.attachments.begin(), group.attachments.end(), usage.resource);
+            uint32_t attachment = static_cast<uint32_t>(found - group.attachments.begin());
+
+            if (found == group.attachments.end()) {
+                // Contents are only loaded when something before this render
+                // pass produced them: an earlier pass this frame, or a
+                // persistent imported image.
+                bool produced_earlier = resource.first_pass < first_pass ||
+                    (!resource.transient && !resource.reset_each_frame);
+
+                vk::AttachmentDescription description{};
+                description.format = resource.import.format;
+                description.samples = vk::SampleCountFlagBits::e1;
+                description.loadOp = usage.clear ? vk::AttachmentLoadOp::eClear :
+                    produced_earlier ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eDontCare;
+                description.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+                description.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+                description.initialLayout = usage.layout;
+
+                group.attachments.push_back(usage.resource);
+                group.clear_values.push_back(usage.clear_value);
+                descriptions.push_back(description);
+                last_usages.push_back(usage);
+                last_subpasses.push_back(subpass);
+            }
+            else if (usage.write || last_usages[attachment].write) {
+                const Usage& previous = last_usages[attachment];
+                auto key = std::make_pair(last_subpasses[attachment], subpass);
+
+                vk::SubpassDependency& dependency = dependencies[key];
+                dependency.srcSubpass = key.first;
+                dependency.dstSubpass = key.second;
+                dependency.srcStageMask |= previous.stages;
+                dependency.srcAccessMask |= previous.write ? previous.access : vk::AccessFlags{};
+                dependency.dstStageMask |= usage.stages;
+                dependency.dstAccessMask |= usage.access;
+                dependency.dependencyFlags = vk::DependencyFlagBits::eByRegion;
+            }
+
+            if (found != group.attachments.end()) {
+                last_usages[attachment] = usage;
+                last_subpasses[attachment] = subpass;
+            }
+
+            vk::AttachmentReference reference{ attachment, usage.layout };
+            if (usage.type == UsageType::ColorAttachment) {
+                color_references[subpass].push_back(reference);
+            }
+            else {
+                depth_references[subpass] = reference;
+                has_depth[subpass] = true;
+            }
+        }
+    }
+
+    for (uint32_t attachment = 0; attachment < descriptions.size(); attachment++) {
+        const ResourceInfo& resource = resources_[group.attachments[attachment]];
+        bool used_later = resource.last_pass > last_pass;
+
+        // Transient images nobody reads afterwards never leave the tile.
+        descriptions[attachment].storeOp = used_later || !resource.transient ?
+            vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+        // The last user hands imported images over directly, saving a barrier.
+        descriptions[attachment].finalLayout = last_usages[attachment].layout;
+        if (!used_later && resource.import.final_layout != vk::ImageLayout::eUndefined) {
+            descriptions[attachment].finalLayout = resource.import.final_layout;
+        }
+    }
+
+    group.descriptions = descriptions;
+
+    if (dynamic_rendering_) {
+        for (uint32_t attachment = 0; attachment < descriptions.size(); attachment++) {
+            if (isDepthFormat(descriptions[attachment].format)) {
+                group.depth_format = descriptions[attachment].format;
+            }
+            else {
+                group.color_formats.push_back(descriptions[attachment].format);
+            }
+        }
+
+        group.inheritance_rendering.colorAttachmentCount = static_cast<uint32_t>(group.color_formats.size());
+        group.inheritance_rendering.pColorAttachmentFormats = group.color_formats.data();
+        group.inheritance_rendering.depthAttachmentFormat = group.depth_format;
+        group.inheritance_rendering.rasterizationSamples = vk::SampleCountFlagBits::e1;
+        return true;
+    }
+
+    std::vector<vk::SubpassDescription> subpasses(group.passes.size());
+    for (uint32_t subpass = 0; subpass < group.passes.size(); subpass++) {
+        subpasses[subpass].pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+        subpasses[subpass].colorAttachmentCount = static_cast<uint32_t>(color_references[subpass].size());
+        subpasses[subpass].pColorAttachments = color_references[subpass].data();
+        subpasses[subpass].pDepthStencilAttachment = has_depth[subpass] ? &depth_references[subpass] : nullptr;
+    }
+
+    // Everything outside the render pass is ordered by execute()'s barriers.
+    std::vector<vk::SubpassDependency> dependency_list;
+    for (const auto& entry : dependencies) {
+        dependency_list.push_back(entry.second);
+    }
+
+    vk::RenderPassCreateInfo render_pass_info{};
+    render_pass_info.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    render_pass_info.pAttachments = descriptions.data();
+    render_pass_info.subpassCount = static_cast<uint32_t>(subpasses.size());
+    render_pass_info.pSubpasses = subpasses.data();
+    render_pass_info.dependencyCount = static_cast<uint32_t>(dependency_list.size());
+    render_pass_info.pDependencies = dependency_list.data();
+
+    try {
+        group.render_pass = context_->getDevice().createRenderPass(render_pass_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create render pass for {}: {}", group.name, e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool RenderGraph::createResources(vk::Extent2D extent) {
+    auto device = context_->getDevice();
+
+    destroyResources();
+    extent_ = extent;
+
+    // Transient images no pass uses are never created.
+    for (ResourceInfo& resource : resources_) {
+        if (!resource.transient || resource.first_pass == ~0u) continue;
+
+        vk::ImageCreateInfo image_info{};
+        image_info.imageType = vk::ImageType::e2D;
+        image_info.extent = vk::Extent3D{ extent.width, extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = resource.import.format;
+        image_info.tiling = vk::ImageTiling::eOptimal;
+        image_info.initialLayout = vk::ImageLayout::eUndefined;
+        image_info.usage = resource.usage;
+        image_info.samples = vk::SampleCountFlagBits::e1;
+        image_info.sharingMode = vk::SharingMode::eExclusive;
+
+        try {
+            resource.image = device.createImage(image_info);
+        }
+        catch (const std::exception& e) {
+            LOGE("Failed to create render graph image {}: {}", resource.name, e.what());
+            return false;
+        }
+    }
+
+    if (!assignMemory()) {
+        return false;
+    }
+
+    for (ResourceInfo& resource : resources_) {
+        if (!resource.image || !resource.transient) continue;
+
+        vk::ImageViewCreateInfo view_info{};
+        view_info.image = resource.image;
+        view_info.viewType = vk::ImageViewType::e2D;
+        view_info.format = resource.import.format;
+        view_info.subresourceRange.aspectMask = isDepthFormat(resource.import.format) ?
+            vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+        view_info.subresourceRange.baseMipLevel = 0;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = 1;
+
+        try {
+            resource.view = device.createImageView(view_info);
+        }
+        catch (const std::exception& e) {
+            LOGE("Failed to create render graph image view {}: {}", resource.name, e.what());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RenderGraph::assignMemory() {
+    auto device = context_->getDevice();
+
+    // Lifetimes count in groups: attachments of one render pass are alive
+    // together, whichever subpasses use them.
+    std::vector<Resource> transients;
+    std::vector<vk::MemoryRequirements> requirements(resources_.size());
+    for (Resource index = 0; index < resources_.size(); index++) {
+        if (!resources_[index].transient || resources_[index].first_pass == ~0u) continue;
+        requirements[index] = device.getImageMemoryRequirements(resources_[index].image);
+        transients.push_back(index);
+    }
+
+    // Largest first, so smaller images fit into the slots of larger ones.
+    std::sort(transients.begin(), transients.end(), [&](Resource a, Resource b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    auto overlaps = [&](Resource a, Resource b) {
+        uint32_t a_first = passes_[resources_[a].first_pass].group, a_last = passes_[resources_[a].last_pass].group;
+        uint32_t b_first = passes_[resources_[b].first_pass].group, b_last = passes_[resources_[b].last_pass].group;
+        return a_first <= b_last && b_first <= a_last;
+    };
+
+    for (Resource index : transients) {
+        uint32_t slot_index = static_cast<uint32_t>(memory_slots_.size());
+        for (uint32_t i = 0; i < memory_slots_.size(); i++) {
+            MemorySlot& slot = memory_slots_[i];
+            if (!(slot.requirements.memoryTypeBits & requirements[index].memoryTypeBits)) continue;
+            if (std::any_of(slot.images.begin(), slot.images.end(), [&](Resource other) { return overlaps(index, other); })) continue;
+            slot_index = i;
+            break;
+        }
+
+        if (slot_index == memory_slots_.size()) {
+            memory_slots_.emplace_back();
+            memory_slots_.back().requirements = requirements[index];
+        }
+
+        MemorySlot& slot = memory_slots_[slot_index];
+        slot.requirements.size = std::max(slot.requirements.size, requirements[index].size);
+        slot.requirements.alignment = std::max(slot.requirements.alignment, requirements[index].alignment);
+        slot.requirements.memoryTypeBits &= requirements[index].memoryTypeBits;
+        slot.images.push_back(index);
+        resources_[index].memory_slot = slot_index;
+    }
+
+    for (MemorySlot& slot : memory_slots_) {
+        if (!context_->getAllocator().allocate(slot.requirements, vk::MemoryPropertyFlagBits::eDeviceLocal,
+            false, slot.allocation)) {
+            LOGE("Failed to allocate render graph memory");
+            return false;
+        }
+
+        for (Resource index : slot.images) {
+            device.bindImageMemory(resources_[index].image, slot.allocation.memory, slot.allocation.offset);
+        }
+    }
+
+    LOGI("Render graph created {} transient images in {} memory slots", transients.size(), memory_slots_.size());
+    return true;
+}
+
+// Frames in flight may still use the framebuffers and transient images when
+// the swapchain is recreated, so they are retired rather than destroyed.
+void RenderGraph::destroyResources() {
+    if (!context_) return;
+
+    std::vector<vk::Framebuffer> framebuffers;
+    std::vector<vk::ImageView> views;
+    std::vector<vk::Image> images;
+    std::vector<GpuAllocation> allocations;
+
+    for (Group& group : groups_) {
+        for (auto& entry : group.framebuffers) {
+            framebuffers.push_back(entry.second);
+        }
+        group.framebuffers.clear();
+    }
+
+    for (ResourceInfo& resource : resources_) {
+        if (!resource.transient) continue;
+
+        if (resource.view) views.push_back(resource.view);
+        if (resource.image) images.push_back(resource.image);
+        resource.view = nullptr;
+        resource.image = nullptr;
+        resource.memory_slot = ~0u;
+        resource.state = AccessState{};
+    }
+
+    for (MemorySlot& slot : memory_slots_) {
+        if (slot.allocation.isValid()) allocations.push_back(slot.allocation);
+    }
+    memory_slots_.clear();
+
+    vk::Device device = context_->getDevice();
+    GpuAllocator* allocator = &context_->getAllocator();
+    context_->retire([device, allocator, framebuffers = std::move(framebuffers), views = std::move(views),
+        images = std::move(images), allocations = std::move(allocations)]() mutable {
+        for (auto framebuffer : framebuffers) device.destroyFramebuffer(framebuffer);
+        for (auto view : views) device.destroyImageView(view);
+        for (auto image : images) device.destroyImage(image);
+        for (auto& allocation : allocations) allocator->free(allocation);
+    });
+}
+
+void RenderGraph::cleanup() {
+    if (!context_) return;
+
+    destroyResources();
+
+    auto device = context_->getDevice();
+    for (Group& group : groups_) {
+        if (group.render_pass) device.destroyRenderPass(group.render_pass);
+    }
+    groups_.clear();
+    compiled_ = false;
+}
+
+vk::RenderPass RenderGraph::getRenderPass(Pass pass) const {
+    return groups_[passes_[pass].group].render_pass;
+}
+
+uint32_t RenderGraph::getSubpass(Pass pass) const {
+    return passes_[pass].subpass;
+}
+
+vk::PipelineRenderingCreateInfoKHR RenderGraph::getPipelineRenderingInfo(Pass pass) const {
+    const Group& group = groups_[passes_[pass].group];
+
+    vk::PipelineRenderingCreateInfoKHR rendering_info{};
+    rendering_info.colorAttachmentCount = static_cast<uint32_t>(group.color_formats.size());
+    rendering_info.pColorAttachmentFormats = group.color_formats.data();
+    rendering_info.depthAttachmentFormat = group.depth_format;
+    return rendering_info;
+}
+
+vk::ImageView RenderGraph::getImageView(Resource image) const {
+    return resources_[image].view;
+}
+
+void RenderGraph::setImage(Resource image, vk::Image handle, vk::ImageView view) {
+    ResourceInfo& resource = resources_[image];
+
+    // A different image has none of the old one's history.
+    if (resource.image != handle) {
+        resource.state = AccessState{};
+        resource.state.layout = resource.import.fixed_layout;
+    }
+    resource.image = handle;
+    resource.view = view;
+}
+
+void RenderGraph::setBuffer(Resource buffer, vk::Buffer handle) {
+    ResourceInfo& resource = resources_[buffer];
+    if (resource.buffer != handle) {
+        resource.state = AccessState{};
+    }
+    resource.buffer = handle;
+}
+
+vk::Framebuffer RenderGraph::getFramebuffer(Group& group) {
+    std::vector<VkImageView> views;
+    for (Resource attachment : group.attachments) {
+        views.push_back(resources_[attachment].view);
+    }
+
+    auto found = group.framebuffers.find(views);
+    if (found != group.framebuffers.end()) {
+        return found->second;
+    }
+
+    std::vector<vk::ImageView> attachments(views.begin(), views.end());
+
+    vk::FramebufferCreateInfo framebuffer_info{};
+    framebuffer_info.renderPass = group.render_pass;
+    framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebuffer_info.pAttachments = attachments.data();
+    framebuffer_info.width = extent_.width;
+    framebuffer_info.height = extent_.height;
+    framebuffer_info.layers = 1;
+
+    vk::Framebuffer framebuffer = context_->getDevice().createFramebuffer(framebuffer_info);
+    group.framebuffers.emplace(views, framebuffer);
+    return framebuffer;
+}
+
+void RenderGraph::beginRendering(vk::CommandBuffer command_buffer, const Group& group,
+    vk::SubpassContents contents) const {
+    std::vector<vk::RenderingAttachmentInfoKHR> color_attachments;
+    vk::RenderingAttachmentInfoKHR depth_attachment{};
+    bool has_depth = false;
+
+    for (size_t i = 0; i < group.attachments.size(); i++) {
+        const vk::AttachmentDescription& description = group.descriptions[i];
+
+        // The barrier in front already moved the image to the layout of its use.
+        vk::RenderingAttachmentInfoKHR attachment{};
+        attachment.imageView = resources_[group.attachments[i]].view;
+        attachment.imageLayout = description.initialLayout;
+        attachment.loadOp = description.loadOp;
+        attachment.storeOp = description.storeOp;
+        attachment.clearValue = group.clear_values[i];
+
+        if (isDepthFormat(description.format)) {
+            depth_attachment = attachment;
+            has_depth = true;
+        }
+        else {
+            color_attachments.push_back(attachment);
+        }
+    }
+
+    vk::RenderingInfoKHR rendering_info{};
+    if (contents == vk::SubpassContents::eSecondaryCommandBuffers) {
+        rendering_info.flags = vk::RenderingFlagBitsKHR::eContentsSecondaryCommandBuffers;
+    }
+    rendering_info.renderArea.offset = vk::Offset2D{ 0, 0 };
+    rendering_info.renderArea.extent = extent_;
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = static_cast<uint32_t>(color_attachments.size());
+    rendering_info.pColorAttachments = color_attachments.data();
+    rendering_info.pDepthAttachment = has_depth ? &depth_attachment : nullptr;
+
+    context_->cmdBeginRendering(command_buffer, rendering_info);
+}
+
+void RenderGraph::execute(vk::CommandBuffer command_buffer, vk::SubpassContents contents) {
+    if (!compiled_) return;
+
+    used_this_frame_.assign(resources_.size(), false);
+    BarrierBatch batch;
+
+    for (Group& group : groups_) {
+        if (profiler_) profiler_->beginScope(command_buffer, group.name.c_str());
+
+        const PassInfo& first = passes_[group.passes[0]];
+        if (first.type == PassType::Compute) {
+            for (const Usage& usage : first.usages) {
+                beginUse(usage.resource);
+                addBarrier(usage, batch);
+                applyUsage(usage);
+            }
+            flushBarriers(command_buffer, batch);
+
+            PassContext context{ command_buffer, contents, nullptr, 0, nullptr, nullptr };
+            first.record(context);
+        }
+        else if (dynamic_rendering_) {
+            // A group holds a single pass here. Final layouts are handed over
+            // by the barriers after the last group.
+            for (const Usage& usage : first.usages) {
+                beginUse(usage.resource);
+                addBarrier(usage, batch);
+                applyUsage(usage);
+            }
+            flushBarriers(command_buffer, batch);
+
+            beginRendering(command_buffer, group, contents);
+            PassContext context{ command_buffer, contents, nullptr, 0, nullptr, &group.inheritance_rendering };
+            first.record(context);
+            context_->cmdEndRendering(command_buffer);
+        }
+        else {
+            // One barrier in front of the render pass covers every subpass;
+            // attachment use within it is ordered by the subpass dependencies.
+            std::vector<Resource> attachments_seen;
+            for (Pass index : group.passes) {
+                for (const Usage& usage : passes_[index].usages) {
+                    bool attachment = isAttachment(usage.type);
+                    bool seen = std::find(attachments_seen.begin(), attachments_seen.end(), usage.resource) != attachments_seen.end();
+
+                    beginUse(usage.resource);
+                    if (!(attachment && seen)) {
+                        addBarrier(usage, batch);
+                    }
+                    applyUsage(usage);
+
+                    if (attachment && !seen) attachments_seen.push_back(usage.resource);
+                }
+            }
+            flushBarriers(command_buffer, batch);
+
+            vk::Framebuffer framebuffer = getFramebuffer(group);
+
+            vk::RenderPassBeginInfo render_pass_info{};
+            render_pass_info.renderPass = group.render_pass;
+            render_pass_info.framebuffer = framebuffer;
+            render_pass_info.renderArea.offset = vk::Offset2D{ 0, 0 };
+            render_pass_info.renderArea.extent = extent_;
+            render_pass_info.clearValueCount = static_cast<uint32_t>(group.clear_values.size());
+            render_pass_info.pClearValues = group.clear_values.data();
+
+            command_buffer.beginRenderPass(render_pass_info, contents);
+            for (uint32_t subpass = 0; subpass < group.passes.size(); subpass++) {
+                if (subpass > 0) {
+                    command_buffer.nextSubpass(contents);
+                }
+
+                PassContext context{ command_buffer, contents, group.render_pass, subpass, framebuffer, nullptr };
+                passes_[group.passes[subpass]].record(context);
+            }
+            command_buffer.endRenderPass();
+
+            // The render pass may have handed an image over already.
+            for (Resource attachment : group.attachments) {
+                ResourceInfo& resource = resources_[attachment];
+                if (resource.last_pass <= group.passes.back() && resource.import.final_layout != vk::ImageLayout::eUndefined) {
+                    resource.state.layout = resource.import.final_layout;
+                }
+            }
+        }
+
+        if (profiler_) profiler_->endScope(command_buffer);
+    }
+
+    // Imported images not handed over by a render pass.
+    for (Resource index = 0; index < resources_.size(); index++) {
+        ResourceInfo& resource = resources_[index];
+        if (!used_this_frame_[index] || resource.import.final_layout == vk::ImageLayout::eUndefined ||
+            resource.state.layout == resource.import.final_layout) {
+            continue;
+        }
+
+        Usage usage{};
+        usage.resource = index;
+        usage.type = UsageType::Sampled;
+        usage.stages = vk::PipelineStageFlagBits::eBottomOfPipe;
+        usage.layout = resource.import.final_layout;
+        usage.write = false;
+        addBarrier(usage, batch);
+        resource.state.layout = resource.import.final_layout;
+    }
+    flushBarriers(command_buffer, batch);
+}
+
+void RenderGraph::beginUse(Resource index) {
+    if (used_this_frame_[index]) return;
+    used_this_frame_[index] = true;
+
+    ResourceInfo& resource = resources_[index];
+    if (resource.transient) {
+        // Contents start over, but the memory may still be in use by this
+        // image last frame or by an alias earlier in this one.
+        resource.state = memory_slots_[resource.memory_slot].state;
+        resource.state.layout = vk::ImageLayout::eUndefined;
+    }
+    else if (resource.reset_each_frame) {
+        resource.state = AccessState{};
+        resource.state.layout = resource.import.fixed_layout;
+    }
+}
+
+void RenderGraph::addBarrier(const Usage& usage, BarrierBatch& batch) {
+    const ResourceInfo& resource = resources_[usage.resource];
+    const AccessState& state = resource.state;
+
+    bool layout_change = resource.is_image && state.layout != usage.layout;
+    vk::PipelineStageFlags src_stages;
+    vk::AccessFlags src_access;
+
+    if (usage.write || layout_change) {
+        // Writes wait for earlier reads (WAR) and writes (WAW).
+        src_stages = state.write_stages | state.read_stages;
+        src_access = state.write_access;
+        if (!src_stages && !layout_change) return;
+    }
+    else if (state.write_stages &&
+        ((usage.stages & ~state.visible_stages) || (usage.access & ~state.visible_access))) {
+        src_stages = state.write_stages;
+        src_access = state.write_access;
+    }
+    else {
+        // Never written, or the last write is already visible to this read.
+        return;
+    }
+
+    // Nothing to wait for but the layout change itself: chaining to the
+    // destination stages also chains to semaphore waits on them.
+    if (!src_stages) {
+        src_stages = usage.stages;
+    }
+
+    batch.src_stages |= src_stages;
+    batch.dst_stages |= usage.stages;
+
+    if (resource.is_image && (layout_change || src_access)) {
+        vk::ImageMemoryBarrier barrier{};
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = usage.access;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = usage.layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.image;
+        barrier.subresourceRange = vk::ImageSubresourceRange{ getBarrierAspect(resource.import.format),
+            0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+        batch.image_barriers.push_back(barrier);
+    }
+    else if (!resource.is_image && src_access) {
+        vk::BufferMemoryBarrier barrier{};
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = usage.access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = resource.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        batch.buffer_barriers.push_back(barrier);
+    }
+}
+
+void RenderGraph::applyUsage(const Usage& usage) {
+    ResourceInfo& resource = resources_[usage.resource];
+    AccessState& state = resource.state;
+
+    if (usage.write) {
+        state.write_stages = usage.stages;
+        state.write_access = usage.access;
+        state.read_stages = vk::PipelineStageFlags{};
+        state.visible_stages = vk::PipelineStageFlags{};
+        state.visible_access = vk::AccessFlags{};
+    }
+    else {
+        state.read_stages |= usage.stages;
+        state.visible_stages |= usage.stages;
+        state.visible_access |= usage.access;
+    }
+
+    if (resource.is_image) {
+        state.layout = usage.layout;
+    }
+
+    if (resource.transient) {
+        memory_slots_[resource.memory_slot].state = state;
+    }
+}
+
+void RenderGraph::flushBarriers(vk::CommandBuffer command_buffer, BarrierBatch& batch) {
+    // Execution-only dependencies (WAR) have stages but no barrier structs.
+    if (batch.src_stages) {
+        command_buffer.pipelineBarrier(batch.src_stages, batch.dst_stages, vk::DependencyFlags{},
+            0, nullptr,
+            static_cast<uint32_t>(batch.buffer_barriers.size()), batch.buffer_barriers.data(),
+            static_cast<uint32_t>(batch.image_barriers.size()), batch.image_barriers.data());
+    }
+
+    batch.src_stages = vk::PipelineStageFlags{};
+    batch.dst_stages = vk::PipelineStageFlags{};
+    batch.image_barriers.clear();
+    batch.buffer_barriers.clear();
+}
+
+bool RenderGraph::isDepthFormat(vk::Format format) {
+    return format == vk::Format::eD32Sfloat || format == vk::Format::eD16Unorm ||
+        format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint;
+}
+
+vk::ImageAspectFlags RenderGraph::getBarrierAspect(vk::Format format) {
+    // Layout transitions of combined formats have to cover both aspects.
+    if (format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint) {
+        return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+    }
+    return isDepthFormat(format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+}
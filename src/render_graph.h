@@ -0,0 +1,230 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VulkanContext;
+class GpuProfiler;
+
+// Frame-level scheduling of passes that declare what they read and write.
+//
+// Passes run in the order they were added. compile() merges runs of graphics
+// passes into one vk::RenderPass with a subpass each, as long as no pass of
+// the run samples an attachment or touches a buffer another pass of the run
+// writes; the dependencies between those subpasses come from the declared
+// attachment use. Everything else is synchronized by execute(): it tracks the
+// last writes and reads of every resource across frames and records a single
+// batched barrier in front of each render pass or compute pass, only for the
+// hazards and layout changes that actually occur.
+//
+// With dynamic rendering (Vulkan 1.3 devices) nothing is merged: every
+// graphics pass begins its own rendering scope on the attachments it declared,
+// with the load and store ops a render pass would have used, and no render
+// pass or framebuffer objects exist. The barriers execute() records then also
+// cover what the subpass dependencies did.
+//
+// Graph-owned images are transient: their contents live within a frame and
+// images whose lifetimes do not overlap share memory.
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+    using Pass = uint32_t;
+
+    enum class PassType {
+        Graphics,
+        Compute
+    };
+
+    struct PassContext {
+        vk::CommandBuffer command_buffer;
+        vk::SubpassContents contents;
+        // Graphics passes only, e.g. for the inheritance of secondary buffers.
+        vk::RenderPass render_pass;
+        uint32_t subpass;
+        vk::Framebuffer framebuffer;
+        // Dynamic rendering only, in place of the three above.
+        const vk::CommandBufferInheritanceRenderingInfoKHR* rendering;
+    };
+    using RecordFunction = std::function<void(const PassContext&)>;
+
+    struct ImageImport {
+        vk::Format format = vk::Format::eUndefined;
+        // Layout the image keeps for every use, e.g. eGeneral for an image that
+        // is both sampled and written as storage. eUndefined lets the graph
+        // pick the optimal layout per use.
+        vk::ImageLayout fixed_layout = vk::ImageLayout::eUndefined;
+        // Layout to hand the image over in after its last use of a frame.
+        vk::ImageLayout final_layout = vk::ImageLayout::eUndefined;
+        // The image starts every frame undefined and unordered, like a swap
+        // chain image whose acquire semaphore already orders it.
+        bool reset_each_frame = false;
+    };
+
+    RenderGraph(std::shared_ptr<VulkanContext> context);
+    ~RenderGraph();
+
+    // Declaration, before compile(). Every pass uses a resource at most once.
+    Resource importImage(const std::string& name, const ImageImport& import);
+    Resource createImage(const std::string& name, vk::Format format);
+    // `reset_each_frame` is for buffers split into per-frame regions, whose
+    // uses by earlier frames are retired by their fences.
+    Resource importBuffer(const std::string& name, bool reset_each_frame = false);
+
+    Pass addPass(const std::string& name, PassType type, RecordFunction record);
+    void addColorAttachment(Pass pass, Resource image, const vk::ClearColorValue* clear = nullptr);
+    void addDepthAttachment(Pass pass, Resource image, bool write, const vk::ClearDepthStencilValue* clear = nullptr);
+    void addImageRead(Pass pass, Resource image, vk::PipelineStageFlags stages);
+    void addImageWrite(Pass pass, Resource image, vk::PipelineStageFlags stages);
+    void addBufferRead(Pass pass, Resource buffer, vk::PipelineStageFlags stages, vk::AccessFlags access);
+    void addBufferWrite(Pass pass, Resource buffer, vk::PipelineStageFlags stages, vk::AccessFlags access);
+
+    // Merges passes and creates the render passes; formats are fixed afterwards.
+    bool compile();
+    // (Re)creates the graph-owned images; call again whenever the extent or
+    // the imported image views change, e.g. after a swap chain resize.
+    bool createResources(vk::Extent2D extent);
+    void cleanup();
+
+    // Null with dynamic rendering; pipelines chain getPipelineRenderingInfo()
+    // instead, which stays valid as long as the graph.
+    vk::RenderPass getRenderPass(Pass pass) const;
+    uint32_t getSubpass(Pass pass) const;
+    bool usesDynamicRendering() const { return dynamic_rendering_; }
+    vk::PipelineRenderingCreateInfoKHR getPipelineRenderingInfo(Pass pass) const;
+    vk::ImageView getImageView(Resource image) const;
+
+    // Handles of imported resources for the next execute().
+    void setImage(Resource image, vk::Image handle, vk::ImageView view);
+    void setBuffer(Resource buffer, vk::Buffer handle);
+
+    // Opens a GPU scope around every render pass and compute pass.
+    void setProfiler(GpuProfiler* profiler) { profiler_ = profiler; }
+
+    // `contents` applies to every subpass; pass callbacks record accordingly.
+    void execute(vk::CommandBuffer command_buffer, vk::SubpassContents contents);
+
+private:
+    enum class UsageType {
+        ColorAttachment,
+        DepthAttachment,
+        Sampled,
+        Storage,
+        Buffer
+    };
+
+    struct Usage {
+        Resource resource;
+        UsageType type;
+        vk::PipelineStageFlags stages;
+        vk::AccessFlags access;
+        vk::ImageLayout layout;
+        bool write;
+        bool clear;
+        vk::ClearValue clear_value;
+    };
+
+    // What the GPU may still be doing with a resource.
+    struct AccessState {
+        vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+        vk::PipelineStageFlags write_stages;
+        vk::AccessFlags write_access;
+        vk::PipelineStageFlags read_stages;   // reads since the last write
+        vk::PipelineStageFlags visible_stages; // stages the last write is visible to
+        vk::AccessFlags visible_access;
+    };
+
+    struct ResourceInfo {
+        std::string name;
+        bool is_image = false;
+        bool transient = false;
+        ImageImport import;
+        bool reset_each_frame = false;
+        vk::ImageUsageFlags usage;
+
+        vk::Image image;
+        vk::ImageView view;
+        vk::Buffer buffer;
+
+        uint32_t first_pass = ~0u;
+        uint32_t last_pass = 0;
+        uint32_t memory_slot = ~0u;
+        AccessState state;
+    };
+
+    struct PassInfo {
+        std::string name;
+        PassType type;
+        RecordFunction record;
+        std::vector<Usage> usages;
+        uint32_t group = 0;
+        uint32_t subpass = 0;
+    };
+
+    // A render pass of merged graphics passes, or a single compute pass.
+    struct Group {
+        std::string name;
+        std::vector<Pass> passes;
+        vk::RenderPass render_pass;
+        std::vector<Resource> attachments;
+        std::vector<vk::AttachmentDescription> descriptions; // per attachment
+        std::vector<vk::ClearValue> clear_values;
+        std::map<std::vector<VkImageView>, vk::Framebuffer> framebuffers;
+
+        // Dynamic rendering: color formats in attachment order.
+        std::vector<vk::Format> color_formats;
+        vk::Format depth_format = vk::Format::eUndefined;
+        vk::CommandBufferInheritanceRenderingInfoKHR inheritance_rendering;
+    };
+
+    // Memory shared by transient images with disjoint lifetimes.
+    struct MemorySlot {
+        GpuAllocation allocation;
+        vk::MemoryRequirements requirements;
+        std::vector<Resource> images;
+        AccessState state;
+    };
+
+    struct BarrierBatch {
+        vk::PipelineStageFlags src_stages;
+        vk::PipelineStageFlags dst_stages;
+        std::vector<vk::ImageMemoryBarrier> image_barriers;
+        std::vector<vk::BufferMemoryBarrier> buffer_barriers;
+    };
+
+    void addUsage(Pass pass, const Usage& usage);
+    bool canMerge(const Group& group, const PassInfo& pass) const;
+    bool createRenderPass(Group& group);
+    bool assignMemory();
+    void destroyResources();
+    vk::Framebuffer getFramebuffer(Group& group);
+    void beginRendering(vk::CommandBuffer command_buffer, const Group& group, vk::SubpassContents contents) const;
+
+    void beginUse(Resource resource);
+    void addBarrier(const Usage& usage, BarrierBatch& batch);
+    void applyUsage(const Usage& usage);
+    void flushBarriers(vk::CommandBuffer command_buffer, BarrierBatch& batch);
+
+    static bool isAttachment(UsageType type) {
+        return type == UsageType::ColorAttachment || type == UsageType::DepthAttachment;
+    }
+    static bool isDepthFormat(vk::Format format);
+    static vk::ImageAspectFlags getBarrierAspect(vk::Format format);
+
+    std::shared_ptr<VulkanContext> context_;
+    GpuProfiler* profiler_;
+
+    std::vector<ResourceInfo> resources_;
+    std::vector<PassInfo> passes_;
+    std::vector<Group> groups_;
+    std::vector<MemorySlot> memory_slots_;
+    std::vector<bool> used_this_frame_;
+
+    vk::Extent2D extent_;
+    bool dynamic_rendering_;
+    bool compiled_;
+};
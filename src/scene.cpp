@@ -0,0 +1,693 @@
+#include "scene.h"
+#include "vulkan_context.h"
+#include "depth_pyramid.h"
+#include "shader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t CULLING_GROUP_SIZE = 64;
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+uint32_t growCapacity(uint32_t capacity, size_t required) {
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+}
+
+Scene::Scene(std::shared_ptr<VulkanContext> context)
+    : context_(context), frame_count_(0), object_capacity_(0), command_capacity_(0), command_count_(0),
+    object_region_size_(0), visible_region_size_(0), indirect_region_size_(0), culling_region_size_(0),
+    view_(1.0f), projection_(1.0f), occlusion_view_(1.0f), occlusion_projection_(1.0f), near_plane_(0.1f),
+    lod_scale_(0.0f), lod_error_threshold_(1.0f), occlusion_ready_(false), pyramid_mip_levels_(0),
+    batches_dirty_(false), revision_(1) {
+}
+
+Scene::~Scene() {
+    cleanup();
+}
+
+bool Scene::initialize(uint32_t object_capacity, uint32_t mesh_capacity) {
+    frame_count_ = VulkanContext::MAX_FRAMES_IN_FLIGHT;
+    region_revisions_.assign(frame_count_, 0);
+
+    if (!createDescriptorSetLayouts()) {
+        LOGE("Failed to create scene descriptor set layouts");
+        return false;
+    }
+
+    if (!createDescriptorPool()) {
+        LOGE("Failed to create scene descriptor pool");
+        return false;
+    }
+
+    if (!createBuffers(std::max(object_capacity, 1u), std::max(mesh_capacity, 1u) * Mesh::MAX_LODS)) {
+        LOGE("Failed to create scene buffers");
+        return false;
+    }
+
+    std::array<vk::DescriptorSetLayout, 2> layouts = { descriptor_set_layout_, culling_descriptor_set_layout_ };
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    alloc_info.pSetLayouts = layouts.data();
+
+    try {
+        auto sets = context_->getDevice().allocateDescriptorSets(alloc_info);
+        descriptor_set_ = sets[0];
+        culling_descriptor_set_ = sets[1];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate scene descriptor sets: {}", e.what());
+        return false;
+    }
+
+    updateDescriptorSets();
+
+    if (!createCullingPipeline()) {
+        LOGE("Failed to create scene culling pipeline");
+        return false;
+    }
+
+    LOGI("Scene initialized with capacity for {} objects and {} draw commands", object_capacity_, command_capacity_);
+    return true;
+}
+
+void Scene::cleanup() {
+    if (!context_) return;
+
+    auto device = context_->getDevice();
+
+    meshes_.clear();
+    objects_.clear();
+    object_meshes_.clear();
+    draw_order_.clear();
+    batches_.clear();
+
+    destroyBuffers();
+
+    if (culling_pipeline_) {
+        device.destroyPipeline(culling_pipeline_);
+        culling_pipeline_ = nullptr;
+    }
+
+    if (culling_pipeline_layout_) {
+        device.destroyPipelineLayout(culling_pipeline_layout_);
+        culling_pipeline_layout_ = nullptr;
+    }
+
+    if (descriptor_pool_) {
+        device.destroyDescriptorPool(descriptor_pool_);
+        descriptor_pool_ = nullptr;
+    }
+
+    if (descriptor_set_layout_) {
+        device.destroyDescriptorSetLayout(descriptor_set_layout_);
+        descriptor_set_layout_ = nullptr;
+    }
+
+    if (culling_descriptor_set_layout_) {
+        device.destroyDescriptorSetLayout(culling_descriptor_set_layout_);
+        culling_descriptor_set_layout_ = nullptr;
+    }
+}
+
+uint32_t Scene::addMesh(std::unique_ptr<Mesh> mesh) {
+    meshes_.push_back(std::move(mesh));
+    return static_cast<uint32_t>(meshes_.size() - 1);
+}
+
+uint32_t Scene::addObject(uint32_t mesh_id, const glm::mat4& transform) {
+    uint32_t object_id = static_cast<uint32_t>(objects_.size());
+
+    objects_.emplace_back();
+    object_meshes_.push_back(mesh_id);
+    setTransform(object_id, transform);
+
+    batches_dirty_ = true;
+    return object_id;
+}
+
+void Scene::setTransform(uint32_t object_id, const glm::mat4& transform) {
+    ObjectData& object = objects_[object_id];
+    object.model = transform;
+    object.normal_matrix = glm::transpose(glm::inverse(transform));
+    updateBounds(object_id);
+    revision_++;
+}
+
+void Scene::updateBounds(uint32_t object_id) {
+    ObjectData& object = objects_[object_id];
+    const BoundingSphere& bounds = meshes_[object_meshes_[object_id]]->getBounds();
+
+    // A sphere stays a sphere under the largest axis scale.
+    float scale = std::max({ glm::length(glm::vec3(object.model[0])),
+        glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2])) });
+    object.bounding_sphere = glm::vec4(glm::vec3(object.model * glm::vec4(bounds.center, 1.0f)),
+        bounds.radius < 0.0f ? -1.0f : bounds.radius * scale);
+}
+
+void Scene::clearObjects() {
+    objects_.clear();
+    object_meshes_.clear();
+    draw_order_.clear();
+    batches_.clear();
+    command_count_ = 0;
+    batches_dirty_ = false;
+    revision_++;
+}
+
+void Scene::setCamera(const glm::mat4& view, const glm::mat4& projection, float near_plane, uint32_t viewport_height) {
+    view_ = view;
+    projection_ = projection;
+    near_plane_ = near_plane;
+    // A sphere of radius r at distance d spans about r * lod_scale_ / d pixels.
+    lod_scale_ = std::abs(projection[1][1]) * 0.5f * static_cast<float>(viewport_height);
+}
+
+bool Scene::setDepthPyramid(const DepthPyramid& depth_pyramid) {
+    // The first pyramid is bound before any frame uses the set.
+    if (pyramid_mip_levels_ > 0 && !replaceCullingDescriptorSet()) {
+        return false;
+    }
+
+    pyramid_extent_ = depth_pyramid.getExtent();
+    pyramid_mip_levels_ = depth_pyramid.getMipLevels();
+
+    vk::DescriptorImageInfo image_info{};
+    image_info.sampler = depth_pyramid.getSampler();
+    image_info.imageView = depth_pyramid.getView();
+    image_info.imageLayout = vk::ImageLayout::eGeneral;
+
+    vk::WriteDescriptorSet descriptor_write{};
+    descriptor_write.dstSet = culling_descriptor_set_;
+    descriptor_write.dstBinding = 4;
+    descriptor_write.dstArrayElement = 0;
+    descriptor_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    descriptor_write.descriptorCount = 1;
+    descriptor_write.pImageInfo = &image_info;
+
+    context_->getDevice().updateDescriptorSets(1, &descriptor_write, 0, nullptr);
+    return true;
+}
+
+bool Scene::replaceCullingDescriptorSet() {
+    auto device = context_->getDevice();
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &culling_descriptor_set_layout_;
+
+    vk::DescriptorSet descriptor_set;
+    try {
+        descriptor_set = device.allocateDescriptorSets(alloc_info)[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate scene culling descriptor set: {}", e.what());
+        return false;
+    }
+
+    // The buffers stay; only the pyramid binding is rewritten by the caller.
+    std::array<vk::CopyDescriptorSet, 4> copies{};
+    for (uint32_t i = 0; i < copies.size(); i++) {
+        copies[i].srcSet = culling_descriptor_set_;
+        copies[i].srcBinding = i;
+        copies[i].dstSet = descriptor_set;
+        copies[i].dstBinding = i;
+        copies[i].descriptorCount = 1;
+    }
+    device.updateDescriptorSets(0, nullptr, static_cast<uint32_t>(copies.size()), copies.data());
+
+    vk::DescriptorPool pool = descriptor_pool_;
+    vk::DescriptorSet old_set = culling_descriptor_set_;
+    context_->retire([device, pool, old_set]() { device.freeDescriptorSets(pool, 1, &old_set); });
+
+    culling_descriptor_set_ = descriptor_set;
+    return true;
+}
+
+bool Scene::update(uint32_t frame_index) {
+    if (batches_dirty_) {
+        rebuildBatches();
+    }
+
+    if (objects_.size() > object_capacity_ || command_count_ > command_capacity_) {
+        uint32_t object_capacity = growCapacity(object_capacity_, objects_.size());
+        uint32_t command_capacity = growCapacity(command_capacity_, command_count_);
+
+        if (!growBuffers(object_capacity, command_capacity)) {
+            LOGE("Failed to grow scene buffers to {} objects", object_capacity);
+            return false;
+        }
+
+        std::fill(region_revisions_.begin(), region_revisions_.end(), 0);
+        LOGI("Scene buffers grown to {} objects and {} draw commands", object_capacity_, command_capacity_);
+    }
+
+    uint32_t region = frame_index % frame_count_;
+    if (region_revisions_[region] != revision_) {
+        auto* objects = reinterpret_cast<ObjectData*>(
+            static_cast<char*>(object_buffer_allocation_.mapped) + object_region_size_ * region);
+        for (const DrawBatch& batch : batches_) {
+            // Packed meshes store positions relative to their bounding box; the
+            // box transform rides on the model matrix, but not on the normal
+            // matrix, which must stay that of the object.
+            const glm::mat4& position_transform = meshes_[batch.mesh_id]->getPositionTransform();
+            for (uint32_t i = batch.first_instance; i < batch.first_instance + batch.instance_count; i++) {
+                objects[i] = objects_[draw_order_[i]];
+                objects[i].model = objects[i].model * position_transform;
+                objects[i].draw_info = glm::uvec4(batch.first_command, batch.lod_count, 0, 0);
+            }
+        }
+
+        region_revisions_[region] = revision_;
+    }
+
+    // The culling pass counts instances up from zero, so the commands are
+    // rewritten every frame. Visible lists are sized for every object of a
+    // batch picking the same LOD: LOD l of a batch starting at instance i
+    // owns the range starting at MAX_LODS * i + l * instance_count.
+    auto* commands = reinterpret_cast<SceneDrawCommand*>(
+        static_cast<char*>(indirect_buffer_allocation_.mapped) + indirect_region_size_ * region);
+    for (const DrawBatch& batch : batches_) {
+        const std::vector<MeshLod>& lods = meshes_[batch.mesh_id]->getLods();
+        for (uint32_t lod = 0; lod < batch.lod_count; lod++) {
+            SceneDrawCommand& command = commands[batch.first_command + lod];
+            command.command.indexCount = lods[lod].index_count;
+            command.command.instanceCount = 0;
+            command.command.firstIndex = lods[lod].first_index;
+            command.command.vertexOffset = 0;
+            command.command.firstInstance = Mesh::MAX_LODS * batch.first_instance + lod * batch.instance_count;
+            command.lod_error = lods[lod].error;
+        }
+    }
+
+    // Frustum planes (Gribb-Hartmann) of the current camera, normalized so the
+    // shader can compare signed distances with the sphere radius. Vulkan clips
+    // z to [0, w], hence the near plane is the third row alone.
+    glm::mat4 view_projection = projection_ * view_;
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    }
+
+    SceneCullingData culling_data{};
+    culling_data.occlusion_view = occlusion_view_;
+    culling_data.occlusion_projection = occlusion_projection_;
+    culling_data.frustum_planes[0] = rows[3] + rows[0];
+    culling_data.frustum_planes[1] = rows[3] - rows[0];
+    culling_data.frustum_planes[2] = rows[3] + rows[1];
+    culling_data.frustum_planes[3] = rows[3] - rows[1];
+    culling_data.frustum_planes[4] = rows[2];
+    culling_data.frustum_planes[5] = rows[3] - rows[2];
+    for (glm::vec4& plane : culling_data.frustum_planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    culling_data.pyramid_params = glm::vec4(static_cast<float>(pyramid_extent_.width),
+        static_cast<float>(pyramid_extent_.height), static_cast<float>(pyramid_mip_levels_), near_plane_);
+    culling_data.camera_position = glm::inverse(view_)[3];
+    culling_data.lod_params = glm::vec4(lod_scale_, lod_error_threshold_, 0.0f, 0.0f);
+    culling_data.counts = glm::uvec4(static_cast<uint32_t>(draw_order_.size()),
+        occlusion_ready_ && pyramid_mip_levels_ > 0 ? 1u : 0u, 0u, 0u);
+    memcpy(static_cast<char*>(culling_buffer_allocation_.mapped) + culling_region_size_ * region,
+        &culling_data, sizeof(culling_data));
+
+    // The pyramid this frame builds is read with this frame's camera next frame.
+    occlusion_view_ = view_;
+    occlusion_projection_ = projection_;
+    occlusion_ready_ = true;
+    return true;
+}
+
+void Scene::recordCulling(vk::CommandBuffer command_buffer, uint32_t frame_index) {
+    if (batches_.empty()) return;
+
+    uint32_t region = frame_index % frame_count_;
+    std::array<uint32_t, 4> dynamic_offsets = {
+        static_cast<uint32_t>(object_region_size_ * region),
+        static_cast<uint32_t>(visible_region_size_ * region),
+        static_cast<uint32_t>(indirect_region_size_ * region),
+        static_cast<uint32_t>(culling_region_size_ * region)
+    };
+
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, culling_pipeline_);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, culling_pipeline_layout_,
+        0, 1, &culling_descriptor_set_, static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+    command_buffer.dispatch((static_cast<uint32_t>(draw_order_.size()) + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+}
+
+void Scene::draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t frame_index) const {
+    draw(command_buffer, pipeline_layout, frame_index, 0, getBatchCount());
+}
+
+void Scene::draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t frame_index,
+    uint32_t first_batch, uint32_t batch_count) const {
+    if (batch_count == 0 || first_batch >= batches_.size()) return;
+    uint32_t last_batch = std::min(first_batch + batch_count, getBatchCount());
+
+    uint32_t region = frame_index % frame_count_;
+    std::array<uint32_t, 2> dynamic_offsets = {
+        static_cast<uint32_t>(object_region_size_ * region),
+        static_cast<uint32_t>(visible_region_size_ * region)
+    };
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout,
+        1, 1, &descriptor_set_, static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+    // LODs no object picked this frame are empty draws and cost next to nothing.
+    vk::DeviceSize region_offset = indirect_region_size_ * region;
+    for (uint32_t i = first_batch; i < last_batch; i++) {
+        const DrawBatch& batch = batches_[i];
+        meshes_[batch.mesh_id]->bind(command_buffer);
+        for (uint32_t lod = 0; lod < batch.lod_count; lod++) {
+            command_buffer.drawIndexedIndirect(indirect_buffer_,
+                region_offset + sizeof(SceneDrawCommand) * (batch.first_command + lod), 1, sizeof(SceneDrawCommand));
+        }
+    }
+}
+
+bool Scene::createDescriptorSetLayouts() {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorCount = 1;
+        bindings[i].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+        bindings[i].pImmutableSamplers = nullptr;
+        bindings[i].stageFlags = vk::ShaderStageFlagBits::eVertex;
+    }
+
+    // Objects, visible list, indirect commands, culling data, depth pyramid.
+    std::array<vk::DescriptorSetLayoutBinding, 5> culling_bindings{};
+    for (uint32_t i = 0; i < culling_bindings.size(); i++) {
+        culling_bindings[i].binding = i;
+        culling_bindings[i].descriptorCount = 1;
+        culling_bindings[i].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+        culling_bindings[i].pImmutableSamplers = nullptr;
+        culling_bindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+    }
+    culling_bindings[3].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+    culling_bindings[4].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    vk::DescriptorSetLayoutCreateInfo culling_layout_info{};
+    culling_layout_info.bindingCount = static_cast<uint32_t>(culling_bindings.size());
+    culling_layout_info.pBindings = culling_bindings.data();
+
+    try {
+        descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
+        culling_descriptor_set_layout_ = device.createDescriptorSetLayout(culling_layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create scene descriptor set layout: {}", e.what());
+        return false;
+    }
+}
+
+bool Scene::createDescriptorPool() {
+    // Room for the sets retired while frames recorded before them complete:
+    // culling sets of depth pyramid replacements, at most two swapchain
+    // recreations per frame, and both sets of at most one growth per frame.
+    const uint32_t scene_sets = 1 + VulkanContext::MAX_FRAMES_IN_FLIGHT;
+    const uint32_t culling_sets = 1 + 3 * VulkanContext::MAX_FRAMES_IN_FLIGHT;
+
+    std::array<vk::DescriptorPoolSize, 3> pool_sizes{};
+    pool_sizes[0].type = vk::DescriptorType::eStorageBufferDynamic;
+    pool_sizes[0].descriptorCount = 2 * scene_sets + 3 * culling_sets;
+    pool_sizes[1].type = vk::DescriptorType::eUniformBufferDynamic;
+    pool_sizes[1].descriptorCount = culling_sets;
+    pool_sizes[2].type = vk::DescriptorType::eCombinedImageSampler;
+    pool_sizes[2].descriptorCount = culling_sets;
+
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = scene_sets + culling_sets;
+
+    try {
+        descriptor_pool_ = context_->getDevice().createDescriptorPool(pool_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create scene descriptor pool: {}", e.what());
+        return false;
+    }
+}
+
+bool Scene::createCullingPipeline() {
+    auto device = context_->getDevice();
+
+    Shader shader(context_);
+    if (!shader.loadComputeFromFile(SHADER_DIR "scene_cull.comp")) {
+        LOGE("Failed to load scene culling shader");
+        return false;
+    }
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &culling_descriptor_set_layout_;
+
+    try {
+        culling_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create scene culling pipeline layout: {}", e.what());
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipeline_info.stage.module = shader.getComputeShader();
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = culling_pipeline_layout_;
+
+    try {
+        culling_pipeline_ = device.createComputePipeline(context_->getPipelineCache(), pipeline_info).value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create scene culling pipeline: {}", e.what());
+        return false;
+    }
+}
+
+bool Scene::createBuffers(uint32_t object_capacity, uint32_t command_capacity) {
+    auto& allocator = context_->getAllocator();
+    auto limits = context_->getPhysicalDevice().getProperties().limits;
+    vk::DeviceSize storage_alignment = std::max<vk::DeviceSize>(limits.minStorageBufferOffsetAlignment, 16);
+
+    object_region_size_ = alignUp(sizeof(ObjectData) * object_capacity, storage_alignment);
+    visible_region_size_ = alignUp(sizeof(uint32_t) * object_capacity * Mesh::MAX_LODS, storage_alignment);
+    indirect_region_size_ = alignUp(sizeof(SceneDrawCommand) * command_capacity, storage_alignment);
+    culling_region_size_ = alignUp(sizeof(SceneCullingData),
+        std::max<vk::DeviceSize>(limits.minUniformBufferOffsetAlignment, 16));
+
+    bool created =
+        allocator.createBuffer(object_region_size_ * frame_count_, vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            object_buffer_, object_buffer_allocation_) &&
+        allocator.createBuffer(visible_region_size_ * frame_count_, vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            visible_buffer_, visible_buffer_allocation_) &&
+        allocator.createBuffer(indirect_region_size_ * frame_count_,
+            vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            indirect_buffer_, indirect_buffer_allocation_) &&
+        allocator.createBuffer(culling_region_size_ * frame_count_, vk::BufferUsageFlagBits::eUniformBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            culling_buffer_, culling_buffer_allocation_);
+
+    if (!created) {
+        destroyBuffers();
+        return false;
+    }
+
+    object_capacity_ = object_capacity;
+    command_capacity_ = command_capacity;
+    return true;
+}
+
+bool Scene::growBuffers(uint32_t object_capacity, uint32_t command_capacity) {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorSetLayout, 2> layouts = { descriptor_set_layout_, culling_descriptor_set_layout_ };
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    alloc_info.pSetLayouts = layouts.data();
+
+    std::vector<vk::DescriptorSet> sets;
+    try {
+        sets = device.allocateDescriptorSets(alloc_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate scene descriptor sets: {}", e.what());
+        return false;
+    }
+
+    // Set the current buffers aside, so that a failed creation restores them
+    // and the scene keeps drawing at its old capacity.
+    std::array<vk::Buffer, 4> old_buffers = { object_buffer_, visible_buffer_, indirect_buffer_, culling_buffer_ };
+    std::array<GpuAllocation, 4> old_allocations = { object_buffer_allocation_, visible_buffer_allocation_,
+        indirect_buffer_allocation_, culling_buffer_allocation_ };
+    std::array<vk::DeviceSize, 4> old_region_sizes = { object_region_size_, visible_region_size_,
+        indirect_region_size_, culling_region_size_ };
+
+    object_buffer_ = nullptr;
+    object_buffer_allocation_ = {};
+    visible_buffer_ = nullptr;
+    visible_buffer_allocation_ = {};
+    indirect_buffer_ = nullptr;
+    indirect_buffer_allocation_ = {};
+    culling_buffer_ = nullptr;
+    culling_buffer_allocation_ = {};
+
+    if (!createBuffers(object_capacity, command_capacity)) {
+        object_buffer_ = old_buffers[0];
+        visible_buffer_ = old_buffers[1];
+        indirect_buffer_ = old_buffers[2];
+        culling_buffer_ = old_buffers[3];
+        object_buffer_allocation_ = old_allocations[0];
+        visible_buffer_allocation_ = old_allocations[1];
+        indirect_buffer_allocation_ = old_allocations[2];
+        culling_buffer_allocation_ = old_allocations[3];
+        object_region_size_ = old_region_sizes[0];
+        visible_region_size_ = old_region_sizes[1];
+        indirect_region_size_ = old_region_sizes[2];
+        culling_region_size_ = old_region_sizes[3];
+
+        device.freeDescriptorSets(descriptor_pool_, static_cast<uint32_t>(sets.size()), sets.data());
+        return false;
+    }
+
+    // Frames in flight still read the old buffers through the old sets; both
+    // are destroyed once those frames complete.
+    GpuAllocator* allocator = &context_->getAllocator();
+    context_->retire([allocator, old_buffers, old_allocations]() mutable {
+        for (size_t i = 0; i < old_buffers.size(); i++) {
+            allocator->destroyBuffer(old_buffers[i], old_allocations[i]);
+        }
+    });
+
+    vk::DescriptorSet old_set = descriptor_set_;
+    vk::DescriptorSet old_culling_set = culling_descriptor_set_;
+    descriptor_set_ = sets[0];
+    culling_descriptor_set_ = sets[1];
+    updateDescriptorSets();
+
+    // The depth pyramid binding carries over once written.
+    if (pyramid_mip_levels_ > 0) {
+        vk::CopyDescriptorSet copy{};
+        copy.srcSet = old_culling_set;
+        copy.srcBinding = 4;
+        copy.dstSet = culling_descriptor_set_;
+        copy.dstBinding = 4;
+        copy.descriptorCount = 1;
+        device.updateDescriptorSets(0, nullptr, 1, &copy);
+    }
+
+    vk::DescriptorPool pool = descriptor_pool_;
+    context_->retire([device, pool, old_set, old_culling_set]() {
+        std::array<vk::DescriptorSet, 2> old_sets = { old_set, old_culling_set };
+        device.freeDescriptorSets(pool, static_cast<uint32_t>(old_sets.size()), old_sets.data());
+    });
+    return true;
+}
+
+void Scene::destroyBuffers() {
+    auto& allocator = context_->getAllocator();
+
+    if (object_buffer_) {
+        allocator.destroyBuffer(object_buffer_, object_buffer_allocation_);
+    }
+
+    if (visible_buffer_) {
+        allocator.destroyBuffer(visible_buffer_, visible_buffer_allocation_);
+    }
+
+    if (indirect_buffer_) {
+        allocator.destroyBuffer(indirect_buffer_, indirect_buffer_allocation_);
+    }
+
+    if (culling_buffer_) {
+        allocator.destroyBuffer(culling_buffer_, culling_buffer_allocation_);
+    }
+}
+
+void Scene::updateDescriptorSets() {
+    std::array<vk::DescriptorBufferInfo, 4> buffer_infos{};
+    buffer_infos[0] = vk::DescriptorBufferInfo{ object_buffer_, 0, object_region_size_ };
+    buffer_infos[1] = vk::DescriptorBufferInfo{ visible_buffer_, 0, visible_region_size_ };
+    buffer_infos[2] = vk::DescriptorBufferInfo{ indirect_buffer_, 0, indirect_region_size_ };
+    buffer_infos[3] = vk::DescriptorBufferInfo{ culling_buffer_, 0, sizeof(SceneCullingData) };
+
+    std::array<vk::WriteDescriptorSet, 6> descriptor_writes{};
+    for (uint32_t i = 0; i < 2; i++) {
+        descriptor_writes[i].dstSet = descriptor_set_;
+        descriptor_writes[i].dstBinding = i;
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pBufferInfo = &buffer_infos[i];
+    }
+
+    for (uint32_t i = 0; i < 4; i++) {
+        vk::WriteDescriptorSet& write = descriptor_writes[2 + i];
+        write.dstSet = culling_descriptor_set_;
+        write.dstBinding = i;
+        write.dstArrayElement = 0;
+        write.descriptorType = i == 3 ? vk::DescriptorType::eUniformBufferDynamic : vk::DescriptorType::eStorageBufferDynamic;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &buffer_infos[i];
+    }
+
+    context_->getDevice().updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+}
+
+void Scene::rebuildBatches() {
+    // Counting sort of objects by mesh: each mesh becomes one contiguous
+    // instance range, with one indirect command per LOD.
+    std::vector<uint32_t> mesh_counts(meshes_.size(), 0);
+    for (uint32_t mesh_id : object_meshes_) {
+        mesh_counts[mesh_id]++;
+    }
+
+    batches_.clear();
+    std::vector<uint32_t> mesh_cursors(meshes_.size(), 0);
+    uint32_t first_instance = 0;
+    command_count_ = 0;
+    for (uint32_t mesh_id = 0; mesh_id < meshes_.size(); mesh_id++) {
+        mesh_cursors[mesh_id] = first_instance;
+        if (mesh_counts[mesh_id] == 0) continue;
+
+        uint32_t lod_count = meshes_[mesh_id]->getLodCount();
+        batches_.push_back({ mesh_id, first_instance, mesh_counts[mesh_id], command_count_, lod_count });
+        first_instance += mesh_counts[mesh_id];
+        command_count_ += lod_count;
+    }
+
+    draw_order_.resize(objects_.size());
+    for (uint32_t object_id = 0; object_id < objects_.size(); object_id++) {
+        draw_order_[mesh_cursors[object_meshes_[object_id]]++] = object_id;
+    }
+
+    batches_dirty_ = false;
+    revision_++;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "mesh.h"
+#include "uniform_buffer.h"
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+class VulkanContext;
+class DepthPyramid;
+
+// Inputs of the culling pass, one uniform region per frame in flight.
+struct SceneCullingData {
+    alignas(16) glm::mat4 occlusion_view;       // camera the depth pyramid was built with
+    alignas(16) glm::mat4 occlusion_projection;
+    alignas(16) glm::vec4 frustum_planes[6];    // current camera, world space
+    alignas(16) glm::vec4 pyramid_params;       // width, height, mip levels, near plane
+    alignas(16) glm::vec4 camera_position;      // current camera, world space
+    alignas(16) glm::vec4 lod_params;           // x = pixels per unit radius at unit distance, y = error threshold
+    alignas(16) glm::uvec4 counts;              // x = object count, y = occlusion enabled
+};
+
+// Indirect command of one mesh LOD. The culling pass reads the LOD's error to
+// pick a level per object, so it travels with the command; drawing only reads
+// the leading VkDrawIndexedIndirectCommand.
+struct SceneDrawCommand {
+    vk::DrawIndexedIndirectCommand command;
+    float lod_error;
+    uint32_t padding[2];
+};
+
+// Flat container of meshes and the objects instancing them. Object transforms
+// live in a storage buffer (set 1, binding 0) with one region per frame in
+// flight; objects are grouped by mesh so each mesh is drawn with a single
+// instanced vkCmdDrawIndexedIndirect, whatever the number of objects using it.
+//
+// Which instances are drawn is decided on the GPU: recordCulling() tests each
+// object's bounding sphere against the camera frustum and the previous
+// frame's depth pyramid, picks the coarsest mesh LOD whose error projects
+// below the threshold, and appends the survivors to that LOD's instance range
+// of the visible list (set 1, binding 1), bumping the instanceCount of its
+// indirect command. Each mesh thus has one indirect command per LOD.
+class Scene {
+public:
+    Scene(std::shared_ptr<VulkanContext> context);
+    ~Scene();
+
+    bool initialize(uint32_t object_capacity = 1024, uint32_t mesh_capacity = 64);
+    void cleanup();
+
+    uint32_t addMesh(std::unique_ptr<Mesh> mesh);
+    uint32_t addObject(uint32_t mesh_id, const glm::mat4& transform);
+    void setTransform(uint32_t object_id, const glm::mat4& transform);
+    void clearObjects();
+
+    // Camera of the coming frame; `projection` is the one used for rendering.
+    void setCamera(const glm::mat4& view, const glm::mat4& projection, float near_plane, uint32_t viewport_height);
+    // Largest screen-space error, in pixels, a LOD may show.
+    void setLodErrorThreshold(float pixels) { lod_error_threshold_ = pixels; }
+    // Source of occlusion culling; call again whenever the pyramid is recreated.
+    // Frames in flight keep the culling descriptor set they were recorded with:
+    // a replacement binds a new set and retires the old one.
+    bool setDepthPyramid(const DepthPyramid& depth_pyramid);
+
+    bool update(uint32_t frame_index);
+    // Must be recorded outside a render pass, after update() and before draw().
+    // The caller orders its compute writes to the visible and indirect buffers
+    // before the draws, which read them in the vertex and draw-indirect stages.
+    void recordCulling(vk::CommandBuffer command_buffer, uint32_t frame_index);
+    void draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t frame_index) const;
+    // Draws batches [first_batch, first_batch + batch_count) only, so several
+    // threads can record disjoint ranges. Only reads the scene.
+    void draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, uint32_t frame_index,
+        uint32_t first_batch, uint32_t batch_count) const;
+
+    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
+
+    size_t getMeshCount() const { return meshes_.size(); }
+    size_t getObjectCount() const { return objects_.size(); }
+    size_t getDrawCount() const { return command_count_; }
+    uint32_t getBatchCount() const { return static_cast<uint32_t>(batches_.size()); }
+
+    // Both are recreated when the scene grows.
+    vk::Buffer getVisibleBuffer() const { return visible_buffer_; }
+    vk::Buffer getIndirectBuffer() const { return indirect_buffer_; }
+
+private:
+    struct DrawBatch {
+        uint32_t mesh_id;
+        uint32_t first_instance;
+        uint32_t instance_count;
+        uint32_t first_command;
+        uint32_t lod_count;
+    };
+
+    bool createDescriptorSetLayouts();
+    bool createDescriptorPool();
+    bool replaceCullingDescriptorSet();
+    bool createCullingPipeline();
+    bool createBuffers(uint32_t object_capacity, uint32_t command_capacity);
+    bool growBuffers(uint32_t object_capacity, uint32_t command_capacity);
+    void destroyBuffers();
+    void updateDescriptorSets();
+    void rebuildBatches();
+    void updateBounds(uint32_t object_id);
+
+    std::shared_ptr<VulkanContext> context_;
+
+    std::vector<std::unique_ptr<Mesh>> meshes_;
+    std::vector<ObjectData> objects_;
+    std::vector<uint32_t> object_meshes_;
+    std::vector<uint32_t> draw_order_; // instance index -> object id
+    std::vector<DrawBatch> batches_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorSetLayout culling_descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    vk::DescriptorSet descriptor_set_;
+    vk::DescriptorSet culling_descriptor_set_;
+
+    vk::PipelineLayout culling_pipeline_layout_;
+    vk::Pipeline culling_pipeline_;
+
+    vk::Buffer object_buffer_;
+    GpuAllocation object_buffer_allocation_;
+    vk::Buffer visible_buffer_;
+    GpuAllocation visible_buffer_allocation_;
+    vk::Buffer indirect_buffer_;
+    GpuAllocation indirect_buffer_allocation_;
+    vk::Buffer culling_buffer_;
+    GpuAllocation culling_buffer_allocation_;
+
+    uint32_t frame_count_;
+    uint32_t object_capacity_;
+    uint32_t command_capacity_;
+    uint32_t command_count_;
+    vk::DeviceSize object_region_size_;
+    vk::DeviceSize visible_region_size_;
+    vk::DeviceSize indirect_region_size_;
+    vk::DeviceSize culling_region_size_;
+
+    glm::mat4 view_;
+    glm::mat4 projection_;
+    glm::mat4 occlusion_view_;
+    glm::mat4 occlusion_projection_;
+    float near_plane_;
+    float lod_scale_;
+    float lod_error_threshold_;
+    bool occlusion_ready_; // occlusion_view_ holds the camera of a frame already rendered
+    vk::Extent2D pyramid_extent_;
+    uint32_t pyramid_mip_levels_;
+
+    bool batches_dirty_;
+    uint64_t revision_;
+    std::vector<uint64_t> region_revisions_; // revision last written to each frame region
+};
@@ -0,0 +1,84 @@
+#include "secondary_command_pools.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+
+SecondaryCommandPools::SecondaryCommandPools(std::shared_ptr<VulkanContext> context)
+    : context_(context), slot_count_(0), current_frame_(0) {
+}
+
+SecondaryCommandPools::~SecondaryCommandPools() {
+    cleanup();
+}
+
+bool SecondaryCommandPools::initialize(uint32_t slot_count) {
+    auto device = context_->getDevice();
+
+    // Buffers are recorded once per frame and the pool is reset as a whole.
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    pool_info.queueFamilyIndex = context_->getQueueFamilyIndices().graphics_family.value();
+
+    slot_count_ = slot_count;
+    frames_.resize(VulkanContext::MAX_FRAMES_IN_FLIGHT);
+
+    try {
+        for (auto& slots : frames_) {
+            slots.resize(slot_count_);
+            for (Slot& slot : slots) {
+                slot.pool = device.createCommandPool(pool_info);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create secondary command pools: {}", e.what());
+        return false;
+    }
+
+    LOGI("Secondary command pools created ({} slots per frame)", slot_count_);
+    return true;
+}
+
+void SecondaryCommandPools::cleanup() {
+    if (!context_) return;
+
+    auto device = context_->getDevice();
+    for (auto& slots : frames_) {
+        for (Slot& slot : slots) {
+            // Destroying the pool frees its command buffers.
+            if (slot.pool) device.destroyCommandPool(slot.pool);
+        }
+    }
+    frames_.clear();
+}
+
+void SecondaryCommandPools::beginFrame(uint32_t frame_index) {
+    current_frame_ = frame_index % static_cast<uint32_t>(frames_.size());
+
+    auto device = context_->getDevice();
+    for (Slot& slot : frames_[current_frame_]) {
+        device.resetCommandPool(slot.pool, vk::CommandPoolResetFlags{});
+        slot.used = 0;
+    }
+}
+
+vk::CommandBuffer SecondaryCommandPools::begin(uint32_t slot_index, const vk::CommandBufferInheritanceInfo& inheritance) {
+    Slot& slot = frames_[current_frame_][slot_index];
+
+    if (slot.used == slot.command_buffers.size()) {
+        vk::CommandBufferAllocateInfo alloc_info{};
+        alloc_info.commandPool = slot.pool;
+        alloc_info.level = vk::CommandBufferLevel::eSecondary;
+        alloc_info.commandBufferCount = 1;
+        slot.command_buffers.push_back(context_->getDevice().allocateCommandBuffers(alloc_info)[0]);
+    }
+
+    vk::CommandBuffer command_buffer = slot.command_buffers[slot.used++];
+
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue |
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    begin_info.pInheritanceInfo = &inheritance;
+    command_buffer.begin(begin_info);
+
+    return command_buffer;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+class VulkanContext;
+
+// Command pools for recording secondary command buffers on several threads.
+//
+// Every frame in flight owns one pool per recording slot. A slot is only ever
+// used by one thread at a time, so recording needs no locking as long as
+// callers hand each concurrent task its own slot. beginFrame() resets every
+// pool of a frame once its fence has been waited on; command buffers are kept
+// and reused from frame to frame.
+class SecondaryCommandPools {
+public:
+    SecondaryCommandPools(std::shared_ptr<VulkanContext> context);
+    ~SecondaryCommandPools();
+
+    bool initialize(uint32_t slot_count);
+    void cleanup();
+
+    void beginFrame(uint32_t frame_index);
+
+    // Returns a secondary command buffer of `slot`, already begun to continue
+    // the render pass described by `inheritance`. The caller ends it.
+    vk::CommandBuffer begin(uint32_t slot, const vk::CommandBufferInheritanceInfo& inheritance);
+
+    uint32_t getSlotCount() const { return slot_count_; }
+
+private:
+    struct Slot {
+        vk::CommandPool pool;
+        std::vector<vk::CommandBuffer> command_buffers;
+        uint32_t used = 0;
+    };
+
+    std::shared_ptr<VulkanContext> context_;
+    std::vector<std::vector<Slot>> frames_; // [frame][slot]
+    uint32_t slot_count_;
+    uint32_t current_frame_;
+};
@@ -1,126 +1,215 @@
-#include "shader.h"
-#include "vulkan_context.h"
-#include "utils/logger.h"
-#include "glsl_compiler.h"
-#include <fstream>
-#include <sstream>
-
-Shader::Shader(std::shared_ptr<VulkanContext> context) : context_(context) {
-}
-
-Shader::~Shader() {
-    cleanup();
-}
-
-ShaderStage getShaderType(const std::string& file_name) {
-
-    std::string file_type;
-
-    size_t pos = file_name.find_last_of('.');
-
-    if (pos != std::string::npos && pos != 0) {
-        file_type = file_name.substr(pos + 1);
-    }
-    else {
-        LOGE("Wrong shader file name!");
-    }
-
-    static const std::unordered_map<const char*, ShaderStage> shader_stage_map{
-        {"vert", ShaderStage::VERTEX},
-        {"frag", ShaderStage::FRAGMENT},
-        {"geom", ShaderStage::GEOMETRY},
-    };
-
-    return shader_stage_map.find(file_type.c_str())->second;
-}
-
-bool Shader::loadFromFile(const std::string& shader_path) {
-    auto shader_spirv = compileGLSL(readFile(shader_path), getShaderType(shader_path));
-
-    if (shader_spirv.empty()) {
-        LOGE("Failed to read shader files");
-        return false;
-    }
-
-    return createShaderModule(shader_spirv, vertex_shader_);
-}
-
-bool Shader::loadFromSource(const std::string& vertex_source, const std::string& fragment_source) {
-    auto vertex_spirv = compileGLSL(vertex_source, ShaderStage::VERTEX);
-    auto fragment_spirv = compileGLSL(fragment_source, ShaderStage::FRAGMENT);
-
-    if (vertex_spirv.empty() || fragment_spirv.empty()) {
-        LOGE("Failed to compile shaders");
-        return false;
-    }
-
-    std::vector<char> vertex_code(vertex_spirv.size() * sizeof(uint32_t));
-    std::vector<char> fragment_code(fragment_spirv.size() * sizeof(uint32_t));
-
-    memcpy(vertex_code.data(), vertex_spirv.data(), vertex_code.size());
-    memcpy(fragment_code.data(), fragment_spirv.data(), fragment_code.size());
-
-    return createShaderModule(vertex_spirv, vertex_shader_) &&
-           createShaderModule(fragment_spirv, fragment_shader_);
-}
-
-void Shader::cleanup() {
-    auto device = context_->getDevice();
-    
-    if (vertex_shader_) {
-        device.destroyShaderModule(vertex_shader_);
-        vertex_shader_ = nullptr;
-    }
-    
-    if (fragment_shader_) {
-        device.destroyShaderModule(fragment_shader_);
-        fragment_shader_ = nullptr;
-    }
-}
-
-bool Shader::createShaderModule(const std::vector<uint32_t>& code, vk::ShaderModule& shader_module) {
-    vk::ShaderModuleCreateInfo create_info{};
-    create_info.codeSize = code.size() * sizeof(uint32_t);
-    create_info.pCode = code.data();
-
-    try {
-        shader_module = context_->getDevice().createShaderModule(create_info);
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("Failed to create shader module: {}", e.what());
-        return false;
-    }
-}
-
-std::string Shader::readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        LOGE("Failed to open file: {}", filename);
-        return {};
-    }
-
-    file.seekg(0, std::ios::end);
-    const size_t size = static_cast<size_t>(file.tellg());
-    file.seekg(0, std::ios::beg);
-
-    if (size == 0) return {};
-
-    std::string content(size, '\0');
-    file.read(content.data(), static_cast<std::streamsize>(size));
-
-    return content;
-}
-
-std::vector<uint32_t> Shader::compileGLSL(const std::string& source, const ShaderStage& stage) {
-    ShadercCompiler compiler;
-    compiler.setOptimizationLevel(true);
-    return compiler.compileFromSource(source, "", stage);
-}
-
-std::string Shader::getDefaultVertexShader() {
-    return readFile(SHADER_DIR "default.vert");
-}
-
-std::string Shader::getDefaultFragmentShader() {
-    return readFile(SHADER_DIR "default.frag");
-}
+#include "shader.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+#include "glsl_compiler.h"
+#include "spirv_cache.h"
+#include <fstream>
+#include <sstream>
+
+Shader::Shader(std::shared_ptr<VulkanContext> context) : context_(context), precompiled_enabled_(true) {
+}
+
+Shader::~Shader() {
+    cleanup();
+}
+
+ShaderStage getShaderType(const std::string& file_name) {
+
+    std::string file_type;
+
+    size_t pos = file_name.find_last_of('.');
+
+    if (pos != std::string::npos && pos != 0) {
+        file_type = file_name.substr(pos + 1);
+    }
+    else {
+        LOGE("Wrong shader file name!");
+    }
+
+    static const std::unordered_map<std::string, ShaderStage> shader_stage_map{
+        {"vert", ShaderStage::VERTEX},
+        {"frag", ShaderStage::FRAGMENT},
+        {"geom", ShaderStage::GEOMETRY},
+        {"comp", ShaderStage::COMPUTE},
+    };
+
+    auto it = shader_stage_map.find(file_type);
+    if (it == shader_stage_map.end()) {
+        LOGE("Unknown shader stage for file: {}", file_name);
+        return ShaderStage::VERTEX;
+    }
+    return it->second;
+}
+
+void Shader::addDefine(const std::string& name, const std::string& value) {
+    defines_.emplace_back(name, value);
+}
+
+bool Shader::loadFromFile(const std::string& shader_path) {
+    auto shader_spirv = loadStage(shader_path, getShaderType(shader_path));
+
+    if (shader_spirv.empty()) {
+        LOGE("Failed to read shader files");
+        return false;
+    }
+
+    return createShaderModule(shader_spirv, vertex_shader_);
+}
+
+bool Shader::loadFromSource(const std::string& vertex_source, const std::string& fragment_source) {
+    auto vertex_spirv = compileGLSL(vertex_source, ShaderStage::VERTEX);
+    auto fragment_spirv = compileGLSL(fragment_source, ShaderStage::FRAGMENT);
+
+    if (vertex_spirv.empty() || fragment_spirv.empty()) {
+        LOGE("Failed to compile shaders");
+        return false;
+    }
+
+    std::vector<char> vertex_code(vertex_spirv.size() * sizeof(uint32_t));
+    std::vector<char> fragment_code(fragment_spirv.size() * sizeof(uint32_t));
+
+    memcpy(vertex_code.data(), vertex_spirv.data(), vertex_code.size());
+    memcpy(fragment_code.data(), fragment_spirv.data(), fragment_code.size());
+
+    return createShaderModule(vertex_spirv, vertex_shader_) &&
+           createShaderModule(fragment_spirv, fragment_shader_);
+}
+
+bool Shader::loadComputeFromFile(const std::string& compute_path) {
+    auto compute_spirv = loadStage(compute_path, ShaderStage::COMPUTE);
+
+    if (compute_spirv.empty()) {
+        LOGE("Failed to load compute shader: {}", compute_path);
+        return false;
+    }
+
+    return createShaderModule(compute_spirv, compute_shader_);
+}
+
+bool Shader::loadFromFiles(const std::string& vertex_path, const std::string& fragment_path) {
+    auto vertex_spirv = loadStage(vertex_path, ShaderStage::VERTEX);
+    auto fragment_spirv = loadStage(fragment_path, ShaderStage::FRAGMENT);
+
+    if (vertex_spirv.empty() || fragment_spirv.empty()) {
+        LOGE("Failed to load shaders: {}, {}", vertex_path, fragment_path);
+        return false;
+    }
+
+    return createShaderModule(vertex_spirv, vertex_shader_) &&
+           createShaderModule(fragment_spirv, fragment_shader_);
+}
+
+void Shader::cleanup() {
+    auto device = context_->getDevice();
+    
+    if (vertex_shader_) {
+        device.destroyShaderModule(vertex_shader_);
+        vertex_shader_ = nullptr;
+    }
+    
+    if (fragment_shader_) {
+        device.destroyShaderModule(fragment_shader_);
+        fragment_shader_ = nullptr;
+    }
+
+    if (compute_shader_) {
+        device.destroyShaderModule(compute_shader_);
+        compute_shader_ = nullptr;
+    }
+}
+
+bool Shader::createShaderModule(const std::vector<uint32_t>& code, vk::ShaderModule& shader_module) {
+    vk::ShaderModuleCreateInfo create_info{};
+    create_info.codeSize = code.size() * sizeof(uint32_t);
+    create_info.pCode = code.data();
+
+    try {
+        shader_module = context_->getDevice().createShaderModule(create_info);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create shader module: {}", e.what());
+        return false;
+    }
+}
+
+std::string Shader::readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        LOGE("Failed to open file: {}", filename);
+        return {};
+    }
+
+    file.seekg(0, std::ios::end);
+    const size_t size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    if (size == 0) return {};
+
+    std::string content(size, '\0');
+    file.read(content.data(), static_cast<std::streamsize>(size));
+
+    return content;
+}
+
+std::vector<uint32_t> Shader::compileGLSL(const std::string& source, const ShaderStage& stage) {
+    if (source.empty()) return {};
+
+    ShadercCompiler compiler;
+    compiler.setOptimizationLevel(true);
+    for (const auto& [name, value] : defines_) {
+        compiler.addMacroDefinition(name, value);
+    }
+
+    try {
+        // Preprocessing is cheap next to an optimized compile, and keying on
+        // its output ignores comment and whitespace-only edits.
+        std::string preprocessed = compiler.preprocessSource(source, "", stage);
+        uint64_t key = SpirvCache::computeKey(preprocessed, static_cast<uint32_t>(stage),
+            ShadercCompiler::getCompilerVersion(), compiler.getOptionsKey());
+
+        std::vector<uint32_t> spirv;
+        if (SpirvCache::load(key, spirv)) {
+            return spirv;
+        }
+
+        spirv = compiler.compileFromSource(source, "", stage);
+        if (!SpirvCache::store(key, spirv)) {
+            LOGW("Compiled shader not cached");
+        }
+        return spirv;
+    }
+    catch (const std::exception& e) {
+        LOGE("{}", e.what());
+        return {};
+    }
+}
+
+std::vector<uint32_t> Shader::loadStage(const std::string& shader_path, const ShaderStage& stage) {
+#ifdef PRECOMPILED_SHADER_DIR
+    if (!defines_.empty() || !precompiled_enabled_) {
+        return compileGLSL(readFile(shader_path), stage);
+    }
+
+    std::string spirv_path = shader_path + ".spv";
+    const std::string shader_dir = SHADER_DIR;
+    if (shader_path.compare(0, shader_dir.size(), shader_dir) == 0) {
+        spirv_path = PRECOMPILED_SHADER_DIR + shader_path.substr(shader_dir.size()) + ".spv";
+    }
+
+    std::vector<uint32_t> spirv;
+    if (SpirvCache::readSpirvFile(spirv_path, spirv)) {
+        return spirv;
+    }
+    LOGW("Precompiled shader not found: {}, compiling at runtime", spirv_path);
+#endif
+
+    return compileGLSL(readFile(shader_path), stage);
+}
+
+std::string Shader::getDefaultVertexShader() {
+    return readFile(SHADER_DIR "default.vert");
+}
+
+std::string Shader::getDefaultFragmentShader() {
+    return readFile(SHADER_DIR "default.frag");
+}
@@ -1,34 +1,50 @@
-#pragma once
-
-#include <vulkan/vulkan.hpp>
-#include <vector>
-#include <string>
-#include <memory>
-
-class VulkanContext;
-enum class ShaderStage;
-
-class Shader {
-public:
-    Shader(std::shared_ptr<VulkanContext> context);
-    ~Shader();
-
-    static std::string readFile(const std::string& filename);
-    bool loadFromFile(const std::string& shader_path);
-    bool loadFromSource(const std::string& vertex_source, const std::string& fragment_source);
-    void cleanup();
-
-    vk::ShaderModule getVertexShader() const { return vertex_shader_; }
-    vk::ShaderModule getFragmentShader() const { return fragment_shader_; }
-    
-    std::string getDefaultVertexShader();
-    std::string getDefaultFragmentShader();
-
-private:
-    bool createShaderModule(const std::vector<uint32_t>& code, vk::ShaderModule& shader_module);
-    std::vector<uint32_t> compileGLSL(const std::string& source, const ShaderStage& stage);
-
-    std::shared_ptr<VulkanContext> context_;
-    vk::ShaderModule vertex_shader_;
-    vk::ShaderModule fragment_shader_;
-};
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <string>
+#include <utility>
+#include <memory>
+
+class VulkanContext;
+enum class ShaderStage;
+
+class Shader {
+public:
+    Shader(std::shared_ptr<VulkanContext> context);
+    ~Shader();
+
+    static std::string readFile(const std::string& filename);
+    // Preprocessor macro for every later load. Variants with defines are
+    // compiled at runtime, since PRECOMPILE_SHADERS builds each file once.
+    void addDefine(const std::string& name, const std::string& value = "");
+    // Off always compiles the GLSL, for reloads of edited sources that the
+    // build-time SPIR-V does not reflect.
+    void setPrecompiledEnabled(bool enabled) { precompiled_enabled_ = enabled; }
+    bool loadFromFile(const std::string& shader_path);
+    bool loadFromSource(const std::string& vertex_source, const std::string& fragment_source);
+    // Prefers the build-time SPIR-V (PRECOMPILE_SHADERS) and falls back to
+    // compiling the GLSL through the SPIR-V cache.
+    bool loadFromFiles(const std::string& vertex_path, const std::string& fragment_path);
+    bool loadComputeFromFile(const std::string& compute_path);
+    void cleanup();
+
+    vk::ShaderModule getVertexShader() const { return vertex_shader_; }
+    vk::ShaderModule getFragmentShader() const { return fragment_shader_; }
+    vk::ShaderModule getComputeShader() const { return compute_shader_; }
+    
+    std::string getDefaultVertexShader();
+    std::string getDefaultFragmentShader();
+
+private:
+    bool createShaderModule(const std::vector<uint32_t>& code, vk::ShaderModule& shader_module);
+    std::vector<uint32_t> compileGLSL(const std::string& source, const ShaderStage& stage);
+    std::vector<uint32_t> loadStage(const std::string& shader_path, const ShaderStage& stage);
+
+    std::shared_ptr<VulkanContext> context_;
+    vk::ShaderModule vertex_shader_;
+    vk::ShaderModule fragment_shader_;
+    vk::ShaderModule compute_shader_;
+    std::vector<std::pair<std::string, std::string>> defines_;
+    bool precompiled_enabled_;
+};
@@ -1,598 +1,910 @@
-#include "skybox.h"
-#include "vulkan_context.h"
-#include "utils/logger.h"
-#include <array>
-#include <cmath>
-
-#include "shader.h"
-
-SkyBox::SkyBox(std::shared_ptr<VulkanContext> context)
-    : context_(context), vertex_count_(0),
-    top_color_(0.5f, 0.7f, 1.0f), bottom_color_(0.9f, 0.9f, 0.8f) {
-}
-
-SkyBox::~SkyBox() {
-    cleanup();
-}
-
-bool SkyBox::initialize() {
-    if (!createVertexBuffer()) {
-        LOGE("Failed to create skybox vertex buffer");
-        return false;
-    }
-
-    if (!createDescriptorSetLayout()) {
-        LOGE("Failed to create skybox descriptor set layout");
-        return false;
-    }
-
-    if (!createUniformBuffer()) {
-        LOGE("Failed to create skybox uniform buffer");
-        return false;
-    }
-
-    if (!createDescriptorPool()) {
-        LOGE("Failed to create skybox descriptor pool");
-        return false;
-    }
-
-    LOGI("SkyBox initialized successfully");
-    return true;
-}
-
-void SkyBox::cleanup() {
-    auto device = context_->getDevice();
-
-    if (cubemap_sampler_) device.destroySampler(cubemap_sampler_);
-    if (cubemap_image_view_) device.destroyImageView(cubemap_image_view_);
-    if (cubemap_image_) {
-        device.destroyImage(cubemap_image_);
-        device.freeMemory(cubemap_image_memory_);
-    }
-
-    if (uniform_buffer_) {
-        device.destroyBuffer(uniform_buffer_);
-        device.freeMemory(uniform_buffer_memory_);
-    }
-
-    if (vertex_buffer_) {
-        device.destroyBuffer(vertex_buffer_);
-        device.freeMemory(vertex_buffer_memory_);
-    }
-
-    if (descriptor_pool_) device.destroyDescriptorPool(descriptor_pool_);
-    if (descriptor_set_layout_) device.destroyDescriptorSetLayout(descriptor_set_layout_);
-}
-
-bool SkyBox::createDefaultSkyBox(const glm::vec3& top_color, const glm::vec3& bottom_color, int resolution) {
-    LOGI("Creating default gradient skybox with resolution: {}", resolution);
-    
-    top_color_ = top_color;
-    bottom_color_ = bottom_color;
-
-    if (!createCubemapTexture(resolution, resolution)) {
-        LOGE("Failed to create cubemap from generated data");
-        return false;
-    }
-
-    if (!createDescriptorSets()) {
-        LOGE("Failed to create skybox descriptor sets");
-        return false;
-    }
-
-    LOGI("Default gradient skybox created successfully");
-    return true;
-}
-
-std::vector<unsigned char> SkyBox::generateFaceTexture(int face, int resolution,
-    const glm::vec3& top_color,
-    const glm::vec3& bottom_color) {
-    std::vector<unsigned char> image_data(resolution * resolution * 4);
-
-    for (int y = 0; y < resolution; ++y) {
-        for (int x = 0; x < resolution; ++x) {
-            float u = (x + 0.5f) / resolution;
-            float v = (y + 0.5f) / resolution;
-
-            glm::vec3 direction = uvToDirection(u, v, face);
-            
-            float t = (direction.y + 1.0f) * 0.5f;
-            t = std::clamp(t, 0.0f, 1.0f);
-
-            glm::vec3 color = interpolateColor(bottom_color, top_color, t);
-
-            int index = (y * resolution + x) * 4;
-            image_data[index] = static_cast<unsigned char>(color.r * 255);
-            image_data[index + 1] = static_cast<unsigned char>(color.g * 255);
-            image_data[index + 2] = static_cast<unsigned char>(color.b * 255);
-            image_data[index + 3] = 255;
-        }
-    }
-
-    return image_data;
-}
-
-glm::vec3 SkyBox::uvToDirection(float u, float v, int face) {
-    float x = u * 2.0f - 1.0f;
-    float y = v * 2.0f - 1.0f;
-
-    glm::vec3 direction;
-
-    switch (face) {
-    case 0:
-        direction = glm::vec3(1.0f, -y, -x);
-        break;
-    case 1:
-        direction = glm::vec3(-1.0f, -y, x);
-        break;
-    case 2:
-        direction = glm::vec3(x, 1.0f, y);
-        break;
-    case 3:
-        direction = glm::vec3(x, -1.0f, -y);
-        break;
-    case 4:
-        direction = glm::vec3(x, -y, 1.0f);
-        break;
-    case 5:
-        direction = glm::vec3(-x, -y, -1.0f);
-        break;
-    default:
-        direction = glm::vec3(0.0f, 1.0f, 0.0f);
-        break;
-    }
-
-    return glm::normalize(direction);
-}
-
-glm::vec3 SkyBox::interpolateColor(const glm::vec3& color1, const glm::vec3& color2, float t) {
-    return color1 * (1.0f - t) + color2 * t;
-}
-
-bool SkyBox::createCubemapTexture(int width, int height) {
-    auto device = context_->getDevice();
-    
-    vk::ImageCreateInfo image_info{};
-    image_info.imageType = vk::ImageType::e2D;
-    image_info.extent.width = static_cast<uint32_t>(width);
-    image_info.extent.height = static_cast<uint32_t>(height);
-    image_info.extent.depth = 1;
-    image_info.mipLevels = 1;
-    image_info.arrayLayers = 6;
-    image_info.format = vk::Format::eR8G8B8A8Srgb;
-    image_info.tiling = vk::ImageTiling::eOptimal;
-    image_info.initialLayout = vk::ImageLayout::eUndefined;
-    image_info.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
-    image_info.samples = vk::SampleCountFlagBits::e1;
-    image_info.sharingMode = vk::SharingMode::eExclusive;
-    image_info.flags = vk::ImageCreateFlagBits::eCubeCompatible;
-
-    try {
-        cubemap_image_ = device.createImage(image_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create cubemap image: {}", e.what());
-        return false;
-    }
-    
-    vk::MemoryRequirements mem_requirements = device.getImageMemoryRequirements(cubemap_image_);
-    vk::MemoryAllocateInfo alloc_info{};
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits,
-        vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    try {
-        cubemap_image_memory_ = device.allocateMemory(alloc_info);
-        device.bindImageMemory(cubemap_image_, cubemap_image_memory_, 0);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to allocate cubemap image memory: {}", e.what());
-        return false;
-    }
-    
-    transitionImageLayout(cubemap_image_, vk::Format::eR8G8B8A8Srgb,
-        vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 6);
-    
-    vk::DeviceSize image_size = width * height * 4;
-
-    for (uint32_t i = 0; i < 6; i++) {
-        auto face_data = generateFaceTexture(i, width, top_color_, bottom_color_);
-
-        vk::Buffer staging_buffer;
-        vk::DeviceMemory staging_buffer_memory;
-
-        if (!createBuffer(image_size, vk::BufferUsageFlagBits::eTransferSrc,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-            staging_buffer, staging_buffer_memory)) {
-            return false;
-        }
-
-        void* data = device.mapMemory(staging_buffer_memory, 0, image_size);
-        memcpy(data, face_data.data(), static_cast<size_t>(image_size));
-        device.unmapMemory(staging_buffer_memory);
-
-        copyBufferToImage(staging_buffer, cubemap_image_, static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height), i);
-
-        device.destroyBuffer(staging_buffer);
-        device.freeMemory(staging_buffer_memory);
-    }
-    
-    transitionImageLayout(cubemap_image_, vk::Format::eR8G8B8A8Srgb,
-        vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, 6);
-    
-    vk::ImageViewCreateInfo view_info{};
-    view_info.image = cubemap_image_;
-    view_info.viewType = vk::ImageViewType::eCube;
-    view_info.format = vk::Format::eR8G8B8A8Srgb;
-    view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    view_info.subresourceRange.baseMipLevel = 0;
-    view_info.subresourceRange.levelCount = 1;
-    view_info.subresourceRange.baseArrayLayer = 0;
-    view_info.subresourceRange.layerCount = 6;
-
-    try {
-        cubemap_image_view_ = device.createImageView(view_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create cubemap image view: {}", e.what());
-        return false;
-    }
-    
-    vk::SamplerCreateInfo sampler_info{};
-    sampler_info.magFilter = vk::Filter::eLinear;
-    sampler_info.minFilter = vk::Filter::eLinear;
-    sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
-    sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
-    sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
-    sampler_info.anisotropyEnable = VK_TRUE;
-    sampler_info.maxAnisotropy = 16.0f;
-    sampler_info.borderColor = vk::BorderColor::eIntOpaqueBlack;
-    sampler_info.unnormalizedCoordinates = VK_FALSE;
-    sampler_info.compareEnable = VK_FALSE;
-    sampler_info.compareOp = vk::CompareOp::eAlways;
-    sampler_info.mipmapMode = vk::SamplerMipmapMode::eLinear;
-
-    try {
-        cubemap_sampler_ = device.createSampler(sampler_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create cubemap sampler: {}", e.what());
-        return false;
-    }
-}
-
-bool SkyBox::createVertexBuffer() {
-    std::array<SkyBoxVertex, 36> vertices = { {
-            {{-1.0f, -1.0f,  1.0f}},
-            {{ 1.0f, -1.0f,  1.0f}},
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{-1.0f,  1.0f,  1.0f}},
-            {{-1.0f, -1.0f,  1.0f}},
-            
-            {{-1.0f, -1.0f, -1.0f}},
-            {{-1.0f,  1.0f, -1.0f}},
-            {{ 1.0f,  1.0f, -1.0f}},
-            {{ 1.0f,  1.0f, -1.0f}},
-            {{ 1.0f, -1.0f, -1.0f}},
-            {{-1.0f, -1.0f, -1.0f}},
-            
-            {{-1.0f,  1.0f,  1.0f}},
-            {{-1.0f,  1.0f, -1.0f}},
-            {{-1.0f, -1.0f, -1.0f}},
-            {{-1.0f, -1.0f, -1.0f}},
-            {{-1.0f, -1.0f,  1.0f}},
-            {{-1.0f,  1.0f,  1.0f}},
-            
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{ 1.0f, -1.0f, -1.0f}},
-            {{ 1.0f,  1.0f, -1.0f}},
-            {{ 1.0f, -1.0f, -1.0f}},
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{ 1.0f, -1.0f,  1.0f}},
-            
-            {{-1.0f, -1.0f, -1.0f}},
-            {{ 1.0f, -1.0f, -1.0f}},
-            {{ 1.0f, -1.0f,  1.0f}},
-            {{ 1.0f, -1.0f,  1.0f}},
-            {{-1.0f, -1.0f,  1.0f}},
-            {{-1.0f, -1.0f, -1.0f}},
-            
-            {{-1.0f,  1.0f, -1.0f}},
-            {{-1.0f,  1.0f,  1.0f}},
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{ 1.0f,  1.0f,  1.0f}},
-            {{ 1.0f,  1.0f, -1.0f}},
-            {{-1.0f,  1.0f, -1.0f}}
-        } };
-
-    vertex_count_ = vertices.size();
-    vk::DeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
-
-    vk::Buffer staging_buffer;
-    vk::DeviceMemory staging_buffer_memory;
-
-    if (!createBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-        staging_buffer, staging_buffer_memory)) {
-        return false;
-    }
-
-    auto device = context_->getDevice();
-    void* data = device.mapMemory(staging_buffer_memory, 0, buffer_size);
-    memcpy(data, vertices.data(), static_cast<size_t>(buffer_size));
-    device.unmapMemory(staging_buffer_memory);
-
-    if (!createBuffer(buffer_size,
-        vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        vertex_buffer_, vertex_buffer_memory_)) {
-        device.destroyBuffer(staging_buffer);
-        device.freeMemory(staging_buffer_memory);
-        return false;
-    }
-    
-    vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
-    vk::BufferCopy copy_region{};
-    copy_region.size = buffer_size;
-    command_buffer.copyBuffer(staging_buffer, vertex_buffer_, 1, &copy_region);
-    context_->endSingleTimeCommands(command_buffer);
-
-    device.destroyBuffer(staging_buffer);
-    device.freeMemory(staging_buffer_memory);
-
-    return true;
-}
-
-bool SkyBox::createDescriptorSetLayout() {
-    auto device = context_->getDevice();
-
-    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
-    
-    bindings[0].binding = 0;
-    bindings[0].descriptorCount = 1;
-    bindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-    bindings[0].pImmutableSamplers = nullptr;
-    bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex;
-    
-    bindings[1].binding = 1;
-    bindings[1].descriptorCount = 1;
-    bindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-    bindings[1].pImmutableSamplers = nullptr;
-    bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
-
-    vk::DescriptorSetLayoutCreateInfo layout_info{};
-    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
-    layout_info.pBindings = bindings.data();
-
-    try {
-        descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create skybox descriptor set layout: {}", e.what());
-        return false;
-    }
-}
-
-bool SkyBox::createDescriptorPool() {
-    auto device = context_->getDevice();
-
-    std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
-    pool_sizes[0].type = vk::DescriptorType::eUniformBuffer;
-    pool_sizes[0].descriptorCount = 1;
-    pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-    pool_sizes[1].descriptorCount = 1;
-
-    vk::DescriptorPoolCreateInfo pool_info{};
-    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
-    pool_info.pPoolSizes = pool_sizes.data();
-    pool_info.maxSets = 1;
-
-    try {
-        descriptor_pool_ = device.createDescriptorPool(pool_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create skybox descriptor pool: {}", e.what());
-        return false;
-    }
-}
-
-bool SkyBox::createDescriptorSets() {
-    auto device = context_->getDevice();
-
-    vk::DescriptorSetAllocateInfo alloc_info{};
-    alloc_info.descriptorPool = descriptor_pool_;
-    alloc_info.descriptorSetCount = 1;
-    alloc_info.pSetLayouts = &descriptor_set_layout_;
-
-    try {
-        auto descriptor_sets = device.allocateDescriptorSets(alloc_info);
-        descriptor_set_ = descriptor_sets[0];
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to allocate skybox descriptor sets: {}", e.what());
-        return false;
-    }
-
-    std::array<vk::WriteDescriptorSet, 2> descriptor_writes{};
-    
-    vk::DescriptorBufferInfo buffer_info{};
-    buffer_info.buffer = uniform_buffer_;
-    buffer_info.offset = 0;
-    buffer_info.range = sizeof(SkyBoxUBO);
-
-    descriptor_writes[0].dstSet = descriptor_set_;
-    descriptor_writes[0].dstBinding = 0;
-    descriptor_writes[0].dstArrayElement = 0;
-    descriptor_writes[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-    descriptor_writes[0].descriptorCount = 1;
-    descriptor_writes[0].pBufferInfo = &buffer_info;
-    
-    vk::DescriptorImageInfo image_info{};
-    image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-    image_info.imageView = cubemap_image_view_;
-    image_info.sampler = cubemap_sampler_;
-
-    descriptor_writes[1].dstSet = descriptor_set_;
-    descriptor_writes[1].dstBinding = 1;
-    descriptor_writes[1].dstArrayElement = 0;
-    descriptor_writes[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-    descriptor_writes[1].descriptorCount = 1;
-    descriptor_writes[1].pImageInfo = &image_info;
-
-    device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
-        descriptor_writes.data(), 0, nullptr);
-
-    return true;
-}
-
-bool SkyBox::createUniformBuffer() {
-    vk::DeviceSize buffer_size = sizeof(SkyBoxUBO);
-
-    return createBuffer(buffer_size, vk::BufferUsageFlagBits::eUniformBuffer,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-        uniform_buffer_, uniform_buffer_memory_);
-}
-
-void SkyBox::updateUniforms(const SkyBoxUBO& ubo) {
-    auto device = context_->getDevice();
-    void* data = device.mapMemory(uniform_buffer_memory_, 0, sizeof(SkyBoxUBO));
-    memcpy(data, &ubo, sizeof(SkyBoxUBO));
-    device.unmapMemory(uniform_buffer_memory_);
-}
-
-void SkyBox::draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout) {
-    vk::Buffer vertex_buffers[] = { vertex_buffer_ };
-    vk::DeviceSize offsets[] = { 0 };
-
-    command_buffer.bindVertexBuffers(0, 1, vertex_buffers, offsets);
-    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-        pipeline_layout, 0, 1, &descriptor_set_, 0, nullptr);
-    command_buffer.draw(vertex_count_, 1, 0, 0);
-}
-
-bool SkyBox::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-    vk::MemoryPropertyFlags properties,
-    vk::Buffer& buffer, vk::DeviceMemory& buffer_memory) {
-    auto device = context_->getDevice();
-
-    vk::BufferCreateInfo buffer_info{};
-    buffer_info.size = size;
-    buffer_info.usage = usage;
-    buffer_info.sharingMode = vk::SharingMode::eExclusive;
-
-    try {
-        buffer = device.createBuffer(buffer_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create buffer: {}", e.what());
-        return false;
-    }
-
-    vk::MemoryRequirements mem_requirements = device.getBufferMemoryRequirements(buffer);
-
-    vk::MemoryAllocateInfo alloc_info{};
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, properties);
-
-    try {
-        buffer_memory = device.allocateMemory(alloc_info);
-        device.bindBufferMemory(buffer, buffer_memory, 0);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to allocate buffer memory: {}", e.what());
-        device.destroyBuffer(buffer);
-        return false;
-    }
-
-    return true;
-}
-
-uint32_t SkyBox::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties mem_properties = context_->getPhysicalDevice().getMemoryProperties();
-
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((type_filter & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("Failed to find suitable memory type!");
-}
-
-void SkyBox::transitionImageLayout(vk::Image image, vk::Format format,
-    vk::ImageLayout old_layout, vk::ImageLayout new_layout,
-    uint32_t layer_count) {
-    vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
-
-    vk::ImageMemoryBarrier barrier{};
-    barrier.oldLayout = old_layout;
-    barrier.newLayout = new_layout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = layer_count;
-
-    vk::PipelineStageFlags source_stage;
-    vk::PipelineStageFlags destination_stage;
-
-    if (old_layout == vk::ImageLayout::eUndefined && new_layout == vk::ImageLayout::eTransferDstOptimal) {
-        barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-        source_stage = vk::PipelineStageFlagBits::eTopOfPipe;
-        destination_stage = vk::PipelineStageFlagBits::eTransfer;
-    }
-    else if (old_layout == vk::ImageLayout::eTransferDstOptimal && new_layout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-        source_stage = vk::PipelineStageFlagBits::eTransfer;
-        destination_stage = vk::PipelineStageFlagBits::eFragmentShader;
-    }
-    else {
-        throw std::invalid_argument("Unsupported layout transition!");
-    }
-
-    command_buffer.pipelineBarrier(source_stage, destination_stage, vk::DependencyFlags{},
-        0, nullptr, 0, nullptr, 1, &barrier);
-
-    context_->endSingleTimeCommands(command_buffer);
-}
-
-void SkyBox::copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height,
-    uint32_t layer_index) {
-    vk::CommandBuffer command_buffer = context_->beginSingleTimeCommands();
-
-    vk::BufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = layer_index;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = vk::Offset3D{ 0, 0, 0 };
-    region.imageExtent = vk::Extent3D{ width, height, 1 };
-
-    command_buffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
-
-    context_->endSingleTimeCommands(command_buffer);
-}
-
-std::string SkyBox::getVertexShaderSource() {
-    return Shader::readFile(SHADER_DIR "skybox/skybox.vert");
-}
-
-std::string SkyBox::getFragmentShaderSource() {
-    return Shader::readFile(SHADER_DIR "skybox/skybox.frag");
-}
+#include "skybox.h"
+#include "vulkan_context.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "shader.h"
+
+namespace {
+
+// Matches the push constant block in skybox_gradient.comp.
+struct GradientParams {
+    glm::vec4 top_color;
+    glm::vec4 bottom_color;
+    uint32_t face_size;
+};
+
+constexpr uint32_t GRADIENT_GROUP_SIZE = 8;
+constexpr vk::Format COMPUTE_CUBEMAP_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+}
+
+SkyBox::SkyBox(std::shared_ptr<VulkanContext> context)
+    : context_(context), vertex_count_(0), ubo_offset_(0),
+    top_color_(0.5f, 0.7f, 1.0f), bottom_color_(0.9f, 0.9f, 0.8f),
+    cubemap_layout_(vk::ImageLayout::eUndefined), cubemap_resolution_(0), cubemap_mip_levels_(1),
+    cubemap_format_(vk::Format::eUndefined), mips_dirty_(false), gradient_dirty_(false) {
+}
+
+SkyBox::~SkyBox() {
+    cleanup();
+}
+
+bool SkyBox::initialize() {
+    if (!createVertexBuffer()) {
+        LOGE("Failed to create skybox vertex buffer");
+        return false;
+    }
+
+    if (!createDescriptorSetLayout()) {
+        LOGE("Failed to create skybox descriptor set layout");
+        return false;
+    }
+
+    if (!createDescriptorPool()) {
+        LOGE("Failed to create skybox descriptor pool");
+        return false;
+    }
+
+    LOGI("SkyBox initialized successfully");
+    return true;
+}
+
+void SkyBox::cleanup() {
+    auto device = context_->getDevice();
+    auto& allocator = context_->getAllocator();
+
+    destroyComputeResources();
+    destroyCubemap();
+
+    if (vertex_buffer_) {
+        allocator.destroyBuffer(vertex_buffer_, vertex_buffer_allocation_);
+    }
+
+    if (descriptor_pool_) {
+        device.destroyDescriptorPool(descriptor_pool_);
+        descriptor_pool_ = nullptr;
+    }
+    if (descriptor_set_layout_) {
+        device.destroyDescriptorSetLayout(descriptor_set_layout_);
+        descriptor_set_layout_ = nullptr;
+    }
+}
+
+bool SkyBox::createDefaultSkyBox(const glm::vec3& top_color, const glm::vec3& bottom_color, int resolution) {
+    LOGI("Creating default gradient skybox with resolution: {}", resolution);
+    
+    top_color_ = top_color;
+    bottom_color_ = bottom_color;
+
+    if (resolution <= 0) {
+        LOGE("Invalid skybox resolution: {}", resolution);
+        return false;
+    }
+
+    // A repeated call replaces the previous cubemap.
+    if (cubemap_image_ && !retireResources()) {
+        return false;
+    }
+
+    if (isComputeSupported() && createComputePipeline() &&
+        createCubemapImage(resolution, COMPUTE_CUBEMAP_FORMAT,
+            vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled) &&
+        createCubemapSampler() && createDescriptorSets() && createComputeDescriptorSet()) {
+        gradient_dirty_ = true;
+        LOGI("Default gradient skybox created on the GPU");
+        return true;
+    }
+
+    LOGW("Compute skybox unavailable, generating the cubemap on the CPU");
+    destroyComputeResources();
+    destroyCubemap();
+    context_->getDevice().resetDescriptorPool(descriptor_pool_);
+
+    if (!createFromCubemapData(generateCubemapData(resolution, top_color, bottom_color), resolution)) {
+        return false;
+    }
+
+    LOGI("Default gradient skybox created successfully");
+    return true;
+}
+
+bool SkyBox::setGradientColors(const glm::vec3& top_color, const glm::vec3& bottom_color) {
+    if (!compute_pipeline_) {
+        LOGW("Skybox colors can only be changed on the compute path");
+        return false;
+    }
+
+    top_color_ = top_color;
+    bottom_color_ = bottom_color;
+    gradient_dirty_ = true;
+    return true;
+}
+
+void SkyBox::recordUpdate(vk::CommandBuffer command_buffer) {
+    // Uploaded faces arrive in level 0 as a transfer source.
+    if (mips_dirty_) {
+        recordMipChain(command_buffer, vk::ImageLayout::eTransferSrcOptimal,
+            vk::PipelineStageFlagBits::eTransfer, vk::AccessFlags{});
+        mips_dirty_ = false;
+    }
+
+    if (!gradient_dirty_ || !compute_pipeline_) return;
+
+    vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 6 };
+
+    // Earlier frames may still be sampling the cubemap; the barrier orders the
+    // rewrite after their fragment shaders on this queue.
+    bool first_write = cubemap_layout_ == vk::ImageLayout::eUndefined;
+
+    vk::ImageMemoryBarrier to_general{};
+    to_general.oldLayout = cubemap_layout_;
+    to_general.newLayout = vk::ImageLayout::eGeneral;
+    to_general.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_general.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_general.image = cubemap_image_;
+    to_general.subresourceRange = range;
+    to_general.srcAccessMask = first_write ? vk::AccessFlags{} : vk::AccessFlags(vk::AccessFlagBits::eShaderRead);
+    to_general.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+
+    // Image based lighting bakes sample the cubemap from compute as well.
+    vk::PipelineStageFlags read_stages =
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+
+    command_buffer.pipelineBarrier(
+        first_write ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe) : read_stages,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &to_general);
+
+    GradientParams params{};
+    params.top_color = glm::vec4(top_color_, 1.0f);
+    params.bottom_color = glm::vec4(bottom_color_, 1.0f);
+    params.face_size = static_cast<uint32_t>(cubemap_resolution_);
+
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, compute_pipeline_);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+        compute_pipeline_layout_, 0, 1, &compute_descriptor_set_, 0, nullptr);
+    command_buffer.pushConstants(compute_pipeline_layout_, vk::ShaderStageFlagBits::eCompute,
+        0, sizeof(GradientParams), &params);
+
+    uint32_t group_count = (params.face_size + GRADIENT_GROUP_SIZE - 1) / GRADIENT_GROUP_SIZE;
+    command_buffer.dispatch(group_count, group_count, 6);
+
+    recordMipChain(command_buffer, vk::ImageLayout::eGeneral,
+        vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
+    gradient_dirty_ = false;
+}
+
+void SkyBox::recordMipChain(vk::CommandBuffer command_buffer, vk::ImageLayout base_layout,
+    vk::PipelineStageFlags src_stage, vk::AccessFlags src_access) {
+    vk::PipelineStageFlags read_stages =
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = cubemap_image_;
+    barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 6 };
+
+    if (cubemap_mip_levels_ > 1) {
+        // The lower levels are rewritten whole, so their contents are dropped;
+        // earlier frames may still sample them, hence the read stages.
+        std::array<vk::ImageMemoryBarrier, 2> to_transfer{ barrier, barrier };
+        to_transfer[0].oldLayout = base_layout;
+        to_transfer[0].newLayout = vk::ImageLayout::eTransferSrcOptimal;
+        to_transfer[0].srcAccessMask = src_access;
+        to_transfer[0].dstAccessMask = vk::AccessFlagBits::eTransferRead;
+        to_transfer[1].oldLayout = vk::ImageLayout::eUndefined;
+        to_transfer[1].newLayout = vk::ImageLayout::eTransferDstOptimal;
+        to_transfer[1].dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        to_transfer[1].subresourceRange.baseMipLevel = 1;
+        to_transfer[1].subresourceRange.levelCount = cubemap_mip_levels_ - 1;
+
+        command_buffer.pipelineBarrier(src_stage | read_stages, vk::PipelineStageFlagBits::eTransfer,
+            vk::DependencyFlags{}, nullptr, nullptr, to_transfer);
+
+        int32_t size = cubemap_resolution_;
+        for (uint32_t level = 1; level < cubemap_mip_levels_; level++) {
+            int32_t next_size = std::max(size / 2, 1);
+
+            vk::ImageBlit blit{};
+            blit.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - 1, 0, 6 };
+            blit.srcOffsets[1] = vk::Offset3D{ size, size, 1 };
+            blit.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 6 };
+            blit.dstOffsets[1] = vk::Offset3D{ next_size, next_size, 1 };
+
+            command_buffer.blitImage(cubemap_image_, vk::ImageLayout::eTransferSrcOptimal,
+                cubemap_image_, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+
+            // The level just written is the source of the next blit.
+            vk::ImageMemoryBarrier to_source = barrier;
+            to_source.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+            to_source.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+            to_source.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            to_source.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+            to_source.subresourceRange.baseMipLevel = level;
+
+            command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags{}, nullptr, nullptr, to_source);
+
+            size = next_size;
+        }
+
+        base_layout = vk::ImageLayout::eTransferSrcOptimal;
+        src_stage = vk::PipelineStageFlagBits::eTransfer;
+        src_access = vk::AccessFlagBits::eTransferWrite;
+    }
+
+    vk::ImageMemoryBarrier to_shader_read = barrier;
+    to_shader_read.oldLayout = base_layout;
+    to_shader_read.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    to_shader_read.srcAccessMask = src_access;
+    to_shader_read.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+    to_shader_read.subresourceRange.levelCount = cubemap_mip_levels_;
+
+    command_buffer.pipelineBarrier(src_stage, read_stages,
+        vk::DependencyFlags{}, nullptr, nullptr, to_shader_read);
+
+    cubemap_layout_ = vk::ImageLayout::eShaderReadOnlyOptimal;
+}
+
+bool SkyBox::createFromCubemapData(const std::vector<unsigned char>& cubemap_data, int resolution) {
+    size_t expected_size = static_cast<size_t>(resolution) * resolution * 4 * 6;
+    if (resolution <= 0 || cubemap_data.size() != expected_size) {
+        LOGE("Invalid cubemap data: {} bytes for resolution {}", cubemap_data.size(), resolution);
+        return false;
+    }
+
+    if (!createCubemapTexture(cubemap_data.data(), resolution, resolution)) {
+        LOGE("Failed to create cubemap from generated data");
+        return false;
+    }
+
+    if (!createDescriptorSets()) {
+        LOGE("Failed to create skybox descriptor sets");
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<unsigned char> SkyBox::generateCubemapData(int resolution,
+    const glm::vec3& top_color,
+    const glm::vec3& bottom_color) {
+    size_t face_size = static_cast<size_t>(resolution) * resolution * 4;
+    std::vector<unsigned char> cubemap_data(face_size * 6);
+
+    for (int i = 0; i < 6; i++) {
+        auto face_data = generateFaceTexture(i, resolution, top_color, bottom_color);
+        memcpy(cubemap_data.data() + face_size * i, face_data.data(), face_size);
+    }
+
+    return cubemap_data;
+}
+
+std::vector<unsigned char> SkyBox::generateFaceTexture(int face, int resolution,
+    const glm::vec3& top_color,
+    const glm::vec3& bottom_color) {
+    std::vector<unsigned char> image_data(resolution * resolution * 4);
+
+    for (int y = 0; y < resolution; ++y) {
+        for (int x = 0; x < resolution; ++x) {
+            float u = (x + 0.5f) / resolution;
+            float v = (y + 0.5f) / resolution;
+
+            glm::vec3 direction = uvToDirection(u, v, face);
+            
+            float t = (direction.y + 1.0f) * 0.5f;
+            t = std::clamp(t, 0.0f, 1.0f);
+
+            glm::vec3 color = interpolateColor(bottom_color, top_color, t);
+
+            int index = (y * resolution + x) * 4;
+            image_data[index] = static_cast<unsigned char>(color.r * 255);
+            image_data[index + 1] = static_cast<unsigned char>(color.g * 255);
+            image_data[index + 2] = static_cast<unsigned char>(color.b * 255);
+            image_data[index + 3] = 255;
+        }
+    }
+
+    return image_data;
+}
+
+glm::vec3 SkyBox::uvToDirection(float u, float v, int face) {
+    float x = u * 2.0f - 1.0f;
+    float y = v * 2.0f - 1.0f;
+
+    glm::vec3 direction;
+
+    switch (face) {
+    case 0:
+        direction = glm::vec3(1.0f, -y, -x);
+        break;
+    case 1:
+        direction = glm::vec3(-1.0f, -y, x);
+        break;
+    case 2:
+        direction = glm::vec3(x, 1.0f, y);
+        break;
+    case 3:
+        direction = glm::vec3(x, -1.0f, -y);
+        break;
+    case 4:
+        direction = glm::vec3(x, -y, 1.0f);
+        break;
+    case 5:
+        direction = glm::vec3(-x, -y, -1.0f);
+        break;
+    default:
+        direction = glm::vec3(0.0f, 1.0f, 0.0f);
+        break;
+    }
+
+    return glm::normalize(direction);
+}
+
+glm::vec3 SkyBox::interpolateColor(const glm::vec3& color1, const glm::vec3& color2, float t) {
+    return color1 * (1.0f - t) + color2 * t;
+}
+
+bool SkyBox::createCubemapTexture(const unsigned char* cubemap_data, int width, int height) {
+    if (!createCubemapImage(width, vk::Format::eR8G8B8A8Srgb,
+        vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled)) {
+        return false;
+    }
+    
+    vk::DeviceSize face_size = width * height * 4;
+    std::vector<vk::BufferImageCopy> regions(6);
+
+    for (uint32_t i = 0; i < 6; i++) {
+        regions[i].bufferOffset = face_size * i;
+        regions[i].bufferRowLength = 0;
+        regions[i].bufferImageHeight = 0;
+        regions[i].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        regions[i].imageSubresource.mipLevel = 0;
+        regions[i].imageSubresource.baseArrayLayer = i;
+        regions[i].imageSubresource.layerCount = 1;
+        regions[i].imageOffset = vk::Offset3D{ 0, 0, 0 };
+        regions[i].imageExtent = vk::Extent3D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+    }
+
+    vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 6 };
+
+    // With a mip chain level 0 stays a transfer source until recordUpdate()
+    // has blitted the other levels.
+    bool has_mips = cubemap_mip_levels_ > 1;
+    bool uploaded = has_mips ?
+        context_->getUploadService().uploadImage(cubemap_image_, cubemap_data, face_size * 6,
+            regions, range, vk::ImageLayout::eTransferSrcOptimal,
+            vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead) :
+        context_->getUploadService().uploadImage(cubemap_image_, cubemap_data, face_size * 6,
+            regions, range, vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+    if (!uploaded) {
+        LOGE("Failed to upload cubemap faces");
+        return false;
+    }
+    cubemap_layout_ = has_mips ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+    mips_dirty_ = has_mips;
+
+    return createCubemapSampler();
+}
+
+bool SkyBox::createCubemapImage(int resolution, vk::Format format, vk::ImageUsageFlags usage) {
+    auto device = context_->getDevice();
+    auto& allocator = context_->getAllocator();
+
+    // The image based lighting prefilter reads blurrier levels for the wide
+    // samples of rough lobes, so the cubemap gets a full mip chain when the
+    // format can be blitted.
+    auto features = context_->getPhysicalDevice().getFormatProperties(format).optimalTilingFeatures;
+    bool can_blit = (features & vk::FormatFeatureFlagBits::eBlitSrc) &&
+        (features & vk::FormatFeatureFlagBits::eBlitDst) &&
+        (features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+    uint32_t mip_levels = can_blit ? static_cast<uint32_t>(std::floor(std::log2(resolution))) + 1 : 1;
+    if (mip_levels > 1) {
+        usage |= vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+    }
+    
+    vk::ImageCreateInfo image_info{};
+    image_info.imageType = vk::ImageType::e2D;
+    image_info.extent.width = static_cast<uint32_t>(resolution);
+    image_info.extent.height = static_cast<uint32_t>(resolution);
+    image_info.extent.depth = 1;
+    image_info.mipLevels = mip_levels;
+    image_info.arrayLayers = 6;
+    image_info.format = format;
+    image_info.tiling = vk::ImageTiling::eOptimal;
+    image_info.initialLayout = vk::ImageLayout::eUndefined;
+    image_info.usage = usage;
+    image_info.samples = vk::SampleCountFlagBits::e1;
+    image_info.sharingMode = vk::SharingMode::eExclusive;
+    image_info.flags = vk::ImageCreateFlagBits::eCubeCompatible;
+
+    if (!allocator.createImage(image_info, vk::MemoryPropertyFlagBits::eDeviceLocal,
+        cubemap_image_, cubemap_image_allocation_)) {
+        LOGE("Failed to create cubemap image");
+        return false;
+    }
+    cubemap_layout_ = vk::ImageLayout::eUndefined;
+    cubemap_resolution_ = resolution;
+    cubemap_mip_levels_ = mip_levels;
+    cubemap_format_ = format;
+    mips_dirty_ = false;
+    
+    vk::ImageViewCreateInfo view_info{};
+    view_info.image = cubemap_image_;
+    view_info.viewType = vk::ImageViewType::eCube;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+    view_info.subresourceRange.baseMipLevel = 0;
+    view_info.subresourceRange.levelCount = mip_levels;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 6;
+
+    try {
+        cubemap_image_view_ = device.createImageView(view_info);
+
+        // Compute writes the faces of level 0 as layers of a 2D array; only
+        // the sampled view sees the image as a cube.
+        if (usage & vk::ImageUsageFlagBits::eStorage) {
+            view_info.viewType = vk::ImageViewType::e2DArray;
+            view_info.subresourceRange.levelCount = 1;
+            cubemap_storage_view_ = device.createImageView(view_info);
+        }
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create cubemap image view: {}", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool SkyBox::createCubemapSampler() {
+    vk::SamplerCreateInfo sampler_info{};
+    sampler_info.magFilter = vk::Filter::eLinear;
+    sampler_info.minFilter = vk::Filter::eLinear;
+    sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    sampler_info.anisotropyEnable = VK_TRUE;
+    sampler_info.maxAnisotropy = 16.0f;
+    sampler_info.borderColor = vk::BorderColor::eIntOpaqueBlack;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.compareOp = vk::CompareOp::eAlways;
+    sampler_info.mipmapMode = vk::SamplerMipmapMode::eLinear;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = static_cast<float>(cubemap_mip_levels_);
+
+    try {
+        cubemap_sampler_ = context_->getDevice().createSampler(sampler_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create cubemap sampler: {}", e.what());
+        return false;
+    }
+}
+
+void SkyBox::destroyCubemap() {
+    auto device = context_->getDevice();
+
+    if (cubemap_sampler_) {
+        device.destroySampler(cubemap_sampler_);
+        cubemap_sampler_ = nullptr;
+    }
+    if (cubemap_storage_view_) {
+        device.destroyImageView(cubemap_storage_view_);
+        cubemap_storage_view_ = nullptr;
+    }
+    if (cubemap_image_view_) {
+        device.destroyImageView(cubemap_image_view_);
+        cubemap_image_view_ = nullptr;
+    }
+    if (cubemap_image_) {
+        context_->getAllocator().destroyImage(cubemap_image_, cubemap_image_allocation_);
+        cubemap_image_ = nullptr;
+    }
+    cubemap_layout_ = vk::ImageLayout::eUndefined;
+}
+
+bool SkyBox::retireResources() {
+    vk::Device device = context_->getDevice();
+    GpuAllocator* allocator = &context_->getAllocator();
+
+    // Frames in flight may still sample the cubemap, dispatch the gradient or
+    // bind sets from the pool, so all of it outlives them.
+    vk::Sampler sampler = cubemap_sampler_;
+    vk::ImageView storage_view = cubemap_storage_view_;
+    vk::ImageView image_view = cubemap_image_view_;
+    vk::Image image = cubemap_image_;
+    GpuAllocation image_allocation = cubemap_image_allocation_;
+    vk::Pipeline pipeline = compute_pipeline_;
+    vk::PipelineLayout pipeline_layout = compute_pipeline_layout_;
+    vk::DescriptorSetLayout set_layout = compute_descriptor_set_layout_;
+    vk::DescriptorPool pool = descriptor_pool_;
+
+    context_->retire([device, allocator, sampler, storage_view, image_view, image, image_allocation,
+        pipeline, pipeline_layout, set_layout, pool]() mutable {
+        if (sampler) device.destroySampler(sampler);
+        if (storage_view) device.destroyImageView(storage_view);
+        if (image_view) device.destroyImageView(image_view);
+        if (image) allocator->destroyImage(image, image_allocation);
+        if (pipeline) device.destroyPipeline(pipeline);
+        if (pipeline_layout) device.destroyPipelineLayout(pipeline_layout);
+        if (set_layout) device.destroyDescriptorSetLayout(set_layout);
+        if (pool) device.destroyDescriptorPool(pool);
+    });
+
+    cubemap_sampler_ = nullptr;
+    cubemap_storage_view_ = nullptr;
+    cubemap_image_view_ = nullptr;
+    cubemap_image_ = nullptr;
+    cubemap_image_allocation_ = GpuAllocation{};
+    cubemap_layout_ = vk::ImageLayout::eUndefined;
+    compute_pipeline_ = nullptr;
+    compute_pipeline_layout_ = nullptr;
+    compute_descriptor_set_layout_ = nullptr;
+    compute_descriptor_set_ = nullptr;
+    descriptor_pool_ = nullptr;
+    descriptor_set_ = nullptr;
+    gradient_shader_.reset();
+    gradient_dirty_ = false;
+    mips_dirty_ = false;
+
+    if (!createDescriptorPool()) {
+        LOGE("Failed to recreate skybox descriptor pool");
+        return false;
+    }
+    return true;
+}
+
+bool SkyBox::isComputeSupported() const {
+    auto physical_device = context_->getPhysicalDevice();
+
+    // The dispatch is recorded into the frame's graphics command buffer.
+    uint32_t graphics_family = context_->getQueueFamilyIndices().graphics_family.value();
+    auto queue_families = physical_device.getQueueFamilyProperties();
+    if (!(queue_families[graphics_family].queueFlags & vk::QueueFlagBits::eCompute)) {
+        return false;
+    }
+
+    auto features = physical_device.getFormatProperties(COMPUTE_CUBEMAP_FORMAT).optimalTilingFeatures;
+    return (features & vk::FormatFeatureFlagBits::eStorageImage) &&
+        (features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+}
+
+bool SkyBox::createComputePipeline() {
+    auto device = context_->getDevice();
+
+    gradient_shader_ = std::make_unique<Shader>(context_);
+    if (!gradient_shader_->loadComputeFromFile(getGradientShaderPath())) {
+        LOGE("Failed to load skybox gradient shader");
+        return false;
+    }
+
+    vk::DescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorCount = 1;
+    binding.descriptorType = vk::DescriptorType::eStorageImage;
+    binding.pImmutableSamplers = nullptr;
+    binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+
+    vk::PushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(GradientParams);
+
+    try {
+        compute_descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
+
+        vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pSetLayouts = &compute_descriptor_set_layout_;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+        compute_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox compute pipeline layout: {}", e.what());
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipeline_info.stage.module = gradient_shader_->getComputeShader();
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = compute_pipeline_layout_;
+
+    try {
+        auto result = device.createComputePipeline(context_->getPipelineCache(), pipeline_info);
+        compute_pipeline_ = result.value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox compute pipeline: {}", e.what());
+        return false;
+    }
+}
+
+bool SkyBox::createComputeDescriptorSet() {
+    auto device = context_->getDevice();
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &compute_descriptor_set_layout_;
+
+    try {
+        auto descriptor_sets = device.allocateDescriptorSets(alloc_info);
+        compute_descriptor_set_ = descriptor_sets[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate skybox compute descriptor set: {}", e.what());
+        return false;
+    }
+
+    vk::DescriptorImageInfo image_info{};
+    image_info.imageLayout = vk::ImageLayout::eGeneral;
+    image_info.imageView = cubemap_storage_view_;
+
+    vk::WriteDescriptorSet descriptor_write{};
+    descriptor_write.dstSet = compute_descriptor_set_;
+    descriptor_write.dstBinding = 0;
+    descriptor_write.dstArrayElement = 0;
+    descriptor_write.descriptorType = vk::DescriptorType::eStorageImage;
+    descriptor_write.descriptorCount = 1;
+    descriptor_write.pImageInfo = &image_info;
+
+    device.updateDescriptorSets(1, &descriptor_write, 0, nullptr);
+    return true;
+}
+
+void SkyBox::destroyComputeResources() {
+    auto device = context_->getDevice();
+
+    if (compute_pipeline_) {
+        device.destroyPipeline(compute_pipeline_);
+        compute_pipeline_ = nullptr;
+    }
+    if (compute_pipeline_layout_) {
+        device.destroyPipelineLayout(compute_pipeline_layout_);
+        compute_pipeline_layout_ = nullptr;
+    }
+    if (compute_descriptor_set_layout_) {
+        device.destroyDescriptorSetLayout(compute_descriptor_set_layout_);
+        compute_descriptor_set_layout_ = nullptr;
+    }
+    gradient_shader_.reset();
+    compute_descriptor_set_ = nullptr;
+    gradient_dirty_ = false;
+}
+
+bool SkyBox::createVertexBuffer() {
+    std::array<SkyBoxVertex, 36> vertices = { {
+            {{-1.0f, -1.0f,  1.0f}},
+            {{ 1.0f, -1.0f,  1.0f}},
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{-1.0f,  1.0f,  1.0f}},
+            {{-1.0f, -1.0f,  1.0f}},
+            
+            {{-1.0f, -1.0f, -1.0f}},
+            {{-1.0f,  1.0f, -1.0f}},
+            {{ 1.0f,  1.0f, -1.0f}},
+            {{ 1.0f,  1.0f, -1.0f}},
+            {{ 1.0f, -1.0f, -1.0f}},
+            {{-1.0f, -1.0f, -1.0f}},
+            
+            {{-1.0f,  1.0f,  1.0f}},
+            {{-1.0f,  1.0f, -1.0f}},
+            {{-1.0f, -1.0f, -1.0f}},
+            {{-1.0f, -1.0f, -1.0f}},
+            {{-1.0f, -1.0f,  1.0f}},
+            {{-1.0f,  1.0f,  1.0f}},
+            
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{ 1.0f, -1.0f, -1.0f}},
+            {{ 1.0f,  1.0f, -1.0f}},
+            {{ 1.0f, -1.0f, -1.0f}},
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{ 1.0f, -1.0f,  1.0f}},
+            
+            {{-1.0f, -1.0f, -1.0f}},
+            {{ 1.0f, -1.0f, -1.0f}},
+            {{ 1.0f, -1.0f,  1.0f}},
+            {{ 1.0f, -1.0f,  1.0f}},
+            {{-1.0f, -1.0f,  1.0f}},
+            {{-1.0f, -1.0f, -1.0f}},
+            
+            {{-1.0f,  1.0f, -1.0f}},
+            {{-1.0f,  1.0f,  1.0f}},
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{ 1.0f,  1.0f,  1.0f}},
+            {{ 1.0f,  1.0f, -1.0f}},
+            {{-1.0f,  1.0f, -1.0f}}
+        } };
+
+    vertex_count_ = vertices.size();
+    vk::DeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
+
+    if (!context_->getAllocator().createBuffer(buffer_size,
+        vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        vertex_buffer_, vertex_buffer_allocation_)) {
+        return false;
+    }
+
+    return context_->getUploadService().uploadBuffer(vertex_buffer_, vertices.data(), buffer_size, 0,
+        vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+}
+
+bool SkyBox::createDescriptorSetLayout() {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+    
+    bindings[0].binding = 0;
+    bindings[0].descriptorCount = 1;
+    bindings[0].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+    bindings[0].pImmutableSamplers = nullptr;
+    bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex;
+    
+    bindings[1].binding = 1;
+    bindings[1].descriptorCount = 1;
+    bindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    bindings[1].pImmutableSamplers = nullptr;
+    bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    try {
+        descriptor_set_layout_ = device.createDescriptorSetLayout(layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox descriptor set layout: {}", e.what());
+        return false;
+    }
+}
+
+bool SkyBox::createDescriptorPool() {
+    auto device = context_->getDevice();
+
+    std::array<vk::DescriptorPoolSize, 3> pool_sizes{};
+    pool_sizes[0].type = vk::DescriptorType::eUniformBufferDynamic;
+    pool_sizes[0].descriptorCount = 1;
+    pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
+    pool_sizes[1].descriptorCount = 1;
+    pool_sizes[2].type = vk::DescriptorType::eStorageImage;
+    pool_sizes[2].descriptorCount = 1;
+
+    // The draw set plus the compute set that writes the cubemap.
+    vk::DescriptorPoolCreateInfo pool_info{};
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = 2;
+
+    try {
+        descriptor_pool_ = device.createDescriptorPool(pool_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox descriptor pool: {}", e.what());
+        return false;
+    }
+}
+
+bool SkyBox::createDescriptorSets() {
+    auto device = context_->getDevice();
+
+    vk::DescriptorSetAllocateInfo alloc_info{};
+    alloc_info.descriptorPool = descriptor_pool_;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+    try {
+        auto descriptor_sets = device.allocateDescriptorSets(alloc_info);
+        descriptor_set_ = descriptor_sets[0];
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate skybox descriptor sets: {}", e.what());
+        return false;
+    }
+
+    std::array<vk::WriteDescriptorSet, 2> descriptor_writes{};
+    
+    vk::DescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = context_->getUniformRing().getBuffer();
+    buffer_info.offset = 0;
+    buffer_info.range = sizeof(SkyBoxUBO);
+
+    descriptor_writes[0].dstSet = descriptor_set_;
+    descriptor_writes[0].dstBinding = 0;
+    descriptor_writes[0].dstArrayElement = 0;
+    descriptor_writes[0].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+    descriptor_writes[0].descriptorCount = 1;
+    descriptor_writes[0].pBufferInfo = &buffer_info;
+    
+    vk::DescriptorImageInfo image_info{};
+    image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    image_info.imageView = cubemap_image_view_;
+    image_info.sampler = cubemap_sampler_;
+
+    descriptor_writes[1].dstSet = descriptor_set_;
+    descriptor_writes[1].dstBinding = 1;
+    descriptor_writes[1].dstArrayElement = 0;
+    descriptor_writes[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    descriptor_writes[1].descriptorCount = 1;
+    descriptor_writes[1].pImageInfo = &image_info;
+
+    device.updateDescriptorSets(static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(), 0, nullptr);
+
+    return true;
+}
+
+uint64_t SkyBox::getEnvironmentKey() const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, &top_color_, sizeof(top_color_));
+    hash = hashBytes(hash, &bottom_color_, sizeof(bottom_color_));
+    hash = hashBytes(hash, &cubemap_resolution_, sizeof(cubemap_resolution_));
+    hash = hashBytes(hash, &cubemap_mip_levels_, sizeof(cubemap_mip_levels_));
+    hash = hashBytes(hash, &cubemap_format_, sizeof(cubemap_format_));
+    return hash;
+}
+
+void SkyBox::updateUniforms(const SkyBoxUBO& ubo) {
+    ubo_offset_ = context_->getUniformRing().push(ubo);
+}
+
+void SkyBox::draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout) {
+    vk::Buffer vertex_buffers[] = { vertex_buffer_ };
+    vk::DeviceSize offsets[] = { 0 };
+
+    command_buffer.bindVertexBuffers(0, 1, vertex_buffers, offsets);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+        pipeline_layout, 0, 1, &descriptor_set_, 1, &ubo_offset_);
+    command_buffer.draw(vertex_count_, 1, 0, 0);
+}
+
+std::string SkyBox::getVertexShaderPath() {
+    return SHADER_DIR "skybox/skybox.vert";
+}
+
+std::string SkyBox::getFragmentShaderPath() {
+    return SHADER_DIR "skybox/skybox.frag";
+}
+
+std::string SkyBox::getGradientShaderPath() {
+    return SHADER_DIR "skybox/skybox_gradient.comp";
+}
+
+std::string SkyBox::getVertexShaderSource() {
+    return Shader::readFile(getVertexShaderPath());
+}
+
+std::string SkyBox::getFragmentShaderSource() {
+    return Shader::readFile(getFragmentShaderPath());
+}
@@ -1,103 +1,145 @@
-#pragma once
-
-#include "vertex.h"
-#include "uniform_buffer.h"
-#include "texture.h"
-#include <vulkan/vulkan.hpp>
-#include <memory>
-#include <vector>
-#include <string>
-#include <array>
-
-class VulkanContext;
-
-class SkyBox {
-public:
-    SkyBox(std::shared_ptr<VulkanContext> context);
-    ~SkyBox();
-
-    bool initialize();
-    void cleanup();
-    
-    bool createDefaultSkyBox(const glm::vec3& top_color = glm::vec3(0.5f, 0.7f, 1.0f),
-        const glm::vec3& bottom_color = glm::vec3(0.9f, 0.9f, 0.8f),
-        int resolution = 256);
-
-    void updateUniforms(const SkyBoxUBO& ubo);
-    void draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout);
-
-    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
-    vk::DescriptorSet getDescriptorSet() const { return descriptor_set_; }
-
-    static std::string getVertexShaderSource();
-    static std::string getFragmentShaderSource();
-
-    struct SkyBoxVertex {
-        glm::vec3 position;
-
-        static vk::VertexInputBindingDescription getBindingDescription() {
-            vk::VertexInputBindingDescription binding_description{};
-            binding_description.binding = 0;
-            binding_description.stride = sizeof(SkyBoxVertex);
-            binding_description.inputRate = vk::VertexInputRate::eVertex;
-            return binding_description;
-        }
-
-        static std::array<vk::VertexInputAttributeDescription, 1> getAttributeDescriptions() {
-            std::array<vk::VertexInputAttributeDescription, 1> attribute_descriptions{};
-
-            attribute_descriptions[0].binding = 0;
-            attribute_descriptions[0].location = 0;
-            attribute_descriptions[0].format = vk::Format::eR32G32B32Sfloat;
-            attribute_descriptions[0].offset = offsetof(SkyBoxVertex, position);
-
-            return attribute_descriptions;
-        }
-    };
-
-private:
-    bool createVertexBuffer();
-    bool createDescriptorSetLayout();
-    bool createDescriptorPool();
-    bool createDescriptorSets();
-    bool createUniformBuffer();
-    
-    bool createCubemapTexture(int width, int height);
-
-    bool createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-        vk::MemoryPropertyFlags properties,
-        vk::Buffer& buffer, vk::DeviceMemory& buffer_memory);
-    uint32_t findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties);
-    void transitionImageLayout(vk::Image image, vk::Format format,
-        vk::ImageLayout old_layout, vk::ImageLayout new_layout,
-        uint32_t layer_count = 1);
-    void copyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height,
-        uint32_t layer_index = 0);
-    
-    glm::vec3 uvToDirection(float u, float v, int face);
-    glm::vec3 interpolateColor(const glm::vec3& color1, const glm::vec3& color2, float t);
-    std::vector<unsigned char> generateFaceTexture(int face, int resolution,
-        const glm::vec3& top_color,
-        const glm::vec3& bottom_color);
-
-    std::shared_ptr<VulkanContext> context_;
-    
-    glm::vec3 top_color_;
-    glm::vec3 bottom_color_;
-
-    vk::Buffer vertex_buffer_;
-    vk::DeviceMemory vertex_buffer_memory_;
-    uint32_t vertex_count_;
-
-    vk::DescriptorSetLayout descriptor_set_layout_;
-    vk::DescriptorPool descriptor_pool_;
-    vk::DescriptorSet descriptor_set_;
-
-    vk::Buffer uniform_buffer_;
-    vk::DeviceMemory uniform_buffer_memory_;
-
-    vk::Image cubemap_image_;
-    vk::DeviceMemory cubemap_image_memory_;
-    vk::ImageView cubemap_image_view_;
-    vk::Sampler cubemap_sampler_;
-};
+#pragma once
+
+#include "vertex.h"
+#include "uniform_buffer.h"
+#include "texture.h"
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+#include <string>
+#include <array>
+
+class VulkanContext;
+class Shader;
+
+class SkyBox {
+public:
+    SkyBox(std::shared_ptr<VulkanContext> context);
+    ~SkyBox();
+
+    bool initialize();
+    void cleanup();
+    
+    // Fills the cubemap on the GPU with skybox_gradient.comp; the dispatch is
+    // recorded by the next recordUpdate(). Falls back to the CPU generator when
+    // the compute path is unavailable.
+    bool createDefaultSkyBox(const glm::vec3& top_color = glm::vec3(0.5f, 0.7f, 1.0f),
+        const glm::vec3& bottom_color = glm::vec3(0.9f, 0.9f, 0.8f),
+        int resolution = 256);
+
+    // Only takes effect on the compute path; a CPU-generated cubemap is fixed.
+    bool setGradientColors(const glm::vec3& top_color, const glm::vec3& bottom_color);
+    // Writes the gradient and rebuilds the cubemap's mip chain when needed.
+    // Must be recorded outside a render pass, before the skybox is drawn.
+    void recordUpdate(vk::CommandBuffer command_buffer);
+
+    // CPU half of createDefaultSkyBox: all six RGBA faces back to back, safe to
+    // run on any thread. createFromCubemapData() uploads the result.
+    static std::vector<unsigned char> generateCubemapData(int resolution,
+        const glm::vec3& top_color,
+        const glm::vec3& bottom_color);
+    bool createFromCubemapData(const std::vector<unsigned char>& cubemap_data, int resolution);
+
+    void updateUniforms(const SkyBoxUBO& ubo);
+    void draw(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout);
+
+    vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout_; }
+    vk::DescriptorSet getDescriptorSet() const { return descriptor_set_; }
+
+    vk::ImageView getCubemapView() const { return cubemap_image_view_; }
+    vk::Sampler getCubemapSampler() const { return cubemap_sampler_; }
+    // Identifies the cubemap contents (colors, resolution, format) for caches
+    // of data derived from it.
+    uint64_t getEnvironmentKey() const;
+
+    static std::string getVertexShaderPath();
+    static std::string getFragmentShaderPath();
+    static std::string getGradientShaderPath();
+    static std::string getVertexShaderSource();
+    static std::string getFragmentShaderSource();
+
+    struct SkyBoxVertex {
+        glm::vec3 position;
+
+        static vk::VertexInputBindingDescription getBindingDescription() {
+            vk::VertexInputBindingDescription binding_description{};
+            binding_description.binding = 0;
+            binding_description.stride = sizeof(SkyBoxVertex);
+            binding_description.inputRate = vk::VertexInputRate::eVertex;
+            return binding_description;
+        }
+
+        static std::array<vk::VertexInputAttributeDescription, 1> getAttributeDescriptions() {
+            std::array<vk::VertexInputAttributeDescription, 1> attribute_descriptions{};
+
+            attribute_descriptions[0].binding = 0;
+            attribute_descriptions[0].location = 0;
+            attribute_descriptions[0].format = vk::Format::eR32G32B32Sfloat;
+            attribute_descriptions[0].offset = offsetof(SkyBoxVertex, position);
+
+            return attribute_descriptions;
+        }
+    };
+
+private:
+    bool createVertexBuffer();
+    bool createDescriptorSetLayout();
+    bool createDescriptorPool();
+    bool createDescriptorSets();
+    
+    bool createCubemapTexture(const unsigned char* cubemap_data, int width, int height);
+    bool createCubemapImage(int resolution, vk::Format format, vk::ImageUsageFlags usage);
+    bool createCubemapSampler();
+    void destroyCubemap();
+    // Blits levels 1.. from level 0, then leaves every level shader-readable.
+    void recordMipChain(vk::CommandBuffer command_buffer, vk::ImageLayout base_layout,
+        vk::PipelineStageFlags src_stage, vk::AccessFlags src_access);
+    // Hands everything the frames in flight may still use to retire() and
+    // starts over with an empty descriptor pool.
+    bool retireResources();
+
+    bool isComputeSupported() const;
+    bool createComputePipeline();
+    bool createComputeDescriptorSet();
+    void destroyComputeResources();
+
+    static glm::vec3 uvToDirection(float u, float v, int face);
+    static glm::vec3 interpolateColor(const glm::vec3& color1, const glm::vec3& color2, float t);
+    static std::vector<unsigned char> generateFaceTexture(int face, int resolution,
+        const glm::vec3& top_color,
+        const glm::vec3& bottom_color);
+
+    std::shared_ptr<VulkanContext> context_;
+    
+    glm::vec3 top_color_;
+    glm::vec3 bottom_color_;
+
+    vk::Buffer vertex_buffer_;
+    GpuAllocation vertex_buffer_allocation_;
+    uint32_t vertex_count_;
+
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::DescriptorPool descriptor_pool_;
+    vk::DescriptorSet descriptor_set_;
+
+    uint32_t ubo_offset_;
+
+    vk::Image cubemap_image_;
+    GpuAllocation cubemap_image_allocation_;
+    vk::ImageView cubemap_image_view_;
+    vk::ImageView cubemap_storage_view_;
+    vk::Sampler cubemap_sampler_;
+    vk::ImageLayout cubemap_layout_;
+    int cubemap_resolution_;
+    uint32_t cubemap_mip_levels_;
+    vk::Format cubemap_format_;
+    bool mips_dirty_;
+
+    std::unique_ptr<Shader> gradient_shader_;
+    vk::DescriptorSetLayout compute_descriptor_set_layout_;
+    vk::DescriptorSet compute_descriptor_set_;
+    vk::PipelineLayout compute_pipeline_layout_;
+    vk::Pipeline compute_pipeline_;
+    bool gradient_dirty_;
+};
@@ -0,0 +1,109 @@
+#include "spirv_cache.h"
+#include "utils/logger.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+}
+
+uint64_t SpirvCache::computeKey(const std::string& preprocessed_source, uint32_t stage,
+    const std::string& compiler_version, const std::string& options_key) {
+    // Lengths are mixed in so the field boundaries are part of the hash.
+    uint64_t hash = FNV_OFFSET_BASIS;
+    uint64_t source_size = preprocessed_source.size();
+    uint64_t version_size = compiler_version.size();
+    uint64_t options_size = options_key.size();
+
+    hash = hashBytes(hash, &source_size, sizeof(source_size));
+    hash = hashBytes(hash, preprocessed_source.data(), preprocessed_source.size());
+    hash = hashBytes(hash, &stage, sizeof(stage));
+    hash = hashBytes(hash, &version_size, sizeof(version_size));
+    hash = hashBytes(hash, compiler_version.data(), compiler_version.size());
+    hash = hashBytes(hash, &options_size, sizeof(options_size));
+    hash = hashBytes(hash, options_key.data(), options_key.size());
+    return hash;
+}
+
+bool SpirvCache::load(uint64_t key, std::vector<uint32_t>& spirv) {
+    return readSpirvFile(getCachePath(key), spirv);
+}
+
+bool SpirvCache::store(uint64_t key, const std::vector<uint32_t>& spirv) {
+    std::error_code error;
+    std::filesystem::create_directories(CACHE_DIR, error);
+    if (error) {
+        LOGW("Failed to create shader cache directory: {}", error.message());
+        return false;
+    }
+
+    std::string cache_path = getCachePath(key);
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOGW("Failed to create shader cache file: {}", temp_path);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+
+        if (!file) {
+            LOGW("Failed to write shader cache file: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error) {
+        LOGW("Failed to move shader cache file into place: {}", error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool SpirvCache::readSpirvFile(const std::string& path, std::vector<uint32_t>& spirv) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto size = static_cast<size_t>(file.tellg());
+    if (size < sizeof(uint32_t) * 5 || size % sizeof(uint32_t) != 0) {
+        LOGW("Invalid SPIR-V file size, ignoring: {}", path);
+        return false;
+    }
+
+    spirv.resize(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(spirv.data()), size);
+
+    if (!file || spirv[0] != SPIRV_MAGIC) {
+        LOGW("Invalid SPIR-V file, ignoring: {}", path);
+        spirv.clear();
+        return false;
+    }
+
+    return true;
+}
+
+std::string SpirvCache::getCachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(CACHE_DIR) / name).string();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// On-disk cache of compiled SPIR-V, one file per key under CACHE_DIR. The key
+// covers everything that affects the compiler's output: the preprocessed
+// source, the shader stage, the compiler version and the compile options
+// (optimization level, debug info and macros), so a hit can be used without
+// invoking shaderc at all.
+class SpirvCache {
+public:
+    static uint64_t computeKey(const std::string& preprocessed_source, uint32_t stage,
+        const std::string& compiler_version, const std::string& options_key);
+
+    static bool load(uint64_t key, std::vector<uint32_t>& spirv);
+    static bool store(uint64_t key, const std::vector<uint32_t>& spirv);
+
+    static bool readSpirvFile(const std::string& path, std::vector<uint32_t>& spirv);
+
+private:
+    static std::string getCachePath(uint64_t key);
+
+    static constexpr const char* CACHE_DIR = "shader_cache";
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+};
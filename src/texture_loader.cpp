@@ -0,0 +1,539 @@
+#include "texture_loader.h"
+#include "texture.h"
+#include "mapped_file.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+constexpr vk::DeviceSize LEVEL_ALIGNMENT = 16;
+
+// Compressed files are not decoded, so any format able to store alpha is
+// assumed to use it.
+bool formatHasAlpha(vk::Format format) {
+    switch (format) {
+    case vk::Format::eR8G8B8A8Unorm:
+    case vk::Format::eR8G8B8A8Srgb:
+    case vk::Format::eB8G8R8A8Unorm:
+    case vk::Format::eB8G8R8A8Srgb:
+    case vk::Format::eBc1RgbaUnormBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+    case vk::Format::eBc2UnormBlock:
+    case vk::Format::eBc2SrgbBlock:
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock:
+    case vk::Format::eBc7UnormBlock:
+    case vk::Format::eBc7SrgbBlock:
+    case vk::Format::eAstc4x4UnormBlock:
+    case vk::Format::eAstc4x4SrgbBlock:
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct KTX2Header {
+    uint8_t identifier[12];
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+};
+static_assert(sizeof(KTX2Header) == 80, "KTX2 header layout");
+
+struct KTX2LevelIndex {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct DDSPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t four_cc;
+    uint32_t rgb_bit_count;
+    uint32_t r_mask;
+    uint32_t g_mask;
+    uint32_t b_mask;
+    uint32_t a_mask;
+};
+
+struct DDSHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitch_or_linear_size;
+    uint32_t depth;
+    uint32_t mip_map_count;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixel_format;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+static_assert(sizeof(DDSHeader) == 124, "DDS header layout");
+
+struct DDSHeaderDX10 {
+    uint32_t dxgi_format;
+    uint32_t resource_dimension;
+    uint32_t misc_flag;
+    uint32_t array_size;
+    uint32_t misc_flags2;
+};
+
+constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+        (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+constexpr uint32_t DDS_MAGIC = makeFourCC('D', 'D', 'S', ' ');
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+const std::array<float, 256>& getSrgbToLinearTable() {
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> values{};
+        for (size_t i = 0; i < values.size(); i++) {
+            float c = static_cast<float>(i) / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// Indexed by linear value * 4095; fine enough that the round trip of every
+// 8-bit sRGB value is exact.
+const std::array<uint8_t, 4096>& getLinearToSrgbTable() {
+    static const std::array<uint8_t, 4096> table = []() {
+        std::array<uint8_t, 4096> values{};
+        for (size_t i = 0; i < values.size(); i++) {
+            float l = static_cast<float>(i) / 4095.0f;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+        return values;
+    }();
+    return table;
+}
+
+std::string getExtension(const std::string& filename) {
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+}
+
+bool TextureLoader::load(const std::string& filename, TextureData& texture) {
+    std::string extension = getExtension(filename);
+    if (extension == ".ktx2" || extension == ".dds") {
+        bool loaded = extension == ".ktx2" ? loadKTX2(filename, texture) : loadDDS(filename, texture);
+        texture.alpha_tested = loaded && formatHasAlpha(texture.format);
+        return loaded;
+    }
+
+    ImageData image = Texture::loadImageData(filename, 4);
+    if (!image.isValid()) {
+        return false;
+    }
+
+    return fromImage(image, true, texture);
+}
+
+bool TextureLoader::fromImage(const ImageData& image, bool generate_mips, TextureData& texture) {
+    if (!image.isValid() || image.channels != 4) {
+        LOGE("Texture image data must be RGBA8");
+        return false;
+    }
+
+    texture = TextureData{};
+    texture.format = vk::Format::eR8G8B8A8Srgb;
+
+    uint32_t width = static_cast<uint32_t>(image.width);
+    uint32_t height = static_cast<uint32_t>(image.height);
+    if (!addLevel(texture, image.pixels, vk::DeviceSize(width) * height * 4, width, height)) {
+        return false;
+    }
+
+    size_t pixel_count = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < pixel_count && !texture.alpha_tested; i++) {
+        texture.alpha_tested = image.pixels[i * 4 + 3] < 128;
+    }
+
+    if (generate_mips) {
+        generateMipChain(texture);
+    }
+    return true;
+}
+
+bool TextureLoader::getFormatBlockInfo(vk::Format format, uint32_t& block_width, uint32_t& block_height,
+    uint32_t& block_bytes) {
+    block_width = 4;
+    block_height = 4;
+    block_bytes = 16;
+
+    switch (format) {
+    case vk::Format::eR8G8B8A8Unorm:
+    case vk::Format::eR8G8B8A8Srgb:
+        block_width = 1;
+        block_height = 1;
+        block_bytes = 4;
+        return true;
+    case vk::Format::eBc1RgbUnormBlock:
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbaUnormBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+    case vk::Format::eBc4UnormBlock:
+    case vk::Format::eBc4SnormBlock:
+        block_bytes = 8;
+        return true;
+    case vk::Format::eBc2UnormBlock:
+    case vk::Format::eBc2SrgbBlock:
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock:
+    case vk::Format::eBc5UnormBlock:
+    case vk::Format::eBc5SnormBlock:
+    case vk::Format::eBc7UnormBlock:
+    case vk::Format::eBc7SrgbBlock:
+    case vk::Format::eAstc4x4UnormBlock:
+    case vk::Format::eAstc4x4SrgbBlock:
+        return true;
+    case vk::Format::eAstc5x5UnormBlock:
+    case vk::Format::eAstc5x5SrgbBlock:
+        block_width = block_height = 5;
+        return true;
+    case vk::Format::eAstc6x6UnormBlock:
+    case vk::Format::eAstc6x6SrgbBlock:
+        block_width = block_height = 6;
+        return true;
+    case vk::Format::eAstc8x8UnormBlock:
+    case vk::Format::eAstc8x8SrgbBlock:
+        block_width = block_height = 8;
+        return true;
+    case vk::Format::eAstc10x10UnormBlock:
+    case vk::Format::eAstc10x10SrgbBlock:
+        block_width = block_height = 10;
+        return true;
+    case vk::Format::eAstc12x12UnormBlock:
+    case vk::Format::eAstc12x12SrgbBlock:
+        block_width = block_height = 12;
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t TextureLoader::getMipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+        levels++;
+    }
+    return levels;
+}
+
+bool TextureLoader::loadKTX2(const std::string& filename, TextureData& texture) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        LOGE("Failed to open texture: {}", filename);
+        return false;
+    }
+
+    const auto* bytes = static_cast<const unsigned char*>(file.getData());
+    size_t file_size = file.getSize();
+
+    KTX2Header header{};
+    if (file_size < sizeof(header)) {
+        LOGE("KTX2 file too small: {}", filename);
+        return false;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        LOGE("Not a KTX2 file: {}", filename);
+        return false;
+    }
+
+    if (header.supercompression_scheme != 0 || header.pixel_depth > 1 || header.layer_count > 1 ||
+        header.face_count != 1 || header.pixel_width == 0 || header.pixel_height == 0) {
+        LOGE("Unsupported KTX2 texture (only plain 2D images without supercompression): {}", filename);
+        return false;
+    }
+
+    texture = TextureData{};
+    texture.format = static_cast<vk::Format>(header.vk_format);
+
+    uint32_t block_width, block_height, block_bytes;
+    if (!getFormatBlockInfo(texture.format, block_width, block_height, block_bytes)) {
+        LOGE("Unsupported KTX2 format {}: {}", header.vk_format, filename);
+        return false;
+    }
+
+    // levelCount 0 asks the loader to build the mips.
+    uint32_t level_count = std::max(1u, header.level_count);
+    if (level_count > getMipLevelCount(header.pixel_width, header.pixel_height)) {
+        LOGE("KTX2 level {} out of bounds or mis-sized: {}", level_count - 1, filename);
+        return false;
+    }
+
+    size_t index_end = sizeof(header) + sizeof(KTX2LevelIndex) * level_count;
+    if (file_size < index_end) {
+        LOGE("KTX2 level index truncated: {}", filename);
+        return false;
+    }
+
+    for (uint32_t level = 0; level < level_count; level++) {
+        KTX2LevelIndex index{};
+        memcpy(&index, bytes + sizeof(header) + sizeof(KTX2LevelIndex) * level, sizeof(index));
+
+        uint32_t width = std::max(1u, header.pixel_width >> level);
+        uint32_t height = std::max(1u, header.pixel_height >> level);
+
+        if (index.byte_offset > file_size || index.byte_length > file_size - index.byte_offset ||
+            index.byte_length != getLevelSize(texture.format, width, height)) {
+            LOGE("KTX2 level {} out of bounds or mis-sized: {}", level, filename);
+            return false;
+        }
+
+        addLevel(texture, bytes + index.byte_offset, index.byte_length, width, height);
+    }
+
+    if (header.level_count == 0 && block_width == 1) {
+        generateMipChain(texture);
+    }
+
+    LOGI("Loaded KTX2 texture: {} ({}x{}, {} levels, format {})", filename,
+        header.pixel_width, header.pixel_height, texture.getMipLevels(), vk::to_string(texture.format));
+    return true;
+}
+
+bool TextureLoader::loadDDS(const std::string& filename, TextureData& texture) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        LOGE("Failed to open texture: {}", filename);
+        return false;
+    }
+
+    const auto* bytes = static_cast<const unsigned char*>(file.getData());
+    size_t file_size = file.getSize();
+
+    uint32_t magic = 0;
+    DDSHeader header{};
+    if (file_size < sizeof(magic) + sizeof(header)) {
+        LOGE("DDS file too small: {}", filename);
+        return false;
+    }
+    memcpy(&magic, bytes, sizeof(magic));
+    memcpy(&header, bytes + sizeof(magic), sizeof(header));
+
+    if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader)) {
+        LOGE("Not a DDS file: {}", filename);
+        return false;
+    }
+
+    size_t data_offset = sizeof(magic) + sizeof(header);
+    vk::Format format = vk::Format::eUndefined;
+
+    if ((header.pixel_format.flags & DDPF_FOURCC) && header.pixel_format.four_cc == makeFourCC('D', 'X', '1', '0')) {
+        DDSHeaderDX10 dx10{};
+        if (file_size < data_offset + sizeof(dx10)) {
+            LOGE("DDS DX10 header truncated: {}", filename);
+            return false;
+        }
+        memcpy(&dx10, bytes + data_offset, sizeof(dx10));
+        data_offset += sizeof(dx10);
+
+        if (dx10.resource_dimension != DDS_DIMENSION_TEXTURE2D || dx10.array_size > 1) {
+            LOGE("Unsupported DDS texture (only single 2D images): {}", filename);
+            return false;
+        }
+        format = getDDSFormat(dx10.dxgi_format);
+    }
+    else if (header.pixel_format.flags & DDPF_FOURCC) {
+        format = getDDSFourCCFormat(header.pixel_format.four_cc);
+    }
+    else if ((header.pixel_format.flags & DDPF_RGB) && header.pixel_format.rgb_bit_count == 32 &&
+        header.pixel_format.r_mask == 0x000000FF && header.pixel_format.g_mask == 0x0000FF00 &&
+        header.pixel_format.b_mask == 0x00FF0000) {
+        format = vk::Format::eR8G8B8A8Srgb;
+    }
+
+    if (format == vk::Format::eUndefined) {
+        LOGE("Unsupported DDS pixel format: {}", filename);
+        return false;
+    }
+
+    if ((header.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) || header.width == 0 || header.height == 0) {
+        LOGE("Unsupported DDS texture (only single 2D images): {}", filename);
+        return false;
+    }
+
+    texture = TextureData{};
+    texture.format = format;
+
+    uint32_t level_count = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mip_map_count) : 1;
+    level_count = std::min(level_count, getMipLevelCount(header.width, header.height));
+
+    for (uint32_t level = 0; level < level_count; level++) {
+        uint32_t width = std::max(1u, header.width >> level);
+        uint32_t height = std::max(1u, header.height >> level);
+        vk::DeviceSize size = getLevelSize(format, width, height);
+
+        if (size > file_size - data_offset) {
+            LOGE("DDS level {} truncated: {}", level, filename);
+            return false;
+        }
+
+        addLevel(texture, bytes + data_offset, size, width, height);
+        data_offset += static_cast<size_t>(size);
+    }
+
+    LOGI("Loaded DDS texture: {} ({}x{}, {} levels, format {})", filename,
+        header.width, header.height, texture.getMipLevels(), vk::to_string(format));
+    return true;
+}
+
+vk::Format TextureLoader::getDDSFormat(uint32_t dxgi_format) {
+    switch (dxgi_format) {
+    case 28: return vk::Format::eR8G8B8A8Unorm;
+    case 29: return vk::Format::eR8G8B8A8Srgb;
+    case 71: return vk::Format::eBc1RgbaUnormBlock;
+    case 72: return vk::Format::eBc1RgbaSrgbBlock;
+    case 74: return vk::Format::eBc2UnormBlock;
+    case 75: return vk::Format::eBc2SrgbBlock;
+    case 77: return vk::Format::eBc3UnormBlock;
+    case 78: return vk::Format::eBc3SrgbBlock;
+    case 80: return vk::Format::eBc4UnormBlock;
+    case 81: return vk::Format::eBc4SnormBlock;
+    case 83: return vk::Format::eBc5UnormBlock;
+    case 84: return vk::Format::eBc5SnormBlock;
+    case 98: return vk::Format::eBc7UnormBlock;
+    case 99: return vk::Format::eBc7SrgbBlock;
+    default: return vk::Format::eUndefined;
+    }
+}
+
+vk::Format TextureLoader::getDDSFourCCFormat(uint32_t four_cc) {
+    // Legacy headers carry no colour space: colour formats are taken as sRGB,
+    // the one- and two-channel formats as linear data.
+    switch (four_cc) {
+    case makeFourCC('D', 'X', 'T', '1'): return vk::Format::eBc1RgbaSrgbBlock;
+    case makeFourCC('D', 'X', 'T', '3'): return vk::Format::eBc2SrgbBlock;
+    case makeFourCC('D', 'X', 'T', '5'): return vk::Format::eBc3SrgbBlock;
+    case makeFourCC('A', 'T', 'I', '1'):
+    case makeFourCC('B', 'C', '4', 'U'): return vk::Format::eBc4UnormBlock;
+    case makeFourCC('A', 'T', 'I', '2'):
+    case makeFourCC('B', 'C', '5', 'U'): return vk::Format::eBc5UnormBlock;
+    default: return vk::Format::eUndefined;
+    }
+}
+
+bool TextureLoader::addLevel(TextureData& texture, const unsigned char* data, vk::DeviceSize size,
+    uint32_t width, uint32_t height) {
+    if (!data || size == 0) return false;
+
+    // Buffer offsets for copies must be a multiple of the texel block size and of 4.
+    vk::DeviceSize offset = (texture.data.size() + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+    texture.data.resize(static_cast<size_t>(offset + size));
+    memcpy(texture.data.data() + offset, data, static_cast<size_t>(size));
+    texture.levels.push_back({ offset, size, width, height });
+    return true;
+}
+
+vk::DeviceSize TextureLoader::getLevelSize(vk::Format format, uint32_t width, uint32_t height) {
+    uint32_t block_width, block_height, block_bytes;
+    if (!getFormatBlockInfo(format, block_width, block_height, block_bytes)) {
+        return 0;
+    }
+
+    vk::DeviceSize blocks_x = (width + block_width - 1) / block_width;
+    vk::DeviceSize blocks_y = (height + block_height - 1) / block_height;
+    return blocks_x * blocks_y * block_bytes;
+}
+
+void TextureLoader::generateMipChain(TextureData& texture) {
+    if (texture.levels.size() != 1) return;
+
+    bool srgb = texture.format == vk::Format::eR8G8B8A8Srgb;
+    uint32_t level_count = getMipLevelCount(texture.getWidth(), texture.getHeight());
+
+    // Lay out every level first so `data` does not reallocate while filling.
+    vk::DeviceSize end = texture.data.size();
+    for (uint32_t level = 1; level < level_count; level++) {
+        const TextureMipLevel& previous = texture.levels.back();
+        uint32_t width = std::max(1u, previous.width / 2);
+        uint32_t height = std::max(1u, previous.height / 2);
+        vk::DeviceSize offset = (end + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+        vk::DeviceSize size = vk::DeviceSize(width) * height * 4;
+        texture.levels.push_back({ offset, size, width, height });
+        end = offset + size;
+    }
+    texture.data.resize(static_cast<size_t>(end));
+
+    const auto& to_linear = getSrgbToLinearTable();
+    const auto& to_srgb = getLinearToSrgbTable();
+
+    for (uint32_t level = 1; level < level_count; level++) {
+        const TextureMipLevel& src_level = texture.levels[level - 1];
+        const TextureMipLevel& dst_level = texture.levels[level];
+        const unsigned char* src = texture.data.data() + src_level.offset;
+        unsigned char* dst = texture.data.data() + dst_level.offset;
+
+        for (uint32_t y = 0; y < dst_level.height; y++) {
+            uint32_t y0 = std::min(y * 2, src_level.height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, src_level.height - 1);
+
+            for (uint32_t x = 0; x < dst_level.width; x++) {
+                uint32_t x0 = std::min(x * 2, src_level.width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, src_level.width - 1);
+
+                const unsigned char* texels[4] = {
+                    src + (size_t(y0) * src_level.width + x0) * 4,
+                    src + (size_t(y0) * src_level.width + x1) * 4,
+                    src + (size_t(y1) * src_level.width + x0) * 4,
+                    src + (size_t(y1) * src_level.width + x1) * 4,
+                };
+
+                unsigned char* out = dst + (size_t(y) * dst_level.width + x) * 4;
+                for (int c = 0; c < 3; c++) {
+                    if (srgb) {
+                        float sum = to_linear[texels[0][c]] + to_linear[texels[1][c]] +
+                            to_linear[texels[2][c]] + to_linear[texels[3][c]];
+                        out[c] = to_srgb[static_cast<size_t>(sum * 0.25f * 4095.0f + 0.5f)];
+                    }
+                    else {
+                        out[c] = static_cast<unsigned char>(
+                            (texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+                    }
+                }
+                out[3] = static_cast<unsigned char>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+            }
+        }
+    }
+}
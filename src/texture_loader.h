@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct ImageData;
+
+struct TextureMipLevel {
+    vk::DeviceSize offset;
+    vk::DeviceSize size;
+    uint32_t width;
+    uint32_t height;
+};
+
+// A complete 2D texture ready for upload: every mip level back to back in
+// `data`, in the layout vkCmdCopyBufferToImage expects for `format`.
+struct TextureData {
+    vk::Format format = vk::Format::eUndefined;
+    // Some texel may fall below the 0.5 alpha cutoff, so draws sampling the
+    // texture need the alpha-tested (discarding) pipelines.
+    bool alpha_tested = false;
+    std::vector<unsigned char> data;
+    std::vector<TextureMipLevel> levels;
+
+    bool isValid() const { return !levels.empty(); }
+    uint32_t getWidth() const { return levels.empty() ? 0 : levels[0].width; }
+    uint32_t getHeight() const { return levels.empty() ? 0 : levels[0].height; }
+    uint32_t getMipLevels() const { return static_cast<uint32_t>(levels.size()); }
+};
+
+// CPU side of texture loading; everything here is safe to run on worker threads.
+//
+// KTX2 and DDS files are taken as they are, so pre-compressed BC1/BC3/BC4/BC5/
+// BC7 and ASTC data (with whatever mips the file carries) goes to the GPU
+// unchanged. Any other image is decoded by stb_image as RGBA8 sRGB and gets a
+// full mip chain, box-filtered in linear space.
+class TextureLoader {
+public:
+    static bool load(const std::string& filename, TextureData& texture);
+    static bool fromImage(const ImageData& image, bool generate_mips, TextureData& texture);
+
+    // Texel block extent and size in bytes; false for formats we cannot size.
+    static bool getFormatBlockInfo(vk::Format format, uint32_t& block_width, uint32_t& block_height,
+        uint32_t& block_bytes);
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+private:
+    static bool loadKTX2(const std::string& filename, TextureData& texture);
+    static bool loadDDS(const std::string& filename, TextureData& texture);
+    static vk::Format getDDSFormat(uint32_t dxgi_format);
+    static vk::Format getDDSFourCCFormat(uint32_t four_cc);
+
+    static bool addLevel(TextureData& texture, const unsigned char* data, vk::DeviceSize size,
+        uint32_t width, uint32_t height);
+    static vk::DeviceSize getLevelSize(vk::Format format, uint32_t width, uint32_t height);
+    static void generateMipChain(TextureData& texture);
+};
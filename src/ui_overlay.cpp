@@ -6,20 +6,24 @@
 #include <imgui/imgui_impl_vulkan.h>
 
 #include <algorithm>
+#include <cstdio>
 
 UIOverlay::UIOverlay(std::shared_ptr<VulkanContext> context, GLFWwindow* window)
     : context_(context), window_(window),
     current_fps_(0.0f), current_frame_time_(0.0f), frame_time_history_index_(0),
+    gpu_profiler_(nullptr), cpu_profiler_(nullptr), frame_pacer_(nullptr),
     fps_(0.0f), average_frame_time_(0.0f), frame_count_(0), time_accumulator_(0.0f) {
     
     std::fill(frame_time_history_, frame_time_history_ + FRAME_TIME_HISTORY_SIZE, 0.0f);
+    std::fill(gpu_time_history_, gpu_time_history_ + FRAME_TIME_HISTORY_SIZE, 0.0f);
 }
 
 UIOverlay::~UIOverlay() {
     cleanup();
 }
 
-bool UIOverlay::initialize(vk::RenderPass render_pass) {
+bool UIOverlay::initialize(vk::RenderPass render_pass, uint32_t subpass,
+    const vk::PipelineRenderingCreateInfoKHR* rendering_info) {
     if (!createDescriptorPool()) {
         LOGE("Failed to create ImGui descriptor pool");
         return false;
@@ -41,18 +45,28 @@ bool UIOverlay::initialize(vk::RenderPass render_pass) {
     init_info.Instance = context_->getInstance();
     init_info.PhysicalDevice = context_->getPhysicalDevice();
     init_info.Device = context_->getDevice();
-    init_info.QueueFamily = 0;
+    init_info.QueueFamily = context_->getQueueFamilyIndices().graphics_family.value();
     init_info.Queue = context_->getGraphicsQueue();
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = context_->getPipelineCache();
     init_info.DescriptorPool = imgui_descriptor_pool_;
     init_info.RenderPass = render_pass;
-    init_info.Subpass = 0;
+    init_info.Subpass = subpass;
     init_info.MinImageCount = 2;
     init_info.ImageCount = context_->getSwapChainImages().size();
     init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
     init_info.Allocator = nullptr;
     init_info.CheckVkResultFn = nullptr;
 
+    if (rendering_info) {
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+        init_info.UseDynamicRendering = true;
+        init_info.PipelineRenderingCreateInfo = static_cast<VkPipelineRenderingCreateInfoKHR>(*rendering_info);
+#else
+        LOGE("ImGui was built without dynamic rendering support");
+        return false;
+#endif
+    }
+
     if (!ImGui_ImplVulkan_Init(&init_info)) {
         LOGE("Failed to initialize ImGui Vulkan implementation");
         return false;
@@ -87,9 +101,22 @@ void UIOverlay::updatePerformanceData(float fps, float frame_time) {
     current_frame_time_ = frame_time;
     
     frame_time_history_[frame_time_history_index_] = frame_time;
+
+    // Scope 0 is the whole GPU frame.
+    float gpu_time = 0.0f;
+    if (gpu_profiler_ && !gpu_profiler_->getScopes().empty()) {
+        gpu_time = gpu_profiler_->getScopes()[0].milliseconds;
+    }
+    gpu_time_history_[frame_time_history_index_] = gpu_time;
+
     frame_time_history_index_ = (frame_time_history_index_ + 1) % FRAME_TIME_HISTORY_SIZE;
 }
 
+void UIOverlay::setProfilers(const GpuProfiler* gpu_profiler, const CpuProfiler* cpu_profiler) {
+    gpu_profiler_ = gpu_profiler;
+    cpu_profiler_ = cpu_profiler;
+}
+
 void UIOverlay::render(vk::CommandBuffer command_buffer) {
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -181,6 +208,11 @@ void UIOverlay::renderPerformanceWindow() {
         
         ImGui::Text("FPS: %.1f", current_fps_);
         ImGui::Text("Frame Time: %.2f ms", current_frame_time_);
+        if (frame_pacer_) {
+            // Without present wait the frame is only known to be rendered.
+            ImGui::Text(frame_pacer_->isPresentTimed() ? "Input To Present: %.2f ms" : "Input To GPU Done: %.2f ms",
+                frame_pacer_->getLatency());
+        }
         
         ImVec4 fps_color;
         if (current_fps_ >= 60.0f) {
@@ -206,10 +238,79 @@ void UIOverlay::renderPerformanceWindow() {
         ImGui::PlotLines("Frame Time (ms)", frame_time_history_, FRAME_TIME_HISTORY_SIZE,
             frame_time_history_index_, nullptr, min_time, max_time,
             ImVec2(250, 80));
+
+        renderProfilerStatistics();
+        renderMemoryStatistics();
     }
     ImGui::End();
 }
 
+void UIOverlay::renderMemoryStatistics() {
+    ImGui::Separator();
+    ImGui::Text("GPU Memory");
+
+    const float bytes_per_mb = 1024.0f * 1024.0f;
+
+    for (const auto& heap : context_->getAllocator().getHeapStatistics()) {
+        if (heap.block_count == 0) continue;
+
+        ImGui::Text("Heap %u (%s): %.1f / %.1f MB", heap.heap_index,
+            heap.device_local ? "device" : "host",
+            heap.used_bytes / bytes_per_mb, heap.heap_size / bytes_per_mb);
+        ImGui::Text("  %u blocks, %u allocations, %.1f MB reserved", heap.block_count,
+            heap.allocation_count, heap.reserved_bytes / bytes_per_mb);
+    }
+}
+
+void UIOverlay::renderProfilerStatistics() {
+    if (gpu_profiler_ && gpu_profiler_->isAvailable()) {
+        ImGui::Separator();
+        ImGui::Text("GPU Passes");
+
+        float max_time = *std::max_element(gpu_time_history_, gpu_time_history_ + FRAME_TIME_HISTORY_SIZE);
+        ImGui::PlotLines("GPU Time (ms)", gpu_time_history_, FRAME_TIME_HISTORY_SIZE,
+            frame_time_history_index_, nullptr, 0.0f, std::max(max_time, 1.0f),
+            ImVec2(250, 60));
+
+        renderScopeTree(gpu_profiler_->getScopes());
+
+        if (gpu_profiler_->hasPipelineStatistics()) {
+            const PipelineStatistics& statistics = gpu_profiler_->getPipelineStatistics();
+            ImGui::Text("Input primitives: %llu", static_cast<unsigned long long>(statistics.input_primitives));
+            ImGui::Text("Vertex invocations: %llu", static_cast<unsigned long long>(statistics.vertex_invocations));
+            ImGui::Text("Clipped primitives: %llu", static_cast<unsigned long long>(statistics.clipping_primitives));
+            ImGui::Text("Fragment invocations: %llu", static_cast<unsigned long long>(statistics.fragment_invocations));
+            ImGui::Text("Compute invocations: %llu", static_cast<unsigned long long>(statistics.compute_invocations));
+        }
+    }
+
+    if (cpu_profiler_) {
+        ImGui::Separator();
+        ImGui::Text("CPU Scopes");
+        renderScopeTree(cpu_profiler_->getScopes());
+    }
+}
+
+void UIOverlay::renderScopeTree(const std::vector<ProfileScope>& scopes) {
+    if (scopes.empty()) return;
+
+    // Bars are relative to the root scope, i.e. the share of the frame.
+    const float INDENT = 12.0f;
+    float frame_time = std::max(scopes[0].milliseconds, 0.001f);
+
+    for (const ProfileScope& scope : scopes) {
+        if (scope.depth > 0) ImGui::Indent(INDENT * scope.depth);
+
+        char label[32];
+        snprintf(label, sizeof(label), "%.2f ms", scope.milliseconds);
+        ImGui::ProgressBar(std::min(scope.milliseconds / frame_time, 1.0f), ImVec2(120, 0), label);
+        ImGui::SameLine();
+        ImGui::Text("%s", scope.name.c_str());
+
+        if (scope.depth > 0) ImGui::Unindent(INDENT * scope.depth);
+    }
+}
+
 void UIOverlay::setupImGuiStyle() {
     ImGuiStyle& style = ImGui::GetStyle();
     
@@ -1,29 +1,50 @@
-#pragma once
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-struct UniformBufferObject {
-    alignas(16) glm::mat4 model;
-    alignas(16) glm::mat4 view;
-    alignas(16) glm::mat4 proj;
-    alignas(16) glm::mat4 normal_matrix;
-    alignas(16) glm::vec3 camera_pos;
-};
-
-struct PBRMaterial {
-    alignas(16) glm::vec3 albedo = glm::vec3(1.0f);
-    alignas(4) float metallic = 0.0f;
-    alignas(4) float roughness = 0.5f;
-    alignas(4) float ao = 1.0f;
-};
-
-struct LightData {
-    alignas(16) glm::vec3 position = glm::vec3(10.0f, 10.0f, 10.0f);
-    alignas(16) glm::vec3 color = glm::vec3(300.0f);
-};
-
-struct SkyBoxUBO {
-    alignas(16) glm::mat4 view;
-    alignas(16) glm::mat4 projection;
-};
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+struct UniformBufferObject {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 proj;
+    alignas(16) glm::vec3 camera_pos;
+};
+
+// Per-object entry of the scene storage buffer, in draw order. The vertex
+// shader reaches it through the visible list the culling pass writes.
+struct ObjectData {
+    alignas(16) glm::mat4 model;
+    alignas(16) glm::mat4 normal_matrix;
+    alignas(16) glm::vec4 bounding_sphere; // world-space center, radius
+    alignas(16) glm::uvec4 draw_info;      // x = first draw command (LOD 0), y = LOD count
+};
+
+struct PBRMaterial {
+    alignas(16) glm::vec3 albedo = glm::vec3(1.0f);
+    alignas(4) float metallic = 0.0f;
+    alignas(4) float roughness = 0.5f;
+    alignas(4) float ao = 1.0f;
+};
+
+// Entry of the bindless material buffer: PBRMaterial plus the slot of its
+// albedo texture in the bindless texture array.
+struct BindlessMaterial {
+    alignas(16) glm::vec3 albedo = glm::vec3(1.0f);
+    alignas(4) float metallic = 0.0f;
+    alignas(4) float roughness = 0.5f;
+    alignas(4) float ao = 1.0f;
+    alignas(4) uint32_t albedo_texture = 0;
+};
+
+// Entry of the light list storage buffer. `radius` bounds the light's
+// influence so it can be binned into clusters.
+struct PointLight {
+    alignas(16) glm::vec3 position = glm::vec3(0.0f);
+    alignas(4) float radius = 10.0f;
+    alignas(16) glm::vec3 color = glm::vec3(1.0f);
+    alignas(4) float intensity = 1.0f;
+};
+
+struct SkyBoxUBO {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 projection;
+};
@@ -0,0 +1,66 @@
+#include "uniform_ring.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+UniformRing::UniformRing(vk::Device device, GpuAllocator& allocator, const vk::PhysicalDeviceLimits& limits)
+    : device_(device), allocator_(allocator),
+    alignment_(std::max<vk::DeviceSize>(limits.minUniformBufferOffsetAlignment, 16)),
+    frame_count_(0), frame_size_(0), frame_begin_(0), cursor_(0) {
+}
+
+UniformRing::~UniformRing() {
+    cleanup();
+}
+
+bool UniformRing::initialize(uint32_t frame_count, uint32_t slots_per_frame, vk::DeviceSize slot_size) {
+    frame_count_ = frame_count;
+    frame_size_ = alignUp(slots_per_frame * alignUp(slot_size, alignment_), alignment_);
+
+    if (!allocator_.createBuffer(frame_size_ * frame_count_, vk::BufferUsageFlagBits::eUniformBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        buffer_, allocation_)) {
+        LOGE("Failed to create uniform ring buffer");
+        return false;
+    }
+
+    beginFrame(0);
+
+    LOGI("Uniform ring created: {} frames x {} KB", frame_count_, frame_size_ / 1024);
+    return true;
+}
+
+void UniformRing::cleanup() {
+    if (buffer_) {
+        allocator_.destroyBuffer(buffer_, allocation_);
+    }
+}
+
+void UniformRing::beginFrame(uint32_t frame_index) {
+    frame_begin_ = frame_size_ * (frame_index % frame_count_);
+    cursor_ = frame_begin_;
+}
+
+uint32_t UniformRing::push(const void* data, vk::DeviceSize size) {
+    vk::DeviceSize aligned_size = alignUp(size, alignment_);
+
+    if (cursor_ + aligned_size > frame_begin_ + frame_size_) {
+        LOGE("Uniform ring frame region exhausted ({} bytes)", frame_size_);
+        throw std::runtime_error("Uniform ring frame region exhausted!");
+    }
+
+    vk::DeviceSize offset = cursor_;
+    memcpy(static_cast<char*>(allocation_.mapped) + offset, data, static_cast<size_t>(size));
+    cursor_ += aligned_size;
+
+    return static_cast<uint32_t>(offset);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+
+// Persistently mapped uniform buffer split into one region per frame in flight.
+// Each frame the region of the frame being recorded is rewound and per-draw
+// uniform blocks are appended; the returned offset is fed to bindDescriptorSets
+// as the dynamic offset of an eUniformBufferDynamic binding. Because a region is
+// only reused once that frame's fence has signaled, the CPU never overwrites
+// data the GPU is still reading.
+class UniformRing {
+public:
+    UniformRing(vk::Device device, GpuAllocator& allocator, const vk::PhysicalDeviceLimits& limits);
+    ~UniformRing();
+
+    bool initialize(uint32_t frame_count, uint32_t slots_per_frame, vk::DeviceSize slot_size);
+    void cleanup();
+
+    void beginFrame(uint32_t frame_index);
+
+    // Throws std::runtime_error when the frame's region is full: wrapping
+    // would overwrite blocks this frame has already bound.
+    uint32_t push(const void* data, vk::DeviceSize size);
+
+    template <typename T>
+    uint32_t push(const T& value) { return push(&value, sizeof(T)); }
+
+    vk::Buffer getBuffer() const { return buffer_; }
+    uint32_t getFrameCount() const { return frame_count_; }
+
+private:
+    vk::Device device_;
+    GpuAllocator& allocator_;
+    vk::DeviceSize alignment_;
+
+    vk::Buffer buffer_;
+    GpuAllocation allocation_;
+
+    uint32_t frame_count_;
+    vk::DeviceSize frame_size_;
+    vk::DeviceSize frame_begin_;
+    vk::DeviceSize cursor_;
+};
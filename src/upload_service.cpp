@@ -0,0 +1,346 @@
+#include "upload_service.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstring>
+
+UploadService::UploadService(vk::Device device, GpuAllocator& allocator,
+    vk::Queue transfer_queue, uint32_t transfer_family, uint32_t graphics_family,
+    uint32_t frames_in_flight)
+    : device_(device), allocator_(allocator), transfer_queue_(transfer_queue),
+    transfer_family_(transfer_family), graphics_family_(graphics_family),
+    frames_in_flight_(frames_in_flight), batch_open_(false),
+    next_ticket_(1), completed_ticket_(0), frame_serial_(0) {
+}
+
+UploadService::~UploadService() {
+    cleanup();
+}
+
+bool UploadService::initialize() {
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    pool_info.queueFamilyIndex = transfer_family_;
+
+    try {
+        command_pool_ = device_.createCommandPool(pool_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create upload command pool: {}", e.what());
+        return false;
+    }
+
+    LOGI("Upload service initialized on queue family {} ({})", transfer_family_,
+        hasOwnershipTransfer() ? "dedicated transfer" : "shared with graphics");
+    return true;
+}
+
+void UploadService::cleanup() {
+    if (!command_pool_) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (batch_open_) {
+        submitBatch();
+    }
+    retireBatches(true);
+
+    device_.destroyCommandPool(command_pool_);
+    command_pool_ = nullptr;
+}
+
+bool UploadService::uploadBuffer(vk::Buffer buffer, const void* data, vk::DeviceSize size, vk::DeviceSize offset,
+    vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    StagingBuffer staging;
+    if (!beginBatch() || !createStagingBuffer(data, size, staging)) {
+        return false;
+    }
+
+    vk::BufferCopy copy_region{};
+    copy_region.srcOffset = 0;
+    copy_region.dstOffset = offset;
+    copy_region.size = size;
+    open_batch_.command_buffer.copyBuffer(staging.buffer, buffer, 1, &copy_region);
+    open_batch_.staging_buffers.push_back(staging);
+
+    vk::BufferMemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    if (hasOwnershipTransfer()) {
+        barrier.srcQueueFamilyIndex = transfer_family_;
+        barrier.dstQueueFamilyIndex = graphics_family_;
+
+        vk::BufferMemoryBarrier acquire = barrier;
+        acquire.srcAccessMask = vk::AccessFlagBits::eNone;
+        open_batch_.buffer_acquires.push_back(acquire);
+
+        barrier.dstAccessMask = vk::AccessFlagBits::eNone;
+    }
+
+    open_batch_.buffer_releases.push_back(barrier);
+    open_batch_.dst_stages |= dst_stage;
+    return true;
+}
+
+bool UploadService::uploadImage(vk::Image image, const void* data, vk::DeviceSize size,
+    const std::vector<vk::BufferImageCopy>& regions, const vk::ImageSubresourceRange& range,
+    vk::ImageLayout final_layout, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    StagingBuffer staging;
+    if (!beginBatch() || !createStagingBuffer(data, size, staging)) {
+        return false;
+    }
+
+    vk::CommandBuffer command_buffer = open_batch_.command_buffer;
+
+    vk::ImageMemoryBarrier to_transfer{};
+    to_transfer.oldLayout = vk::ImageLayout::eUndefined;
+    to_transfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.srcAccessMask = vk::AccessFlagBits::eNone;
+    to_transfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    to_transfer.image = image;
+    to_transfer.subresourceRange = range;
+
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+        vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &to_transfer);
+
+    command_buffer.copyBufferToImage(staging.buffer, image, vk::ImageLayout::eTransferDstOptimal,
+        static_cast<uint32_t>(regions.size()), regions.data());
+    open_batch_.staging_buffers.push_back(staging);
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = final_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = dst_access;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+
+    if (hasOwnershipTransfer()) {
+        // Release and acquire must describe the same layout transition.
+        barrier.srcQueueFamilyIndex = transfer_family_;
+        barrier.dstQueueFamilyIndex = graphics_family_;
+
+        vk::ImageMemoryBarrier acquire = barrier;
+        acquire.srcAccessMask = vk::AccessFlagBits::eNone;
+        open_batch_.image_acquires.push_back(acquire);
+
+        barrier.dstAccessMask = vk::AccessFlagBits::eNone;
+    }
+
+    open_batch_.image_releases.push_back(barrier);
+    open_batch_.dst_stages |= dst_stage;
+    return true;
+}
+
+uint64_t UploadService::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!batch_open_) {
+        return next_ticket_ - 1;
+    }
+    return submitBatch();
+}
+
+bool UploadService::isComplete(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    retireBatches(false);
+    return ticket <= completed_ticket_;
+}
+
+void UploadService::wait(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (batch_open_ && open_batch_.ticket <= ticket) {
+        submitBatch();
+    }
+
+    for (const Batch& batch : submitted_batches_) {
+        if (batch.ticket > ticket) break;
+        if (batch.fence) {
+            device_.waitForFences(1, &batch.fence, VK_TRUE, UINT64_MAX);
+        }
+    }
+
+    retireBatches(false);
+}
+
+void UploadService::beginFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    frame_serial_++;
+    retireBatches(false);
+}
+
+void UploadService::acquire(vk::CommandBuffer command_buffer,
+    std::vector<vk::Semaphore>& wait_semaphores, std::vector<vk::PipelineStageFlags>& wait_stages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (batch_open_) {
+        submitBatch();
+    }
+
+    // Without an ownership transfer the uploads were submitted to this very
+    // queue and their release barriers already make them visible.
+    if (!hasOwnershipTransfer()) return;
+
+    std::vector<vk::BufferMemoryBarrier> buffer_barriers;
+    std::vector<vk::ImageMemoryBarrier> image_barriers;
+    vk::PipelineStageFlags stages;
+
+    for (Batch& batch : submitted_batches_) {
+        if (batch.acquired) continue;
+
+        buffer_barriers.insert(buffer_barriers.end(), batch.buffer_acquires.begin(), batch.buffer_acquires.end());
+        image_barriers.insert(image_barriers.end(), batch.image_acquires.begin(), batch.image_acquires.end());
+        stages |= batch.dst_stages;
+
+        wait_semaphores.push_back(batch.semaphore);
+        wait_stages.push_back(batch.dst_stages);
+
+        batch.acquired = true;
+        batch.acquire_frame = frame_serial_;
+    }
+
+    if (buffer_barriers.empty() && image_barriers.empty()) return;
+
+    // The source stages match the semaphore wait stages so the acquire is
+    // ordered after the transfer queue's release.
+    command_buffer.pipelineBarrier(stages, stages, vk::DependencyFlags{},
+        0, nullptr,
+        static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+        static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+}
+
+bool UploadService::beginBatch() {
+    if (batch_open_) return true;
+
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.level = vk::CommandBufferLevel::ePrimary;
+    alloc_info.commandPool = command_pool_;
+    alloc_info.commandBufferCount = 1;
+
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    try {
+        open_batch_ = Batch{};
+        open_batch_.command_buffer = device_.allocateCommandBuffers(alloc_info)[0];
+        open_batch_.command_buffer.begin(begin_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to begin upload batch: {}", e.what());
+        return false;
+    }
+
+    open_batch_.ticket = next_ticket_++;
+    batch_open_ = true;
+    return true;
+}
+
+bool UploadService::createStagingBuffer(const void* data, vk::DeviceSize size, StagingBuffer& staging) {
+    if (!allocator_.createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        staging.buffer, staging.allocation)) {
+        LOGE("Failed to create upload staging buffer ({} bytes)", size);
+        return false;
+    }
+
+    memcpy(staging.allocation.mapped, data, static_cast<size_t>(size));
+    return true;
+}
+
+uint64_t UploadService::submitBatch() {
+    Batch& batch = open_batch_;
+    batch_open_ = false;
+
+    // Release barriers on a dedicated transfer queue only need to complete the
+    // transfer writes; the consumer stages are waited on by the acquire.
+    vk::PipelineStageFlags dst_stages = hasOwnershipTransfer()
+        ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe) : batch.dst_stages;
+
+    if (!batch.buffer_releases.empty() || !batch.image_releases.empty()) {
+        batch.command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dst_stages,
+            vk::DependencyFlags{}, 0, nullptr,
+            static_cast<uint32_t>(batch.buffer_releases.size()), batch.buffer_releases.data(),
+            static_cast<uint32_t>(batch.image_releases.size()), batch.image_releases.data());
+    }
+
+    try {
+        batch.command_buffer.end();
+        batch.fence = device_.createFence({});
+        if (hasOwnershipTransfer()) {
+            batch.semaphore = device_.createSemaphore({});
+        }
+
+        vk::SubmitInfo submit_info{};
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &batch.command_buffer;
+        if (batch.semaphore) {
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &batch.semaphore;
+        }
+
+        transfer_queue_.submit(submit_info, batch.fence);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to submit upload batch {}: {}", batch.ticket, e.what());
+        throw;
+    }
+
+    uint64_t ticket = batch.ticket;
+    submitted_batches_.push_back(std::move(batch));
+    return ticket;
+}
+
+void UploadService::retireBatches(bool wait_all) {
+    for (auto it = submitted_batches_.begin(); it != submitted_batches_.end();) {
+        Batch& batch = *it;
+
+        if (batch.fence) {
+            if (wait_all) {
+                device_.waitForFences(1, &batch.fence, VK_TRUE, UINT64_MAX);
+            }
+            else if (device_.getFenceStatus(batch.fence) != vk::Result::eSuccess) {
+                // Batches complete in submission order on a single queue.
+                break;
+            }
+
+            for (auto& staging : batch.staging_buffers) {
+                allocator_.destroyBuffer(staging.buffer, staging.allocation);
+            }
+            batch.staging_buffers.clear();
+
+            device_.destroyFence(batch.fence);
+            batch.fence = nullptr;
+            device_.freeCommandBuffers(command_pool_, batch.command_buffer);
+            completed_ticket_ = std::max(completed_ticket_, batch.ticket);
+        }
+
+        // A semaphore may only be destroyed once the frame that waited on it has finished.
+        bool semaphore_done = !batch.semaphore || wait_all ||
+            (batch.acquired && batch.acquire_frame + frames_in_flight_ <= frame_serial_);
+        if (!semaphore_done) {
+            ++it;
+            continue;
+        }
+
+        if (batch.semaphore) {
+            device_.destroySemaphore(batch.semaphore);
+        }
+        it = submitted_batches_.erase(it);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "gpu_allocator.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+// Streams buffer and image data to device-local resources on the transfer
+// queue without blocking the CPU or the graphics queue.
+//
+// Uploads are recorded into the currently open batch, one command buffer per
+// batch. flush() submits the batch with a fence; staging memory is released
+// once that fence has signaled. When the transfer queue belongs to a family
+// other than graphics, every resource is released by the transfer queue and
+// acquired by the graphics queue: acquire() records the matching acquire
+// barriers into the frame's command buffer and hands back the semaphore the
+// frame submission has to wait on.
+class UploadService {
+public:
+    UploadService(vk::Device device, GpuAllocator& allocator,
+        vk::Queue transfer_queue, uint32_t transfer_family, uint32_t graphics_family,
+        uint32_t frames_in_flight);
+    ~UploadService();
+
+    bool initialize();
+    void cleanup();
+
+    bool uploadBuffer(vk::Buffer buffer, const void* data, vk::DeviceSize size, vk::DeviceSize offset = 0,
+        vk::PipelineStageFlags dst_stage = vk::PipelineStageFlagBits::eVertexInput,
+        vk::AccessFlags dst_access = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead);
+
+    // Buffer offsets in `regions` are relative to `data`. The image is
+    // transitioned from eUndefined, so the whole subresource range is replaced.
+    bool uploadImage(vk::Image image, const void* data, vk::DeviceSize size,
+        const std::vector<vk::BufferImageCopy>& regions, const vk::ImageSubresourceRange& range,
+        vk::ImageLayout final_layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::PipelineStageFlags dst_stage = vk::PipelineStageFlagBits::eFragmentShader,
+        vk::AccessFlags dst_access = vk::AccessFlagBits::eShaderRead);
+
+    // Submits the open batch; returns its ticket, or the last ticket if nothing was pending.
+    uint64_t flush();
+    bool isComplete(uint64_t ticket);
+    void wait(uint64_t ticket);
+
+    // Graphics side, called once per frame by the renderer: beginFrame() after the
+    // frame's fence wait, acquire() before any pass that may read uploaded data.
+    void beginFrame();
+    void acquire(vk::CommandBuffer command_buffer,
+        std::vector<vk::Semaphore>& wait_semaphores, std::vector<vk::PipelineStageFlags>& wait_stages);
+
+    bool hasOwnershipTransfer() const { return transfer_family_ != graphics_family_; }
+
+private:
+    struct StagingBuffer {
+        vk::Buffer buffer;
+        GpuAllocation allocation;
+    };
+
+    struct Batch {
+        uint64_t ticket = 0;
+        vk::CommandBuffer command_buffer;
+        vk::Fence fence;
+        vk::Semaphore semaphore;
+        std::vector<StagingBuffer> staging_buffers;
+        std::vector<vk::BufferMemoryBarrier> buffer_releases;
+        std::vector<vk::ImageMemoryBarrier> image_releases;
+        std::vector<vk::BufferMemoryBarrier> buffer_acquires;
+        std::vector<vk::ImageMemoryBarrier> image_acquires;
+        vk::PipelineStageFlags dst_stages;
+        bool acquired = false;
+        uint64_t acquire_frame = 0;
+    };
+
+    bool beginBatch();
+    bool createStagingBuffer(const void* data, vk::DeviceSize size, StagingBuffer& staging);
+    uint64_t submitBatch();
+    void retireBatches(bool wait_all);
+
+    vk::Device device_;
+    GpuAllocator& allocator_;
+    vk::Queue transfer_queue_;
+    uint32_t transfer_family_;
+    uint32_t graphics_family_;
+    uint32_t frames_in_flight_;
+
+    vk::CommandPool command_pool_;
+
+    Batch open_batch_;
+    bool batch_open_;
+    std::deque<Batch> submitted_batches_;
+
+    uint64_t next_ticket_;
+    uint64_t completed_ticket_;
+    uint64_t frame_serial_;
+
+    std::mutex mutex_;
+};
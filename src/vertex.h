@@ -1,46 +1,115 @@
-#pragma once
-
-#include <vulkan/vulkan.hpp>
-#include <glm/glm.hpp>
-#include <array>
-
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 tex_coord;
-    glm::vec3 tangent;
-
-    static vk::VertexInputBindingDescription getBindingDescription() {
-        vk::VertexInputBindingDescription binding_description{};
-        binding_description.binding = 0;
-        binding_description.stride = sizeof(Vertex);
-        binding_description.inputRate = vk::VertexInputRate::eVertex;
-        return binding_description;
-    }
-
-    static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions() {
-        std::array<vk::VertexInputAttributeDescription, 4> attribute_descriptions{};
-        
-        attribute_descriptions[0].binding = 0;
-        attribute_descriptions[0].location = 0;
-        attribute_descriptions[0].format = vk::Format::eR32G32B32Sfloat;
-        attribute_descriptions[0].offset = offsetof(Vertex, position);
-        
-        attribute_descriptions[1].binding = 0;
-        attribute_descriptions[1].location = 1;
-        attribute_descriptions[1].format = vk::Format::eR32G32B32Sfloat;
-        attribute_descriptions[1].offset = offsetof(Vertex, normal);
-        
-        attribute_descriptions[2].binding = 0;
-        attribute_descriptions[2].location = 2;
-        attribute_descriptions[2].format = vk::Format::eR32G32Sfloat;
-        attribute_descriptions[2].offset = offsetof(Vertex, tex_coord);
-        
-        attribute_descriptions[3].binding = 0;
-        attribute_descriptions[3].location = 3;
-        attribute_descriptions[3].format = vk::Format::eR32G32B32Sfloat;
-        attribute_descriptions[3].offset = offsetof(Vertex, tangent);
-
-        return attribute_descriptions;
-    }
-};
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+
+// Object-space bounds of a mesh, used for GPU culling. A negative radius
+// marks a mesh without bounds, which is never culled.
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;
+};
+
+// One level of detail: a range of the mesh's index buffer, all levels sharing
+// its vertex buffer. `error` is the surface deviation of the level relative to
+// the mesh's bounding radius, so it holds at any object scale.
+struct MeshLod {
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+    float error = 0.0f;
+};
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 tex_coord;
+    glm::vec3 tangent;
+
+    static vk::VertexInputBindingDescription getBindingDescription() {
+        vk::VertexInputBindingDescription binding_description{};
+        binding_description.binding = 0;
+        binding_description.stride = sizeof(Vertex);
+        binding_description.inputRate = vk::VertexInputRate::eVertex;
+        return binding_description;
+    }
+
+    static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions() {
+        std::array<vk::VertexInputAttributeDescription, 4> attribute_descriptions{};
+        
+        attribute_descriptions[0].binding = 0;
+        attribute_descriptions[0].location = 0;
+        attribute_descriptions[0].format = vk::Format::eR32G32B32Sfloat;
+        attribute_descriptions[0].offset = offsetof(Vertex, position);
+        
+        attribute_descriptions[1].binding = 0;
+        attribute_descriptions[1].location = 1;
+        attribute_descriptions[1].format = vk::Format::eR32G32B32Sfloat;
+        attribute_descriptions[1].offset = offsetof(Vertex, normal);
+        
+        attribute_descriptions[2].binding = 0;
+        attribute_descriptions[2].location = 2;
+        attribute_descriptions[2].format = vk::Format::eR32G32Sfloat;
+        attribute_descriptions[2].offset = offsetof(Vertex, tex_coord);
+        
+        attribute_descriptions[3].binding = 0;
+        attribute_descriptions[3].location = 3;
+        attribute_descriptions[3].format = vk::Format::eR32G32B32Sfloat;
+        attribute_descriptions[3].offset = offsetof(Vertex, tangent);
+
+        return attribute_descriptions;
+    }
+};
+
+// Layout of the vertex buffer of a mesh. Packed meshes store PackedVertex and
+// are drawn with the PACKED_VERTEX variant of default.vert.
+enum class VertexFormat {
+    Full,
+    Packed
+};
+
+// Quantized Vertex, 20 bytes instead of 44. The position is unorm16 within the
+// mesh's bounding box, so the box transform (Mesh::getPositionTransform) has
+// to be folded into the model matrix; its w holds the bitangent sign. Normal
+// and tangent are octahedral snorm16, the UV is fp16.
+struct PackedVertex {
+    uint16_t position[4];
+    uint32_t normal;
+    uint32_t tex_coord;
+    uint32_t tangent;
+
+    static vk::VertexInputBindingDescription getBindingDescription() {
+        vk::VertexInputBindingDescription binding_description{};
+        binding_description.binding = 0;
+        binding_description.stride = sizeof(PackedVertex);
+        binding_description.inputRate = vk::VertexInputRate::eVertex;
+        return binding_description;
+    }
+
+    static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions() {
+        std::array<vk::VertexInputAttributeDescription, 4> attribute_descriptions{};
+
+        attribute_descriptions[0].binding = 0;
+        attribute_descriptions[0].location = 0;
+        attribute_descriptions[0].format = vk::Format::eR16G16B16A16Unorm;
+        attribute_descriptions[0].offset = offsetof(PackedVertex, position);
+
+        attribute_descriptions[1].binding = 0;
+        attribute_descriptions[1].location = 1;
+        attribute_descriptions[1].format = vk::Format::eR16G16Snorm;
+        attribute_descriptions[1].offset = offsetof(PackedVertex, normal);
+
+        attribute_descriptions[2].binding = 0;
+        attribute_descriptions[2].location = 2;
+        attribute_descriptions[2].format = vk::Format::eR16G16Sfloat;
+        attribute_descriptions[2].offset = offsetof(PackedVertex, tex_coord);
+
+        attribute_descriptions[3].binding = 0;
+        attribute_descriptions[3].location = 3;
+        attribute_descriptions[3].format = vk::Format::eR16G16Snorm;
+        attribute_descriptions[3].offset = offsetof(PackedVertex, tangent);
+
+        return attribute_descriptions;
+    }
+};
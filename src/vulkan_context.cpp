@@ -1,478 +1,900 @@
-#include "vulkan_context.h"
-#include "utils/logger.h"
-#include <set>
-#include <algorithm>
-#include <limits>
-
-VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT messageType,
-    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-    void* pUserData) {
-    
-    if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
-        LOGW("Validation layer: {}", pCallbackData->pMessage);
-    }
-    
-    return VK_FALSE;
-}
-
-VulkanContext::VulkanContext() : window_(nullptr) {
-}
-
-VulkanContext::~VulkanContext() {
-    cleanup();
-}
-
-bool VulkanContext::initialize(GLFWwindow* window) {
-    window_ = window;
-
-    if (!createInstance()) {
-        LOGE("Failed to create Vulkan instance");
-        return false;
-    }
-
-    if (!setupDebugMessenger()) {
-        LOGE("Failed to setup debug messenger");
-        return false;
-    }
-
-    if (!createSurface()) {
-        LOGE("Failed to create window surface");
-        return false;
-    }
-
-    if (!pickPhysicalDevice()) {
-        LOGE("Failed to find a suitable GPU");
-        return false;
-    }
-
-    if (!createLogicalDevice()) {
-        LOGE("Failed to create logical device");
-        return false;
-    }
-
-    if (!createSwapChain()) {
-        LOGE("Failed to create swap chain");
-        return false;
-    }
-
-    if (!createImageViews()) {
-        LOGE("Failed to create image views");
-        return false;
-    }
-
-    if (!createCommandPool()) {
-        LOGE("Failed to create command pool");
-        return false;
-    }
-
-    LOGI("Vulkan context initialized successfully");
-    return true;
-}
-
-void VulkanContext::cleanup() {
-    if (device_) {
-        device_.waitIdle();
-        
-        cleanupSwapChain();
-        
-        if (command_pool_) {
-            device_.destroyCommandPool(command_pool_);
-        }
-        
-        device_.destroy();
-    }
-
-    if (instance_) {
-        if (enable_validation_layers_ && debug_messenger_) {
-            auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)instance_.getProcAddr("vkDestroyDebugUtilsMessengerEXT");
-            if (func != nullptr) {
-                func(instance_, debug_messenger_, nullptr);
-            }
-        }
-
-        if (surface_) {
-            instance_.destroySurfaceKHR(surface_);
-        }
-        
-        instance_.destroy();
-    }
-}
-
-bool VulkanContext::createInstance() {
-    vk::ApplicationInfo app_info{};
-    app_info.pApplicationName = "Vulkan Renderer";
-    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.pEngineName = "No Engine";
-    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
-
-    vk::InstanceCreateInfo create_info{};
-    create_info.pApplicationInfo = &app_info;
-
-    uint32_t glfw_extension_count = 0;
-    const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-    std::vector<const char*> extensions(glfw_extensions, glfw_extensions + glfw_extension_count);
-
-    if (enable_validation_layers_) {
-        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-    }
-
-    create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-    create_info.ppEnabledExtensionNames = extensions.data();
-
-    if (enable_validation_layers_) {
-        create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers_.size());
-        create_info.ppEnabledLayerNames = validation_layers_.data();
-    } else {
-        create_info.enabledLayerCount = 0;
-    }
-
-    try {
-        instance_ = vk::createInstance(create_info);
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("Failed to create instance: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanContext::setupDebugMessenger() {
-    if (!enable_validation_layers_) return true;
-
-    vk::DebugUtilsMessengerCreateInfoEXT create_info{};
-    create_info.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose |
-                                  vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning |
-                                  vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
-    create_info.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral |
-                              vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation |
-                              vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance;
-    create_info.pfnUserCallback = debugCallback;
-
-    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)instance_.getProcAddr("vkCreateDebugUtilsMessengerEXT");
-    if (func != nullptr) {
-        VkResult result = func(instance_, reinterpret_cast<const VkDebugUtilsMessengerCreateInfoEXT*>(&create_info), nullptr, reinterpret_cast<VkDebugUtilsMessengerEXT*>(&debug_messenger_));
-        return result == VK_SUCCESS;
-    }
-
-    return false;
-}
-
-bool VulkanContext::createSurface() {
-    VkSurfaceKHR surface;
-    VkResult result = glfwCreateWindowSurface(instance_, window_, nullptr, &surface);
-    surface_ = surface;
-    return result == VK_SUCCESS;
-}
-
-bool VulkanContext::pickPhysicalDevice() {
-    auto devices = instance_.enumeratePhysicalDevices();
-
-    if (devices.empty()) {
-        LOGE("Failed to find GPUs with Vulkan support");
-        return false;
-    }
-
-    for (const auto& device : devices) {
-        if (isDeviceSuitable(device)) {
-            physical_device_ = device;
-            break;
-        }
-    }
-
-    if (!physical_device_) {
-        LOGE("Failed to find a suitable GPU");
-        return false;
-    }
-
-    return true;
-}
-
-bool VulkanContext::createLogicalDevice() {
-    QueueFamilyIndices indices = findQueueFamilies(physical_device_);
-
-    std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = {indices.graphics_family.value(), indices.present_family.value()};
-
-    float queue_priority = 1.0f;
-    for (uint32_t queue_family : unique_queue_families) {
-        vk::DeviceQueueCreateInfo queue_create_info{};
-        queue_create_info.queueFamilyIndex = queue_family;
-        queue_create_info.queueCount = 1;
-        queue_create_info.pQueuePriorities = &queue_priority;
-        queue_create_infos.push_back(queue_create_info);
-    }
-
-    vk::PhysicalDeviceFeatures device_features{};
-    device_features.samplerAnisotropy = VK_TRUE;
-
-    vk::DeviceCreateInfo create_info{};
-    create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
-    create_info.pQueueCreateInfos = queue_create_infos.data();
-    create_info.pEnabledFeatures = &device_features;
-    create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions_.size());
-    create_info.ppEnabledExtensionNames = device_extensions_.data();
-
-    if (enable_validation_layers_) {
-        create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers_.size());
-        create_info.ppEnabledLayerNames = validation_layers_.data();
-    } else {
-        create_info.enabledLayerCount = 0;
-    }
-
-    try {
-        device_ = physical_device_.createDevice(create_info);
-        graphics_queue_ = device_.getQueue(indices.graphics_family.value(), 0);
-        present_queue_ = device_.getQueue(indices.present_family.value(), 0);
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("Failed to create logical device: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanContext::createSwapChain() {
-    SwapChainSupportDetails swap_chain_support = querySwapChainSupport(physical_device_);
-
-    vk::SurfaceFormatKHR surface_format = chooseSwapSurfaceFormat(swap_chain_support.formats);
-    vk::PresentModeKHR present_mode = chooseSwapPresentMode(swap_chain_support.present_modes);
-    vk::Extent2D extent = chooseSwapExtent(swap_chain_support.capabilities);
-
-    uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
-    if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount) {
-        image_count = swap_chain_support.capabilities.maxImageCount;
-    }
-
-    vk::SwapchainCreateInfoKHR create_info{};
-    create_info.surface = surface_;
-    create_info.minImageCount = image_count;
-    create_info.imageFormat = surface_format.format;
-    create_info.imageColorSpace = surface_format.colorSpace;
-    create_info.imageExtent = extent;
-    create_info.imageArrayLayers = 1;
-    create_info.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
-
-    QueueFamilyIndices indices = findQueueFamilies(physical_device_);
-    uint32_t queue_family_indices[] = {indices.graphics_family.value(), indices.present_family.value()};
-
-    if (indices.graphics_family != indices.present_family) {
-        create_info.imageSharingMode = vk::SharingMode::eConcurrent;
-        create_info.queueFamilyIndexCount = 2;
-        create_info.pQueueFamilyIndices = queue_family_indices;
-    } else {
-        create_info.imageSharingMode = vk::SharingMode::eExclusive;
-    }
-
-    create_info.preTransform = swap_chain_support.capabilities.currentTransform;
-    create_info.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
-    create_info.presentMode = present_mode;
-    create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = nullptr;
-
-    try {
-        swap_chain_ = device_.createSwapchainKHR(create_info);
-        swap_chain_images_ = device_.getSwapchainImagesKHR(swap_chain_);
-        swap_chain_image_format_ = surface_format.format;
-        swap_chain_extent_ = extent;
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("Failed to create swap chain: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanContext::createImageViews() {
-    swap_chain_image_views_.resize(swap_chain_images_.size());
-
-    for (size_t i = 0; i < swap_chain_images_.size(); i++) {
-        vk::ImageViewCreateInfo create_info{};
-        create_info.image = swap_chain_images_[i];
-        create_info.viewType = vk::ImageViewType::e2D;
-        create_info.format = swap_chain_image_format_;
-        create_info.components.r = vk::ComponentSwizzle::eIdentity;
-        create_info.components.g = vk::ComponentSwizzle::eIdentity;
-        create_info.components.b = vk::ComponentSwizzle::eIdentity;
-        create_info.components.a = vk::ComponentSwizzle::eIdentity;
-        create_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-        create_info.subresourceRange.baseMipLevel = 0;
-        create_info.subresourceRange.levelCount = 1;
-        create_info.subresourceRange.baseArrayLayer = 0;
-        create_info.subresourceRange.layerCount = 1;
-
-        try {
-            swap_chain_image_views_[i] = device_.createImageView(create_info);
-        } catch (const std::exception& e) {
-            LOGE("Failed to create image view {}: {}", i, e.what());
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool VulkanContext::createCommandPool() {
-    QueueFamilyIndices queue_family_indices = findQueueFamilies(physical_device_);
-
-    vk::CommandPoolCreateInfo pool_info{};
-    pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
-    pool_info.queueFamilyIndex = queue_family_indices.graphics_family.value();
-
-    try {
-        command_pool_ = device_.createCommandPool(pool_info);
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("Failed to create command pool: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice device) {
-    QueueFamilyIndices indices = findQueueFamilies(device);
-    bool extensions_supported = checkDeviceExtensionSupport(device);
-    
-    bool swap_chain_adequate = false;
-    if (extensions_supported) {
-        SwapChainSupportDetails swap_chain_support = querySwapChainSupport(device);
-        swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
-    }
-
-    return indices.isComplete() && extensions_supported && swap_chain_adequate;
-}
-
-QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice device) {
-    QueueFamilyIndices indices;
-    auto queue_families = device.getQueueFamilyProperties();
-
-    int i = 0;
-    for (const auto& queue_family : queue_families) {
-        if (queue_family.queueFlags & vk::QueueFlagBits::eGraphics) {
-            indices.graphics_family = i;
-        }
-
-        vk::Bool32 present_support = device.getSurfaceSupportKHR(i, surface_);
-        if (present_support) {
-            indices.present_family = i;
-        }
-
-        if (indices.isComplete()) {
-            break;
-        }
-
-        i++;
-    }
-
-    return indices;
-}
-
-bool VulkanContext::checkDeviceExtensionSupport(vk::PhysicalDevice device) {
-    auto available_extensions = device.enumerateDeviceExtensionProperties();
-
-    std::set<std::string> required_extensions(device_extensions_.begin(), device_extensions_.end());
-
-    for (const auto& extension : available_extensions) {
-        required_extensions.erase(extension.extensionName);
-    }
-
-    return required_extensions.empty();
-}
-
-SwapChainSupportDetails VulkanContext::querySwapChainSupport(vk::PhysicalDevice device) {
-    SwapChainSupportDetails details;
-    details.capabilities = device.getSurfaceCapabilitiesKHR(surface_);
-    details.formats = device.getSurfaceFormatsKHR(surface_);
-    details.present_modes = device.getSurfacePresentModesKHR(surface_);
-    return details;
-}
-
-vk::SurfaceFormatKHR VulkanContext::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats) {
-    for (const auto& available_format : available_formats) {
-        if (available_format.format == vk::Format::eB8G8R8A8Srgb && 
-            available_format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
-            return available_format;
-        }
-    }
-    return available_formats[0];
-}
-
-vk::PresentModeKHR VulkanContext::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes) {
-    for (const auto& available_present_mode : available_present_modes) {
-        if (available_present_mode == vk::PresentModeKHR::eMailbox) {
-            return available_present_mode;
-        }
-    }
-    return vk::PresentModeKHR::eFifo;
-}
-
-vk::Extent2D VulkanContext::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) {
-    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-        return capabilities.currentExtent;
-    } else {
-        int width, height;
-        glfwGetFramebufferSize(window_, &width, &height);
-
-        vk::Extent2D actual_extent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
-
-        actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-        actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-
-        return actual_extent;
-    }
-}
-
-vk::CommandBuffer VulkanContext::beginSingleTimeCommands() {
-    vk::CommandBufferAllocateInfo alloc_info{};
-    alloc_info.level = vk::CommandBufferLevel::ePrimary;
-    alloc_info.commandPool = command_pool_;
-    alloc_info.commandBufferCount = 1;
-
-    vk::CommandBuffer command_buffer = device_.allocateCommandBuffers(alloc_info)[0];
-
-    vk::CommandBufferBeginInfo begin_info{};
-    begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-    command_buffer.begin(begin_info);
-    return command_buffer;
-}
-
-void VulkanContext::endSingleTimeCommands(vk::CommandBuffer command_buffer) {
-    command_buffer.end();
-
-    vk::SubmitInfo submit_info{};
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffer;
-
-    graphics_queue_.submit(submit_info, nullptr);
-    graphics_queue_.waitIdle();
-
-    device_.freeCommandBuffers(command_pool_, command_buffer);
-}
-
-bool VulkanContext::recreateSwapChain() {
-    int width = 0, height = 0;
-    glfwGetFramebufferSize(window_, &width, &height);
-    while (width == 0 || height == 0) {
-        glfwGetFramebufferSize(window_, &width, &height);
-        glfwWaitEvents();
-    }
-
-    device_.waitIdle();
-
-    cleanupSwapChain();
-
-    return createSwapChain() && createImageViews();
-}
-
-void VulkanContext::cleanupSwapChain() {
-    for (auto image_view : swap_chain_image_views_) {
-        device_.destroyImageView(image_view);
-    }
-    
-    if (swap_chain_) {
-        device_.destroySwapchainKHR(swap_chain_);
-    }
-}
+#include "vulkan_context.h"
+#include "utils/logger.h"
+#include <set>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT messageType,
+    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+    void* pUserData) {
+    
+    if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+        LOGW("Validation layer: {}", pCallbackData->pMessage);
+    }
+    
+    return VK_FALSE;
+}
+
+VulkanContext::VulkanContext()
+    : window_(nullptr), headless_(false), vsync_enabled_(true), properties2_enabled_(false), descriptor_indexing_supported_(false),
+    present_wait_supported_(false), vulkan13_path_allowed_(true), dynamic_rendering_supported_(false),
+    push_descriptor_supported_(false), bindless_max_textures_(0), cmd_begin_rendering_(nullptr),
+    cmd_end_rendering_(nullptr), cmd_push_descriptor_set_(nullptr), recorded_frame_(0), completed_frame_(0) {
+}
+
+VulkanContext::~VulkanContext() {
+    cleanup();
+}
+
+bool VulkanContext::initialize(GLFWwindow* window) {
+    window_ = window;
+
+    if (!createInstance()) {
+        LOGE("Failed to create Vulkan instance");
+        return false;
+    }
+
+    if (!setupDebugMessenger()) {
+        LOGE("Failed to setup debug messenger");
+        return false;
+    }
+
+    if (!headless_ && !createSurface()) {
+        LOGE("Failed to create window surface");
+        return false;
+    }
+
+    if (!pickPhysicalDevice()) {
+        LOGE("Failed to find a suitable GPU");
+        return false;
+    }
+    descriptor_indexing_supported_ = queryDescriptorIndexing();
+    present_wait_supported_ = queryPresentWait();
+    dynamic_rendering_supported_ = queryDynamicRendering();
+    push_descriptor_supported_ = queryPushDescriptors();
+
+    if (!createLogicalDevice()) {
+        LOGE("Failed to create logical device");
+        return false;
+    }
+    loadDeviceFunctions();
+
+    if (!createAllocator()) {
+        LOGE("Failed to create GPU memory allocator");
+        return false;
+    }
+
+    if (!createPipelineCache()) {
+        LOGE("Failed to create pipeline cache");
+        return false;
+    }
+
+    if (!createUniformRing()) {
+        LOGE("Failed to create uniform ring");
+        return false;
+    }
+
+    if (!createBindlessTable()) {
+        LOGE("Failed to create bindless table");
+        return false;
+    }
+
+    if (headless_ ? !createOffscreenImages() : !createSwapChain()) {
+        LOGE("Failed to create swap chain");
+        return false;
+    }
+
+    if (!createImageViews()) {
+        LOGE("Failed to create image views");
+        return false;
+    }
+
+    if (!createCommandPool()) {
+        LOGE("Failed to create command pool");
+        return false;
+    }
+
+    if (!createUploadService()) {
+        LOGE("Failed to create upload service");
+        return false;
+    }
+
+    LOGI("Vulkan context initialized successfully");
+    return true;
+}
+
+bool VulkanContext::initializeHeadless(vk::Extent2D extent) {
+    headless_ = true;
+    swap_chain_extent_ = extent;
+    return initialize(nullptr);
+}
+
+void VulkanContext::cleanup() {
+    if (device_) {
+        device_.waitIdle();
+        destroyRetired();
+        
+        cleanupSwapChain();
+        
+        if (command_pool_) {
+            device_.destroyCommandPool(command_pool_);
+        }
+
+        upload_service_.reset();
+        bindless_table_.reset();
+        uniform_ring_.reset();
+
+        if (pipeline_cache_) {
+            pipeline_cache_->save();
+            pipeline_cache_.reset();
+        }
+
+        if (allocator_) {
+            allocator_->logStatistics();
+            allocator_.reset();
+        }
+        
+        device_.destroy();
+    }
+
+    if (instance_) {
+        if (enable_validation_layers_ && debug_messenger_) {
+            auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)instance_.getProcAddr("vkDestroyDebugUtilsMessengerEXT");
+            if (func != nullptr) {
+                func(instance_, debug_messenger_, nullptr);
+            }
+        }
+
+        if (surface_) {
+            instance_.destroySurfaceKHR(surface_);
+        }
+        
+        instance_.destroy();
+    }
+}
+
+bool VulkanContext::createInstance() {
+    vk::ApplicationInfo app_info{};
+    app_info.pApplicationName = "Vulkan Renderer";
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "No Engine";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_0;
+
+    vk::InstanceCreateInfo create_info{};
+    create_info.pApplicationInfo = &app_info;
+
+    std::vector<const char*> extensions;
+    if (!headless_) {
+        uint32_t glfw_extension_count = 0;
+        const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+        extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+    }
+
+    if (enable_validation_layers_) {
+        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
+
+    // Optional: the 1.0 instance needs it to query descriptor indexing.
+    for (const auto& extension : vk::enumerateInstanceExtensionProperties()) {
+        if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            properties2_enabled_ = true;
+            break;
+        }
+    }
+
+    create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    create_info.ppEnabledExtensionNames = extensions.data();
+
+    if (enable_validation_layers_) {
+        create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers_.size());
+        create_info.ppEnabledLayerNames = validation_layers_.data();
+    } else {
+        create_info.enabledLayerCount = 0;
+    }
+
+    try {
+        instance_ = vk::createInstance(create_info);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create instance: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanContext::setupDebugMessenger() {
+    if (!enable_validation_layers_) return true;
+
+    vk::DebugUtilsMessengerCreateInfoEXT create_info{};
+    create_info.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose |
+                                  vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning |
+                                  vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
+    create_info.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral |
+                              vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation |
+                              vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance;
+    create_info.pfnUserCallback = debugCallback;
+
+    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)instance_.getProcAddr("vkCreateDebugUtilsMessengerEXT");
+    if (func != nullptr) {
+        VkResult result = func(instance_, reinterpret_cast<const VkDebugUtilsMessengerCreateInfoEXT*>(&create_info), nullptr, reinterpret_cast<VkDebugUtilsMessengerEXT*>(&debug_messenger_));
+        return result == VK_SUCCESS;
+    }
+
+    return false;
+}
+
+bool VulkanContext::createSurface() {
+    VkSurfaceKHR surface;
+    VkResult result = glfwCreateWindowSurface(instance_, window_, nullptr, &surface);
+    surface_ = surface;
+    return result == VK_SUCCESS;
+}
+
+bool VulkanContext::pickPhysicalDevice() {
+    auto devices = instance_.enumeratePhysicalDevices();
+
+    if (devices.empty()) {
+        LOGE("Failed to find GPUs with Vulkan support");
+        return false;
+    }
+
+    for (const auto& device : devices) {
+        if (isDeviceSuitable(device)) {
+            physical_device_ = device;
+            break;
+        }
+    }
+
+    if (!physical_device_) {
+        LOGE("Failed to find a suitable GPU");
+        return false;
+    }
+
+    return true;
+}
+
+bool VulkanContext::createLogicalDevice() {
+    QueueFamilyIndices indices = findQueueFamilies(physical_device_);
+
+    std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
+    std::set<uint32_t> unique_queue_families = {indices.graphics_family.value(), indices.present_family.value(),
+        indices.transfer_family.value()};
+
+    float queue_priority = 1.0f;
+    for (uint32_t queue_family : unique_queue_families) {
+        vk::DeviceQueueCreateInfo queue_create_info{};
+        queue_create_info.queueFamilyIndex = queue_family;
+        queue_create_info.queueCount = 1;
+        queue_create_info.pQueuePriorities = &queue_priority;
+        queue_create_infos.push_back(queue_create_info);
+    }
+
+    vk::PhysicalDeviceFeatures supported_features = physical_device_.getFeatures();
+
+    vk::PhysicalDeviceFeatures device_features{};
+    device_features.samplerAnisotropy = VK_TRUE;
+    device_features.drawIndirectFirstInstance = VK_TRUE;
+    // Optional: block-compressed textures are rejected per format when missing.
+    device_features.textureCompressionBC = supported_features.textureCompressionBC;
+    device_features.textureCompressionASTC_LDR = supported_features.textureCompressionASTC_LDR;
+    // Optional: the profiler skips pipeline statistics without them.
+    device_features.pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery;
+    device_features.inheritedQueries = supported_features.inheritedQueries;
+
+    // Headless devices present nothing and need no swap chain extension.
+    std::vector<const char*> extensions = headless_ ? std::vector<const char*>{} : device_extensions_;
+    void* feature_chain = nullptr;
+
+    // Optional: without it materials keep their own descriptor sets.
+    vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+    if (descriptor_indexing_supported_) {
+        extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        // default.frag indexes the texture array with a material's index.
+        device_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        indexing_features.runtimeDescriptorArray = VK_TRUE;
+        indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+        indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        indexing_features.pNext = feature_chain;
+        feature_chain = &indexing_features;
+    }
+
+    // Optional: the frame pacer falls back to a frame limiter.
+    vk::PhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    vk::PhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    if (present_wait_supported_) {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        present_id_features.presentId = VK_TRUE;
+        present_id_features.pNext = feature_chain;
+        present_wait_features.presentWait = VK_TRUE;
+        present_wait_features.pNext = &present_id_features;
+        feature_chain = &present_wait_features;
+    }
+
+    // Optional: the render graph falls back to render passes and framebuffers.
+    // On the 1.0 instance the extension needs the ones it was built on.
+    vk::PhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+    if (dynamic_rendering_supported_) {
+        extensions.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        dynamic_rendering_features.dynamicRendering = VK_TRUE;
+        dynamic_rendering_features.pNext = feature_chain;
+        feature_chain = &dynamic_rendering_features;
+    }
+
+    // Optional: materials allocate and update descriptor sets instead.
+    if (push_descriptor_supported_) {
+        extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    }
+
+    vk::DeviceCreateInfo create_info{};
+    create_info.pNext = feature_chain;
+    create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
+    create_info.pQueueCreateInfos = queue_create_infos.data();
+    create_info.pEnabledFeatures = &device_features;
+    create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    create_info.ppEnabledExtensionNames = extensions.data();
+
+    if (enable_validation_layers_) {
+        create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers_.size());
+        create_info.ppEnabledLayerNames = validation_layers_.data();
+    } else {
+        create_info.enabledLayerCount = 0;
+    }
+
+    try {
+        device_ = physical_device_.createDevice(create_info);
+        graphics_queue_ = device_.getQueue(indices.graphics_family.value(), 0);
+        present_queue_ = device_.getQueue(indices.present_family.value(), 0);
+        transfer_queue_ = device_.getQueue(indices.transfer_family.value(), 0);
+        queue_family_indices_ = indices;
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create logical device: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanContext::createPipelineCache() {
+    pipeline_cache_ = std::make_unique<PipelineCache>(device_, physical_device_);
+    return pipeline_cache_->initialize(PIPELINE_CACHE_PATH);
+}
+
+bool VulkanContext::createUploadService() {
+    upload_service_ = std::make_unique<UploadService>(device_, *allocator_, transfer_queue_,
+        queue_family_indices_.transfer_family.value(), queue_family_indices_.graphics_family.value(),
+        MAX_FRAMES_IN_FLIGHT);
+    return upload_service_->initialize();
+}
+
+bool VulkanContext::createAllocator() {
+    try {
+        allocator_ = std::make_unique<GpuAllocator>(physical_device_, device_);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create allocator: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanContext::createUniformRing() {
+    uniform_ring_ = std::make_unique<UniformRing>(device_, *allocator_, physical_device_.getProperties().limits);
+    return uniform_ring_->initialize(MAX_FRAMES_IN_FLIGHT, UNIFORM_RING_SLOTS_PER_FRAME, UNIFORM_RING_SLOT_SIZE);
+}
+
+bool VulkanContext::createBindlessTable() {
+    if (!descriptor_indexing_supported_) {
+        LOGI("Descriptor indexing unavailable, materials bind their own descriptor sets");
+        return true;
+    }
+
+    bindless_table_ = std::make_unique<BindlessTable>(device_, *allocator_);
+    return bindless_table_->initialize(bindless_max_textures_, MAX_BINDLESS_MATERIALS);
+}
+
+bool VulkanContext::createSwapChain() {
+    SwapChainSupportDetails swap_chain_support = querySwapChainSupport(physical_device_);
+
+    vk::SurfaceFormatKHR surface_format = chooseSwapSurfaceFormat(swap_chain_support.formats);
+    vk::PresentModeKHR present_mode = chooseSwapPresentMode(swap_chain_support.present_modes);
+    vk::Extent2D extent = chooseSwapExtent(swap_chain_support.capabilities);
+
+    uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
+    if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount) {
+        image_count = swap_chain_support.capabilities.maxImageCount;
+    }
+
+    vk::SwapchainCreateInfoKHR create_info{};
+    create_info.surface = surface_;
+    create_info.minImageCount = image_count;
+    create_info.imageFormat = surface_format.format;
+    create_info.imageColorSpace = surface_format.colorSpace;
+    create_info.imageExtent = extent;
+    create_info.imageArrayLayers = 1;
+    create_info.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
+
+    const QueueFamilyIndices& indices = queue_family_indices_;
+    uint32_t queue_family_indices[] = {indices.graphics_family.value(), indices.present_family.value()};
+
+    if (indices.graphics_family != indices.present_family) {
+        create_info.imageSharingMode = vk::SharingMode::eConcurrent;
+        create_info.queueFamilyIndexCount = 2;
+        create_info.pQueueFamilyIndices = queue_family_indices;
+    } else {
+        create_info.imageSharingMode = vk::SharingMode::eExclusive;
+    }
+
+    create_info.preTransform = swap_chain_support.capabilities.currentTransform;
+    create_info.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
+    create_info.presentMode = present_mode;
+    create_info.clipped = VK_TRUE;
+    create_info.oldSwapchain = swap_chain_;
+
+    try {
+        swap_chain_ = device_.createSwapchainKHR(create_info);
+        swap_chain_images_ = device_.getSwapchainImagesKHR(swap_chain_);
+        swap_chain_image_format_ = surface_format.format;
+        swap_chain_extent_ = extent;
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create swap chain: {}", e.what());
+        return false;
+    }
+}
+
+// Stand-ins for swap chain images: one color target per frame slot, copied
+// back to the host instead of presented.
+bool VulkanContext::createOffscreenImages() {
+    vk::ImageCreateInfo image_info{};
+    image_info.imageType = vk::ImageType::e2D;
+    image_info.format = OFFSCREEN_FORMAT;
+    image_info.extent = vk::Extent3D{ swap_chain_extent_.width, swap_chain_extent_.height, 1 };
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = vk::SampleCountFlagBits::e1;
+    image_info.tiling = vk::ImageTiling::eOptimal;
+    image_info.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+    image_info.sharingMode = vk::SharingMode::eExclusive;
+    image_info.initialLayout = vk::ImageLayout::eUndefined;
+
+    swap_chain_images_.resize(MAX_FRAMES_IN_FLIGHT);
+    offscreen_allocations_.resize(MAX_FRAMES_IN_FLIGHT);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if (!allocator_->createImage(image_info, vk::MemoryPropertyFlagBits::eDeviceLocal,
+            swap_chain_images_[i], offscreen_allocations_[i])) {
+            LOGE("Failed to create offscreen image {}", i);
+            return false;
+        }
+    }
+
+    swap_chain_image_format_ = OFFSCREEN_FORMAT;
+    LOGI("Headless: {} offscreen targets of {}x{}", MAX_FRAMES_IN_FLIGHT,
+        swap_chain_extent_.width, swap_chain_extent_.height);
+    return true;
+}
+
+bool VulkanContext::createImageViews() {
+    swap_chain_image_views_.resize(swap_chain_images_.size());
+
+    for (size_t i = 0; i < swap_chain_images_.size(); i++) {
+        vk::ImageViewCreateInfo create_info{};
+        create_info.image = swap_chain_images_[i];
+        create_info.viewType = vk::ImageViewType::e2D;
+        create_info.format = swap_chain_image_format_;
+        create_info.components.r = vk::ComponentSwizzle::eIdentity;
+        create_info.components.g = vk::ComponentSwizzle::eIdentity;
+        create_info.components.b = vk::ComponentSwizzle::eIdentity;
+        create_info.components.a = vk::ComponentSwizzle::eIdentity;
+        create_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+        create_info.subresourceRange.baseMipLevel = 0;
+        create_info.subresourceRange.levelCount = 1;
+        create_info.subresourceRange.baseArrayLayer = 0;
+        create_info.subresourceRange.layerCount = 1;
+
+        try {
+            swap_chain_image_views_[i] = device_.createImageView(create_info);
+        } catch (const std::exception& e) {
+            LOGE("Failed to create image view {}: {}", i, e.what());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VulkanContext::createCommandPool() {
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    pool_info.queueFamilyIndex = queue_family_indices_.graphics_family.value();
+
+    try {
+        command_pool_ = device_.createCommandPool(pool_info);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create command pool: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice device) {
+    QueueFamilyIndices indices = findQueueFamilies(device);
+    bool extensions_supported = headless_ || checkDeviceExtensionSupport(device);
+    
+    bool swap_chain_adequate = headless_;
+    if (extensions_supported && !headless_) {
+        SwapChainSupportDetails swap_chain_support = querySwapChainSupport(device);
+        swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
+    }
+
+    // Scene batches address their instances through firstInstance of indirect commands.
+    bool features_supported = device.getFeatures().drawIndirectFirstInstance;
+
+    return indices.isComplete() && extensions_supported && swap_chain_adequate && features_supported;
+}
+
+QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice device) {
+    QueueFamilyIndices indices;
+    auto queue_families = device.getQueueFamilyProperties();
+    bool transfer_only = false;
+
+    for (uint32_t i = 0; i < queue_families.size(); i++) {
+        const auto& flags = queue_families[i].queueFlags;
+
+        if (!indices.graphics_family.has_value() && (flags & vk::QueueFlagBits::eGraphics)) {
+            indices.graphics_family = i;
+        }
+
+        if (!indices.present_family.has_value() && !headless_ && device.getSurfaceSupportKHR(i, surface_)) {
+            indices.present_family = i;
+        }
+
+        // Prefer a transfer-only family (the copy engine), then any non-graphics one.
+        if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics)) {
+            bool family_transfer_only = !(flags & vk::QueueFlagBits::eCompute);
+            if (!indices.transfer_family.has_value() || (family_transfer_only && !transfer_only)) {
+                indices.transfer_family = i;
+                transfer_only = family_transfer_only;
+            }
+        }
+    }
+
+    if (!indices.transfer_family.has_value()) {
+        indices.transfer_family = indices.graphics_family;
+    }
+
+    // Nothing is presented headless; the graphics queue stands in.
+    if (headless_) {
+        indices.present_family = indices.graphics_family;
+    }
+
+    return indices;
+}
+
+bool VulkanContext::checkDeviceExtensionSupport(vk::PhysicalDevice device) {
+    auto available_extensions = device.enumerateDeviceExtensionProperties();
+
+    std::set<std::string> required_extensions(device_extensions_.begin(), device_extensions_.end());
+
+    for (const auto& extension : available_extensions) {
+        required_extensions.erase(extension.extensionName);
+    }
+
+    return required_extensions.empty();
+}
+
+// The bindless path needs update-after-bind sampler arrays and one descriptor
+// set more than the renderer binds otherwise. Both features and limits come through
+// VK_KHR_get_physical_device_properties2, which the loader does not export.
+bool VulkanContext::queryDescriptorIndexing() {
+    if (!properties2_enabled_) return false;
+
+    std::set<std::string> required_extensions = {
+        VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+    };
+    for (const auto& extension : physical_device_.enumerateDeviceExtensionProperties()) {
+        required_extensions.erase(extension.extensionName);
+    }
+    if (!required_extensions.empty()) return false;
+
+    if (physical_device_.getProperties().limits.maxBoundDescriptorSets <= BindlessTable::DESCRIPTOR_SET) return false;
+
+    auto get_features = (PFN_vkGetPhysicalDeviceFeatures2KHR)instance_.getProcAddr("vkGetPhysicalDeviceFeatures2KHR");
+    auto get_properties = (PFN_vkGetPhysicalDeviceProperties2KHR)instance_.getProcAddr("vkGetPhysicalDeviceProperties2KHR");
+    if (get_features == nullptr || get_properties == nullptr) return false;
+
+    vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+    vk::PhysicalDeviceFeatures2KHR features{};
+    features.pNext = &indexing_features;
+    get_features(physical_device_, reinterpret_cast<VkPhysicalDeviceFeatures2KHR*>(&features));
+
+    if (!features.features.shaderSampledImageArrayDynamicIndexing ||
+        !indexing_features.runtimeDescriptorArray || !indexing_features.descriptorBindingPartiallyBound ||
+        !indexing_features.descriptorBindingSampledImageUpdateAfterBind ||
+        !indexing_features.descriptorBindingUpdateUnusedWhilePending) {
+        return false;
+    }
+
+    vk::PhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties{};
+    vk::PhysicalDeviceProperties2KHR properties{};
+    properties.pNext = &indexing_properties;
+    get_properties(physical_device_, reinterpret_cast<VkPhysicalDeviceProperties2KHR*>(&properties));
+
+    bindless_max_textures_ = std::min({ MAX_BINDLESS_TEXTURES,
+        indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+        indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+        indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+    return bindless_max_textures_ > 0;
+}
+
+bool VulkanContext::queryPresentWait() {
+    if (headless_ || !properties2_enabled_) return false;
+
+    std::set<std::string> required_extensions = {
+        VK_KHR_PRESENT_ID_EXTENSION_NAME,
+        VK_KHR_PRESENT_WAIT_EXTENSION_NAME
+    };
+    for (const auto& extension : physical_device_.enumerateDeviceExtensionProperties()) {
+        required_extensions.erase(extension.extensionName);
+    }
+    if (!required_extensions.empty()) return false;
+
+    auto get_features = (PFN_vkGetPhysicalDeviceFeatures2KHR)instance_.getProcAddr("vkGetPhysicalDeviceFeatures2KHR");
+    if (get_features == nullptr) return false;
+
+    vk::PhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    vk::PhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.pNext = &present_id_features;
+    vk::PhysicalDeviceFeatures2KHR features{};
+    features.pNext = &present_wait_features;
+    get_features(physical_device_, reinterpret_cast<VkPhysicalDeviceFeatures2KHR*>(&features));
+
+    return present_id_features.presentId && present_wait_features.presentWait;
+}
+
+// Only offered on 1.3 devices, where the extensions are promoted and known
+// to be mature; older drivers keep the render pass path they were tested on.
+bool VulkanContext::queryDynamicRendering() {
+    if (!vulkan13_path_allowed_ || !properties2_enabled_) return false;
+    if (physical_device_.getProperties().apiVersion < VK_API_VERSION_1_3) return false;
+
+    std::set<std::string> required_extensions = {
+        VK_KHR_MULTIVIEW_EXTENSION_NAME,
+        VK_KHR_MAINTENANCE2_EXTENSION_NAME,
+        VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+        VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
+    };
+    for (const auto& extension : physical_device_.enumerateDeviceExtensionProperties()) {
+        required_extensions.erase(extension.extensionName);
+    }
+    if (!required_extensions.empty()) return false;
+
+    auto get_features = (PFN_vkGetPhysicalDeviceFeatures2KHR)instance_.getProcAddr("vkGetPhysicalDeviceFeatures2KHR");
+    if (get_features == nullptr) return false;
+
+    vk::PhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+    vk::PhysicalDeviceFeatures2KHR features{};
+    features.pNext = &dynamic_rendering_features;
+    get_features(physical_device_, reinterpret_cast<VkPhysicalDeviceFeatures2KHR*>(&features));
+
+    return dynamic_rendering_features.dynamicRendering;
+}
+
+bool VulkanContext::queryPushDescriptors() {
+    if (!vulkan13_path_allowed_ || !properties2_enabled_) return false;
+    if (physical_device_.getProperties().apiVersion < VK_API_VERSION_1_3) return false;
+
+    for (const auto& extension : physical_device_.enumerateDeviceExtensionProperties()) {
+        if (strcmp(extension.extensionName, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VulkanContext::loadDeviceFunctions() {
+    if (dynamic_rendering_supported_) {
+        cmd_begin_rendering_ = (PFN_vkCmdBeginRenderingKHR)device_.getProcAddr("vkCmdBeginRenderingKHR");
+        cmd_end_rendering_ = (PFN_vkCmdEndRenderingKHR)device_.getProcAddr("vkCmdEndRenderingKHR");
+        if (cmd_begin_rendering_ == nullptr || cmd_end_rendering_ == nullptr) {
+            LOGW("Dynamic rendering functions missing, using render passes");
+            dynamic_rendering_supported_ = false;
+        }
+    }
+
+    if (push_descriptor_supported_) {
+        cmd_push_descriptor_set_ = (PFN_vkCmdPushDescriptorSetKHR)device_.getProcAddr("vkCmdPushDescriptorSetKHR");
+        if (cmd_push_descriptor_set_ == nullptr) {
+            LOGW("Push descriptor function missing, using descriptor sets");
+            push_descriptor_supported_ = false;
+        }
+    }
+
+    LOGI("Dynamic rendering: {}, push descriptors: {}", dynamic_rendering_supported_ ? "on" : "off",
+        push_descriptor_supported_ ? "on" : "off");
+}
+
+void VulkanContext::cmdBeginRendering(vk::CommandBuffer command_buffer, const vk::RenderingInfoKHR& rendering_info) const {
+    cmd_begin_rendering_(command_buffer, reinterpret_cast<const VkRenderingInfoKHR*>(&rendering_info));
+}
+
+void VulkanContext::cmdEndRendering(vk::CommandBuffer command_buffer) const {
+    cmd_end_rendering_(command_buffer);
+}
+
+void VulkanContext::cmdPushDescriptorSet(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point,
+    vk::PipelineLayout layout, uint32_t set, uint32_t write_count, const vk::WriteDescriptorSet* writes) const {
+    cmd_push_descriptor_set_(command_buffer, static_cast<VkPipelineBindPoint>(bind_point), layout, set, write_count,
+        reinterpret_cast<const VkWriteDescriptorSet*>(writes));
+}
+
+SwapChainSupportDetails VulkanContext::querySwapChainSupport(vk::PhysicalDevice device) {
+    SwapChainSupportDetails details;
+    details.capabilities = device.getSurfaceCapabilitiesKHR(surface_);
+    details.formats = device.getSurfaceFormatsKHR(surface_);
+    details.present_modes = device.getSurfacePresentModesKHR(surface_);
+    return details;
+}
+
+vk::SurfaceFormatKHR VulkanContext::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats) {
+    for (const auto& available_format : available_formats) {
+        if (available_format.format == vk::Format::eB8G8R8A8Srgb && 
+            available_format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
+            return available_format;
+        }
+    }
+    return available_formats[0];
+}
+
+vk::PresentModeKHR VulkanContext::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes) {
+    if (!vsync_enabled_ && std::find(available_present_modes.begin(), available_present_modes.end(),
+        vk::PresentModeKHR::eImmediate) != available_present_modes.end()) {
+        return vk::PresentModeKHR::eImmediate;
+    }
+
+    for (const auto& available_present_mode : available_present_modes) {
+        if (available_present_mode == vk::PresentModeKHR::eMailbox) {
+            return available_present_mode;
+        }
+    }
+    return vk::PresentModeKHR::eFifo;
+}
+
+vk::Extent2D VulkanContext::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) {
+    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+        return capabilities.currentExtent;
+    } else {
+        int width, height;
+        glfwGetFramebufferSize(window_, &width, &height);
+
+        vk::Extent2D actual_extent = {
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height)
+        };
+
+        actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+
+        return actual_extent;
+    }
+}
+
+void VulkanContext::completeFrame(uint64_t frame) {
+    completed_frame_ = std::max(completed_frame_, frame);
+
+    // Fences signal in submission order, so the queue drains from the front.
+    while (!retired_resources_.empty() && retired_resources_.front().frame <= completed_frame_) {
+        std::function<void()> destroy = std::move(retired_resources_.front().destroy);
+        retired_resources_.pop_front();
+        destroy();
+    }
+}
+
+void VulkanContext::retire(std::function<void()> destroy) {
+    if (recorded_frame_ <= completed_frame_) {
+        destroy();
+        return;
+    }
+    retired_resources_.push_back({ recorded_frame_, std::move(destroy) });
+}
+
+void VulkanContext::destroyRetired() {
+    while (!retired_resources_.empty()) {
+        std::function<void()> destroy = std::move(retired_resources_.front().destroy);
+        retired_resources_.pop_front();
+        destroy();
+    }
+    completed_frame_ = recorded_frame_;
+}
+
+vk::CommandBuffer VulkanContext::beginSingleTimeCommands() {
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.level = vk::CommandBufferLevel::ePrimary;
+    alloc_info.commandPool = command_pool_;
+    alloc_info.commandBufferCount = 1;
+
+    vk::CommandBuffer command_buffer = device_.allocateCommandBuffers(alloc_info)[0];
+
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    command_buffer.begin(begin_info);
+    return command_buffer;
+}
+
+void VulkanContext::endSingleTimeCommands(vk::CommandBuffer command_buffer) {
+    command_buffer.end();
+
+    vk::SubmitInfo submit_info{};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+
+    vk::Fence fence = device_.createFence({});
+    graphics_queue_.submit(submit_info, fence);
+    device_.waitForFences(1, &fence, VK_TRUE, UINT64_MAX);
+    device_.destroyFence(fence);
+
+    device_.freeCommandBuffers(command_pool_, command_buffer);
+}
+
+bool VulkanContext::recreateSwapChain() {
+    // Offscreen targets keep their extent.
+    if (headless_) return true;
+
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window_, &width, &height);
+    while (width == 0 || height == 0) {
+        glfwGetFramebufferSize(window_, &width, &height);
+        glfwWaitEvents();
+    }
+
+    // Handing the old swapchain to the driver as oldSwapchain lets it finish
+    // queued presents while the new one is built. Frames in flight may still
+    // render into the old images, so the old views and swapchain are retired
+    // with them instead of waiting.
+    std::vector<vk::ImageView> old_image_views = std::move(swap_chain_image_views_);
+    swap_chain_image_views_.clear();
+
+    vk::SwapchainKHR old_swap_chain = swap_chain_;
+    bool created = createSwapChain();
+
+    // oldSwapchain is retired even when creation fails.
+    if (swap_chain_ == old_swap_chain) {
+        swap_chain_ = nullptr;
+    }
+    vk::Device device = device_;
+    retire([device, old_image_views, old_swap_chain]() {
+        for (auto image_view : old_image_views) {
+            device.destroyImageView(image_view);
+        }
+        if (old_swap_chain) device.destroySwapchainKHR(old_swap_chain);
+    });
+
+    return created && createImageViews();
+}
+
+void VulkanContext::cleanupSwapChain() {
+    for (auto image_view : swap_chain_image_views_) {
+        device_.destroyImageView(image_view);
+    }
+    
+    if (swap_chain_) {
+        device_.destroySwapchainKHR(swap_chain_);
+    }
+
+    for (size_t i = 0; i < offscreen_allocations_.size(); i++) {
+        allocator_->destroyImage(swap_chain_images_[i], offscreen_allocations_[i]);
+    }
+    offscreen_allocations_.clear();
+}
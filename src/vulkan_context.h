@@ -1,98 +1,199 @@
-#pragma once
-
-#include <vulkan/vulkan.hpp>
-#include <GLFW/glfw3.h>
-#include <vector>
-#include <optional>
-
-struct QueueFamilyIndices {
-    std::optional<uint32_t> graphics_family;
-    std::optional<uint32_t> present_family;
-
-    bool isComplete() {
-        return graphics_family.has_value() && present_family.has_value();
-    }
-};
-
-struct SwapChainSupportDetails {
-    vk::SurfaceCapabilitiesKHR capabilities;
-    std::vector<vk::SurfaceFormatKHR> formats;
-    std::vector<vk::PresentModeKHR> present_modes;
-};
-
-class VulkanContext {
-public:
-    VulkanContext();
-    ~VulkanContext();
-
-    bool initialize(GLFWwindow* window);
-    void cleanup();
-
-    vk::Instance getInstance() const { return instance_; }
-    vk::PhysicalDevice getPhysicalDevice() const { return physical_device_; }
-    vk::Device getDevice() const { return device_; }
-    vk::Queue getGraphicsQueue() const { return graphics_queue_; }
-    vk::Queue getPresentQueue() const { return present_queue_; }
-    vk::SurfaceKHR getSurface() const { return surface_; }
-    vk::SwapchainKHR getSwapChain() const { return swap_chain_; }
-    vk::Format getSwapChainImageFormat() const { return swap_chain_image_format_; }
-    vk::Extent2D getSwapChainExtent() const { return swap_chain_extent_; }
-    vk::CommandPool getCommandPool() const { return command_pool_; }
-
-    const std::vector<vk::Image>& getSwapChainImages() const { return swap_chain_images_; }
-    const std::vector<vk::ImageView>& getSwapChainImageViews() const { return swap_chain_image_views_; }
-
-    vk::CommandBuffer beginSingleTimeCommands();
-    void endSingleTimeCommands(vk::CommandBuffer command_buffer);
-
-    bool recreateSwapChain();
-
-private:
-    bool createInstance();
-    bool setupDebugMessenger();
-    bool createSurface();
-    bool pickPhysicalDevice();
-    bool createLogicalDevice();
-    bool createSwapChain();
-    bool createImageViews();
-    bool createCommandPool();
-
-    bool isDeviceSuitable(vk::PhysicalDevice device);
-    QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
-    bool checkDeviceExtensionSupport(vk::PhysicalDevice device);
-    SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice device);
-    vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats);
-    vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes);
-    vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities);
-
-    void cleanupSwapChain();
-
-    GLFWwindow* window_;
-    vk::Instance instance_;
-    vk::DebugUtilsMessengerEXT debug_messenger_;
-    vk::SurfaceKHR surface_;
-    vk::PhysicalDevice physical_device_;
-    vk::Device device_;
-    vk::Queue graphics_queue_;
-    vk::Queue present_queue_;
-    vk::SwapchainKHR swap_chain_;
-    std::vector<vk::Image> swap_chain_images_;
-    vk::Format swap_chain_image_format_;
-    vk::Extent2D swap_chain_extent_;
-    std::vector<vk::ImageView> swap_chain_image_views_;
-    vk::CommandPool command_pool_;
-
-    const std::vector<const char*> validation_layers_ = {
-        "VK_LAYER_KHRONOS_validation"
-    };
-
-    const std::vector<const char*> device_extensions_ = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
-
-    #ifdef NDEBUG
-        const bool enable_validation_layers_ = false;
-    #else
-        const bool enable_validation_layers_ = true;
-    #endif
-};
+#pragma once
+
+#include "gpu_allocator.h"
+#include "uniform_ring.h"
+#include "upload_service.h"
+#include "pipeline_cache.h"
+#include "bindless_table.h"
+#include <vulkan/vulkan.hpp>
+#include <GLFW/glfw3.h>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <deque>
+#include <functional>
+
+struct QueueFamilyIndices {
+    std::optional<uint32_t> graphics_family;
+    std::optional<uint32_t> present_family;
+    std::optional<uint32_t> transfer_family; // dedicated transfer family if any, else graphics
+
+    bool isComplete() {
+        return graphics_family.has_value() && present_family.has_value();
+    }
+};
+
+struct SwapChainSupportDetails {
+    vk::SurfaceCapabilitiesKHR capabilities;
+    std::vector<vk::SurfaceFormatKHR> formats;
+    std::vector<vk::PresentModeKHR> present_modes;
+};
+
+class VulkanContext {
+public:
+    // Capacity of every per-frame resource; the renderer may use fewer.
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+    VulkanContext();
+    ~VulkanContext();
+
+    bool initialize(GLFWwindow* window);
+    // No window, surface or swap chain: the swap chain getters describe
+    // MAX_FRAMES_IN_FLIGHT offscreen color targets of the given extent instead.
+    bool initializeHeadless(vk::Extent2D extent);
+    void cleanup();
+
+    // Off prefers immediate presents, then mailbox. Must be set before initialize().
+    void setVsyncEnabled(bool enabled) { vsync_enabled_ = enabled; }
+    // Off keeps Vulkan 1.3 devices on the render pass and descriptor set path
+    // of older ones. Must be set before initialize().
+    void setVulkan13PathEnabled(bool enabled) { vulkan13_path_allowed_ = enabled; }
+
+    bool isHeadless() const { return headless_; }
+
+    vk::Instance getInstance() const { return instance_; }
+    vk::PhysicalDevice getPhysicalDevice() const { return physical_device_; }
+    vk::Device getDevice() const { return device_; }
+    vk::Queue getGraphicsQueue() const { return graphics_queue_; }
+    vk::Queue getPresentQueue() const { return present_queue_; }
+    vk::Queue getTransferQueue() const { return transfer_queue_; }
+    const QueueFamilyIndices& getQueueFamilyIndices() const { return queue_family_indices_; }
+    vk::SurfaceKHR getSurface() const { return surface_; }
+    vk::SwapchainKHR getSwapChain() const { return swap_chain_; }
+    vk::Format getSwapChainImageFormat() const { return swap_chain_image_format_; }
+    vk::Extent2D getSwapChainExtent() const { return swap_chain_extent_; }
+    vk::CommandPool getCommandPool() const { return command_pool_; }
+    GpuAllocator& getAllocator() const { return *allocator_; }
+    UniformRing& getUniformRing() const { return *uniform_ring_; }
+    UploadService& getUploadService() const { return *upload_service_; }
+    vk::PipelineCache getPipelineCache() const { return pipeline_cache_->getHandle(); }
+    // Null without descriptor indexing support; callers keep their own sets then.
+    BindlessTable* getBindlessTable() const { return bindless_table_.get(); }
+    // VK_KHR_present_id and VK_KHR_present_wait are both enabled.
+    bool supportsPresentWait() const { return present_wait_supported_; }
+    // Vulkan 1.3 devices only. The 1.0 instance reaches both through their
+    // KHR extensions, recorded with the functions below.
+    bool supportsDynamicRendering() const { return dynamic_rendering_supported_; }
+    bool supportsPushDescriptors() const { return push_descriptor_supported_; }
+
+    void cmdBeginRendering(vk::CommandBuffer command_buffer, const vk::RenderingInfoKHR& rendering_info) const;
+    void cmdEndRendering(vk::CommandBuffer command_buffer) const;
+    void cmdPushDescriptorSet(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point,
+        vk::PipelineLayout layout, uint32_t set, uint32_t write_count, const vk::WriteDescriptorSet* writes) const;
+
+    const std::vector<vk::Image>& getSwapChainImages() const { return swap_chain_images_; }
+    const std::vector<vk::ImageView>& getSwapChainImageViews() const { return swap_chain_image_views_; }
+
+    // Frame serials for deferred destruction, main thread only. beginFrame()
+    // numbers the frame about to be recorded, completeFrame() reports a frame
+    // whose fence has signaled. A retired resource is destroyed once every
+    // frame recorded up to the retire() call has completed, so nothing waits
+    // for the device to go idle.
+    uint64_t beginFrame() { return ++recorded_frame_; }
+    void completeFrame(uint64_t frame);
+    void retire(std::function<void()> destroy);
+    // Destroys everything retired; the device must be idle.
+    void destroyRetired();
+
+    vk::CommandBuffer beginSingleTimeCommands();
+    void endSingleTimeCommands(vk::CommandBuffer command_buffer);
+
+    bool recreateSwapChain();
+
+private:
+    bool createInstance();
+    bool setupDebugMessenger();
+    bool createSurface();
+    bool pickPhysicalDevice();
+    bool createLogicalDevice();
+    bool createAllocator();
+    bool createPipelineCache();
+    bool createUniformRing();
+    bool createBindlessTable();
+    bool createSwapChain();
+    bool createOffscreenImages();
+    bool createImageViews();
+    bool createCommandPool();
+    bool createUploadService();
+
+    bool isDeviceSuitable(vk::PhysicalDevice device);
+    QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
+    bool checkDeviceExtensionSupport(vk::PhysicalDevice device);
+    bool queryDescriptorIndexing();
+    bool queryPresentWait();
+    bool queryDynamicRendering();
+    bool queryPushDescriptors();
+    void loadDeviceFunctions();
+    SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice device);
+    vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats);
+    vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes);
+    vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities);
+
+    void cleanupSwapChain();
+
+    GLFWwindow* window_;
+    vk::Instance instance_;
+    vk::DebugUtilsMessengerEXT debug_messenger_;
+    vk::SurfaceKHR surface_;
+    vk::PhysicalDevice physical_device_;
+    vk::Device device_;
+    vk::Queue graphics_queue_;
+    vk::Queue present_queue_;
+    vk::Queue transfer_queue_;
+    QueueFamilyIndices queue_family_indices_;
+    vk::SwapchainKHR swap_chain_;
+    std::vector<vk::Image> swap_chain_images_;
+    vk::Format swap_chain_image_format_;
+    vk::Extent2D swap_chain_extent_;
+    std::vector<vk::ImageView> swap_chain_image_views_;
+    std::vector<GpuAllocation> offscreen_allocations_;
+    vk::CommandPool command_pool_;
+    std::unique_ptr<GpuAllocator> allocator_;
+    std::unique_ptr<UniformRing> uniform_ring_;
+    std::unique_ptr<UploadService> upload_service_;
+    std::unique_ptr<PipelineCache> pipeline_cache_;
+    std::unique_ptr<BindlessTable> bindless_table_;
+
+    struct RetiredResource {
+        uint64_t frame;  // newest frame that may still use it
+        std::function<void()> destroy;
+    };
+    std::deque<RetiredResource> retired_resources_;
+    uint64_t recorded_frame_;
+    uint64_t completed_frame_;
+
+    bool headless_;
+    bool vsync_enabled_;
+    bool properties2_enabled_;
+    bool descriptor_indexing_supported_;
+    bool present_wait_supported_;
+    bool vulkan13_path_allowed_;
+    bool dynamic_rendering_supported_;
+    bool push_descriptor_supported_;
+    uint32_t bindless_max_textures_;
+
+    PFN_vkCmdBeginRenderingKHR cmd_begin_rendering_;
+    PFN_vkCmdEndRenderingKHR cmd_end_rendering_;
+    PFN_vkCmdPushDescriptorSetKHR cmd_push_descriptor_set_;
+
+    static constexpr uint32_t UNIFORM_RING_SLOTS_PER_FRAME = 1024;
+    static constexpr vk::DeviceSize UNIFORM_RING_SLOT_SIZE = 512;
+    static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+    static constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+    static constexpr uint32_t MAX_BINDLESS_MATERIALS = 1024;
+    static constexpr vk::Format OFFSCREEN_FORMAT = vk::Format::eR8G8B8A8Srgb;
+
+    const std::vector<const char*> validation_layers_ = {
+        "VK_LAYER_KHRONOS_validation"
+    };
+
+    const std::vector<const char*> device_extensions_ = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    };
+
+    #ifdef NDEBUG
+        const bool enable_validation_layers_ = false;
+    #else
+        const bool enable_validation_layers_ = true;
+    #endif
+};
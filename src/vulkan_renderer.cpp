@@ -1,922 +1,1645 @@
-﻿#include "vulkan_renderer.h"
-#include "model_loader.h"
-#include "utils/logger.h"
-#include <algorithm>
-#include <array>
-
-VulkanRenderer::VulkanRenderer()
-    : window_(nullptr), window_width_(800), window_height_(600),
-    window_title_("Vulkan Renderer"), framebuffer_resized_(false),
-    current_frame_(0), delta_time_(0.0f), first_mouse_(true),
-    last_x_(400.0), last_y_(300.0) {
-    last_time_ = std::chrono::steady_clock::now();
-}
-
-VulkanRenderer::~VulkanRenderer() {
-    cleanup();
-}
-
-bool VulkanRenderer::initialize(int width, int height, const std::string& title) {
-    window_width_ = width;
-    window_height_ = height;
-    window_title_ = title;
-
-    if (!initWindow()) {
-        LOGE("Failed to initialize window");
-        return false;
-    }
-
-    if (!initVulkan()) {
-        LOGE("Failed to initialize Vulkan");
-        return false;
-    }
-
-    camera_ = std::make_unique<Camera>(glm::vec3(2.0f, 1.5f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f), -105.0f, -15.0f);
-
-    LOGI("Vulkan Renderer initialized successfully");
-    return true;
-}
-
-void VulkanRenderer::run() {
-    mainLoop();
-}
-
-void VulkanRenderer::cleanup() {
-    if (context_) {
-        ui_overlay_.reset();
-
-        auto device = context_->getDevice();
-        device.waitIdle();
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            if (render_finished_semaphores_[i]) device.destroySemaphore(render_finished_semaphores_[i]);
-            if (image_available_semaphores_[i]) device.destroySemaphore(image_available_semaphores_[i]);
-            if (in_flight_fences_[i]) device.destroyFence(in_flight_fences_[i]);
-        }
-
-        if (depth_image_view_) device.destroyImageView(depth_image_view_);
-        if (depth_image_) device.destroyImage(depth_image_);
-        if (depth_image_memory_) device.freeMemory(depth_image_memory_);
-
-        for (auto framebuffer : swap_chain_framebuffers_) {
-            device.destroyFramebuffer(framebuffer);
-        }
-
-        if (graphics_pipeline_) device.destroyPipeline(graphics_pipeline_);
-        if (pipeline_layout_) device.destroyPipelineLayout(pipeline_layout_);
-
-        if (skybox_pipeline_) device.destroyPipeline(skybox_pipeline_);
-        if (skybox_pipeline_layout_) device.destroyPipelineLayout(skybox_pipeline_layout_);
-
-        if (render_pass_) device.destroyRenderPass(render_pass_);
-    }
-
-    mesh_.reset();
-    shader_.reset();
-    material_.reset();
-    skybox_.reset();
-    skybox_shader_.reset();
-    context_.reset();
-
-    if (window_) {
-        glfwDestroyWindow(window_);
-        glfwTerminate();
-    }
-}
-
-bool VulkanRenderer::loadModel(const std::string& obj_path) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-
-    if (!ModelLoader::loadOBJ(obj_path, vertices, indices)) {
-        LOGE("Failed to load model: {}", obj_path);
-        return false;
-    }
-
-    mesh_ = std::make_unique<Mesh>(context_);
-    if (!mesh_->create(vertices, indices)) {
-        LOGE("Failed to create mesh");
-        return false;
-    }
-
-    LOGI("Model loaded successfully: {}", obj_path);
-    return true;
-}
-
-bool VulkanRenderer::loadTexture(const std::string& texture_path) {
-    if (!material_) {
-        LOGE("Material not initialized, cannot load texture");
-        return false;
-    }
-    
-    auto texture = std::make_shared<Texture>(context_);
-
-    if (!texture->loadFromFile(texture_path)) {
-        LOGW("Failed to load texture from: {}, try to use default texture", texture_path);
-        if (!texture->loadFromFile(MODEL_DIR "default_texture.png")) {
-            LOGE("Cannot load default texture");
-            return false;
-        }
-        LOGI("Using default texture");
-    }
-    
-    if (!material_->setTexture(texture)) {
-        LOGE("Failed to set texture to material");
-        return false;
-    }
-    
-    return true;
-}
-
-bool VulkanRenderer::createDefaultSkyBox() {
-    LOGI("Creating default skybox");
-    
-    if (!skybox_) {
-        skybox_ = std::make_unique<SkyBox>(context_);
-        if (!skybox_->initialize()) {
-            LOGE("Failed to initialize skybox");
-            return false;
-        }
-    }
-    
-    if (!skybox_->createDefaultSkyBox()) {
-        LOGE("Failed to create default skybox");
-        return false;
-    }
-    
-    skybox_shader_ = std::make_unique<Shader>(context_);
-    if (!skybox_shader_->loadFromSource(SkyBox::getVertexShaderSource(),
-        SkyBox::getFragmentShaderSource())) {
-        LOGE("Failed to load skybox shaders");
-        return false;
-    }
-
-    if (!createSkyBoxPipeline()) {
-        LOGE("Failed to create skybox pipeline");
-        return false;
-    }
-
-    LOGI("Default skybox created successfully");
-    return true;
-}
-
-bool VulkanRenderer::initWindow() {
-    glfwInit();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-
-    window_ = glfwCreateWindow(window_width_, window_height_, window_title_.c_str(), nullptr, nullptr);
-    if (!window_) {
-        LOGE("Failed to create GLFW window");
-        return false;
-    }
-
-    glfwSetWindowUserPointer(window_, this);
-    glfwSetFramebufferSizeCallback(window_, framebufferResizeCallback);
-    glfwSetCursorPosCallback(window_, mouseCallback);
-    glfwSetScrollCallback(window_, scrollCallback);
-    glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    return true;
-}
-
-bool VulkanRenderer::initVulkan() {
-    context_ = std::make_shared<VulkanContext>();
-    if (!context_->initialize(window_)) {
-        return false;
-    }
-
-    if (!createRenderPass()) {
-        return false;
-    }
-
-    shader_ = std::make_unique<Shader>(context_);
-    if (!shader_->loadFromSource(shader_->getDefaultVertexShader(), shader_->getDefaultFragmentShader())) {
-        LOGE("Failed to load default shaders");
-        return false;
-    }
-
-    material_ = std::make_unique<Material>(context_);
-    if (!material_->initialize()) {
-        return false;
-    }
-
-    if (!createGraphicsPipeline()) {
-        return false;
-    }
-
-    if (!createDepthResources()) {
-        return false;
-    }
-
-    if (!createFramebuffers()) {
-        return false;
-    }
-
-    if (!createCommandBuffers()) {
-        return false;
-    }
-
-    if (!createSyncObjects()) {
-        return false;
-    }
-    
-    ui_overlay_ = std::make_unique<UIOverlay>(context_, window_);
-    if (!ui_overlay_->initialize(render_pass_)) {
-        LOGE("Failed to initialize UI overlay");
-        return false;
-    }
-
-    return true;
-}
-
-bool VulkanRenderer::createRenderPass() {
-    auto device = context_->getDevice();
-
-    vk::AttachmentDescription color_attachment{};
-    color_attachment.format = context_->getSwapChainImageFormat();
-    color_attachment.samples = vk::SampleCountFlagBits::e1;
-    color_attachment.loadOp = vk::AttachmentLoadOp::eClear;
-    color_attachment.storeOp = vk::AttachmentStoreOp::eStore;
-    color_attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
-    color_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    color_attachment.initialLayout = vk::ImageLayout::eUndefined;
-    color_attachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
-
-    vk::AttachmentDescription depth_attachment{};
-    depth_attachment.format = vk::Format::eD32Sfloat;
-    depth_attachment.samples = vk::SampleCountFlagBits::e1;
-    depth_attachment.loadOp = vk::AttachmentLoadOp::eClear;
-    depth_attachment.storeOp = vk::AttachmentStoreOp::eDontCare;
-    depth_attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
-    depth_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    depth_attachment.initialLayout = vk::ImageLayout::eUndefined;
-    depth_attachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
-
-    vk::AttachmentReference color_attachment_ref{};
-    color_attachment_ref.attachment = 0;
-    color_attachment_ref.layout = vk::ImageLayout::eColorAttachmentOptimal;
-
-    vk::AttachmentReference depth_attachment_ref{};
-    depth_attachment_ref.attachment = 1;
-    depth_attachment_ref.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
-
-    vk::SubpassDescription subpass{};
-    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment_ref;
-    subpass.pDepthStencilAttachment = &depth_attachment_ref;
-
-    vk::SubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    dependency.srcAccessMask = vk::AccessFlagBits::eNone;
-    dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-
-    std::array<vk::AttachmentDescription, 2> attachments = { color_attachment, depth_attachment };
-    vk::RenderPassCreateInfo render_pass_info{};
-    render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-    render_pass_info.pAttachments = attachments.data();
-    render_pass_info.subpassCount = 1;
-    render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
-
-    try {
-        render_pass_ = device.createRenderPass(render_pass_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create render pass: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanRenderer::createGraphicsPipeline() {
-    auto device = context_->getDevice();
-
-    vk::PipelineShaderStageCreateInfo vert_shader_stage_info{};
-    vert_shader_stage_info.stage = vk::ShaderStageFlagBits::eVertex;
-    vert_shader_stage_info.module = shader_->getVertexShader();
-    vert_shader_stage_info.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo frag_shader_stage_info{};
-    frag_shader_stage_info.stage = vk::ShaderStageFlagBits::eFragment;
-    frag_shader_stage_info.module = shader_->getFragmentShader();
-    frag_shader_stage_info.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, frag_shader_stage_info };
-
-    auto binding_description = Vertex::getBindingDescription();
-    auto attribute_descriptions = Vertex::getAttributeDescriptions();
-
-    vk::PipelineVertexInputStateCreateInfo vertex_input_info{};
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
-    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
-
-    vk::PipelineInputAssemblyStateCreateInfo input_assembly{};
-    input_assembly.topology = vk::PrimitiveTopology::eTriangleList;
-    input_assembly.primitiveRestartEnable = VK_FALSE;
-
-    vk::Viewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(context_->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(context_->getSwapChainExtent().height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    vk::Rect2D scissor{};
-    scissor.offset = vk::Offset2D{ 0, 0 };
-    scissor.extent = context_->getSwapChainExtent();
-
-    vk::PipelineViewportStateCreateInfo viewport_state{};
-    viewport_state.viewportCount = 1;
-    viewport_state.scissorCount = 1;
-
-    vk::PipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = vk::PolygonMode::eFill;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
-    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    vk::PipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-    vk::PipelineDepthStencilStateCreateInfo depth_stencil{};
-    depth_stencil.depthTestEnable = VK_TRUE;
-    depth_stencil.depthWriteEnable = VK_TRUE;
-    depth_stencil.depthCompareOp = vk::CompareOp::eLess;
-    depth_stencil.depthBoundsTestEnable = VK_FALSE;
-    depth_stencil.stencilTestEnable = VK_FALSE;
-
-    vk::PipelineColorBlendAttachmentState color_blend_attachment{};
-    color_blend_attachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    color_blend_attachment.blendEnable = VK_FALSE;
-
-    vk::PipelineColorBlendStateCreateInfo color_blending{};
-    color_blending.logicOpEnable = VK_FALSE;
-    color_blending.logicOp = vk::LogicOp::eCopy;
-    color_blending.attachmentCount = 1;
-    color_blending.pAttachments = &color_blend_attachment;
-
-    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
-    pipeline_layout_info.setLayoutCount = 1;
-    auto descriptor_set_layout = material_->getDescriptorSetLayout();
-    pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
-
-    try {
-        pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create pipeline layout: {}", e.what());
-        return false;
-    }
-
-    std::vector<vk::DynamicState> dynamic_states = {
-        vk::DynamicState::eViewport,
-        vk::DynamicState::eScissor
-    };
-
-    vk::PipelineDynamicStateCreateInfo dynamic_state{};
-    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
-    dynamic_state.pDynamicStates = dynamic_states.data();
-
-    vk::GraphicsPipelineCreateInfo pipeline_info{};
-    pipeline_info.stageCount = 2;
-    pipeline_info.pStages = shader_stages;
-    pipeline_info.pVertexInputState = &vertex_input_info;
-    pipeline_info.pInputAssemblyState = &input_assembly;
-    pipeline_info.pViewportState = &viewport_state;
-    pipeline_info.pRasterizationState = &rasterizer;
-    pipeline_info.pMultisampleState = &multisampling;
-    pipeline_info.pDepthStencilState = &depth_stencil;
-    pipeline_info.pColorBlendState = &color_blending;
-    pipeline_info.pDynamicState = &dynamic_state;
-    pipeline_info.layout = pipeline_layout_;
-    pipeline_info.renderPass = render_pass_;
-    pipeline_info.subpass = 0;
-
-    try {
-        auto result = device.createGraphicsPipeline(nullptr, pipeline_info);
-        graphics_pipeline_ = result.value;
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create graphics pipeline: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanRenderer::createSkyBoxPipeline() {
-    auto device = context_->getDevice();
-
-    vk::PipelineShaderStageCreateInfo vert_shader_stage_info{};
-    vert_shader_stage_info.stage = vk::ShaderStageFlagBits::eVertex;
-    vert_shader_stage_info.module = skybox_shader_->getVertexShader();
-    vert_shader_stage_info.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo frag_shader_stage_info{};
-    frag_shader_stage_info.stage = vk::ShaderStageFlagBits::eFragment;
-    frag_shader_stage_info.module = skybox_shader_->getFragmentShader();
-    frag_shader_stage_info.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, frag_shader_stage_info };
-
-    auto binding_description = SkyBox::SkyBoxVertex::getBindingDescription();
-    auto attribute_descriptions = SkyBox::SkyBoxVertex::getAttributeDescriptions();
-
-    vk::PipelineVertexInputStateCreateInfo vertex_input_info{};
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
-    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
-
-    vk::PipelineInputAssemblyStateCreateInfo input_assembly{};
-    input_assembly.topology = vk::PrimitiveTopology::eTriangleList;
-    input_assembly.primitiveRestartEnable = VK_FALSE;
-
-    vk::Viewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(context_->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(context_->getSwapChainExtent().height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    vk::Rect2D scissor{};
-    scissor.offset = vk::Offset2D{ 0, 0 };
-    scissor.extent = context_->getSwapChainExtent();
-
-    vk::PipelineViewportStateCreateInfo viewport_state{};
-    viewport_state.viewportCount = 1;
-    viewport_state.pViewports = &viewport;
-    viewport_state.scissorCount = 1;
-    viewport_state.pScissors = &scissor;
-
-    vk::PipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = vk::PolygonMode::eFill;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
-    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    vk::PipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-    vk::PipelineDepthStencilStateCreateInfo depth_stencil{};
-    depth_stencil.depthTestEnable = VK_TRUE;
-    depth_stencil.depthWriteEnable = VK_FALSE;
-    depth_stencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
-    depth_stencil.depthBoundsTestEnable = VK_FALSE;
-    depth_stencil.stencilTestEnable = VK_FALSE;
-
-    vk::PipelineColorBlendAttachmentState color_blend_attachment{};
-    color_blend_attachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    color_blend_attachment.blendEnable = VK_TRUE;
-    color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-    color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-    color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
-    color_blend_attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-    color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
-    color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
-
-    vk::PipelineColorBlendStateCreateInfo color_blending{};
-    color_blending.logicOpEnable = VK_FALSE;
-    color_blending.logicOp = vk::LogicOp::eCopy;
-    color_blending.attachmentCount = 1;
-    color_blending.pAttachments = &color_blend_attachment;
-
-    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
-    pipeline_layout_info.setLayoutCount = 1;
-    auto skybox_descriptor_set_layout = skybox_->getDescriptorSetLayout();
-    pipeline_layout_info.pSetLayouts = &skybox_descriptor_set_layout;
-
-    try {
-        skybox_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create skybox pipeline layout: {}", e.what());
-        return false;
-    }
-
-    vk::GraphicsPipelineCreateInfo pipeline_info{};
-    pipeline_info.stageCount = 2;
-    pipeline_info.pStages = shader_stages;
-    pipeline_info.pVertexInputState = &vertex_input_info;
-    pipeline_info.pInputAssemblyState = &input_assembly;
-    pipeline_info.pViewportState = &viewport_state;
-    pipeline_info.pRasterizationState = &rasterizer;
-    pipeline_info.pMultisampleState = &multisampling;
-    pipeline_info.pDepthStencilState = &depth_stencil;
-    pipeline_info.pColorBlendState = &color_blending;
-    pipeline_info.layout = skybox_pipeline_layout_;
-    pipeline_info.renderPass = render_pass_;
-    pipeline_info.subpass = 0;
-
-    try {
-        auto result = device.createGraphicsPipeline(nullptr, pipeline_info);
-        skybox_pipeline_ = result.value;
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create skybox graphics pipeline: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanRenderer::createFramebuffers() {
-    auto device = context_->getDevice();
-    const auto& swap_chain_image_views = context_->getSwapChainImageViews();
-
-    swap_chain_framebuffers_.resize(swap_chain_image_views.size());
-
-    for (size_t i = 0; i < swap_chain_image_views.size(); i++) {
-        std::array<vk::ImageView, 2> attachments = {
-            swap_chain_image_views[i],
-            depth_image_view_
-        };
-
-        vk::FramebufferCreateInfo framebuffer_info{};
-        framebuffer_info.renderPass = render_pass_;
-        framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebuffer_info.pAttachments = attachments.data();
-        framebuffer_info.width = context_->getSwapChainExtent().width;
-        framebuffer_info.height = context_->getSwapChainExtent().height;
-        framebuffer_info.layers = 1;
-
-        try {
-            swap_chain_framebuffers_[i] = device.createFramebuffer(framebuffer_info);
-        }
-        catch (const std::exception& e) {
-            LOGE("Failed to create framebuffer {}: {}", i, e.what());
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool VulkanRenderer::createCommandBuffers() {
-    auto device = context_->getDevice();
-
-    command_buffers_.resize(MAX_FRAMES_IN_FLIGHT);
-
-    vk::CommandBufferAllocateInfo alloc_info{};
-    alloc_info.commandPool = context_->getCommandPool();
-    alloc_info.level = vk::CommandBufferLevel::ePrimary;
-    alloc_info.commandBufferCount = static_cast<uint32_t>(command_buffers_.size());
-
-    try {
-        command_buffers_ = device.allocateCommandBuffers(alloc_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to allocate command buffers: {}", e.what());
-        return false;
-    }
-}
-
-bool VulkanRenderer::createSyncObjects() {
-    auto device = context_->getDevice();
-
-    image_available_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    render_finished_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    in_flight_fences_.resize(MAX_FRAMES_IN_FLIGHT);
-
-    vk::SemaphoreCreateInfo semaphore_info{};
-    vk::FenceCreateInfo fence_info{};
-    fence_info.flags = vk::FenceCreateFlagBits::eSignaled;
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        try {
-            image_available_semaphores_[i] = device.createSemaphore(semaphore_info);
-            render_finished_semaphores_[i] = device.createSemaphore(semaphore_info);
-            in_flight_fences_[i] = device.createFence(fence_info);
-        }
-        catch (const std::exception& e) {
-            LOGE("Failed to create synchronization objects for frame {}: {}", i, e.what());
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool VulkanRenderer::createDepthResources() {
-    auto device = context_->getDevice();
-    vk::Format depth_format = vk::Format::eD32Sfloat;
-
-    vk::ImageCreateInfo image_info{};
-    image_info.imageType = vk::ImageType::e2D;
-    image_info.extent.width = context_->getSwapChainExtent().width;
-    image_info.extent.height = context_->getSwapChainExtent().height;
-    image_info.extent.depth = 1;
-    image_info.mipLevels = 1;
-    image_info.arrayLayers = 1;
-    image_info.format = depth_format;
-    image_info.tiling = vk::ImageTiling::eOptimal;
-    image_info.initialLayout = vk::ImageLayout::eUndefined;
-    image_info.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
-    image_info.samples = vk::SampleCountFlagBits::e1;
-    image_info.sharingMode = vk::SharingMode::eExclusive;
-
-    try {
-        depth_image_ = device.createImage(image_info);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create depth image: {}", e.what());
-        return false;
-    }
-
-    vk::MemoryRequirements mem_requirements = device.getImageMemoryRequirements(depth_image_);
-
-    vk::MemoryAllocateInfo alloc_info{};
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    try {
-        depth_image_memory_ = device.allocateMemory(alloc_info);
-        device.bindImageMemory(depth_image_, depth_image_memory_, 0);
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to allocate depth image memory: {}", e.what());
-        return false;
-    }
-
-    vk::ImageViewCreateInfo view_info{};
-    view_info.image = depth_image_;
-    view_info.viewType = vk::ImageViewType::e2D;
-    view_info.format = depth_format;
-    view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
-    view_info.subresourceRange.baseMipLevel = 0;
-    view_info.subresourceRange.levelCount = 1;
-    view_info.subresourceRange.baseArrayLayer = 0;
-    view_info.subresourceRange.layerCount = 1;
-
-    try {
-        depth_image_view_ = device.createImageView(view_info);
-        return true;
-    }
-    catch (const std::exception& e) {
-        LOGE("Failed to create depth image view: {}", e.what());
-        return false;
-    }
-}
-
-void VulkanRenderer::mainLoop() {
-    last_time_ = std::chrono::steady_clock::now();
-
-    while (!glfwWindowShouldClose(window_)) {
-        glfwPollEvents();
-
-        auto current_time = std::chrono::steady_clock::now();
-        delta_time_ = std::chrono::duration<float>(current_time - last_time_).count();
-        last_time_ = current_time;
-
-        if (ui_overlay_) {
-            ui_overlay_->update(delta_time_);
-        	ui_overlay_->updatePerformanceData(ui_overlay_->getCurrentFPS(), ui_overlay_->getAverageFrameTime());
-        }
-
-        processInput();
-        drawFrame();
-    }
-
-    context_->getDevice().waitIdle();
-}
-
-void VulkanRenderer::drawFrame() {
-    auto device = context_->getDevice();
-
-    device.waitForFences(1, &in_flight_fences_[current_frame_], VK_TRUE, UINT64_MAX);
-
-    uint32_t image_index;
-    vk::Result result = device.acquireNextImageKHR(context_->getSwapChain(), UINT64_MAX,
-        image_available_semaphores_[current_frame_], nullptr, &image_index);
-
-    if (result == vk::Result::eErrorOutOfDateKHR) {
-        recreateSwapChain();
-        return;
-    }
-    else if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
-        throw std::runtime_error("Failed to acquire swap chain image!");
-    }
-
-    updateUniformBuffer();
-    updateSkyBoxUniforms();
-
-    device.resetFences(1, &in_flight_fences_[current_frame_]);
-
-    command_buffers_[current_frame_].reset();
-
-    vk::CommandBufferBeginInfo begin_info{};
-    command_buffers_[current_frame_].begin(begin_info);
-
-    vk::RenderPassBeginInfo render_pass_info{};
-    render_pass_info.renderPass = render_pass_;
-    render_pass_info.framebuffer = swap_chain_framebuffers_[image_index];
-    render_pass_info.renderArea.offset = vk::Offset2D{ 0, 0 };
-    render_pass_info.renderArea.extent = context_->getSwapChainExtent();
-
-    std::array<vk::ClearValue, 2> clear_values{};
-    clear_values[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-    clear_values[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
-
-    render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
-    render_pass_info.pClearValues = clear_values.data();
-
-    command_buffers_[current_frame_].beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
-
-    vk::Viewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(context_->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(context_->getSwapChainExtent().height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    command_buffers_[current_frame_].setViewport(0, 1, &viewport);
-
-    vk::Rect2D scissor{};
-    scissor.offset = vk::Offset2D{ 0, 0 };
-    scissor.extent = context_->getSwapChainExtent();
-    command_buffers_[current_frame_].setScissor(0, 1, &scissor);
-
-    if (skybox_ && skybox_pipeline_) {
-        command_buffers_[current_frame_].bindPipeline(vk::PipelineBindPoint::eGraphics, skybox_pipeline_);
-        skybox_->draw(command_buffers_[current_frame_], skybox_pipeline_layout_);
-    }
-
-    command_buffers_[current_frame_].bindPipeline(vk::PipelineBindPoint::eGraphics, graphics_pipeline_);
-    material_->bind(command_buffers_[current_frame_], pipeline_layout_);
-
-    if (mesh_) {
-        mesh_->draw(command_buffers_[current_frame_]);
-    }
-
-    if (ui_overlay_) {
-        ui_overlay_->render(command_buffers_[current_frame_]);
-    }
-
-    command_buffers_[current_frame_].endRenderPass();
-    command_buffers_[current_frame_].end();
-
-    vk::SubmitInfo submit_info{};
-
-    vk::Semaphore wait_semaphores[] = { image_available_semaphores_[current_frame_] };
-    vk::PipelineStageFlags wait_stages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = wait_semaphores;
-    submit_info.pWaitDstStageMask = wait_stages;
-
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffers_[current_frame_];
-
-    vk::Semaphore signal_semaphores[] = { render_finished_semaphores_[current_frame_] };
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = signal_semaphores;
-
-    context_->getGraphicsQueue().submit(submit_info, in_flight_fences_[current_frame_]);
-
-    vk::PresentInfoKHR present_info{};
-    present_info.waitSemaphoreCount = 1;
-    present_info.pWaitSemaphores = signal_semaphores;
-
-    vk::SwapchainKHR swap_chains[] = { context_->getSwapChain() };
-    present_info.swapchainCount = 1;
-    present_info.pSwapchains = swap_chains;
-    present_info.pImageIndices = &image_index;
-
-    result = context_->getPresentQueue().presentKHR(present_info);
-
-    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || framebuffer_resized_) {
-        framebuffer_resized_ = false;
-        recreateSwapChain();
-    }
-    else if (result != vk::Result::eSuccess) {
-        throw std::runtime_error("Failed to present swap chain image!");
-    }
-
-    current_frame_ = (current_frame_ + 1) % MAX_FRAMES_IN_FLIGHT;
-}
-
-void VulkanRenderer::updateUniformBuffer() {
-    static auto start_time = std::chrono::high_resolution_clock::now();
-    auto current_time = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(current_time - start_time).count();
-
-    UniformBufferObject ubo{};
-    ubo.model = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    ubo.view = camera_->getViewMatrix();
-    ubo.proj = camera_->getProjectionMatrix(static_cast<float>(context_->getSwapChainExtent().width) /
-        static_cast<float>(context_->getSwapChainExtent().height));
-    ubo.proj[1][1] *= -1;
-    ubo.normal_matrix = glm::transpose(glm::inverse(ubo.model));
-    ubo.camera_pos = camera_->getPosition();
-
-    material_->updateUniforms(ubo);
-}
-
-void VulkanRenderer::updateSkyBoxUniforms() {
-    if (!skybox_) return;
-
-    SkyBoxUBO ubo{};
-    ubo.view = camera_->getViewMatrix();
-    ubo.projection = camera_->getProjectionMatrix(static_cast<float>(context_->getSwapChainExtent().width) /
-        static_cast<float>(context_->getSwapChainExtent().height));
-    ubo.projection[1][1] *= -1;
-
-    skybox_->updateUniforms(ubo);
-}
-
-void VulkanRenderer::recreateSwapChain() {
-    auto device = context_->getDevice();
-    device.waitIdle();
-
-    for (auto framebuffer : swap_chain_framebuffers_) {
-        device.destroyFramebuffer(framebuffer);
-    }
-
-    device.destroyImageView(depth_image_view_);
-    device.destroyImage(depth_image_);
-    device.freeMemory(depth_image_memory_);
-
-    if (graphics_pipeline_) device.destroyPipeline(graphics_pipeline_);
-    if (skybox_pipeline_) device.destroyPipeline(skybox_pipeline_);
-
-    context_->recreateSwapChain();
-
-    createDepthResources();
-    createFramebuffers();
-    createGraphicsPipeline();
-
-    if (skybox_) {
-        createSkyBoxPipeline();
-    }
-}
-
-void VulkanRenderer::processInput() {
-    bool move_forward = glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS;
-    bool move_backward = glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS;
-    bool move_left = glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS;
-    bool move_right = glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS;
-
-    camera_->processInput(delta_time_, move_forward, move_backward, move_left, move_right);
-
-    if (glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window_, true);
-    }
-}
-
-uint32_t VulkanRenderer::findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties mem_properties = context_->getPhysicalDevice().getMemoryProperties();
-
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((type_filter & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("Failed to find suitable memory type!");
-}
-
-void VulkanRenderer::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
-    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
-    renderer->framebuffer_resized_ = true;
-}
-
-void VulkanRenderer::mouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
-    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
-
-    if (renderer->first_mouse_) {
-        renderer->last_x_ = x_pos;
-        renderer->last_y_ = y_pos;
-        renderer->first_mouse_ = false;
-    }
-
-    float x_offset = x_pos - renderer->last_x_;
-    float y_offset = renderer->last_y_ - y_pos;
-
-    renderer->last_x_ = x_pos;
-    renderer->last_y_ = y_pos;
-
-    renderer->camera_->processMouseMovement(x_offset, y_offset);
-}
-
-void VulkanRenderer::scrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
-    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
-    renderer->camera_->processMouseScroll(static_cast<float>(y_offset));
-}
+﻿#include "vulkan_renderer.h"
+#include "model_loader.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+// CPU stage of a model load: either a mapped cache hit or freshly parsed data.
+struct ModelData {
+    MappedFile cache_file;
+    MeshCacheView cache_view;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    BoundingSphere bounds;
+    double parse_ms = 0.0;
+    bool valid = false;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ModelData loadModelData(const std::string& obj_path, JobSystem* job_system) {
+    ModelData data;
+    std::string cache_path = MeshCache::getCachePath(obj_path);
+
+    if (MeshCache::open(cache_path, obj_path, data.cache_file, data.cache_view)) {
+        LOGI("Model loaded from cache: {}", cache_path);
+        data.bounds = ModelLoader::computeBoundingSphere(data.cache_view.vertices, data.cache_view.vertex_count);
+        data.valid = true;
+        return data;
+    }
+
+    if (!ModelLoader::loadOBJ(obj_path, data.vertices, data.indices, job_system)) {
+        return data;
+    }
+
+    MeshOptimizer::optimize(data.vertices, data.indices, data.lods, Mesh::MAX_LODS);
+    LOGI("Model optimized: {} ({} LODs)", obj_path, data.lods.size());
+
+    if (!MeshCache::write(cache_path, obj_path, data.vertices, data.indices, data.lods)) {
+        LOGW("Mesh cache not written for: {}", obj_path);
+    }
+
+    data.bounds = ModelLoader::computeBoundingSphere(data.vertices.data(), data.vertices.size());
+    data.valid = true;
+    return data;
+}
+
+struct LoadedTexture {
+    TextureData texture;
+    std::string path;
+    double decode_ms = 0.0;
+};
+
+LoadedTexture loadTextureData(const std::string& texture_path) {
+    LoadedTexture data;
+    data.path = texture_path;
+
+    if (!TextureLoader::load(texture_path, data.texture)) {
+        LOGW("Failed to load texture from: {}, try to use default texture", texture_path);
+        data.path = MODEL_DIR "default_texture.png";
+        if (TextureLoader::load(data.path, data.texture)) {
+            LOGI("Using default texture");
+        }
+    }
+
+    return data;
+}
+
+}
+
+VulkanRenderer::VulkanRenderer()
+    : window_(nullptr), headless_(false), window_width_(800), window_height_(600),
+    window_title_("Vulkan Renderer"), framebuffer_resized_(false), depth_prepass_enabled_(true),
+    vertex_format_(VertexFormat::Full), parallel_recording_enabled_(false),
+    low_latency_enabled_(false), vsync_enabled_(true), vulkan13_path_enabled_(true), hot_reload_enabled_(false),
+    frames_in_flight_(DEFAULT_FRAMES_IN_FLIGHT), current_frame_(0), frame_number_(0), frame_serials_{},
+    shader_reload_requested_(false), texture_reload_requested_(false), delta_time_(0.0f), first_mouse_(true),
+    last_x_(400.0), last_y_(300.0) {
+    last_time_ = std::chrono::steady_clock::now();
+}
+
+VulkanRenderer::~VulkanRenderer() {
+    cleanup();
+}
+
+bool VulkanRenderer::initialize(int width, int height, const std::string& title) {
+    window_width_ = width;
+    window_height_ = height;
+    window_title_ = title;
+
+    if (!initWindow()) {
+        LOGE("Failed to initialize window");
+        return false;
+    }
+
+    return initRenderer();
+}
+
+bool VulkanRenderer::initializeHeadless(int width, int height) {
+    window_width_ = width;
+    window_height_ = height;
+    headless_ = true;
+
+    if (!initRenderer()) {
+        return false;
+    }
+
+    frame_readback_ = std::make_unique<FrameReadback>(context_, *job_system_);
+    return frame_readback_->initialize(context_->getSwapChainExtent(), context_->getSwapChainImageFormat());
+}
+
+bool VulkanRenderer::initRenderer() {
+    if (!initVulkan()) {
+        LOGE("Failed to initialize Vulkan");
+        return false;
+    }
+
+    job_system_ = std::make_unique<JobSystem>();
+    LOGI("Job system started with {} workers", job_system_->getWorkerCount());
+
+    // One recording slot per worker plus the main thread, which joins in.
+    secondary_pools_ = std::make_unique<SecondaryCommandPools>(context_);
+    if (!secondary_pools_->initialize(job_system_->getWorkerCount() + 1)) {
+        return false;
+    }
+
+    camera_ = std::make_unique<Camera>(glm::vec3(2.0f, 1.5f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f), -105.0f, -15.0f);
+
+    LOGI("Vulkan Renderer initialized successfully");
+    return true;
+}
+
+void VulkanRenderer::run() {
+    if (headless_) {
+        LOGE("A headless renderer has no main loop, use renderOffscreen()");
+        return;
+    }
+    mainLoop();
+}
+
+double VulkanRenderer::renderOffscreen(uint32_t frame_count, const std::string& directory,
+    FrameReadback::OutputFormat format, const std::function<void(uint32_t frame, Camera& camera)>& before_frame) {
+    if (!headless_) {
+        LOGE("renderOffscreen() needs a renderer created with initializeHeadless()");
+        return -1.0;
+    }
+
+    frame_readback_->setOutput(directory, format);
+    uint64_t written_before = frame_readback_->getFramesWritten();
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    try {
+        renderFrames(frame_count, before_frame);
+    }
+    catch (const std::exception& e) {
+        LOGE("Offscreen rendering failed: {}", e.what());
+        return -1.0;
+    }
+
+    // The last frames in flight are still being copied back.
+    auto device = context_->getDevice();
+    device.waitForFences(static_cast<uint32_t>(in_flight_fences_.size()), in_flight_fences_.data(),
+        VK_TRUE, UINT64_MAX);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        frame_readback_->collect((current_frame_ + i) % MAX_FRAMES_IN_FLIGHT);
+    }
+    bool written = frame_readback_->flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    double frames_per_second = seconds > 0.0 ? frame_count / seconds : 0.0;
+    LOGI("Rendered {} frames offscreen in {:.2f} s: {:.1f} FPS, {} written", frame_count, seconds,
+        frames_per_second, frame_readback_->getFramesWritten() - written_before);
+
+    return written ? frames_per_second : -1.0;
+}
+
+bool VulkanRenderer::renderFrames(uint32_t frame_count,
+    const std::function<void(uint32_t frame, Camera& camera)>& before_frame) {
+    last_time_ = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        // Events keep the window responsive; input is left to before_frame.
+        if (!headless_) {
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window_)) {
+                return false;
+            }
+        }
+
+        auto current_time = std::chrono::steady_clock::now();
+        delta_time_ = std::chrono::duration<float>(current_time - last_time_).count();
+        last_time_ = current_time;
+
+        if (before_frame) {
+            before_frame(i, *camera_);
+        }
+        drawFrame();
+    }
+
+    return true;
+}
+
+void VulkanRenderer::cleanup() {
+    // Readback buffers may still be the target of a copy.
+    if (frame_readback_) {
+        context_->getDevice().waitIdle();
+        frame_readback_.reset();
+    }
+
+    job_system_.reset();
+    pending_loads_.clear();
+
+    // Workers drained on shutdown, so a started reload has finished.
+    if (shader_reload_.valid()) {
+        ShaderReload reload = shader_reload_.get();
+        destroyScenePipelines(reload.pipelines);
+    }
+    texture_reload_ = {};
+
+    if (context_) {
+        ui_overlay_.reset();
+
+        auto device = context_->getDevice();
+        device.waitIdle();
+        // Retired objects may hold the context or resources destroyed below.
+        context_->destroyRetired();
+
+        gpu_profiler_.reset();
+        frame_pacer_.reset();
+        secondary_pools_.reset();
+        render_graph_.reset();
+
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            if (render_finished_semaphores_[i]) device.destroySemaphore(render_finished_semaphores_[i]);
+            if (image_available_semaphores_[i]) device.destroySemaphore(image_available_semaphores_[i]);
+            if (in_flight_fences_[i]) device.destroyFence(in_flight_fences_[i]);
+        }
+
+        if (graphics_pipeline_) device.destroyPipeline(graphics_pipeline_);
+        if (alpha_tested_pipeline_) device.destroyPipeline(alpha_tested_pipeline_);
+        if (depth_prepass_pipeline_) device.destroyPipeline(depth_prepass_pipeline_);
+        if (depth_prepass_alpha_pipeline_) device.destroyPipeline(depth_prepass_alpha_pipeline_);
+        if (pipeline_layout_) device.destroyPipelineLayout(pipeline_layout_);
+
+        if (skybox_pipeline_) device.destroyPipeline(skybox_pipeline_);
+        if (skybox_pipeline_layout_) device.destroyPipelineLayout(skybox_pipeline_layout_);
+    }
+
+    scene_.reset();
+    shader_.reset();
+    depth_prepass_shader_.reset();
+    material_.reset();
+    skybox_.reset();
+    skybox_shader_.reset();
+    ibl_.reset();
+    light_grid_.reset();
+    depth_pyramid_.reset();
+    context_.reset();
+
+    if (window_) {
+        glfwDestroyWindow(window_);
+        glfwTerminate();
+    }
+}
+
+bool VulkanRenderer::loadModel(const std::string& obj_path) {
+    auto result = requestModel(obj_path);
+    finishPendingLoads();
+    return result.get();
+}
+
+bool VulkanRenderer::loadModelInstanced(const std::string& obj_path, const std::vector<glm::mat4>& transforms) {
+    auto result = requestModelInstanced(obj_path, transforms);
+    finishPendingLoads();
+    return result.get();
+}
+
+bool VulkanRenderer::loadTexture(const std::string& texture_path) {
+    auto result = requestTexture(texture_path);
+    finishPendingLoads();
+    return result.get();
+}
+
+bool VulkanRenderer::createDefaultSkyBox() {
+    auto result = requestDefaultSkyBox();
+    finishPendingLoads();
+    return result.get();
+}
+
+bool VulkanRenderer::setSkyBoxColors(const glm::vec3& top_color, const glm::vec3& bottom_color) {
+    if (!skybox_ || !skybox_->setGradientColors(top_color, bottom_color)) {
+        return false;
+    }
+
+    ibl_->invalidate();
+    return true;
+}
+
+std::future<bool> VulkanRenderer::requestModel(const std::string& obj_path) {
+    return requestModelInstanced(obj_path,
+        { glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)) });
+}
+
+std::future<bool> VulkanRenderer::requestModelInstanced(const std::string& obj_path,
+    const std::vector<glm::mat4>& transforms) {
+    JobSystem* job_system = job_system_.get();
+    auto data = std::make_shared<std::future<ModelData>>(job_system_->submit([obj_path, job_system]() {
+        auto start_time = std::chrono::steady_clock::now();
+        ModelData model = loadModelData(obj_path, job_system);
+        model.parse_ms = millisecondsSince(start_time);
+        return model;
+    }));
+
+    return addPendingLoad([this, data, obj_path, transforms]() {
+        ModelData model = data->get();
+        load_timings_.parse_ms += model.parse_ms;
+        if (!model.valid) {
+            LOGE("Failed to load model: {}", obj_path);
+            return false;
+        }
+
+        auto upload_start = std::chrono::steady_clock::now();
+
+        auto mesh = std::make_unique<Mesh>(context_, vertex_format_);
+        bool created = model.cache_file.isOpen()
+            ? mesh->create(model.cache_view.vertices, model.cache_view.vertex_count,
+                model.cache_view.indices, model.cache_view.index_count)
+            : mesh->create(model.vertices, model.indices);
+        if (!created) {
+            LOGE("Failed to create mesh");
+            return false;
+        }
+        mesh->setBounds(model.bounds);
+        if (model.cache_file.isOpen()) {
+            mesh->setLods(model.cache_view.lods, model.cache_view.lod_count);
+        }
+        else {
+            mesh->setLods(model.lods.data(), model.lods.size());
+        }
+
+        uint32_t mesh_id = scene_->addMesh(std::move(mesh));
+        for (const auto& transform : transforms) {
+            scene_->addObject(mesh_id, transform);
+        }
+        load_timings_.upload_ms += millisecondsSince(upload_start);
+
+        LOGI("Model loaded successfully: {} ({} instances)", obj_path, transforms.size());
+        return true;
+    });
+}
+
+std::future<bool> VulkanRenderer::requestTexture(const std::string& texture_path) {
+    auto data = std::make_shared<std::future<LoadedTexture>>(job_system_->submit([texture_path]() {
+        auto start_time = std::chrono::steady_clock::now();
+        LoadedTexture loaded = loadTextureData(texture_path);
+        loaded.decode_ms = millisecondsSince(start_time);
+        return loaded;
+    }));
+
+    return addPendingLoad([this, data]() {
+        if (!material_) {
+            LOGE("Material not initialized, cannot load texture");
+            return false;
+        }
+
+        LoadedTexture loaded = data->get();
+        load_timings_.decode_ms += loaded.decode_ms;
+        if (!loaded.texture.isValid()) {
+            LOGE("Cannot load default texture");
+            return false;
+        }
+
+        auto upload_start = std::chrono::steady_clock::now();
+        auto texture = std::make_shared<Texture>(context_);
+        bool created = texture->createFromTextureData(loaded.texture, loaded.path);
+        load_timings_.upload_ms += millisecondsSince(upload_start);
+        if (!created) {
+            return false;
+        }
+
+        if (!material_->setTexture(texture)) {
+            LOGE("Failed to set texture to material");
+            return false;
+        }
+        watchTexture(loaded.path);
+
+        return true;
+    });
+}
+
+std::future<bool> VulkanRenderer::requestDefaultSkyBox() {
+    LOGI("Creating default skybox");
+
+    // Nothing to do off-thread: the gradient is written by a compute dispatch
+    // recorded into the first frame.
+    return addPendingLoad([this]() {
+        if (!skybox_) {
+            skybox_ = std::make_unique<SkyBox>(context_);
+            if (!skybox_->initialize()) {
+                LOGE("Failed to initialize skybox");
+                return false;
+            }
+        }
+
+        if (!skybox_->createDefaultSkyBox()) {
+            LOGE("Failed to create default skybox");
+            return false;
+        }
+
+        if (!ibl_->setEnvironment(skybox_->getCubemapView(), skybox_->getCubemapSampler(),
+            skybox_->getEnvironmentKey())) {
+            LOGW("Image based lighting unavailable for the default skybox");
+        }
+
+        skybox_shader_ = std::make_unique<Shader>(context_);
+        if (!skybox_shader_->loadFromFiles(SkyBox::getVertexShaderPath(),
+            SkyBox::getFragmentShaderPath())) {
+            LOGE("Failed to load skybox shaders");
+            return false;
+        }
+
+        auto pipeline_start = std::chrono::steady_clock::now();
+        bool pipeline_created = createSkyBoxPipeline();
+        load_timings_.pipeline_ms += millisecondsSince(pipeline_start);
+        if (!pipeline_created) {
+            LOGE("Failed to create skybox pipeline");
+            return false;
+        }
+
+        LOGI("Default skybox created successfully");
+        return true;
+    });
+}
+
+bool VulkanRenderer::finishPendingLoads() {
+    // Moved out first: a finish stage may itself request further loads.
+    std::vector<PendingLoad> loads = std::move(pending_loads_);
+    pending_loads_.clear();
+
+    bool all_succeeded = true;
+    for (auto& load : loads) {
+        bool succeeded = false;
+        try {
+            succeeded = load.finish();
+        }
+        catch (const std::exception& e) {
+            LOGE("Asset load failed: {}", e.what());
+        }
+        load.result.set_value(succeeded);
+        all_succeeded = all_succeeded && succeeded;
+    }
+
+    return all_succeeded;
+}
+
+std::future<bool> VulkanRenderer::addPendingLoad(std::function<bool()> finish) {
+    PendingLoad load;
+    load.finish = std::move(finish);
+    std::future<bool> result = load.result.get_future();
+    pending_loads_.push_back(std::move(load));
+    return result;
+}
+
+bool VulkanRenderer::initWindow() {
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+    window_ = glfwCreateWindow(window_width_, window_height_, window_title_.c_str(), nullptr, nullptr);
+    if (!window_) {
+        LOGE("Failed to create GLFW window");
+        return false;
+    }
+
+    glfwSetWindowUserPointer(window_, this);
+    glfwSetFramebufferSizeCallback(window_, framebufferResizeCallback);
+    glfwSetCursorPosCallback(window_, mouseCallback);
+    glfwSetScrollCallback(window_, scrollCallback);
+    glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    return true;
+}
+
+bool VulkanRenderer::initVulkan() {
+    context_ = std::make_shared<VulkanContext>();
+    context_->setVsyncEnabled(vsync_enabled_);
+    context_->setVulkan13PathEnabled(vulkan13_path_enabled_);
+    if (headless_ ? !context_->initializeHeadless(vk::Extent2D{ static_cast<uint32_t>(window_width_),
+        static_cast<uint32_t>(window_height_) }) : !context_->initialize(window_)) {
+        return false;
+    }
+
+    if (!createRenderGraph()) {
+        return false;
+    }
+
+    shader_ = loadSceneShader(SHADER_DIR "default.frag", true);
+    if (!shader_) {
+        LOGE("Failed to load default shaders");
+        return false;
+    }
+
+    if (depth_prepass_enabled_) {
+        depth_prepass_shader_ = loadSceneShader(SHADER_DIR "depth_prepass.frag", true);
+        if (!depth_prepass_shader_) {
+            LOGE("Failed to load depth pre-pass shaders");
+            return false;
+        }
+    }
+
+    material_ = std::make_unique<Material>(context_);
+    if (!material_->initialize()) {
+        return false;
+    }
+
+    scene_ = std::make_unique<Scene>(context_);
+    if (!scene_->initialize()) {
+        return false;
+    }
+
+    ibl_ = std::make_unique<ImageBasedLighting>(context_);
+    if (!ibl_->initialize()) {
+        return false;
+    }
+
+    light_grid_ = std::make_unique<LightGrid>(context_);
+    if (!light_grid_->initialize()) {
+        return false;
+    }
+
+    PointLight default_light{};
+    default_light.position = glm::vec3(10.0f, 10.0f, 10.0f);
+    default_light.radius = 40.0f;
+    default_light.intensity = 300.0f;
+    light_grid_->addLight(default_light);
+
+    auto pipeline_start = std::chrono::steady_clock::now();
+    bool pipeline_created = createGraphicsPipeline();
+    load_timings_.pipeline_ms += millisecondsSince(pipeline_start);
+    if (!pipeline_created) {
+        return false;
+    }
+
+    if (!render_graph_->createResources(context_->getSwapChainExtent())) {
+        return false;
+    }
+
+    depth_pyramid_ = std::make_unique<DepthPyramid>(context_);
+    if (!depth_pyramid_->initialize() ||
+        !depth_pyramid_->create(render_graph_->getImageView(depth_resource_), context_->getSwapChainExtent())) {
+        return false;
+    }
+    if (!scene_->setDepthPyramid(*depth_pyramid_)) {
+        return false;
+    }
+
+    if (!createCommandBuffers()) {
+        return false;
+    }
+
+    if (!createSyncObjects()) {
+        return false;
+    }
+
+    gpu_profiler_ = std::make_unique<GpuProfiler>(context_);
+    if (!gpu_profiler_->initialize()) {
+        return false;
+    }
+    render_graph_->setProfiler(gpu_profiler_.get());
+
+    frame_pacer_ = std::make_unique<FramePacer>(context_);
+    if (!frame_pacer_->initialize()) {
+        return false;
+    }
+
+    if (headless_) {
+        return true;
+    }
+
+    ui_overlay_ = std::make_unique<UIOverlay>(context_, window_);
+    vk::PipelineRenderingCreateInfoKHR ui_rendering_info = render_graph_->getPipelineRenderingInfo(forward_pass_);
+    if (!ui_overlay_->initialize(render_pass_, getMainSubpass(),
+        render_graph_->usesDynamicRendering() ? &ui_rendering_info : nullptr)) {
+        LOGE("Failed to initialize UI overlay");
+        return false;
+    }
+    ui_overlay_->setProfilers(gpu_profiler_.get(), &cpu_profiler_);
+    ui_overlay_->setFramePacer(frame_pacer_.get());
+
+    return true;
+}
+
+// The frame as passes over declared resources; the graph derives the render
+// pass, its subpass dependencies and every barrier in between from them.
+bool VulkanRenderer::createRenderGraph() {
+    render_graph_ = std::make_unique<RenderGraph>(context_);
+
+    RenderGraph::ImageImport backbuffer{};
+    backbuffer.format = context_->getSwapChainImageFormat();
+    // Headless targets stay attachments; the readback moves them to transfer.
+    backbuffer.final_layout = headless_ ? vk::ImageLayout::eUndefined : vk::ImageLayout::ePresentSrcKHR;
+    backbuffer.reset_each_frame = true;
+    backbuffer_resource_ = render_graph_->importImage("Backbuffer", backbuffer);
+
+    RenderGraph::ImageImport depth_pyramid{};
+    depth_pyramid.format = DepthPyramid::PYRAMID_FORMAT;
+    depth_pyramid.fixed_layout = vk::ImageLayout::eGeneral;
+    depth_pyramid_resource_ = render_graph_->importImage("Depth Pyramid", depth_pyramid);
+
+    depth_resource_ = render_graph_->createImage("Depth", vk::Format::eD32Sfloat);
+
+    // All three are per-frame regions of their buffers.
+    visible_buffer_resource_ = render_graph_->importBuffer("Visible Instances", true);
+    indirect_buffer_resource_ = render_graph_->importBuffer("Indirect Commands", true);
+    cluster_buffer_resource_ = render_graph_->importBuffer("Light Clusters", true);
+
+    vk::ClearColorValue clear_color{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } };
+    vk::ClearDepthStencilValue clear_depth{ 1.0f, 0 };
+
+    RenderGraph::Pass light_culling = render_graph_->addPass("Light Culling", RenderGraph::PassType::Compute,
+        [this](const RenderGraph::PassContext& pass) {
+            light_grid_->recordCulling(pass.command_buffer, current_frame_);
+        });
+    render_graph_->addBufferWrite(light_culling, cluster_buffer_resource_,
+        vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
+
+    // Tests against the pyramid of the previous frame.
+    RenderGraph::Pass scene_culling = render_graph_->addPass("Scene Culling", RenderGraph::PassType::Compute,
+        [this](const RenderGraph::PassContext& pass) {
+            scene_->recordCulling(pass.command_buffer, current_frame_);
+        });
+    render_graph_->addImageRead(scene_culling, depth_pyramid_resource_, vk::PipelineStageFlagBits::eComputeShader);
+    render_graph_->addBufferWrite(scene_culling, visible_buffer_resource_,
+        vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
+    render_graph_->addBufferWrite(scene_culling, indirect_buffer_resource_,
+        vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    // With the pre-pass, it lays down depth only and the forward pass tests
+    // against it without writing.
+    if (depth_prepass_enabled_) {
+        depth_prepass_pass_ = render_graph_->addPass("Depth Prepass", RenderGraph::PassType::Graphics,
+            [this](const RenderGraph::PassContext& pass) { recordDepthPrepassPass(pass); });
+        render_graph_->addDepthAttachment(depth_prepass_pass_, depth_resource_, true, &clear_depth);
+        render_graph_->addBufferRead(depth_prepass_pass_, visible_buffer_resource_,
+            vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead);
+        render_graph_->addBufferRead(depth_prepass_pass_, indirect_buffer_resource_,
+            vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+    }
+
+    forward_pass_ = render_graph_->addPass("Forward", RenderGraph::PassType::Graphics,
+        [this](const RenderGraph::PassContext& pass) { recordForwardPass(pass); });
+    render_graph_->addColorAttachment(forward_pass_, backbuffer_resource_, &clear_color);
+    render_graph_->addDepthAttachment(forward_pass_, depth_resource_, !depth_prepass_enabled_,
+        depth_prepass_enabled_ ? nullptr : &clear_depth);
+    render_graph_->addBufferRead(forward_pass_, visible_buffer_resource_,
+        vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead);
+    render_graph_->addBufferRead(forward_pass_, indirect_buffer_resource_,
+        vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+    render_graph_->addBufferRead(forward_pass_, cluster_buffer_resource_,
+        vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead);
+
+    // Occluders for the next frame's culling pass.
+    RenderGraph::Pass pyramid_build = render_graph_->addPass("Depth Pyramid", RenderGraph::PassType::Compute,
+        [this](const RenderGraph::PassContext& pass) {
+            depth_pyramid_->recordBuild(pass.command_buffer);
+        });
+    render_graph_->addImageRead(pyramid_build, depth_resource_, vk::PipelineStageFlagBits::eComputeShader);
+    render_graph_->addImageWrite(pyramid_build, depth_pyramid_resource_, vk::PipelineStageFlagBits::eComputeShader);
+
+    if (!render_graph_->compile()) {
+        LOGE("Failed to compile render graph");
+        return false;
+    }
+
+    render_pass_ = render_graph_->getRenderPass(forward_pass_);
+    return true;
+}
+
+std::unique_ptr<Shader> VulkanRenderer::loadSceneShader(const std::string& fragment_path, bool precompiled) const {
+    auto shader = std::make_unique<Shader>(context_);
+
+    // The bindless variants read materials and textures from the global table.
+    if (context_->getBindlessTable()) {
+        shader->addDefine("BINDLESS");
+    }
+    shader->setPrecompiledEnabled(precompiled);
+
+    if (!shader->loadFromFiles(SHADER_DIR "default.vert", fragment_path)) {
+        return nullptr;
+    }
+    return shader;
+}
+
+bool VulkanRenderer::createGraphicsPipeline() {
+    if (!createPipelineLayout()) {
+        return false;
+    }
+
+    ScenePipelines pipelines;
+    if (!createScenePipelines(*shader_, depth_prepass_shader_.get(), pipelines)) {
+        return false;
+    }
+
+    graphics_pipeline_ = pipelines.opaque;
+    alpha_tested_pipeline_ = pipelines.alpha_tested;
+    depth_prepass_pipeline_ = pipelines.depth_prepass;
+    depth_prepass_alpha_pipeline_ = pipelines.depth_prepass_alpha;
+    return true;
+}
+
+bool VulkanRenderer::createPipelineLayout() {
+    std::vector<vk::DescriptorSetLayout> descriptor_set_layouts = {
+        material_->getDescriptorSetLayout(),
+        scene_->getDescriptorSetLayout(),
+        ibl_->getDescriptorSetLayout(),
+        light_grid_->getDescriptorSetLayout()
+    };
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+
+    BindlessTable* bindless_table = context_->getBindlessTable();
+    vk::PushConstantRange push_constant_range{};
+    if (bindless_table) {
+        descriptor_set_layouts.push_back(bindless_table->getDescriptorSetLayout());
+        push_constant_range = bindless_table->getPushConstantRange();
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    }
+
+    pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
+    pipeline_layout_info.pSetLayouts = descriptor_set_layouts.data();
+
+    try {
+        pipeline_layout_ = context_->getDevice().createPipelineLayout(pipeline_layout_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create pipeline layout: {}", e.what());
+        return false;
+    }
+}
+
+// Only reads state that is fixed after initialization, so reloads run it on
+// a worker while the main thread keeps rendering with the old pipelines.
+bool VulkanRenderer::createScenePipelines(const Shader& shader, const Shader* depth_prepass_shader,
+    ScenePipelines& pipelines) const {
+    auto device = context_->getDevice();
+
+    vk::PipelineShaderStageCreateInfo vert_shader_stage_info{};
+    vert_shader_stage_info.stage = vk::ShaderStageFlagBits::eVertex;
+    vert_shader_stage_info.module = shader.getVertexShader();
+    vert_shader_stage_info.pName = "main";
+
+    // PACKED_VERTEX (constant_id 0 in default.vert) selects how the vertex
+    // attributes are decoded.
+    bool packed_vertices = vertex_format_ == VertexFormat::Packed;
+    VkBool32 packed_vertex = packed_vertices ? VK_TRUE : VK_FALSE;
+    vk::SpecializationMapEntry vertex_specialization_entry{ 0, 0, sizeof(VkBool32) };
+    vk::SpecializationInfo vertex_specialization_info{ 1, &vertex_specialization_entry, sizeof(VkBool32), &packed_vertex };
+    vert_shader_stage_info.pSpecializationInfo = &vertex_specialization_info;
+
+    vk::PipelineShaderStageCreateInfo frag_shader_stage_info{};
+    frag_shader_stage_info.stage = vk::ShaderStageFlagBits::eFragment;
+    frag_shader_stage_info.module = shader.getFragmentShader();
+    frag_shader_stage_info.pName = "main";
+
+    vk::PipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, frag_shader_stage_info };
+
+    auto binding_description = packed_vertices ?
+        PackedVertex::getBindingDescription() : Vertex::getBindingDescription();
+    auto attribute_descriptions = packed_vertices ?
+        PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+
+    vk::PipelineVertexInputStateCreateInfo vertex_input_info{};
+    vertex_input_info.vertexBindingDescriptionCount = 1;
+    vertex_input_info.pVertexBindingDescriptions = &binding_description;
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo input_assembly{};
+    input_assembly.topology = vk::PrimitiveTopology::eTriangleList;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    vk::PipelineViewportStateCreateInfo viewport_state{};
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
+    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::PipelineDepthStencilStateCreateInfo depth_stencil{};
+    depth_stencil.depthTestEnable = VK_TRUE;
+    depth_stencil.depthWriteEnable = VK_TRUE;
+    depth_stencil.depthCompareOp = vk::CompareOp::eLess;
+    depth_stencil.depthBoundsTestEnable = VK_FALSE;
+    depth_stencil.stencilTestEnable = VK_FALSE;
+
+    vk::PipelineColorBlendAttachmentState color_blend_attachment{};
+    color_blend_attachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    color_blend_attachment.blendEnable = VK_FALSE;
+
+    vk::PipelineColorBlendStateCreateInfo color_blending{};
+    color_blending.logicOpEnable = VK_FALSE;
+    color_blending.logicOp = vk::LogicOp::eCopy;
+    color_blending.attachmentCount = 1;
+    color_blending.pAttachments = &color_blend_attachment;
+
+    std::vector<vk::DynamicState> dynamic_states = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+
+    vk::PipelineDynamicStateCreateInfo dynamic_state{};
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+
+    vk::GraphicsPipelineCreateInfo pipeline_info{};
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = shader_stages;
+    pipeline_info.pVertexInputState = &vertex_input_info;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterizer;
+    pipeline_info.pMultisampleState = &multisampling;
+    pipeline_info.pDepthStencilState = &depth_stencil;
+    pipeline_info.pColorBlendState = &color_blending;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = pipeline_layout_;
+    pipeline_info.renderPass = render_pass_;
+    pipeline_info.subpass = getMainSubpass();
+
+    // Without a render pass, pipelines name the formats they render to.
+    vk::PipelineRenderingCreateInfoKHR rendering_info{};
+    if (render_graph_->usesDynamicRendering()) {
+        rendering_info = render_graph_->getPipelineRenderingInfo(forward_pass_);
+        pipeline_info.pNext = &rendering_info;
+    }
+
+    // ALPHA_TEST (constant_id 0 in default.frag) compiles the discard in or out.
+    VkBool32 alpha_test = VK_FALSE;
+    vk::SpecializationMapEntry specialization_entry{ 0, 0, sizeof(VkBool32) };
+    vk::SpecializationInfo specialization_info{ 1, &specialization_entry, sizeof(VkBool32), &alpha_test };
+    shader_stages[1].pSpecializationInfo = &specialization_info;
+
+    if (depth_prepass_enabled_) {
+        // Depth is final after the pre-pass, so the main pass shades exactly
+        // the visible fragment of each pixel and never needs to discard.
+        depth_stencil.depthWriteEnable = VK_FALSE;
+        depth_stencil.depthCompareOp = vk::CompareOp::eEqual;
+    }
+
+    try {
+        pipelines.opaque = device.createGraphicsPipeline(context_->getPipelineCache(), pipeline_info).value;
+
+        if (!depth_prepass_enabled_) {
+            alpha_test = VK_TRUE;
+            pipelines.alpha_tested = device.createGraphicsPipeline(context_->getPipelineCache(), pipeline_info).value;
+            return true;
+        }
+
+        depth_stencil.depthWriteEnable = VK_TRUE;
+        depth_stencil.depthCompareOp = vk::CompareOp::eLess;
+        color_blending.attachmentCount = 0;
+        pipeline_info.subpass = render_graph_->getSubpass(depth_prepass_pass_);
+        if (render_graph_->usesDynamicRendering()) {
+            rendering_info = render_graph_->getPipelineRenderingInfo(depth_prepass_pass_);
+        }
+
+        // Opaque geometry needs no fragment shader to write depth.
+        pipeline_info.stageCount = 1;
+        pipelines.depth_prepass = device.createGraphicsPipeline(context_->getPipelineCache(), pipeline_info).value;
+
+        vk::PipelineShaderStageCreateInfo alpha_frag_shader_stage_info{};
+        alpha_frag_shader_stage_info.stage = vk::ShaderStageFlagBits::eFragment;
+        alpha_frag_shader_stage_info.module = depth_prepass_shader->getFragmentShader();
+        alpha_frag_shader_stage_info.pName = "main";
+
+        vk::PipelineShaderStageCreateInfo prepass_shader_stages[] = { vert_shader_stage_info, alpha_frag_shader_stage_info };
+        pipeline_info.stageCount = 2;
+        pipeline_info.pStages = prepass_shader_stages;
+        pipelines.depth_prepass_alpha = device.createGraphicsPipeline(context_->getPipelineCache(), pipeline_info).value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create graphics pipeline: {}", e.what());
+        destroyScenePipelines(pipelines);
+        pipelines = {};
+        return false;
+    }
+}
+
+void VulkanRenderer::destroyScenePipelines(const ScenePipelines& pipelines) const {
+    auto device = context_->getDevice();
+    if (pipelines.opaque) device.destroyPipeline(pipelines.opaque);
+    if (pipelines.alpha_tested) device.destroyPipeline(pipelines.alpha_tested);
+    if (pipelines.depth_prepass) device.destroyPipeline(pipelines.depth_prepass);
+    if (pipelines.depth_prepass_alpha) device.destroyPipeline(pipelines.depth_prepass_alpha);
+}
+
+bool VulkanRenderer::createSkyBoxPipeline() {
+    auto device = context_->getDevice();
+
+    vk::PipelineShaderStageCreateInfo vert_shader_stage_info{};
+    vert_shader_stage_info.stage = vk::ShaderStageFlagBits::eVertex;
+    vert_shader_stage_info.module = skybox_shader_->getVertexShader();
+    vert_shader_stage_info.pName = "main";
+
+    vk::PipelineShaderStageCreateInfo frag_shader_stage_info{};
+    frag_shader_stage_info.stage = vk::ShaderStageFlagBits::eFragment;
+    frag_shader_stage_info.module = skybox_shader_->getFragmentShader();
+    frag_shader_stage_info.pName = "main";
+
+    vk::PipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, frag_shader_stage_info };
+
+    auto binding_description = SkyBox::SkyBoxVertex::getBindingDescription();
+    auto attribute_descriptions = SkyBox::SkyBoxVertex::getAttributeDescriptions();
+
+    vk::PipelineVertexInputStateCreateInfo vertex_input_info{};
+    vertex_input_info.vertexBindingDescriptionCount = 1;
+    vertex_input_info.pVertexBindingDescriptions = &binding_description;
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo input_assembly{};
+    input_assembly.topology = vk::PrimitiveTopology::eTriangleList;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    vk::PipelineViewportStateCreateInfo viewport_state{};
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
+    rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::PipelineDepthStencilStateCreateInfo depth_stencil{};
+    depth_stencil.depthTestEnable = VK_TRUE;
+    depth_stencil.depthWriteEnable = VK_FALSE;
+    depth_stencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
+    depth_stencil.depthBoundsTestEnable = VK_FALSE;
+    depth_stencil.stencilTestEnable = VK_FALSE;
+
+    vk::PipelineColorBlendAttachmentState color_blend_attachment{};
+    color_blend_attachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    color_blend_attachment.blendEnable = VK_TRUE;
+    color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+    color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+    color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
+    color_blend_attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+    color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+    color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
+
+    vk::PipelineColorBlendStateCreateInfo color_blending{};
+    color_blending.logicOpEnable = VK_FALSE;
+    color_blending.logicOp = vk::LogicOp::eCopy;
+    color_blending.attachmentCount = 1;
+    color_blending.pAttachments = &color_blend_attachment;
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    auto skybox_descriptor_set_layout = skybox_->getDescriptorSetLayout();
+    pipeline_layout_info.pSetLayouts = &skybox_descriptor_set_layout;
+
+    try {
+        skybox_pipeline_layout_ = device.createPipelineLayout(pipeline_layout_info);
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox pipeline layout: {}", e.what());
+        return false;
+    }
+
+    std::vector<vk::DynamicState> dynamic_states = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+
+    vk::PipelineDynamicStateCreateInfo dynamic_state{};
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+
+    vk::GraphicsPipelineCreateInfo pipeline_info{};
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = shader_stages;
+    pipeline_info.pVertexInputState = &vertex_input_info;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterizer;
+    pipeline_info.pMultisampleState = &multisampling;
+    pipeline_info.pDepthStencilState = &depth_stencil;
+    pipeline_info.pColorBlendState = &color_blending;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = skybox_pipeline_layout_;
+    pipeline_info.renderPass = render_pass_;
+    pipeline_info.subpass = getMainSubpass();
+
+    vk::PipelineRenderingCreateInfoKHR rendering_info{};
+    if (render_graph_->usesDynamicRendering()) {
+        rendering_info = render_graph_->getPipelineRenderingInfo(forward_pass_);
+        pipeline_info.pNext = &rendering_info;
+    }
+
+    try {
+        auto result = device.createGraphicsPipeline(context_->getPipelineCache(), pipeline_info);
+        skybox_pipeline_ = result.value;
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to create skybox graphics pipeline: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanRenderer::createCommandBuffers() {
+    auto device = context_->getDevice();
+
+    command_buffers_.resize(MAX_FRAMES_IN_FLIGHT);
+
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.commandPool = context_->getCommandPool();
+    alloc_info.level = vk::CommandBufferLevel::ePrimary;
+    alloc_info.commandBufferCount = static_cast<uint32_t>(command_buffers_.size());
+
+    try {
+        command_buffers_ = device.allocateCommandBuffers(alloc_info);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOGE("Failed to allocate command buffers: {}", e.what());
+        return false;
+    }
+}
+
+bool VulkanRenderer::createSyncObjects() {
+    auto device = context_->getDevice();
+
+    image_available_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
+    render_finished_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
+    in_flight_fences_.resize(MAX_FRAMES_IN_FLIGHT);
+
+    vk::SemaphoreCreateInfo semaphore_info{};
+    vk::FenceCreateInfo fence_info{};
+    fence_info.flags = vk::FenceCreateFlagBits::eSignaled;
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        try {
+            image_available_semaphores_[i] = device.createSemaphore(semaphore_info);
+            render_finished_semaphores_[i] = device.createSemaphore(semaphore_info);
+            in_flight_fences_[i] = device.createFence(fence_info);
+        }
+        catch (const std::exception& e) {
+            LOGE("Failed to create synchronization objects for frame {}: {}", i, e.what());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void VulkanRenderer::mainLoop() {
+    last_time_ = std::chrono::steady_clock::now();
+    auto start_time = last_time_;
+
+    while (!glfwWindowShouldClose(window_)) {
+        // The low-latency mode polls inside drawFrame, after acquire.
+        if (!low_latency_enabled_) {
+            glfwPollEvents();
+        }
+
+        auto current_time = std::chrono::steady_clock::now();
+        delta_time_ = std::chrono::duration<float>(current_time - last_time_).count();
+        last_time_ = current_time;
+
+        if (!low_latency_enabled_) {
+            updateOverlay();
+            processInput();
+        }
+        drawFrame();
+
+        if (!camera_path_file_.empty()) {
+            recorded_path_.record(std::chrono::duration<float>(last_time_ - start_time).count(), *camera_);
+        }
+    }
+
+    context_->getDevice().waitIdle();
+
+    if (!camera_path_file_.empty()) {
+        recorded_path_.save(camera_path_file_);
+    }
+}
+
+// Starts the ImGui frame, so it must follow the event poll whose input it shows.
+void VulkanRenderer::updateOverlay() {
+    if (ui_overlay_) {
+        ui_overlay_->update(delta_time_);
+        ui_overlay_->updatePerformanceData(ui_overlay_->getCurrentFPS(), ui_overlay_->getAverageFrameTime());
+    }
+}
+
+void VulkanRenderer::drawFrame() {
+    auto device = context_->getDevice();
+
+    cpu_profiler_.beginFrame();
+
+    cpu_profiler_.beginScope("Wait For Frame");
+    device.waitForFences(1, &in_flight_fences_[current_frame_], VK_TRUE, UINT64_MAX);
+    cpu_profiler_.endScope();
+    frame_pacer_->retireFrame(current_frame_);
+    context_->completeFrame(frame_serials_[current_frame_]);
+    if (frame_readback_) {
+        frame_readback_->collect(current_frame_);
+    }
+
+    if (hot_reload_enabled_) {
+        updateHotReload();
+    }
+
+    if (low_latency_enabled_ && !headless_) {
+        CpuProfiler::Scope scope(cpu_profiler_, "Wait For Display");
+        frame_pacer_->waitForDisplay();
+    }
+
+    context_->getUniformRing().beginFrame(current_frame_);
+    context_->getUploadService().beginFrame();
+    ibl_->beginFrame(current_frame_);
+    secondary_pools_->beginFrame(current_frame_);
+
+    // Headless, every frame slot owns one offscreen target.
+    uint32_t image_index = current_frame_;
+    if (!headless_) {
+        vk::Result result = device.acquireNextImageKHR(context_->getSwapChain(), UINT64_MAX,
+            image_available_semaphores_[current_frame_], nullptr, &image_index);
+
+        if (result == vk::Result::eErrorOutOfDateKHR) {
+            recreateSwapChain();
+            return;
+        }
+        else if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+            throw std::runtime_error("Failed to acquire swap chain image!");
+        }
+    }
+
+    // Everything from here on reaches the screen with this image.
+    if (low_latency_enabled_ && !headless_) {
+        glfwPollEvents();
+        updateOverlay();
+        processInput();
+    }
+    frame_pacer_->beginFrame(current_frame_, input_time_);
+
+    cpu_profiler_.beginScope("Update");
+    updateUniformBuffer();
+    updateSkyBoxUniforms();
+
+    if (!scene_->update(current_frame_)) {
+        throw std::runtime_error("Failed to update scene buffers!");
+    }
+    cpu_profiler_.endScope();
+
+    frame_serials_[current_frame_] = context_->beginFrame();
+    device.resetFences(1, &in_flight_fences_[current_frame_]);
+
+    command_buffers_[current_frame_].reset();
+
+    cpu_profiler_.beginScope("Record");
+
+    vk::CommandBufferBeginInfo begin_info{};
+    command_buffers_[current_frame_].begin(begin_info);
+    gpu_profiler_->beginFrame(command_buffers_[current_frame_], current_frame_);
+
+    std::vector<vk::Semaphore> wait_semaphores;
+    std::vector<vk::PipelineStageFlags> wait_stages;
+    if (!headless_) {
+        wait_semaphores.push_back(image_available_semaphores_[current_frame_]);
+        wait_stages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    }
+    context_->getUploadService().acquire(command_buffers_[current_frame_], wait_semaphores, wait_stages);
+
+    if (skybox_) {
+        GpuProfiler::Scope scope(*gpu_profiler_, command_buffers_[current_frame_], "Sky Update");
+        skybox_->recordUpdate(command_buffers_[current_frame_]);
+    }
+    {
+        GpuProfiler::Scope scope(*gpu_profiler_, command_buffers_[current_frame_], "IBL Bake");
+        ibl_->recordBake(command_buffers_[current_frame_], current_frame_);
+    }
+
+    render_graph_->setImage(backbuffer_resource_, context_->getSwapChainImages()[image_index],
+        context_->getSwapChainImageViews()[image_index]);
+    render_graph_->setImage(depth_pyramid_resource_, depth_pyramid_->getImage(), depth_pyramid_->getView());
+    render_graph_->setBuffer(visible_buffer_resource_, scene_->getVisibleBuffer());
+    render_graph_->setBuffer(indirect_buffer_resource_, scene_->getIndirectBuffer());
+    render_graph_->setBuffer(cluster_buffer_resource_, light_grid_->getClusterBuffer());
+
+    render_graph_->execute(command_buffers_[current_frame_], parallel_recording_enabled_ ?
+        vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+
+    if (frame_readback_) {
+        GpuProfiler::Scope scope(*gpu_profiler_, command_buffers_[current_frame_], "Readback");
+        frame_readback_->record(command_buffers_[current_frame_], current_frame_,
+            context_->getSwapChainImages()[image_index], frame_number_);
+    }
+
+    gpu_profiler_->endFrame(command_buffers_[current_frame_]);
+    command_buffers_[current_frame_].end();
+    cpu_profiler_.endScope();
+
+    vk::SubmitInfo submit_info{};
+
+    submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+    submit_info.pWaitSemaphores = wait_semaphores.data();
+    submit_info.pWaitDstStageMask = wait_stages.data();
+
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffers_[current_frame_];
+
+    vk::Semaphore signal_semaphores[] = { render_finished_semaphores_[current_frame_] };
+    submit_info.signalSemaphoreCount = headless_ ? 0 : 1;
+    submit_info.pSignalSemaphores = signal_semaphores;
+
+    cpu_profiler_.beginScope("Submit And Present");
+    context_->getGraphicsQueue().submit(submit_info, in_flight_fences_[current_frame_]);
+
+    if (headless_) {
+        cpu_profiler_.endScope();
+        current_frame_ = (current_frame_ + 1) % frames_in_flight_;
+        frame_number_++;
+        return;
+    }
+
+    vk::PresentInfoKHR present_info{};
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = signal_semaphores;
+
+    vk::SwapchainKHR swap_chains[] = { context_->getSwapChain() };
+    present_info.swapchainCount = 1;
+    present_info.pSwapchains = swap_chains;
+    present_info.pImageIndices = &image_index;
+    frame_pacer_->attachPresentId(present_info);
+
+    vk::Result result = context_->getPresentQueue().presentKHR(present_info);
+    cpu_profiler_.endScope();
+
+    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || framebuffer_resized_) {
+        framebuffer_resized_ = false;
+        recreateSwapChain();
+    }
+    else if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to present swap chain image!");
+    }
+
+    current_frame_ = (current_frame_ + 1) % frames_in_flight_;
+    frame_number_++;
+}
+
+void VulkanRenderer::setHotReloadEnabled(bool enabled) {
+    hot_reload_enabled_ = enabled;
+    if (!enabled) return;
+
+    file_watcher_.watch(SHADER_DIR "default.vert");
+    file_watcher_.watch(SHADER_DIR "default.frag");
+    if (depth_prepass_enabled_) {
+        file_watcher_.watch(SHADER_DIR "depth_prepass.frag");
+    }
+    if (!texture_path_.empty()) {
+        file_watcher_.watch(texture_path_);
+    }
+    LOGI("Hot reload enabled");
+}
+
+void VulkanRenderer::watchTexture(const std::string& texture_path) {
+    if (!texture_path_.empty() && texture_path_ != texture_path) {
+        file_watcher_.unwatch(texture_path_);
+    }
+    texture_path_ = texture_path;
+    if (hot_reload_enabled_) {
+        file_watcher_.watch(texture_path_);
+    }
+}
+
+// Runs between frames, after the fence wait. Compiles and pipeline builds go
+// to the job system; finished ones are swapped in here and the objects they
+// replace are retired through the context, so no frame waits on the device.
+void VulkanRenderer::updateHotReload() {
+    for (const std::string& path : file_watcher_.poll()) {
+        if (path == texture_path_) {
+            LOGI("Texture changed: {}", path);
+            texture_reload_requested_ = true;
+        }
+        else {
+            LOGI("Shader changed: {}", path);
+            shader_reload_requested_ = true;
+        }
+    }
+
+    // One compile at a time; edits made during it start another afterwards.
+    if (shader_reload_requested_ && !shader_reload_.valid()) {
+        shader_reload_requested_ = false;
+        shader_reload_start_ = std::chrono::steady_clock::now();
+        shader_reload_ = job_system_->submit([this]() { return buildShaderReload(); });
+    }
+
+    // Likewise one decode at a time, so the last edit is always reloaded.
+    if (texture_reload_requested_ && !texture_reload_.valid()) {
+        texture_reload_requested_ = false;
+        texture_reload_start_ = std::chrono::steady_clock::now();
+        texture_reload_ = job_system_->submit([path = texture_path_]() {
+            TextureReload reload;
+            // A file still being written fails to decode and is not uploaded.
+            reload.valid = TextureLoader::load(path, reload.data) && reload.data.isValid();
+            return reload;
+        });
+    }
+
+    auto is_ready = [](const auto& future) {
+        return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    if (is_ready(shader_reload_)) {
+        ShaderReload reload = shader_reload_.get();
+        if (reload.valid) {
+            ScenePipelines old_pipelines{ graphics_pipeline_, alpha_tested_pipeline_, depth_prepass_pipeline_,
+                depth_prepass_alpha_pipeline_ };
+            context_->retire([this, old_pipelines]() { destroyScenePipelines(old_pipelines); });
+
+            graphics_pipeline_ = reload.pipelines.opaque;
+            alpha_tested_pipeline_ = reload.pipelines.alpha_tested;
+            depth_prepass_pipeline_ = reload.pipelines.depth_prepass;
+            depth_prepass_alpha_pipeline_ = reload.pipelines.depth_prepass_alpha;
+
+            // Pipelines keep no reference to their modules.
+            shader_ = std::move(reload.shader);
+            depth_prepass_shader_ = std::move(reload.depth_prepass_shader);
+
+            LOGI("Shaders reloaded in {:.1f} ms", std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - shader_reload_start_).count());
+        }
+        else {
+            LOGW("Shader reload failed, keeping the current pipelines");
+        }
+    }
+
+    if (is_ready(texture_reload_)) {
+        TextureReload reload = texture_reload_.get();
+        auto texture = std::make_shared<Texture>(context_);
+        if (reload.valid && texture->createFromTextureData(reload.data, texture_path_) &&
+            material_->setTexture(texture)) {
+            LOGI("Texture reloaded in {:.1f} ms", std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - texture_reload_start_).count());
+        }
+        else {
+            LOGW("Texture reload failed: {}", texture_path_);
+        }
+    }
+}
+
+VulkanRenderer::ShaderReload VulkanRenderer::buildShaderReload() const {
+    ShaderReload reload;
+
+    reload.shader = loadSceneShader(SHADER_DIR "default.frag", false);
+    if (!reload.shader) {
+        return reload;
+    }
+
+    if (depth_prepass_enabled_) {
+        reload.depth_prepass_shader = loadSceneShader(SHADER_DIR "depth_prepass.frag", false);
+        if (!reload.depth_prepass_shader) {
+            return reload;
+        }
+    }
+
+    reload.valid = createScenePipelines(*reload.shader, reload.depth_prepass_shader.get(), reload.pipelines);
+    return reload;
+}
+
+void VulkanRenderer::setFramesInFlight(uint32_t count) {
+    // Per-frame resources exist for MAX_FRAMES_IN_FLIGHT slots; fewer slots
+    // simply leave the rest idle.
+    frames_in_flight_ = std::clamp<uint32_t>(count, 1, MAX_FRAMES_IN_FLIGHT);
+}
+
+void VulkanRenderer::setViewportAndScissor(vk::CommandBuffer command_buffer) const {
+    vk::Viewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(context_->getSwapChainExtent().width);
+    viewport.height = static_cast<float>(context_->getSwapChainExtent().height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    command_buffer.setViewport(0, 1, &viewport);
+
+    vk::Rect2D scissor{};
+    scissor.offset = vk::Offset2D{ 0, 0 };
+    scissor.extent = context_->getSwapChainExtent();
+    command_buffer.setScissor(0, 1, &scissor);
+}
+
+// Everything shares the one material, so it decides whether the draws take
+// the alpha-tested path.
+void VulkanRenderer::recordDepthPrepass(vk::CommandBuffer command_buffer, uint32_t first_batch, uint32_t batch_count) const {
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+        material_->isAlphaTested() ? depth_prepass_alpha_pipeline_ : depth_prepass_pipeline_);
+    material_->bind(command_buffer, pipeline_layout_);
+    scene_->draw(command_buffer, pipeline_layout_, current_frame_, first_batch, batch_count);
+}
+
+void VulkanRenderer::recordSkybox(vk::CommandBuffer command_buffer) const {
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, skybox_pipeline_);
+    skybox_->draw(command_buffer, skybox_pipeline_layout_);
+}
+
+void VulkanRenderer::recordOpaque(vk::CommandBuffer command_buffer, uint32_t first_batch, uint32_t batch_count) const {
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+        !depth_prepass_enabled_ && material_->isAlphaTested() ? alpha_tested_pipeline_ : graphics_pipeline_);
+    material_->bind(command_buffer, pipeline_layout_);
+    ibl_->bind(command_buffer, pipeline_layout_, 2);
+    light_grid_->bind(command_buffer, pipeline_layout_, 3, current_frame_);
+    scene_->draw(command_buffer, pipeline_layout_, current_frame_, first_batch, batch_count);
+}
+
+vk::CommandBufferInheritanceInfo VulkanRenderer::getInheritanceInfo(const RenderGraph::PassContext& pass) const {
+    vk::CommandBufferInheritanceInfo inheritance{};
+    // With dynamic rendering the graph's rendering info stands in for all three.
+    inheritance.pNext = pass.rendering;
+    inheritance.renderPass = pass.render_pass;
+    inheritance.subpass = pass.subpass;
+    inheritance.framebuffer = pass.framebuffer;
+    inheritance.pipelineStatistics = gpu_profiler_->getStatisticFlags();
+    return inheritance;
+}
+
+// Secondary-only subpasses allow nothing but executeCommands, so in that mode
+// the graph's scope around the render pass is the finest timing there is.
+void VulkanRenderer::recordDepthPrepassPass(const RenderGraph::PassContext& pass) {
+    if (pass.contents == vk::SubpassContents::eInline) {
+        GpuProfiler::Scope scope(*gpu_profiler_, pass.command_buffer, "Depth Prepass");
+        setViewportAndScissor(pass.command_buffer);
+        recordDepthPrepass(pass.command_buffer, 0, scene_->getBatchCount());
+        return;
+    }
+
+    std::vector<vk::CommandBuffer> secondaries;
+    recordSceneSecondaries(getInheritanceInfo(pass), true, secondaries);
+    if (!secondaries.empty()) {
+        pass.command_buffer.executeCommands(secondaries);
+    }
+}
+
+void VulkanRenderer::recordForwardPass(const RenderGraph::PassContext& pass) {
+    vk::CommandBuffer command_buffer = pass.command_buffer;
+
+    if (pass.contents == vk::SubpassContents::eInline) {
+        setViewportAndScissor(command_buffer);
+
+        if (skybox_ && skybox_pipeline_) {
+            GpuProfiler::Scope scope(*gpu_profiler_, command_buffer, "Skybox");
+            recordSkybox(command_buffer);
+        }
+        {
+            GpuProfiler::Scope scope(*gpu_profiler_, command_buffer, "Opaque");
+            recordOpaque(command_buffer, 0, scene_->getBatchCount());
+        }
+
+        if (ui_overlay_) {
+            GpuProfiler::Scope scope(*gpu_profiler_, command_buffer, "UI");
+            ui_overlay_->render(command_buffer);
+        }
+        return;
+    }
+
+    vk::CommandBufferInheritanceInfo inheritance = getInheritanceInfo(pass);
+    std::vector<vk::CommandBuffer> secondaries;
+
+    // The skybox and UI are recorded on this thread into slot 0, which is
+    // free before and after the scene tasks.
+    if (skybox_ && skybox_pipeline_) {
+        vk::CommandBuffer skybox_commands = secondary_pools_->begin(0, inheritance);
+        setViewportAndScissor(skybox_commands);
+        recordSkybox(skybox_commands);
+        skybox_commands.end();
+        secondaries.push_back(skybox_commands);
+    }
+
+    recordSceneSecondaries(inheritance, false, secondaries);
+
+    if (ui_overlay_) {
+        vk::CommandBuffer ui_commands = secondary_pools_->begin(0, inheritance);
+        ui_overlay_->render(ui_commands);
+        ui_commands.end();
+        secondaries.push_back(ui_commands);
+    }
+
+    if (!secondaries.empty()) {
+        command_buffer.executeCommands(secondaries);
+    }
+}
+
+void VulkanRenderer::recordSceneSecondaries(const vk::CommandBufferInheritanceInfo& inheritance, bool depth_only,
+    std::vector<vk::CommandBuffer>& command_buffers) {
+    uint32_t batch_count = scene_->getBatchCount();
+    if (batch_count == 0) return;
+
+    uint32_t slot_count = secondary_pools_->getSlotCount();
+    uint32_t batches_per_task = (batch_count + slot_count - 1) / slot_count;
+    uint32_t task_count = (batch_count + batches_per_task - 1) / batches_per_task;
+
+    size_t first_buffer = command_buffers.size();
+    command_buffers.resize(first_buffer + task_count);
+
+    // Task i records into slot i, whichever thread picks it up, so no two
+    // threads ever share a pool.
+    job_system_->parallelFor(task_count, [&](size_t task) {
+        uint32_t first_batch = static_cast<uint32_t>(task) * batches_per_task;
+
+        vk::CommandBuffer scene_commands = secondary_pools_->begin(static_cast<uint32_t>(task), inheritance);
+        setViewportAndScissor(scene_commands);
+        if (depth_only) {
+            recordDepthPrepass(scene_commands, first_batch, batches_per_task);
+        }
+        else {
+            recordOpaque(scene_commands, first_batch, batches_per_task);
+        }
+        scene_commands.end();
+
+        command_buffers[first_buffer + task] = scene_commands;
+    });
+}
+
+void VulkanRenderer::updateUniformBuffer() {
+    static auto start_time = std::chrono::high_resolution_clock::now();
+    auto current_time = std::chrono::high_resolution_clock::now();
+    float time = std::chrono::duration<float, std::chrono::seconds::period>(current_time - start_time).count();
+
+    UniformBufferObject ubo{};
+    ubo.view = camera_->getViewMatrix();
+    ubo.proj = camera_->getProjectionMatrix(static_cast<float>(context_->getSwapChainExtent().width) /
+        static_cast<float>(context_->getSwapChainExtent().height));
+    ubo.proj[1][1] *= -1;
+    ubo.camera_pos = camera_->getPosition();
+
+    material_->updateUniforms(ubo);
+    scene_->setCamera(ubo.view, ubo.proj, camera_->getNearPlane(), context_->getSwapChainExtent().height);
+
+    if (!light_grid_->update(current_frame_, ubo.view, ubo.proj, context_->getSwapChainExtent(),
+        camera_->getNearPlane(), camera_->getFarPlane())) {
+        throw std::runtime_error("Failed to update light grid!");
+    }
+}
+
+void VulkanRenderer::updateSkyBoxUniforms() {
+    if (!skybox_) return;
+
+    SkyBoxUBO ubo{};
+    ubo.view = camera_->getViewMatrix();
+    ubo.projection = camera_->getProjectionMatrix(static_cast<float>(context_->getSwapChainExtent().width) /
+        static_cast<float>(context_->getSwapChainExtent().height));
+    ubo.projection[1][1] *= -1;
+
+    skybox_->updateUniforms(ubo);
+}
+
+void VulkanRenderer::recreateSwapChain() {
+    // Frames in flight keep rendering into the old images: the swapchain,
+    // framebuffers, transient images and depth pyramid they use are retired
+    // through the context and destroyed as those frames complete.
+    //
+    // Pipelines use dynamic viewport and scissor, and the graph's render passes
+    // depend only on the surface format, which does not change for the same
+    // surface.
+    if (!context_->recreateSwapChain() || !render_graph_->createResources(context_->getSwapChainExtent()) ||
+        !depth_pyramid_->create(render_graph_->getImageView(depth_resource_), context_->getSwapChainExtent()) ||
+        !scene_->setDepthPyramid(*depth_pyramid_)) {
+        throw std::runtime_error("Failed to recreate swap chain!");
+    }
+    frame_pacer_->resetSwapChain();
+}
+
+void VulkanRenderer::processInput() {
+    input_time_ = std::chrono::steady_clock::now();
+
+    bool move_forward = glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS;
+    bool move_backward = glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS;
+    bool move_left = glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS;
+    bool move_right = glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS;
+
+    camera_->processInput(delta_time_, move_forward, move_backward, move_left, move_right);
+
+    if (glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window_, true);
+    }
+}
+
+void VulkanRenderer::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
+    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
+    renderer->framebuffer_resized_ = true;
+}
+
+void VulkanRenderer::mouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
+
+    if (renderer->first_mouse_) {
+        renderer->last_x_ = x_pos;
+        renderer->last_y_ = y_pos;
+        renderer->first_mouse_ = false;
+    }
+
+    float x_offset = x_pos - renderer->last_x_;
+    float y_offset = renderer->last_y_ - y_pos;
+
+    renderer->last_x_ = x_pos;
+    renderer->last_y_ = y_pos;
+
+    renderer->camera_->processMouseMovement(x_offset, y_offset);
+}
+
+void VulkanRenderer::scrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+    auto renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
+    renderer->camera_->processMouseScroll(static_cast<float>(y_offset));
+}
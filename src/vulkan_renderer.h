@@ -1,100 +1,305 @@
-﻿#pragma once
-
-#include "vulkan_context.h"
-#include "camera.h"
-#include "mesh.h"
-#include "shader.h"
-#include "texture.h"
-#include "material.h"
-#include "skybox.h"
-#include "utils/ui_overlay.h"
-#include <GLFW/glfw3.h>
-#include <memory>
-#include <vector>
-#include <chrono>
-
-class VulkanRenderer {
-public:
-    VulkanRenderer();
-    ~VulkanRenderer();
-
-    bool initialize(int width = 800, int height = 600, const std::string& title = "Vulkan Renderer");
-    void run();
-    void cleanup();
-
-    bool loadModel(const std::string& obj_path);
-
-    bool createDefaultSkyBox();
-
-    bool loadTexture(const std::string& texture_path);
-
-private:
-    bool initWindow();
-    bool initVulkan();
-    bool createRenderPass();
-    bool createGraphicsPipeline();
-    bool createSkyBoxPipeline();
-    bool createFramebuffers();
-    bool createCommandBuffers();
-    bool createSyncObjects();
-    bool createDepthResources();
-
-    void mainLoop();
-    void drawFrame();
-    void updateUniformBuffer();
-    void updateSkyBoxUniforms();
-    void recreateSwapChain();
-
-    uint32_t findMemoryType(uint32_t type_filter, vk::MemoryPropertyFlags properties);
-    
-    static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
-    static void mouseCallback(GLFWwindow* window, double x_pos, double y_pos);
-    static void scrollCallback(GLFWwindow* window, double x_offset, double y_offset);
-    void processInput();
-    
-    GLFWwindow* window_;
-    int window_width_;
-    int window_height_;
-    std::string window_title_;
-    bool framebuffer_resized_;
-    
-    std::shared_ptr<VulkanContext> context_;
-    
-    vk::RenderPass render_pass_;
-    vk::DescriptorSetLayout descriptor_set_layout_;
-    vk::PipelineLayout pipeline_layout_;
-    vk::Pipeline graphics_pipeline_;
-    
-    vk::PipelineLayout skybox_pipeline_layout_;
-    vk::Pipeline skybox_pipeline_;
-
-    std::vector<vk::Framebuffer> swap_chain_framebuffers_;
-    std::vector<vk::CommandBuffer> command_buffers_;
-    
-    vk::Image depth_image_;
-    vk::DeviceMemory depth_image_memory_;
-    vk::ImageView depth_image_view_;
-    
-    std::vector<vk::Semaphore> image_available_semaphores_;
-    std::vector<vk::Semaphore> render_finished_semaphores_;
-    std::vector<vk::Fence> in_flight_fences_;
-    uint32_t current_frame_;
-    
-    std::unique_ptr<Camera> camera_;
-    std::unique_ptr<Mesh> mesh_;
-    std::unique_ptr<Shader> shader_;
-    std::unique_ptr<Material> material_;
-    
-    std::unique_ptr<SkyBox> skybox_;
-    std::unique_ptr<Shader> skybox_shader_;
-
-    std::unique_ptr<UIOverlay> ui_overlay_;
-    
-    std::chrono::steady_clock::time_point last_time_;
-    float delta_time_;
-    
-    bool first_mouse_;
-    double last_x_, last_y_;
-
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
-};
+﻿#pragma once
+
+#include "vulkan_context.h"
+#include "camera.h"
+#include "mesh.h"
+#include "scene.h"
+#include "shader.h"
+#include "texture.h"
+#include "material.h"
+#include "skybox.h"
+#include "image_based_lighting.h"
+#include "light_grid.h"
+#include "depth_pyramid.h"
+#include "job_system.h"
+#include "profiler.h"
+#include "secondary_command_pools.h"
+#include "frame_pacer.h"
+#include "render_graph.h"
+#include "frame_readback.h"
+#include "camera_path.h"
+#include "file_watcher.h"
+#include "utils/ui_overlay.h"
+#include <GLFW/glfw3.h>
+#include <memory>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <future>
+
+// CPU time of each load stage, summed over every load since initialize().
+// Parse and decode run on the job system, so together they may exceed the
+// wall-clock load time; upload counts the time spent creating resources and
+// queuing their copies, not the transfers themselves.
+struct LoadTimings {
+    double parse_ms = 0.0;
+    double decode_ms = 0.0;
+    double upload_ms = 0.0;
+    double pipeline_ms = 0.0;
+};
+
+class VulkanRenderer {
+public:
+    VulkanRenderer();
+    ~VulkanRenderer();
+
+    bool initialize(int width = 800, int height = 600, const std::string& title = "Vulkan Renderer");
+    // No window or surface: frames go into offscreen targets and are read back
+    // through renderOffscreen(), which replaces run(). There is no UI overlay.
+    bool initializeHeadless(int width, int height);
+    void run();
+    void cleanup();
+
+    bool isHeadless() const { return headless_; }
+
+    // Headless only. Renders frame_count frames back to back as fast as the GPU
+    // allows and writes each into directory, or nowhere for an empty one.
+    // before_frame runs ahead of every frame, e.g. to move the camera. Returns
+    // the throughput in frames per second, including the final writes, or a
+    // negative value on failure.
+    double renderOffscreen(uint32_t frame_count, const std::string& directory = "",
+        FrameReadback::OutputFormat format = FrameReadback::OutputFormat::Png,
+        const std::function<void(uint32_t frame, Camera& camera)>& before_frame = nullptr);
+
+    // Renders frame_count frames without user input, windowed or headless,
+    // calling before_frame ahead of each. False if the window was closed first.
+    bool renderFrames(uint32_t frame_count, const std::function<void(uint32_t frame, Camera& camera)>& before_frame);
+
+    // Saves the camera of every frame of run() into filename on exit, as a
+    // CameraPath for benchmarks to replay.
+    void setCameraPathRecording(const std::string& filename) { camera_path_file_ = filename; }
+
+    bool loadModel(const std::string& obj_path);
+    bool loadModelInstanced(const std::string& obj_path, const std::vector<glm::mat4>& transforms);
+
+    Scene& getScene() { return *scene_; }
+    LightGrid& getLightGrid() { return *light_grid_; }
+
+    // Lays down depth in a separate subpass first, so the lit pass tests with
+    // eEqual and shades each pixel once. Must be set before initialize().
+    void setDepthPrepassEnabled(bool enabled) { depth_prepass_enabled_ = enabled; }
+    bool isDepthPrepassEnabled() const { return depth_prepass_enabled_; }
+
+    // Layout of the vertex buffers of loaded models; Packed quantizes them to
+    // PackedVertex, less than half the size. Must be set before initialize().
+    void setVertexFormat(VertexFormat format) { vertex_format_ = format; }
+    VertexFormat getVertexFormat() const { return vertex_format_; }
+
+    // Records the render pass into secondary command buffers: scene draws are
+    // split across the job system, the skybox and UI get one buffer each.
+    // Off records everything inline on the main thread. May change any frame.
+    void setParallelRecordingEnabled(bool enabled) { parallel_recording_enabled_ = enabled; }
+    bool isParallelRecordingEnabled() const { return parallel_recording_enabled_; }
+
+    // Samples input and updates the camera and uniforms after acquire, right
+    // before recording, instead of ahead of the fence wait, and paces frames
+    // to the display so no queue of finished frames builds up. May change any
+    // frame.
+    void setLowLatencyEnabled(bool enabled) { low_latency_enabled_ = enabled; }
+    bool isLowLatencyEnabled() const { return low_latency_enabled_; }
+
+    // Frames the CPU may record ahead of the GPU, 1 to MAX_FRAMES_IN_FLIGHT.
+    // Fewer cut latency at the cost of overlap. May change any frame.
+    void setFramesInFlight(uint32_t count);
+    uint32_t getFramesInFlight() const { return frames_in_flight_; }
+
+    // Watches the scene shaders and the material texture. Edited shaders are
+    // recompiled and their pipelines rebuilt on the job system, an edited
+    // texture is decoded there; both are swapped in between frames and the
+    // old objects retired once the frames using them complete. May change any
+    // frame.
+    void setHotReloadEnabled(bool enabled);
+    bool isHotReloadEnabled() const { return hot_reload_enabled_; }
+
+    // Off presents without waiting for vertical blank when the surface allows.
+    // Must be set before initialize().
+    void setVsyncEnabled(bool enabled) { vsync_enabled_ = enabled; }
+    bool isVsyncEnabled() const { return vsync_enabled_; }
+
+    // On Vulkan 1.3 devices the graph renders without render passes or
+    // framebuffers and materials push their descriptors; off keeps the path
+    // older devices take. Must be set before initialize().
+    void setVulkan13PathEnabled(bool enabled) { vulkan13_path_enabled_ = enabled; }
+
+    bool createDefaultSkyBox();
+    // Regenerates the gradient on the GPU at the start of the next frame.
+    bool setSkyBoxColors(const glm::vec3& top_color, const glm::vec3& bottom_color);
+
+    bool loadTexture(const std::string& texture_path);
+
+    // Asynchronous loads: the decode/parse stage starts on the job system right
+    // away, the GPU stage runs on this thread in finishPendingLoads(). Each
+    // future resolves to the same result the blocking call would return.
+    std::future<bool> requestModel(const std::string& obj_path);
+    std::future<bool> requestModelInstanced(const std::string& obj_path, const std::vector<glm::mat4>& transforms);
+    std::future<bool> requestTexture(const std::string& texture_path);
+    std::future<bool> requestDefaultSkyBox();
+
+    // Completes every outstanding request in submission order; false if any failed.
+    bool finishPendingLoads();
+
+    JobSystem& getJobSystem() { return *job_system_; }
+    VulkanContext& getContext() { return *context_; }
+    Camera& getCamera() { return *camera_; }
+    const GpuProfiler& getGpuProfiler() const { return *gpu_profiler_; }
+    const CpuProfiler& getCpuProfiler() const { return cpu_profiler_; }
+    const LoadTimings& getLoadTimings() const { return load_timings_; }
+
+private:
+    struct PendingLoad {
+        std::function<bool()> finish;
+        std::promise<bool> result;
+    };
+
+    // The scene's pipelines, rebuilt together when their shaders change.
+    struct ScenePipelines {
+        vk::Pipeline opaque;
+        vk::Pipeline alpha_tested;         // without the pre-pass only
+        vk::Pipeline depth_prepass;        // opaque, vertex stage only
+        vk::Pipeline depth_prepass_alpha;  // alpha-tested, discards below the cutoff
+    };
+
+    struct ShaderReload {
+        std::unique_ptr<Shader> shader;
+        std::unique_ptr<Shader> depth_prepass_shader;
+        ScenePipelines pipelines;
+        bool valid = false;
+    };
+
+    struct TextureReload {
+        TextureData data;
+        bool valid = false;
+    };
+
+    std::future<bool> addPendingLoad(std::function<bool()> finish);
+
+    bool initWindow();
+    bool initRenderer();
+    bool initVulkan();
+    bool createRenderGraph();
+    bool createGraphicsPipeline();
+    bool createPipelineLayout();
+    bool createScenePipelines(const Shader& shader, const Shader* depth_prepass_shader, ScenePipelines& pipelines) const;
+    void destroyScenePipelines(const ScenePipelines& pipelines) const;
+    std::unique_ptr<Shader> loadSceneShader(const std::string& fragment_path, bool precompiled) const;
+    bool createSkyBoxPipeline();
+    bool createCommandBuffers();
+    bool createSyncObjects();
+    uint32_t getMainSubpass() const { return render_graph_->getSubpass(forward_pass_); }
+
+    void mainLoop();
+    void drawFrame();
+    void updateOverlay();
+    void setViewportAndScissor(vk::CommandBuffer command_buffer) const;
+    void recordDepthPrepass(vk::CommandBuffer command_buffer, uint32_t first_batch, uint32_t batch_count) const;
+    void recordSkybox(vk::CommandBuffer command_buffer) const;
+    void recordOpaque(vk::CommandBuffer command_buffer, uint32_t first_batch, uint32_t batch_count) const;
+    void recordDepthPrepassPass(const RenderGraph::PassContext& pass);
+    void recordForwardPass(const RenderGraph::PassContext& pass);
+    vk::CommandBufferInheritanceInfo getInheritanceInfo(const RenderGraph::PassContext& pass) const;
+    void recordSceneSecondaries(const vk::CommandBufferInheritanceInfo& inheritance, bool depth_only,
+        std::vector<vk::CommandBuffer>& command_buffers);
+    void updateUniformBuffer();
+    void updateSkyBoxUniforms();
+    void recreateSwapChain();
+    void updateHotReload();
+    ShaderReload buildShaderReload() const;
+    void watchTexture(const std::string& texture_path);
+
+    static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+    static void mouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+    static void scrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+    void processInput();
+    
+    GLFWwindow* window_;
+    bool headless_;
+    int window_width_;
+    int window_height_;
+    std::string window_title_;
+    bool framebuffer_resized_;
+    bool depth_prepass_enabled_;
+    VertexFormat vertex_format_;
+    bool parallel_recording_enabled_;
+    bool low_latency_enabled_;
+    bool vsync_enabled_;
+    bool vulkan13_path_enabled_;
+    bool hot_reload_enabled_;
+    uint32_t frames_in_flight_;
+    
+    std::shared_ptr<VulkanContext> context_;
+    std::unique_ptr<JobSystem> job_system_;
+    std::unique_ptr<SecondaryCommandPools> secondary_pools_;
+    std::vector<PendingLoad> pending_loads_;
+    LoadTimings load_timings_;
+    
+    std::unique_ptr<RenderGraph> render_graph_;
+    RenderGraph::Resource backbuffer_resource_;
+    RenderGraph::Resource depth_resource_;
+    RenderGraph::Resource depth_pyramid_resource_;
+    RenderGraph::Resource visible_buffer_resource_;
+    RenderGraph::Resource indirect_buffer_resource_;
+    RenderGraph::Resource cluster_buffer_resource_;
+    RenderGraph::Pass depth_prepass_pass_;
+    RenderGraph::Pass forward_pass_;
+
+    vk::RenderPass render_pass_;                 // the forward pass, owned by the graph; null with dynamic rendering
+    vk::DescriptorSetLayout descriptor_set_layout_;
+    vk::PipelineLayout pipeline_layout_;
+    vk::Pipeline graphics_pipeline_;
+    vk::Pipeline alpha_tested_pipeline_;         // without the pre-pass only
+    vk::Pipeline depth_prepass_pipeline_;        // opaque, vertex stage only
+    vk::Pipeline depth_prepass_alpha_pipeline_;  // alpha-tested, discards below the cutoff
+    
+    vk::PipelineLayout skybox_pipeline_layout_;
+    vk::Pipeline skybox_pipeline_;
+
+    std::vector<vk::CommandBuffer> command_buffers_;
+    
+    std::vector<vk::Semaphore> image_available_semaphores_;
+    std::vector<vk::Semaphore> render_finished_semaphores_;
+    std::vector<vk::Fence> in_flight_fences_;
+    uint32_t current_frame_;
+    uint64_t frame_number_;
+    std::array<uint64_t, VulkanContext::MAX_FRAMES_IN_FLIGHT> frame_serials_;  // context serial last recorded per slot
+    
+    std::unique_ptr<Camera> camera_;
+    std::string camera_path_file_;
+    CameraPath recorded_path_;
+    std::unique_ptr<Scene> scene_;
+    std::unique_ptr<Shader> shader_;
+    std::unique_ptr<Shader> depth_prepass_shader_;
+    std::unique_ptr<Material> material_;
+    
+    std::unique_ptr<SkyBox> skybox_;
+    std::unique_ptr<Shader> skybox_shader_;
+    std::unique_ptr<ImageBasedLighting> ibl_;
+    std::unique_ptr<LightGrid> light_grid_;
+    std::unique_ptr<DepthPyramid> depth_pyramid_;
+
+    std::unique_ptr<GpuProfiler> gpu_profiler_;
+    CpuProfiler cpu_profiler_;
+    std::unique_ptr<FramePacer> frame_pacer_;
+    std::unique_ptr<FrameReadback> frame_readback_;  // headless only
+
+    FileWatcher file_watcher_;
+    std::string texture_path_;
+    bool shader_reload_requested_;
+    bool texture_reload_requested_;
+    std::future<ShaderReload> shader_reload_;
+    std::future<TextureReload> texture_reload_;
+    std::chrono::steady_clock::time_point shader_reload_start_;
+    std::chrono::steady_clock::time_point texture_reload_start_;
+
+    std::unique_ptr<UIOverlay> ui_overlay_;
+    
+    std::chrono::steady_clock::time_point last_time_;
+    std::chrono::steady_clock::time_point input_time_;
+    float delta_time_;
+    
+    bool first_mouse_;
+    double last_x_, last_y_;
+
+    static const int MAX_FRAMES_IN_FLIGHT = VulkanContext::MAX_FRAMES_IN_FLIGHT;
+    static const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+};